@@ -16,6 +16,121 @@ kernel void selection_kernel(const device int  *inData,        // Input data col
     }
 }
 
+// Output modes beyond the 0/1 flag array. Predicate: inData[i] < filterValue.
+
+// Packed bitmap: bit i of word i/32. Each simdgroup ballots 32 consecutive rows
+// (Apple GPUs run 32-wide simdgroups; the host checks threadExecutionWidth).
+kernel void selection_bitmap_kernel(const device int* inData,
+                                    device uint* bitmap,
+                                    constant int& filterValue,
+                                    constant uint& dataSize,
+                                    uint index [[thread_position_in_grid]],
+                                    uint lane [[thread_index_in_simdgroup]])
+{
+    bool pass = index < dataSize && inData[index] < filterValue;
+    uint bits = (uint)(simd_vote::vote_t)simd_ballot(pass);
+    if (lane == 0 && index < dataSize) {
+        bitmap[index / 32] = bits;
+    }
+}
+
+// Exclusive prefix sum of one value per thread across the threadgroup. Returns
+// the thread's offset and leaves the threadgroup total in *total.
+static uint threadgroup_exclusive_sum(uint value,
+                                      threadgroup uint* simd_totals, // one slot per simdgroup
+                                      threadgroup uint* total,
+                                      uint lane, uint simd_id, uint simd_size, uint simd_count)
+{
+    uint prefix = simd_prefix_exclusive_sum(value);
+    if (lane == simd_size - 1) simd_totals[simd_id] = prefix + value;
+    threadgroup_barrier(mem_flags::mem_threadgroup);
+    if (simd_id == 0) {
+        uint t = lane < simd_count ? simd_totals[lane] : 0;
+        uint p = simd_prefix_exclusive_sum(t);
+        if (lane < simd_count) simd_totals[lane] = p;
+        if (lane == simd_count - 1) *total = p + t;
+    }
+    threadgroup_barrier(mem_flags::mem_threadgroup);
+    return simd_totals[simd_id] + prefix;
+}
+
+// Stream compaction, pass 1: number of matches in each threadgroup-sized block.
+kernel void selection_block_count_kernel(const device int* inData,
+                                         device uint* blockCounts,
+                                         constant int& filterValue,
+                                         constant uint& dataSize,
+                                         uint index [[thread_position_in_grid]],
+                                         uint group_id [[threadgroup_position_in_grid]],
+                                         uint tid [[thread_index_in_threadgroup]],
+                                         uint threads_per_group [[threads_per_threadgroup]],
+                                         uint lane [[thread_index_in_simdgroup]],
+                                         uint simd_id [[simdgroup_index_in_threadgroup]],
+                                         uint simd_size [[threads_per_simdgroup]])
+{
+    threadgroup uint simd_totals[32];
+    threadgroup uint total;
+    uint pass = (index < dataSize && inData[index] < filterValue) ? 1 : 0;
+    threadgroup_exclusive_sum(pass, simd_totals, &total, lane, simd_id, simd_size,
+                              (threads_per_group + simd_size - 1) / simd_size);
+    if (tid == 0) blockCounts[group_id] = total;
+}
+
+// Pass 2: one threadgroup turns the block counts into exclusive block offsets
+// (in place) and writes the total match count.
+kernel void selection_scan_blocks_kernel(device uint* blockCounts,
+                                         device uint* totalCount,
+                                         constant uint& numBlocks,
+                                         uint tid [[thread_index_in_threadgroup]],
+                                         uint threads_per_group [[threads_per_threadgroup]],
+                                         uint lane [[thread_index_in_simdgroup]],
+                                         uint simd_id [[simdgroup_index_in_threadgroup]],
+                                         uint simd_size [[threads_per_simdgroup]])
+{
+    threadgroup uint simd_totals[32];
+    threadgroup uint total;
+    // Each thread owns a contiguous run of blocks
+    uint per_thread = (numBlocks + threads_per_group - 1) / threads_per_group;
+    uint begin = min(tid * per_thread, numBlocks);
+    uint end = min(begin + per_thread, numBlocks);
+    uint sum = 0;
+    for (uint i = begin; i < end; ++i) sum += blockCounts[i];
+    uint offset = threadgroup_exclusive_sum(sum, simd_totals, &total, lane, simd_id, simd_size,
+                                            (threads_per_group + simd_size - 1) / simd_size);
+    for (uint i = begin; i < end; ++i) {
+        uint count = blockCounts[i];
+        blockCounts[i] = offset;
+        offset += count;
+    }
+    if (tid == 0) totalCount[0] = total;
+}
+
+// Pass 3: every match writes at its block offset plus its rank in the block, so
+// the output keeps input order. Writes the row id, or payload[row] when
+// emitPayload is set (a directly materialized filtered column).
+kernel void selection_compact_kernel(const device int* inData,
+                                     const device uint* payload,
+                                     const device uint* blockOffsets,
+                                     device uint* out,
+                                     constant int& filterValue,
+                                     constant uint& dataSize,
+                                     constant uint& emitPayload,
+                                     uint index [[thread_position_in_grid]],
+                                     uint group_id [[threadgroup_position_in_grid]],
+                                     uint threads_per_group [[threads_per_threadgroup]],
+                                     uint lane [[thread_index_in_simdgroup]],
+                                     uint simd_id [[simdgroup_index_in_threadgroup]],
+                                     uint simd_size [[threads_per_simdgroup]])
+{
+    threadgroup uint simd_totals[32];
+    threadgroup uint total;
+    uint pass = (index < dataSize && inData[index] < filterValue) ? 1 : 0;
+    uint rank = threadgroup_exclusive_sum(pass, simd_totals, &total, lane, simd_id, simd_size,
+                                          (threads_per_group + simd_size - 1) / simd_size);
+    if (pass) {
+        out[blockOffsets[group_id] + rank] = emitPayload ? payload[index] : index;
+    }
+}
+
 
 // --- AGGREGATION KERNELS ---
 // SELECT SUM(l_quantity) FROM lineitem;
@@ -155,6 +270,48 @@ kernel void hash_join_probe(const device int* probeKeys,        // Input: l_orde
 }
 
 
+// --- GROUPED AGGREGATION KERNEL ---
+// SELECT key, COUNT(*), SUM(value) GROUP BY key; synthetic keys from the distribution sweep.
+
+struct GroupEntry {
+    atomic_int  key;   // -1 = empty
+    atomic_uint count;
+    atomic_uint sum;
+};
+
+// Same table design as the join: key % size, linear probing
+kernel void hash_aggregate_kernel(const device int* keys,
+                                  const device int* values,
+                                  device GroupEntry* table,
+                                  constant uint& dataSize,
+                                  constant uint& tableSize,
+                                  uint index [[thread_position_in_grid]])
+{
+    if (index >= dataSize) {
+        return;
+    }
+
+    int key = keys[index];
+    uint slot = (uint)key % tableSize;
+    for (uint i = 0; i < tableSize; ++i) {
+        int current = atomic_load_explicit(&table[slot].key, memory_order_relaxed);
+        // Weak CAS may fail spuriously: retry while the slot still looks empty
+        while (current == -1) {
+            if (atomic_compare_exchange_weak_explicit(&table[slot].key, &current, key,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                current = key;
+            }
+        }
+        if (current == key) {
+            atomic_fetch_add_explicit(&table[slot].count, 1u, memory_order_relaxed);
+            atomic_fetch_add_explicit(&table[slot].sum, (uint)values[index], memory_order_relaxed);
+            return;
+        }
+        slot = (slot + 1 == tableSize) ? 0 : slot + 1;
+    }
+}
+
+
 // --- TPC-H Q1 KERNELS ---
 // TPC-H Query 1: Pricing Summary Report Query
 /*
@@ -1033,7 +1190,7 @@ SELECT
     o_orderdate,
     o_shippriority
 FROM customer, orders, lineitem
-WHERE c_mktsegment = 'BUILDING'
+WHERE c_mktsegment = 'BUILDING'  -- SEGMENT parameter
   AND c_custkey = o_custkey
   AND l_orderkey = o_orderkey
   AND o_orderdate < '1995-03-15'
@@ -1257,17 +1414,18 @@ struct Q3Aggregates_Local {
 
 
 // KERNEL 1: Build a BITMAP on the CUSTOMER table.
-// Replaces hash table with a simple bitmap for 'BUILDING' segment.
+// Replaces hash table with a simple bitmap for the SEGMENT parameter (default 'BUILDING').
 kernel void q3_build_customer_bitmap_kernel(
     const device int* c_custkey,
     const device char* c_mktsegment,
     device atomic_uint* customer_bitmap,
     constant uint& customer_size,
+    constant char& segment_prefix, // first letter of SEGMENT; the 5 segments have distinct initials
     uint index [[thread_position_in_grid]])
 {
     if (index >= customer_size) return;
 
-    if (c_mktsegment[index] == 'B') { // 'B' for BUILDING
+    if (c_mktsegment[index] == segment_prefix) {
         int key = c_custkey[index];
         // Set bit at 'key'
         uint word_idx = key / 32;
@@ -1467,7 +1625,7 @@ FROM (
       AND p_partkey = l_partkey
       AND o_orderkey = l_orderkey
       AND s_nationkey = n_nationkey
-      AND p_name LIKE '%green%'
+      AND p_name LIKE '%green%'  -- COLOR parameter
 ) AS profit
 GROUP BY nation, o_year
 ORDER BY nation, o_year DESC;
@@ -1485,13 +1643,15 @@ struct Q9Aggregates_Local {
     float profit;
 };
 
-// KERNEL 1: Build Bitmap on PART, filtering for p_name LIKE '%green%'
+// KERNEL 1: Build Bitmap on PART, filtering for p_name LIKE '%COLOR%'
 kernel void q9_build_part_ht_kernel(
     const device int* p_partkey [[buffer(0)]],
     const device char* p_name [[buffer(1)]], // Assuming p_name is a fixed-size char array
     device atomic_uint* part_bitmap [[buffer(2)]], // Bitmap: 1 bit per partkey
     constant uint& part_size [[buffer(3)]],
     constant uint& part_ht_size [[buffer(4)]], // Unused, kept for signature compatibility if needed, or remove
+    constant char* color [[buffer(5)]], // COLOR parameter (e.g. "green"), not NUL-terminated
+    constant uint& color_len [[buffer(6)]],
     uint group_id [[threadgroup_position_in_grid]],
     uint thread_id_in_group [[thread_index_in_threadgroup]],
     uint threads_per_group [[threads_per_threadgroup]])
@@ -1499,10 +1659,12 @@ kernel void q9_build_part_ht_kernel(
     uint index = group_id * threads_per_group + thread_id_in_group;
     if (index >= part_size) return;
     bool match = false;
-    for(int i = 0; i < 50; ++i) { // Simplified string search
-        if (p_name[index * 55 + i] == 'g' && p_name[index * 55 + i + 1] == 'r' &&
-            p_name[index * 55 + i + 2] == 'e' && p_name[index * 55 + i + 3] == 'e' &&
-            p_name[index * 55 + i + 4] == 'n') {
+    const device char* name = p_name + index * 55;
+    for (int i = 0; i + (int)color_len <= 55; ++i) { // Simplified string search
+        if (name[i] != color[0]) continue;
+        uint k = 1;
+        while (k < color_len && name[i + k] == color[k]) ++k;
+        if (k == color_len) {
             match = true;
             break;
         }
@@ -1808,9 +1970,8 @@ struct Q13_CustDist_Local {
 
 // --- Q13 substring matching helpers ---
 
-inline int q13_effective_len_fixed_100(const device uchar* s) {
+inline int q13_effective_len_fixed_100(const device uchar* s, int min_pattern_len) {
     const int max_len = 100;
-    const int min_pattern_len = 15;
     for (int i = 0; i < max_len; i++) {
         if (s[i] == 0) {
             return (i < min_pattern_len) ? -1 : i;
@@ -1819,27 +1980,27 @@ inline int q13_effective_len_fixed_100(const device uchar* s) {
     return max_len;
 }
 
-inline bool q13_has_special_requests(const device uchar* s, int comment_len) {
-    const int last_special = comment_len - 15;
+// o_comment LIKE '%WORD1%WORD2%': find the first WORD1, then WORD2 anywhere after it.
+// Later WORD1 occurrences only see a suffix of the same text, so the first one decides.
+inline bool q13_has_word_pair(const device uchar* s, int comment_len,
+                              constant uchar* word1, int word1_len,
+                              constant uchar* word2, int word2_len) {
+    const int last_word1 = comment_len - word1_len - word2_len;
     
-    for (int i = 0; i <= last_special; i++) {
-        if (s[i+3] == 'c') {
-            if (s[i] == 's' && s[i+1] == 'p' && s[i+2] == 'e' && 
-                s[i+4] == 'i' && s[i+5] == 'a' && s[i+6] == 'l') {
-                
-                int req_start = i + 7;
-                int req_end = comment_len - 8;
-                for (int j = req_start; j <= req_end; j++) {
-                    if (s[j+2] == 'q') {
-                        if (s[j] == 'r' && s[j+1] == 'e' && s[j+3] == 'u' &&
-                            s[j+4] == 'e' && s[j+5] == 's' && s[j+6] == 't' && s[j+7] == 's') {
-                            return true;
-                        }
-                    }
-                }
-                return false;
-            }
+    for (int i = 0; i <= last_word1; i++) {
+        if (s[i] != word1[0]) continue;
+        int k = 1;
+        while (k < word1_len && s[i+k] == word1[k]) k++;
+        if (k < word1_len) continue;
+
+        const int last_word2 = comment_len - word2_len;
+        for (int j = i + word1_len; j <= last_word2; j++) {
+            if (s[j] != word2[0]) continue;
+            int m = 1;
+            while (m < word2_len && s[j+m] == word2[m]) m++;
+            if (m == word2_len) return true;
         }
+        return false;
     }
     return false;
 }
@@ -1851,12 +2012,17 @@ kernel void q13_fused_direct_count_kernel(
     device atomic_uint* customer_order_counts,
     constant uint& orders_size,
     constant uint& customer_size,
+    constant uchar* word1,      // WORD1 (e.g. "special")
+    constant uint& word1_len,
+    constant uchar* word2,      // WORD2 (e.g. "requests")
+    constant uint& word2_len,
     uint group_id [[threadgroup_position_in_grid]],
     uint thread_id_in_group [[thread_index_in_threadgroup]],
     uint threads_per_group [[threads_per_threadgroup]],
     uint grid_size [[threads_per_grid]])
 {
     const int comment_len = 100;
+    const int min_pattern_len = (int)(word1_len + word2_len);
     // const uint grid_size = threads_per_group * 2048;
     const uint global_tid = (group_id * threads_per_group) + thread_id_in_group;
     const uint BATCH = 4;
@@ -1868,9 +2034,9 @@ kernel void q13_fused_direct_count_kernel(
             const uint ck = (uint)o_custkey[i];
             if (ck >= 1u && ck <= customer_size) {
                 const device uchar* row = (const device uchar*)(o_comment + (i * comment_len));
-                int effective_len = q13_effective_len_fixed_100(row);
+                int effective_len = q13_effective_len_fixed_100(row, min_pattern_len);
                 if (effective_len > 0) {
-                    bool skip = q13_has_special_requests(row, effective_len);
+                    bool skip = q13_has_word_pair(row, effective_len, word1, (int)word1_len, word2, (int)word2_len);
                     if (!skip) {
                         atomic_fetch_add_explicit(&customer_order_counts[ck - 1u], 1u, memory_order_relaxed);
                     }
@@ -1884,9 +2050,9 @@ kernel void q13_fused_direct_count_kernel(
             const uint ck = (uint)o_custkey[i];
             if (ck >= 1u && ck <= customer_size) {
                 const device uchar* row = (const device uchar*)(o_comment + (i * comment_len));
-                int effective_len = q13_effective_len_fixed_100(row);
+                int effective_len = q13_effective_len_fixed_100(row, min_pattern_len);
                 if (effective_len > 0) {
-                    bool skip = q13_has_special_requests(row, effective_len);
+                    bool skip = q13_has_word_pair(row, effective_len, word1, (int)word1_len, word2, (int)word2_len);
                     if (!skip) {
                         atomic_fetch_add_explicit(&customer_order_counts[ck - 1u], 1u, memory_order_relaxed);
                     }
@@ -1900,9 +2066,9 @@ kernel void q13_fused_direct_count_kernel(
             const uint ck = (uint)o_custkey[i];
             if (ck >= 1u && ck <= customer_size) {
                 const device uchar* row = (const device uchar*)(o_comment + (i * comment_len));
-                int effective_len = q13_effective_len_fixed_100(row);
+                int effective_len = q13_effective_len_fixed_100(row, min_pattern_len);
                 if (effective_len > 0) {
-                    bool skip = q13_has_special_requests(row, effective_len);
+                    bool skip = q13_has_word_pair(row, effective_len, word1, (int)word1_len, word2, (int)word2_len);
                     if (!skip) {
                         atomic_fetch_add_explicit(&customer_order_counts[ck - 1u], 1u, memory_order_relaxed);
                     }
@@ -1916,9 +2082,9 @@ kernel void q13_fused_direct_count_kernel(
             const uint ck = (uint)o_custkey[i];
             if (ck >= 1u && ck <= customer_size) {
                 const device uchar* row = (const device uchar*)(o_comment + (i * comment_len));
-                int effective_len = q13_effective_len_fixed_100(row);
+                int effective_len = q13_effective_len_fixed_100(row, min_pattern_len);
                 if (effective_len > 0) {
-                    bool skip = q13_has_special_requests(row, effective_len);
+                    bool skip = q13_has_word_pair(row, effective_len, word1, (int)word1_len, word2, (int)word2_len);
                     if (!skip) {
                         atomic_fetch_add_explicit(&customer_order_counts[ck - 1u], 1u, memory_order_relaxed);
                     }
@@ -1936,12 +2102,17 @@ kernel void q13_local_count_kernel(
     const device char* o_comment,
     device Q13_OrderCount_Local* intermediate_counts,
     constant uint& orders_size,
+    constant uchar* word1,
+    constant uint& word1_len,
+    constant uchar* word2,
+    constant uint& word2_len,
     uint group_id [[threadgroup_position_in_grid]],
     uint thread_id_in_group [[thread_index_in_threadgroup]],
     uint threads_per_group [[threads_per_threadgroup]],
     uint grid_size [[threads_per_grid]])
 {
     const int comment_len = 100;
+    const int min_pattern_len = (int)(word1_len + word2_len);
     // const uint grid_size = threads_per_group * 2048;
     const uint global_tid = (group_id * threads_per_group) + thread_id_in_group;
     const uint BATCH = 4;
@@ -1952,32 +2123,32 @@ kernel void q13_local_count_kernel(
         if (base + 0 < orders_size) {
             const uint i = base + 0;
             const device uchar* row = (const device uchar*)(o_comment + (i * comment_len));
-            int effective_len = q13_effective_len_fixed_100(row);
-            bool skip = q13_has_special_requests(row, effective_len);
+            int effective_len = q13_effective_len_fixed_100(row, min_pattern_len);
+            bool skip = q13_has_word_pair(row, effective_len, word1, (int)word1_len, word2, (int)word2_len);
             if (!skip) { intermediate_counts[i].custkey = (uint)o_custkey[i]; intermediate_counts[i].order_count = 1; }
             else       { intermediate_counts[i].custkey = 0;               intermediate_counts[i].order_count = 0; }
         }
         if (base + 1 < orders_size) {
             const uint i = base + 1;
             const device uchar* row = (const device uchar*)(o_comment + (i * comment_len));
-            int effective_len = q13_effective_len_fixed_100(row);
-            bool skip = q13_has_special_requests(row, effective_len);
+            int effective_len = q13_effective_len_fixed_100(row, min_pattern_len);
+            bool skip = q13_has_word_pair(row, effective_len, word1, (int)word1_len, word2, (int)word2_len);
             if (!skip) { intermediate_counts[i].custkey = (uint)o_custkey[i]; intermediate_counts[i].order_count = 1; }
             else       { intermediate_counts[i].custkey = 0;               intermediate_counts[i].order_count = 0; }
         }
         if (base + 2 < orders_size) {
             const uint i = base + 2;
             const device uchar* row = (const device uchar*)(o_comment + (i * comment_len));
-            int effective_len = q13_effective_len_fixed_100(row);
-            bool skip = q13_has_special_requests(row, effective_len);
+            int effective_len = q13_effective_len_fixed_100(row, min_pattern_len);
+            bool skip = q13_has_word_pair(row, effective_len, word1, (int)word1_len, word2, (int)word2_len);
             if (!skip) { intermediate_counts[i].custkey = (uint)o_custkey[i]; intermediate_counts[i].order_count = 1; }
             else       { intermediate_counts[i].custkey = 0;               intermediate_counts[i].order_count = 0; }
         }
         if (base + 3 < orders_size) {
             const uint i = base + 3;
             const device uchar* row = (const device uchar*)(o_comment + (i * comment_len));
-            int effective_len = q13_effective_len_fixed_100(row);
-            bool skip = q13_has_special_requests(row, effective_len);
+            int effective_len = q13_effective_len_fixed_100(row, min_pattern_len);
+            bool skip = q13_has_word_pair(row, effective_len, word1, (int)word1_len, word2, (int)word2_len);
             if (!skip) { intermediate_counts[i].custkey = (uint)o_custkey[i]; intermediate_counts[i].order_count = 1; }
             else       { intermediate_counts[i].custkey = 0;               intermediate_counts[i].order_count = 0; }
         }
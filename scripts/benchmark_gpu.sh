@@ -19,44 +19,26 @@ run_and_capture() {
   local sf_arg=$1
   local sf_label=$2
   local out_file="$RESULTS_DIR/gpu_${sf_label}_${TIMESTAMP}.log"
+  local records="$RESULTS_DIR/gpu_${sf_label}_${TIMESTAMP}.jsonl"
   echo "Running GPU benchmarks for ${sf_label}..."
-  "$BUILD_BIN" "$sf_arg" | tee "$out_file" >/dev/null
-
-  # Parse standardized lines
-  # Q1
-  q1_gpu=$(grep -E "^Total TPC-H Q1 GPU time:" "$out_file" | awk '{print $(NF-1)}')
-  q1_wall=$(grep -E "^Total TPC-H Q1 wall-clock:" "$out_file" | awk '{print $(NF-1)}')
-  q1_cpu=$(grep -E "^Q1 CPU time:" "$out_file" | awk '{print $(NF-1)}' || true)
-  q1_execute=$(awk -v gpu="$q1_gpu" -v cpu="$q1_cpu" 'BEGIN { if (gpu && cpu) print gpu + cpu; else if (gpu) print gpu; else print "" }')
-  if [[ -n "$q1_gpu" ]]; then echo "$TIMESTAMP,$sf_label,Q1,$q1_gpu,$q1_wall,$q1_cpu,$q1_execute" >> "$GPU_CSV"; fi
-
-  # Q3
-  q3_gpu=$(grep -E "^Total TPC-H Q3 GPU time:" "$out_file" | awk '{print $(NF-1)}')
-  q3_wall=$(grep -E "^Total TPC-H Q3 wall-clock:" "$out_file" | awk '{print $(NF-1)}')
-  q3_cpu=$(grep -E "^Q3 CPU time:" "$out_file" | awk '{print $(NF-1)}' || true)
-  q3_execute=$(awk -v gpu="$q3_gpu" -v cpu="$q3_cpu" 'BEGIN { if (gpu && cpu) print gpu + cpu; else if (gpu) print gpu; else print "" }')
-  if [[ -n "$q3_gpu" ]]; then echo "$TIMESTAMP,$sf_label,Q3,$q3_gpu,$q3_wall,$q3_cpu,$q3_execute" >> "$GPU_CSV"; fi
-
-  # Q6
-  q6_gpu=$(grep -E "^Total TPC-H Q6 GPU time:" "$out_file" | awk '{print $(NF-1)}')
-  q6_wall=$(grep -E "^Total TPC-H Q6 wall-clock:" "$out_file" | awk '{print $(NF-1)}')
-  q6_cpu=$(grep -E "^Q6 CPU time:" "$out_file" | awk '{print $(NF-1)}' || true)
-  q6_execute=$(awk -v gpu="$q6_gpu" -v cpu="$q6_cpu" 'BEGIN { if (gpu && cpu) print gpu + cpu; else if (gpu) print gpu; else print "" }')
-  if [[ -n "$q6_gpu" ]]; then echo "$TIMESTAMP,$sf_label,Q6,$q6_gpu,$q6_wall,$q6_cpu,$q6_execute" >> "$GPU_CSV"; fi
-
-  # Q9
-  q9_gpu=$(grep -E "^Total TPC-H Q9 GPU time:" "$out_file" | awk '{print $(NF-1)}')
-  q9_wall=$(grep -E "^Total TPC-H Q9 wall-clock:" "$out_file" | awk '{print $(NF-1)}')
-  q9_cpu=$(grep -E "^Q9 CPU time:" "$out_file" | awk '{print $(NF-1)}' || true)
-  q9_execute=$(awk -v gpu="$q9_gpu" -v cpu="$q9_cpu" 'BEGIN { if (gpu && cpu) print gpu + cpu; else if (gpu) print gpu; else print "" }')
-  if [[ -n "$q9_gpu" ]]; then echo "$TIMESTAMP,$sf_label,Q9,$q9_gpu,$q9_wall,$q9_cpu,$q9_execute" >> "$GPU_CSV"; fi
-
-  # Q13
-  q13_gpu=$(grep -E "^Total TPC-H Q13 GPU time:" "$out_file" | awk '{print $(NF-1)}')
-  q13_wall=$(grep -E "^Total TPC-H Q13 wall-clock:" "$out_file" | awk '{print $(NF-1)}')
-  q13_cpu=$(grep -E "^Q13 CPU time:" "$out_file" | awk '{print $(NF-1)}' || true)
-  q13_execute=$(awk -v gpu="$q13_gpu" -v cpu="$q13_cpu" 'BEGIN { if (gpu && cpu) print gpu + cpu; else if (gpu) print gpu; else print "" }')
-  if [[ -n "$q13_gpu" ]]; then echo "$TIMESTAMP,$sf_label,Q13,$q13_gpu,$q13_wall,$q13_cpu,$q13_execute" >> "$GPU_CSV"; fi
+  "$BUILD_BIN" "$sf_arg" --results "$records" | tee "$out_file" >/dev/null
+
+  # One JSON record per query run; GPU time is the scan/probe/count stage,
+  # CPU time the post-processing or merge stage, wall-clock adds the build phase.
+  python3 - "$records" "$TIMESTAMP" "$sf_label" >> "$GPU_CSV" <<'PY'
+import json, sys
+path, timestamp, sf_label = sys.argv[1:4]
+with open(path) as f:
+    for line in f:
+        r = json.loads(line)
+        stages = r["stages_ms"]
+        gpu = next((stages[k] for k in ("scan", "probe", "count") if k in stages), None)
+        if gpu is None:
+            continue
+        cpu = next((stages[k] for k in ("post", "merge") if k in stages), 0.0)
+        build = stages.get("build_warm", stages.get("build_cold", 0.0))
+        print(f"{timestamp},{sf_label},{r['query'].upper()},{gpu:.2f},{build + gpu + cpu:.2f},{cpu:.2f},{gpu + cpu:.2f}")
+PY
 }
 
 # Ensure binary exists
@@ -0,0 +1,253 @@
+#!/usr/bin/env python3
+"""Compare a baseline and a candidate benchmark run and flag regressions.
+
+A run is either a records file written with --results (JSON Lines or CSV), or
+one or more timestamps from a history CSV (results/gpu_results.csv by default):
+'latest', 'previous', a timestamp, a comma-separated list of timestamps, or
+'last:N' for the N most recent runs. Every (scale factor, query, stage) present
+in both runs is tested: with at least two samples on each side, a one-sided
+Welch t-test (candidate slower); otherwise a fixed threshold widened by
+whatever noise the other side shows. A key regresses when it is both
+significant and slower by more than --min-slowdown percent (and --min-delta-ms).
+
+Exit status: 0 = no regression, 1 = at least one regression, 2 = bad input.
+"""
+import argparse
+import csv
+import json
+import math
+import os
+import sys
+
+repo_dir = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+default_history = os.path.join(repo_dir, 'results', 'gpu_results.csv')
+
+# History CSV columns compared as stages
+HISTORY_STAGES = [('gpu_time_ms', 'gpu'), ('wall_clock_ms', 'wall'), ('cpu_merge_ms', 'cpu_merge')]
+
+
+class Summary:
+    """n, mean, variance and median of one key's samples (variance None = unknown)."""
+
+    def __init__(self, n, mean, var, median):
+        self.n = n
+        self.mean = mean
+        self.var = var
+        self.median = median
+
+    @staticmethod
+    def of(values):
+        n = len(values)
+        mean = sum(values) / n
+        var = sum((v - mean) ** 2 for v in values) / (n - 1) if n > 1 else None
+        ordered = sorted(values)
+        median = ordered[n // 2] if n % 2 else 0.5 * (ordered[n // 2 - 1] + ordered[n // 2])
+        return Summary(n, mean, var, median)
+
+    def cv(self):
+        if self.var is None or self.mean <= 0:
+            return None
+        return math.sqrt(self.var) / self.mean
+
+
+# --- Student t tail via the regularized incomplete beta function ---
+def _beta_cf(a, b, x):
+    tiny = 1e-300
+    c, d = 1.0, 1.0 - (a + b) * x / (a + 1.0)
+    d = 1.0 / (d if abs(d) > tiny else tiny)
+    h = d
+    for m in range(1, 300):
+        for num in (m * (b - m) * x / ((a + 2 * m - 1) * (a + 2 * m)),
+                    -(a + m) * (a + b + m) * x / ((a + 2 * m) * (a + 2 * m + 1))):
+            d = 1.0 + num * d
+            d = 1.0 / (d if abs(d) > tiny else tiny)
+            c = 1.0 + num / c
+            c = c if abs(c) > tiny else tiny
+            h *= d * c
+        if abs(d * c - 1.0) < 1e-12:
+            break
+    return h
+
+
+def _betainc(a, b, x):
+    if x <= 0.0:
+        return 0.0
+    if x >= 1.0:
+        return 1.0
+    front = math.exp(math.lgamma(a + b) - math.lgamma(a) - math.lgamma(b) + a * math.log(x) + b * math.log(1.0 - x))
+    if x < (a + 1.0) / (a + b + 2.0):
+        return front * _beta_cf(a, b, x) / a
+    return 1.0 - front * _beta_cf(b, a, 1.0 - x) / b
+
+
+def t_upper_tail(t, df):
+    """P(T > t) for Student's t with df degrees of freedom."""
+    tail = 0.5 * _betainc(0.5 * df, 0.5, df / (df + t * t))
+    return tail if t > 0 else 1.0 - tail
+
+
+def welch_p_slower(base, cand):
+    """One-sided p-value of 'candidate mean > baseline mean'."""
+    se2 = base.var / base.n + cand.var / cand.n
+    if se2 <= 0.0:
+        return 0.0 if cand.mean > base.mean else 1.0
+    t = (cand.mean - base.mean) / math.sqrt(se2)
+    df = se2 ** 2 / ((base.var / base.n) ** 2 / (base.n - 1) + (cand.var / cand.n) ** 2 / (cand.n - 1))
+    return t_upper_tail(t, df)
+
+
+# --- Loading runs ---
+def _sf_label(sf):
+    return f"SF-{float(sf):g}"
+
+
+def load_records(path):
+    """Records written by --results: key -> Summary.
+
+    A key with one record uses that record's sample distribution for its total
+    time; keys repeated across records (appended runs) use one median per record.
+    """
+    totals, stages = {}, {}
+    with open(path, newline='') as f:
+        if path.endswith('.csv'):
+            rows = []
+            for r in csv.DictReader(f):
+                stage_ms = {}
+                for item in filter(None, r['stages'].split(';')):
+                    name, value = item.split('=')
+                    stage_ms[name] = float(value)
+                time_ms = {'n': int(r['samples']), 'mean': float(r['mean_ms']), 'median': float(r['median_ms']),
+                           'stddev': float(r['stddev_ms'])}
+                rows.append((r, time_ms, stage_ms))
+        else:
+            rows = []
+            for line in f:
+                if line.strip():
+                    r = json.loads(line)
+                    rows.append((r, r['time_ms'], r['stages_ms']))
+    for r, time_ms, stage_ms in rows:
+        query = r['query'].upper() + ('' if r['backend'] == 'gpu' else f" ({r['backend']})")
+        if r.get('params'):
+            query += f" [{r['params']}]"
+        base = (_sf_label(r['scale_factor']), query)
+        totals.setdefault(base + ('total',), []).append(time_ms)
+        for name, value in stage_ms.items():
+            stages.setdefault(base + (name,), []).append(value)
+    out = {}
+    for key, entries in totals.items():
+        if len(entries) == 1:
+            e = entries[0]
+            var = e['stddev'] ** 2 if e['n'] > 1 else None
+            out[key] = Summary(e['n'], e['mean'], var, e['median'])
+        else:
+            out[key] = Summary.of([e['median'] for e in entries])
+    for key, values in stages.items():
+        out[key] = Summary.of(values)
+    return out
+
+
+def load_history(path, selector):
+    """Rows of a timestamped history CSV for the selected runs: key -> Summary."""
+    with open(path, newline='') as f:
+        rows = list(csv.DictReader(f))
+    stamps = sorted({r['timestamp'] for r in rows})
+    if not stamps:
+        raise ValueError(f"no runs in {path}")
+    if selector == 'latest':
+        chosen = stamps[-1:]
+    elif selector == 'previous':
+        if len(stamps) < 2:
+            raise ValueError(f"{path} holds a single run; there is no previous one")
+        chosen = stamps[-2:-1]
+    elif selector.startswith('last:'):
+        chosen = stamps[-int(selector[5:]):]
+    else:
+        chosen = selector.split(',')
+        missing = [s for s in chosen if s not in stamps]
+        if missing:
+            raise ValueError(f"run(s) not in {path}: {', '.join(missing)}")
+    values = {}
+    for r in rows:
+        if r['timestamp'] not in chosen:
+            continue
+        for column, stage in HISTORY_STAGES:
+            if r.get(column):
+                values.setdefault((r['scale_factor'], r['query'], stage), []).append(float(r[column]))
+    return {key: Summary.of(v) for key, v in values.items()}, chosen
+
+
+def load_run(spec, history):
+    if os.path.isfile(spec):
+        return load_records(spec), spec
+    runs, chosen = load_history(history, spec)
+    return runs, f"{os.path.basename(history)} @ {','.join(chosen)}"
+
+
+# --- Comparison ---
+def compare(base_runs, cand_runs, alpha, min_slowdown, single_threshold, min_delta_ms):
+    results = []
+    for key in sorted(set(base_runs) & set(cand_runs)):
+        base, cand = base_runs[key], cand_runs[key]
+        if base.median <= 0:
+            continue
+        change = cand.median / base.median - 1.0
+        if base.var is not None and cand.var is not None:
+            p = welch_p_slower(base, cand)
+            significant = p < alpha
+            test = f"welch p={p:.3g}"
+        else:
+            # Single sample on at least one side: widen the threshold by three
+            # coefficients of variation of whichever side has them
+            noise = max([3.0 * s.cv() for s in (base, cand) if s.cv() is not None] + [single_threshold])
+            significant = change > noise
+            test = f"threshold {100 * noise:.0f}%"
+        large = abs(cand.median - base.median) >= min_delta_ms
+        regression = significant and change > min_slowdown and large
+        improvement = large and cand.median < base.median * (1.0 - min_slowdown) and (
+            base.var is None or cand.var is None or welch_p_slower(cand, base) < alpha)
+        results.append((key, base, cand, change, test, regression, improvement))
+    return results
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    parser.add_argument('baseline', help="records file, or history run selector (timestamp[,timestamp..], latest, previous, last:N)")
+    parser.add_argument('candidate', help="records file, or history run selector")
+    parser.add_argument('--history', default=default_history, help="timestamped history CSV (default: results/gpu_results.csv)")
+    parser.add_argument('--alpha', type=float, default=0.01, help="significance level of the t-test (default: 0.01)")
+    parser.add_argument('--min-slowdown', type=float, default=5.0, help="smallest slowdown in %% worth flagging (default: 5)")
+    parser.add_argument('--single-threshold', type=float, default=10.0,
+                        help="slowdown in %% flagged when a side has a single sample (default: 10)")
+    parser.add_argument('--min-delta-ms', type=float, default=0.1,
+                        help="ignore changes smaller than this many ms, below timer resolution (default: 0.1)")
+    args = parser.parse_args()
+
+    try:
+        base_runs, base_name = load_run(args.baseline, args.history)
+        cand_runs, cand_name = load_run(args.candidate, args.history)
+    except (OSError, ValueError, KeyError) as e:
+        print(f"Error: {e}", file=sys.stderr)
+        sys.exit(2)
+
+    results = compare(base_runs, cand_runs, args.alpha, args.min_slowdown / 100.0, args.single_threshold / 100.0,
+                      args.min_delta_ms)
+    if not results:
+        print("Error: the runs share no (scale factor, query, stage)", file=sys.stderr)
+        sys.exit(2)
+
+    print(f"Baseline:  {base_name}")
+    print(f"Candidate: {cand_name}\n")
+    print("| Scale | Query | Stage | Baseline (ms) | Candidate (ms) | Change | Test | Verdict |")
+    print("|------:|------:|------:|--------------:|---------------:|-------:|-----:|--------:|")
+    regressions = 0
+    for (sf, query, stage), base, cand, change, test, regression, improvement in results:
+        verdict = 'REGRESSION' if regression else 'faster' if improvement else 'ok'
+        regressions += regression
+        print(f"| {sf} | {query} | {stage} | {base.median:.2f} (n={base.n}) | {cand.median:.2f} (n={cand.n}) | "
+              f"{100 * change:+.1f}% | {test} | {verdict} |")
+    print(f"\n{regressions} regression(s) in {len(results)} comparison(s)")
+    sys.exit(1 if regressions else 0)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,359 @@
+#include "AsyncReader.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#define GPUDB_HAVE_IO_URING 1
+#endif
+
+namespace {
+
+// O_DIRECT needs block-aligned offsets, lengths and buffers
+constexpr size_t kAlign = 4096;
+
+double msSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+std::mutex g_statsMutex;
+ReadStats g_stats;
+
+// One in-flight block: [offset, offset + expected) of the file into data.
+// request is expected rounded up to whole blocks for O_DIRECT.
+struct Slot {
+    char* data = nullptr;
+    uint64_t offset = 0;
+    size_t expected = 0;
+    size_t request = 0;
+    long result = 0;   // bytes read, or -errno
+    bool done = false;
+};
+
+// pread until the slot is full or the file ends, continuing after a short read.
+void completeRead(int fd, Slot& s) {
+    size_t got = s.result > 0 ? (size_t)s.result : 0;
+    while (got < s.expected) {
+        ssize_t n = pread(fd, s.data + got, s.request - got, (off_t)(s.offset + got));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) { s.result = n < 0 ? -errno : (long)got; return; }
+        got += (size_t)n;
+    }
+    s.result = (long)std::min(got, s.expected);
+}
+
+class Engine {
+public:
+    virtual ~Engine() = default;
+    virtual void submit(Slot& s) = 0;
+    virtual void wait(Slot& s) = 0;
+};
+
+// Baseline: the read happens when the consumer asks for the block.
+class SyncEngine : public Engine {
+public:
+    explicit SyncEngine(int fd) : m_fd(fd) {}
+    void submit(Slot& s) override { s.result = 0; s.done = false; }
+    void wait(Slot& s) override { completeRead(m_fd, s); s.done = true; }
+
+private:
+    int m_fd;
+};
+
+// One pread thread per slot, woken when its slot is resubmitted.
+class ThreadEngine : public Engine {
+public:
+    ThreadEngine(int fd, std::vector<Slot>& slots) : m_fd(fd) {
+        for (Slot& s : slots) m_threads.emplace_back([this, &s] { run(s); });
+    }
+    ~ThreadEngine() override {
+        { std::lock_guard<std::mutex> lock(m_mutex); m_stop = true; }
+        m_cv.notify_all();
+        for (auto& t : m_threads) t.join();
+    }
+    void submit(Slot& s) override {
+        { std::lock_guard<std::mutex> lock(m_mutex); s.result = 0; s.done = false; m_requested.push_back(&s); }
+        m_cv.notify_all();
+    }
+    void wait(Slot& s) override {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cv.wait(lock, [&] { return s.done; });
+    }
+
+private:
+    void run(Slot& s) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        for (;;) {
+            m_cv.wait(lock, [&] { return m_stop || std::find(m_requested.begin(), m_requested.end(), &s) != m_requested.end(); });
+            if (m_stop) return;
+            m_requested.erase(std::find(m_requested.begin(), m_requested.end(), &s));
+            lock.unlock();
+            completeRead(m_fd, s);
+            lock.lock();
+            s.done = true;
+            m_cv.notify_all();
+        }
+    }
+
+    int m_fd;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::vector<Slot*> m_requested;
+    std::vector<std::thread> m_threads;
+    bool m_stop = false;
+};
+
+#ifdef GPUDB_HAVE_IO_URING
+// A minimal single-issuer io_uring: IORING_OP_READ (Linux 5.6+) per slot,
+// completions matched back by user_data. Short or failed reads are finished
+// with pread by the consumer.
+class UringEngine : public Engine {
+public:
+    UringEngine(int fd, std::vector<Slot>& slots) : m_fd(fd), m_slots(slots) {}
+    ~UringEngine() override {
+        if (m_sqes) munmap(m_sqes, m_sqesBytes);
+        if (m_cqRing && m_cqRing != m_sqRing) munmap(m_cqRing, m_cqBytes);
+        if (m_sqRing) munmap(m_sqRing, m_sqBytes);
+        if (m_ring >= 0) close(m_ring);
+    }
+
+    bool init() {
+        io_uring_params p{};
+        m_ring = (int)syscall(__NR_io_uring_setup, (unsigned)m_slots.size(), &p);
+        if (m_ring < 0) return false;
+        m_sqBytes = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+        m_cqBytes = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+        const bool single = p.features & IORING_FEAT_SINGLE_MMAP;
+        if (single) m_sqBytes = m_cqBytes = std::max(m_sqBytes, m_cqBytes);
+        m_sqRing = map(m_sqBytes, IORING_OFF_SQ_RING);
+        m_cqRing = single ? m_sqRing : map(m_cqBytes, IORING_OFF_CQ_RING);
+        m_sqesBytes = p.sq_entries * sizeof(io_uring_sqe);
+        m_sqes = static_cast<io_uring_sqe*>(map(m_sqesBytes, IORING_OFF_SQES));
+        if (!m_sqRing || !m_cqRing || !m_sqes) return false;
+        auto* sq = static_cast<char*>(m_sqRing);
+        auto* cq = static_cast<char*>(m_cqRing);
+        m_sqTail = reinterpret_cast<unsigned*>(sq + p.sq_off.tail);
+        m_sqMask = *reinterpret_cast<unsigned*>(sq + p.sq_off.ring_mask);
+        m_sqArray = reinterpret_cast<unsigned*>(sq + p.sq_off.array);
+        m_cqHead = reinterpret_cast<unsigned*>(cq + p.cq_off.head);
+        m_cqTail = reinterpret_cast<unsigned*>(cq + p.cq_off.tail);
+        m_cqMask = *reinterpret_cast<unsigned*>(cq + p.cq_off.ring_mask);
+        m_cqes = reinterpret_cast<io_uring_cqe*>(cq + p.cq_off.cqes);
+        return true;
+    }
+
+    void submit(Slot& s) override {
+        s.result = 0;
+        s.done = false;
+        const unsigned tail = *m_sqTail;
+        const unsigned index = tail & m_sqMask;
+        io_uring_sqe& sqe = m_sqes[index];
+        std::memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = IORING_OP_READ;
+        sqe.fd = m_fd;
+        sqe.addr = (uint64_t)(uintptr_t)s.data;
+        sqe.len = (unsigned)s.request;
+        sqe.off = s.offset;
+        sqe.user_data = (uint64_t)(&s - m_slots.data());
+        m_sqArray[index] = index;
+        __atomic_store_n(m_sqTail, tail + 1, __ATOMIC_RELEASE);
+        m_unsubmitted += 1;
+    }
+
+    void wait(Slot& s) override {
+        while (!s.done) {
+            long r = syscall(__NR_io_uring_enter, m_ring, m_unsubmitted, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+            if (r < 0) {
+                if (errno == EINTR) continue;
+                // The ring is unusable: finish every outstanding slot with pread
+                for (Slot& o : m_slots) { if (!o.done) { o.result = 0; o.done = true; } }
+                break;
+            }
+            m_unsubmitted -= std::min<unsigned>(m_unsubmitted, (unsigned)r);
+            unsigned head = *m_cqHead;
+            const unsigned tail = __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE);
+            for (; head != tail; ++head) {
+                const io_uring_cqe& cqe = m_cqes[head & m_cqMask];
+                Slot& done = m_slots[cqe.user_data];
+                done.result = cqe.res < 0 ? 0 : std::min<long>(cqe.res, (long)done.expected); // errors are retried with pread
+                done.done = true;
+            }
+            __atomic_store_n(m_cqHead, head, __ATOMIC_RELEASE);
+        }
+        if (s.result < (long)s.expected) completeRead(m_fd, s);
+    }
+
+private:
+    void* map(size_t bytes, off_t offset) {
+        void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ring, offset);
+        return p == MAP_FAILED ? nullptr : p;
+    }
+
+    int m_fd;
+    std::vector<Slot>& m_slots;
+    int m_ring = -1;
+    void* m_sqRing = nullptr;
+    void* m_cqRing = nullptr;
+    io_uring_sqe* m_sqes = nullptr;
+    size_t m_sqBytes = 0, m_cqBytes = 0, m_sqesBytes = 0;
+    unsigned* m_sqTail = nullptr;
+    unsigned* m_sqArray = nullptr;
+    unsigned m_sqMask = 0;
+    unsigned* m_cqHead = nullptr;
+    unsigned* m_cqTail = nullptr;
+    unsigned m_cqMask = 0;
+    io_uring_cqe* m_cqes = nullptr;
+    unsigned m_unsubmitted = 0;
+};
+#endif
+
+std::unique_ptr<Engine> makeEngine(ReadBackend& backend, int fd, std::vector<Slot>& slots) {
+#ifdef GPUDB_HAVE_IO_URING
+    if (backend == ReadBackend::IoUring) {
+        auto uring = std::make_unique<UringEngine>(fd, slots);
+        if (uring->init()) return uring;
+    }
+#endif
+    if (backend == ReadBackend::Sync) return std::make_unique<SyncEngine>(fd);
+    backend = ReadBackend::Threads; // also the io_uring fallback
+    return std::make_unique<ThreadEngine>(fd, slots);
+}
+
+} // namespace
+
+
+// --- Configuration ---
+AsyncReadConfig& asyncReadConfig() {
+    static AsyncReadConfig config;
+    return config;
+}
+
+bool parseReadBackend(const std::string& name, ReadBackend& out) {
+    if (name == "sync") out = ReadBackend::Sync;
+    else if (name == "threads") out = ReadBackend::Threads;
+    else if (name == "uring" || name == "io_uring") out = ReadBackend::IoUring;
+    else return false;
+    return true;
+}
+
+const char* readBackendName(ReadBackend backend) {
+    switch (backend) {
+        case ReadBackend::Sync: return "sync";
+        case ReadBackend::Threads: return "threads";
+        case ReadBackend::IoUring: return "uring";
+    }
+    return "?";
+}
+
+
+// --- Block Reads ---
+bool readFileBlocks(const std::string& path, uint64_t offset, const BlockConsumer& consume) {
+    const auto start = std::chrono::steady_clock::now();
+    const AsyncReadConfig& config = asyncReadConfig();
+    bool direct = config.direct;
+    int fd = -1;
+#ifdef O_DIRECT
+    if (direct) fd = open(path.c_str(), O_RDONLY | O_DIRECT);
+#endif
+    if (fd < 0) {
+        fd = open(path.c_str(), O_RDONLY);
+#ifndef __APPLE__
+        direct = false; // tmpfs and some others refuse O_DIRECT
+#endif
+    }
+    if (fd < 0) return false;
+#ifdef __APPLE__
+    if (direct) fcntl(fd, F_NOCACHE, 1);
+#endif
+    struct stat st {};
+    if (fstat(fd, &st) != 0) { close(fd); return false; }
+    const uint64_t size = (uint64_t)st.st_size;
+    const size_t block = std::max(kAlign, (config.blockBytes + kAlign - 1) / kAlign * kAlign);
+    const uint64_t first = direct ? offset / kAlign * kAlign : offset;
+    const uint64_t blocks = size > first ? (size - first + block - 1) / block : 0;
+    const unsigned depth = (unsigned)std::max<uint64_t>(1, std::min<uint64_t>(std::max(1u, config.queueDepth), blocks));
+
+    std::vector<Slot> slots(depth);
+    for (Slot& s : slots) s.data = static_cast<char*>(::operator new(block, std::align_val_t(kAlign)));
+    ReadBackend backend = config.backend;
+    bool ok = true;
+    double waitMs = 0.0;
+    {
+        std::unique_ptr<Engine> engine = makeEngine(backend, fd, slots);
+        auto issue = [&](uint64_t b) {
+            Slot& s = slots[b % depth];
+            s.offset = first + b * block;
+            s.expected = (size_t)std::min<uint64_t>(block, size - s.offset);
+            s.request = direct ? (s.expected + kAlign - 1) / kAlign * kAlign : s.expected;
+            engine->submit(s);
+        };
+        for (uint64_t b = 0; b < std::min<uint64_t>(depth, blocks); ++b) issue(b);
+        for (uint64_t b = 0; b < blocks && ok; ++b) {
+            Slot& s = slots[b % depth];
+            const auto waitStart = std::chrono::steady_clock::now();
+            engine->wait(s);
+            waitMs += msSince(waitStart);
+            if (s.result != (long)s.expected) {
+                fprintf(stderr, "Error: read of %s failed at offset %llu: %s\n", path.c_str(), (unsigned long long)s.offset,
+                        s.result < 0 ? std::strerror((int)-s.result) : "unexpected end of file");
+                ok = false;
+                break;
+            }
+            const size_t skip = b == 0 ? (size_t)(offset - first) : 0;
+            if (s.expected > skip) consume(s.data + skip, s.expected - skip);
+            if (b + depth < blocks) issue(b + depth);
+        }
+        if (!ok) {
+            for (Slot& s : slots) { if (!s.done) engine->wait(s); } // no read may outlive its buffer
+        }
+    }
+    for (Slot& s : slots) ::operator delete(s.data, std::align_val_t(kAlign));
+    close(fd);
+
+    std::lock_guard<std::mutex> lock(g_statsMutex);
+    g_stats.files += 1;
+    g_stats.directFiles += direct ? 1 : 0;
+    g_stats.bytes += size > offset ? size - offset : 0;
+    g_stats.wallMs += msSince(start);
+    g_stats.waitMs += waitMs;
+    g_stats.backend = backend;
+    return ok;
+}
+
+
+// --- Statistics ---
+ReadStats takeReadStats() {
+    std::lock_guard<std::mutex> lock(g_statsMutex);
+    ReadStats s = g_stats;
+    g_stats = ReadStats{};
+    return s;
+}
+
+void printReadStats(const char* label, const ReadStats& stats) {
+    if (stats.files == 0) return;
+    const AsyncReadConfig& config = asyncReadConfig();
+    char direct[64] = "";
+    if (config.direct) {
+        snprintf(direct, sizeof(direct), ", direct %llu/%llu files", (unsigned long long)stats.directFiles,
+                 (unsigned long long)stats.files);
+    }
+    printf("%s (%s%s, qd %u, %zu KB blocks): %llu files, %.1f MB in %.1f ms, waiting for I/O %.1f ms\n", label,
+           readBackendName(stats.backend), direct, config.queueDepth, config.blockBytes >> 10,
+           (unsigned long long)stats.files, stats.bytes / double(1 << 20), stats.wallMs, stats.waitMs);
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "ColumnCatalog.hpp"
+#include "TpchParams.hpp"
+
+// --- CPU Auto-Tuner ---
+// Searches the CpuTuning knobs of each query on this machine and dataset:
+// worker count, morsel size, the Q3/Q9 probe prefetch distance and the Q13
+// local count table. One knob at a time from the hand-set defaults (coordinate
+// descent), each candidate timed as the best of a few executions after a
+// warm-up, within a budget of candidates per query; a candidate replaces the
+// best only when it is more than 2% faster, and the final winner is timed
+// against the defaults once more and kept only if it still is (two extra
+// candidates beyond the budget). The winners go to a profile file
+// that later runs load at startup, so plain `q3 --backend cpu` runs with the
+// tuned settings. Profiles record the machine (CPU model and core count) and
+// the scale factor and are ignored on another machine or dataset; a loaded
+// profile lists its knobs, and the CPU query banners show the tuned ones.
+
+constexpr const char* kDefaultTuningProfile = "cpu-tuning.profile";
+
+struct TuneConfig {
+    std::vector<std::string> queries{"q1", "q3", "q6", "q9", "q13"};
+    unsigned budget = 12; // candidates per query, the defaults included
+    unsigned reps = 3;    // timed executions per candidate (best of)
+    unsigned maxThreads = 0; // worker counts tried: 1, 2, 4, ... up to this; 0 = hardware concurrency
+    std::string profilePath = kDefaultTuningProfile;
+};
+
+// Tunes every query (with the first parameter set), prints the search and writes the profile.
+bool runAutoTune(const TuneConfig& config, ColumnCatalog& catalog, const TpchParams& params);
+
+// Applies a profile to cpuTuning() and prints its knobs; false (with a note
+// unless the file is missing) when it cannot be read or was tuned on another
+// machine or scale factor.
+bool loadTuningProfile(const std::string& path);
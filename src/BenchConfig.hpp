@@ -0,0 +1,15 @@
+#pragma once
+
+#include <string>
+
+#include "BenchHarness.hpp"
+#include "ResultLog.hpp"
+
+// Global run configuration, set once by main() from the command line and
+// read by every benchmark (GPU and CPU backends alike).
+extern std::string g_dataset_path; // e.g. "data/SF-1/"
+extern HarnessConfig g_harness;    // warm-up, repetitions, time budget, cold cache
+extern ResultLog g_results;        // --results target, disabled by default
+
+// Scale factor parsed from g_dataset_path ("data/SF-10/" -> 10.0); 1.0 if unknown.
+double datasetScaleFactor();
@@ -0,0 +1,106 @@
+#include "BenchHarness.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <numeric>
+
+#include "BenchConfig.hpp"
+#include "Numa.hpp"
+#include "PerfCounters.hpp"
+#include "Roofline.hpp"
+
+namespace {
+
+// Two-sided 95% Student t critical values for 1..30 degrees of freedom
+const double kT95[] = {12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+                       2.201,  2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+                       2.080,  2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+
+double t95(size_t dof) { return dof == 0 ? 0.0 : dof <= 30 ? kT95[dof - 1] : 1.960; }
+
+} // namespace
+
+double percentile(std::vector<double> samples, double p) {
+    if (samples.empty()) return 0.0;
+    std::sort(samples.begin(), samples.end());
+    double rank = p * (double)(samples.size() - 1);
+    size_t lo = (size_t)rank, hi = std::min(lo + 1, samples.size() - 1);
+    return samples[lo] + (samples[hi] - samples[lo]) * (rank - (double)lo);
+}
+
+SampleStats computeStats(const std::vector<double>& samples, bool rejectOutliers) {
+    SampleStats s;
+    std::vector<double> kept = samples;
+    if (rejectOutliers && kept.size() >= 5) {
+        double q1 = percentile(kept, 0.25), q3 = percentile(kept, 0.75);
+        double lo = q1 - 1.5 * (q3 - q1), hi = q3 + 1.5 * (q3 - q1);
+        kept.erase(std::remove_if(kept.begin(), kept.end(), [&](double v) { return v < lo || v > hi; }), kept.end());
+    }
+    s.n = kept.size();
+    s.rejected = samples.size() - kept.size();
+    if (kept.empty()) return s;
+
+    std::sort(kept.begin(), kept.end());
+    s.min = kept.front();
+    s.max = kept.back();
+    s.median = percentile(kept, 0.5);
+    s.p95 = percentile(kept, 0.95);
+    s.p99 = percentile(kept, 0.99);
+    s.mean = std::accumulate(kept.begin(), kept.end(), 0.0) / (double)s.n;
+    if (s.n > 1) {
+        double sq = 0.0;
+        for (double v : kept) sq += (v - s.mean) * (v - s.mean);
+        s.stddev = std::sqrt(sq / (double)(s.n - 1));
+        s.ciHalfWidth = t95(s.n - 1) * s.stddev / std::sqrt((double)s.n);
+    }
+    return s;
+}
+
+void printStats(const std::string& label, const SampleStats& s) {
+    printf("%s: n=%zu", label.c_str(), s.n);
+    if (s.rejected) printf(" (%zu outliers rejected)", s.rejected);
+    printf(", min %0.3f, median %0.3f, mean %0.3f +/- %0.3f (95%% CI), p95 %0.3f, p99 %0.3f, stddev %0.3f ms\n",
+           s.min, s.median, s.mean, s.ciHalfWidth, s.p95, s.p99, s.stddev);
+}
+
+void flushCaches(size_t bytes) {
+    static std::unique_ptr<volatile char[]> buffer;
+    static size_t size = 0;
+    if (size < bytes) { buffer.reset(new volatile char[bytes]); size = bytes; }
+    // Write then read every cache line so both clean and dirty lines get evicted
+    for (size_t i = 0; i < bytes; i += 64) buffer[i] = (char)i;
+    char sink = 0;
+    for (size_t i = 0; i < bytes; i += 64) sink ^= buffer[i];
+    (void)sink;
+}
+
+
+// --- Benchmark Loop ---
+BenchLoop::BenchLoop(const HarnessConfig& config) : m_config(config) {}
+BenchLoop::BenchLoop() : BenchLoop(g_harness) {}
+
+bool BenchLoop::next() {
+    m_span.reset();
+    const int measured = m_executed - m_config.warmup;
+    if (measured >= m_config.repetitions) {
+        if (m_config.timeBudgetMs <= 0.0 || m_samples.size() >= kMaxSamples) return false;
+        double spent = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_measureStart).count();
+        if (spent >= m_config.timeBudgetMs) return false;
+    }
+    if (m_executed == m_config.warmup) {
+        m_measureStart = std::chrono::steady_clock::now();
+        resetPerfStages(); // counters and roofline times cover measured executions only
+        resetStageTimes();
+        resetNumaStats();
+    }
+    if (m_config.coldCache) flushCaches(m_config.flushBytes);
+    ++m_executed;
+    if (traceEnabled()) m_span.emplace(warmup() ? "warm-up" : "execution", "harness");
+    return true;
+}
+
+void BenchLoop::record(double ms) {
+    if (!warmup()) m_samples.push_back(ms);
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "Trace.hpp"
+
+// --- Measurement Harness ---
+// Every benchmark loop runs `warmup` unmeasured executions followed by at least
+// `repetitions` measured ones; with a time budget it keeps measuring until the
+// budget is spent. Reported times are the median of the kept samples, and the
+// full distribution (min, median, mean with confidence interval, p95, p99,
+// standard deviation) is printed next to them. Cold-cache mode streams through
+// a flush buffer larger than the last-level cache before every execution.
+
+struct HarnessConfig {
+    int warmup = 2;             // unmeasured executions
+    int repetitions = 1;        // minimum measured executions
+    double timeBudgetMs = 0.0;  // > 0: keep measuring until this much wall time is spent
+    bool coldCache = false;     // evict CPU caches before every execution
+    size_t flushBytes = size_t(256) << 20;
+    bool rejectOutliers = true; // drop samples outside Tukey's fences (1.5 x IQR)
+
+    // One measured execution, no warm-up (throughput and refresh streams time queries themselves).
+    static HarnessConfig single() { HarnessConfig c; c.warmup = 0; c.repetitions = 1; return c; }
+};
+
+struct SampleStats {
+    size_t n = 0;        // samples kept
+    size_t rejected = 0; // outliers dropped
+    double min = 0.0, max = 0.0, median = 0.0, mean = 0.0, p95 = 0.0, p99 = 0.0, stddev = 0.0;
+    double ciHalfWidth = 0.0; // 95% confidence interval of the mean: mean +/- ciHalfWidth
+};
+
+// Linear-interpolated percentile, p in [0, 1].
+double percentile(std::vector<double> samples, double p);
+SampleStats computeStats(const std::vector<double>& samples, bool rejectOutliers);
+// "<label>: n=.. min .. median .. mean .. +/- .. p95 .. p99 .. stddev .. ms"
+void printStats(const std::string& label, const SampleStats& stats);
+
+// Streams through a static buffer of `bytes` so later accesses miss in cache.
+void flushCaches(size_t bytes);
+
+// Drives one benchmark loop:
+//
+//     BenchLoop loop;
+//     while (loop.next()) { ...execute...; loop.record(ms); }
+//     double ms = loop.stats().median;
+//
+// record() is ignored during warm-up executions. While tracing, every execution
+// is a "warm-up" or "execution" span.
+class BenchLoop {
+public:
+    explicit BenchLoop(const HarnessConfig& config);
+    BenchLoop();
+
+    bool next();
+    bool warmup() const { return m_executed <= m_config.warmup; }
+    void record(double ms);
+    // The current execution does not count (e.g. it overflowed a buffer sized from an estimate); the next one repeats it.
+    void retry() { if (m_executed > 0) --m_executed; }
+
+    const std::vector<double>& samples() const { return m_samples; }
+    SampleStats stats() const { return computeStats(m_samples, m_config.rejectOutliers); }
+    void print(const std::string& label) const { printStats(label, stats()); }
+
+private:
+    static constexpr size_t kMaxSamples = 100000;
+
+    HarnessConfig m_config;
+    int m_executed = 0;
+    std::vector<double> m_samples;
+    std::chrono::steady_clock::time_point m_measureStart;
+    std::optional<TraceSpan> m_span; // current execution
+};
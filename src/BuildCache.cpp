@@ -0,0 +1,96 @@
+#include "BuildCache.hpp"
+
+#include <cstdio>
+
+#include "Trace.hpp"
+
+void BuildPhaseTimer::print(const char* query) const {
+    char cold[32] = "n/a (already cached)", warm[32] = "n/a";
+    if (coldMs >= 0.0) snprintf(cold, sizeof(cold), "%0.2f ms", coldMs);
+    if (warmMs >= 0.0) snprintf(warm, sizeof(warm), "%0.2f ms", warmMs);
+    printf("%s build phase: cold %s, warm %s\n", query, cold, warm);
+}
+
+std::shared_ptr<const void> BuildCache::lookup(const BuildKey& key, const std::function<std::shared_ptr<const void>(size_t&)>& build) {
+    std::shared_ptr<Slot> slot;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_budget == 0) slot = std::make_shared<Slot>(); // caching disabled: private, never retained
+        else {
+            auto& s = m_slots[key.str()];
+            if (!s) { s = std::make_shared<Slot>(); s->table = key.table; }
+            slot = s;
+            slot->lastUse = ++m_tick;
+        }
+    }
+
+    std::call_once(slot->once, [&] {
+        TraceSpan span("build", "build");
+        if (span.active()) span.arg("key", key.str());
+        size_t bytes = 0;
+        slot->value = build(bytes);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        slot->bytes = bytes;
+        auto it = m_slots.find(key.str());
+        if (it != m_slots.end() && it->second == slot) { // not invalidated while building
+            slot->ready = true;
+            m_bytes += bytes;
+            evictLocked(slot.get());
+        }
+    });
+    return slot->value;
+}
+
+void BuildCache::eraseLocked(std::map<std::string, std::shared_ptr<Slot>>::iterator it) {
+    if (it->second->ready) m_bytes -= it->second->bytes;
+    m_slots.erase(it); // in-flight users keep the value alive through their own shared_ptr
+}
+
+void BuildCache::evictLocked(const Slot* keep) {
+    while (m_bytes > m_budget) {
+        auto victim = m_slots.end();
+        for (auto it = m_slots.begin(); it != m_slots.end(); ++it) {
+            if (!it->second->ready || it->second.get() == keep) continue;
+            if (victim == m_slots.end() || it->second->lastUse < victim->second->lastUse) victim = it;
+        }
+        if (victim == m_slots.end()) break; // only the newest entry left; keep it even if over budget
+        eraseLocked(victim);
+    }
+}
+
+void BuildCache::invalidateTable(const std::string& table) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto it = m_slots.begin(); it != m_slots.end();) {
+        auto next = std::next(it);
+        if (it->second->table == table) eraseLocked(it);
+        it = next;
+    }
+}
+
+void BuildCache::clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_slots.clear();
+    m_bytes = 0;
+}
+
+void BuildCache::setBudgetBytes(size_t budgetBytes) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_budget = budgetBytes;
+    if (m_budget == 0) { m_slots.clear(); m_bytes = 0; }
+    else evictLocked(nullptr);
+}
+
+size_t BuildCache::budgetBytes() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_budget;
+}
+
+size_t BuildCache::retainedBytes() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_bytes;
+}
+
+size_t BuildCache::entries() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_slots.size();
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+// --- Build-Side Structure Cache ---
+// Join build structures (bitmaps, direct maps, hash tables) depend only on
+// immutable dimension columns and the query's predicate parameters, so they
+// can be built once and probed by every later or concurrent execution.
+//
+// Entries are keyed by (structure kind, source table + columns, predicate
+// parameters, table data version). Concurrent lookups of a missing key share
+// one build; the others block on that entry only. Every refresh or merge of a
+// table bumps its data version and drops that table's entries.
+// Retained bytes are bounded by an LRU budget; 0 disables caching.
+
+struct BuildKey {
+    std::string kind;    // e.g. "gpu.q3.orders_map"; identifies the structure type
+    std::string table;   // source table, for invalidation
+    std::string columns; // source columns, e.g. "o_orderkey,o_orderdate"
+    std::string params;  // predicate parameters, e.g. "o_orderdate<19950315"
+    uint64_t version = 0;
+
+    std::string str() const { return kind + "|" + table + "(" + columns + ")|" + params + "|v" + std::to_string(version); }
+};
+
+// Build-phase outcome of one execution, summed over its cache lookups.
+struct BuildStats {
+    double ms = 0.0; // lookups plus any builds
+    int built = 0;   // misses
+    int reused = 0;  // hits
+};
+
+// Separates cold (something was built) from warm (all hits) build-phase time
+// across the iterations of one benchmark run.
+struct BuildPhaseTimer {
+    double coldMs = -1.0;
+    double warmMs = -1.0;
+
+    void record(const BuildStats& s) {
+        if (s.built > 0) { if (coldMs < 0.0) coldMs = s.ms; }
+        else warmMs = s.ms;
+    }
+    void print(const char* query) const;
+};
+
+class BuildCache {
+public:
+    static constexpr size_t kDefaultBudgetBytes = size_t(4096) << 20;
+
+    explicit BuildCache(size_t budgetBytes = kDefaultBudgetBytes) : m_budget(budgetBytes) {}
+
+    BuildCache(const BuildCache&) = delete;
+    BuildCache& operator=(const BuildCache&) = delete;
+
+    // build(size_t& bytes) -> std::shared_ptr<T>; must report the retained size.
+    template <typename T, typename BuildFn>
+    std::shared_ptr<const T> getOrBuild(const BuildKey& key, BuildFn&& build, BuildStats* stats = nullptr) {
+        auto start = std::chrono::high_resolution_clock::now();
+        bool built = false;
+        std::shared_ptr<const void> value = lookup(key, [&](size_t& bytes) -> std::shared_ptr<const void> {
+            built = true;
+            return build(bytes);
+        });
+        if (stats) {
+            stats->ms += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+            (built ? stats->built : stats->reused) += 1;
+        }
+        return std::static_pointer_cast<const T>(value);
+    }
+
+    void invalidateTable(const std::string& table);
+    void clear();
+
+    void setBudgetBytes(size_t budgetBytes);
+    size_t budgetBytes() const;
+    size_t retainedBytes() const;
+    size_t entries() const;
+
+private:
+    struct Slot {
+        std::once_flag once;
+        std::shared_ptr<const void> value;
+        std::string table;
+        size_t bytes = 0;
+        uint64_t lastUse = 0;
+        bool ready = false; // guarded by m_mutex
+    };
+
+    std::shared_ptr<const void> lookup(const BuildKey& key, const std::function<std::shared_ptr<const void>(size_t&)>& build);
+    void evictLocked(const Slot* keep);
+    void eraseLocked(std::map<std::string, std::shared_ptr<Slot>>::iterator it);
+
+    mutable std::mutex m_mutex;
+    std::map<std::string, std::shared_ptr<Slot>> m_slots;
+    size_t m_budget;
+    size_t m_bytes = 0;
+    uint64_t m_tick = 0;
+};
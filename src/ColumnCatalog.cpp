@@ -0,0 +1,713 @@
+#include "ColumnCatalog.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+#include <string_view>
+
+#include "AsyncReader.hpp"
+#include "HugePages.hpp"
+#include "Numa.hpp"
+#include "Trace.hpp"
+
+// --- Row Estimate for Text Parsers ---
+// Reserving from the remaining stream length and the first line avoids growing
+// each column by repeated reallocation (and copying) while parsing. Streams
+// that cannot seek are parsed without a reservation.
+namespace {
+size_t estimateRows(std::istream& file) {
+    const std::streampos start = file.tellg();
+    if (start < 0) return 0;
+    file.seekg(0, std::ios::end);
+    const std::streampos end = file.tellg();
+    file.seekg(start);
+    std::string first;
+    if (end <= start || !std::getline(file, first)) { file.clear(); file.seekg(start); return 0; }
+    file.seekg(start);
+    const size_t bytes = (size_t)(end - start);
+    const size_t rows = bytes / (first.size() + 1);
+    return rows + rows / 8 + 1; // slack for lines longer than the first
+}
+} // namespace
+
+// --- Helper to Parse Integer Column ---
+std::vector<int> parseIntColumn(std::istream& file, int columnIndex) {
+    std::vector<int> data;
+    data.reserve(estimateRows(file));
+    std::string line;
+    while (std::getline(file, line)) {
+        std::string token; int currentCol = 0; size_t start = 0; size_t end = line.find('|');
+        while (end != std::string::npos) {
+            if (currentCol == columnIndex) { token = line.substr(start, end - start); data.push_back(std::stoi(token)); break; }
+            start = end + 1; end = line.find('|', start); currentCol++;
+        }
+    }
+    return data;
+}
+
+// --- Helper to Parse Float Column ---
+std::vector<float> parseFloatColumn(std::istream& file, int columnIndex) {
+    std::vector<float> data;
+    data.reserve(estimateRows(file));
+    std::string line;
+    while (std::getline(file, line)) {
+        std::string token; int currentCol = 0; size_t start = 0; size_t end = line.find('|');
+        while (end != std::string::npos) {
+            if (currentCol == columnIndex) { token = line.substr(start, end - start); data.push_back(std::stof(token)); break; }
+            start = end + 1; end = line.find('|', start); currentCol++;
+        }
+    }
+    return data;
+}
+
+// Helper to Parse char columns
+std::vector<char> parseCharColumn(std::istream& file, int columnIndex, int fixed_width) {
+    std::vector<char> data;
+    data.reserve(estimateRows(file) * (size_t)std::max(fixed_width, 1));
+    std::string line; while (std::getline(file, line)) { std::string token; int currentCol = 0; size_t start = 0; size_t end = line.find('|');
+        while (end != std::string::npos) { if (currentCol == columnIndex) { token = line.substr(start, end - start);
+            if (fixed_width > 0) { for (size_t i = 0; i < (size_t)fixed_width; ++i) data.push_back(i < token.length() ? token[i] : '\0'); }
+            else { data.push_back(token[0]);
+            }
+            break;
+        }
+            start = end + 1; end = line.find('|', start); currentCol++;
+        }
+    }
+    return data;
+}
+
+// Helper to Parse date columns (as integers for simplicity, e.g., 19980315)
+std::vector<int> parseDateColumn(std::istream& file, int columnIndex) {
+    std::vector<int> data;
+    data.reserve(estimateRows(file));
+    std::string line;
+    while (std::getline(file, line)) {
+        std::string token; int currentCol = 0; size_t start = 0; size_t end = line.find('|');
+        while (end != std::string::npos) {
+            if (currentCol == columnIndex) {
+                token = line.substr(start, end - start);
+                token.erase(std::remove(token.begin(), token.end(), '-'), token.end());
+                data.push_back(std::stoi(token));
+                break;
+            }
+            start = end + 1; end = line.find('|', start); currentCol++;
+        }
+    }
+    return data;
+}
+
+
+// --- Column Specs and Delta Application ---
+namespace {
+
+struct ColumnSpec {
+    int column;
+    char kind; // 'i' int, 'f' float, 'd' date, 'c' char
+    int width; // fixed width for 'c'; 0 = single char
+
+    std::string key() const { return std::to_string(column) + ":" + kind + std::to_string(width); }
+    size_t rowWidth() const { return (kind == 'c' && width > 0) ? (size_t)width : 1; }
+};
+
+// Main columns follow the NUMA placement policy and the huge-page mode (no-ops by default)
+void placeColumn(const ColumnData& data, const ColumnSpec& spec) {
+    const void* values = data.chars.data();
+    size_t rows = data.chars.size() / spec.rowWidth(), rowBytes = spec.rowWidth();
+    if (!data.ints.empty()) { values = data.ints.data(); rows = data.ints.size(); rowBytes = sizeof(int); }
+    else if (!data.floats.empty()) { values = data.floats.data(); rows = data.floats.size(); rowBytes = sizeof(float); }
+    placeColumnPages(values, rows, rowBytes);
+    adviseHugePages(values, rows * rowBytes);
+}
+
+std::shared_ptr<ColumnData> parseColumn(std::istream& in, const ColumnSpec& spec) {
+    auto out = std::make_shared<ColumnData>();
+    switch (spec.kind) {
+        case 'i': out->ints = parseIntColumn(in, spec.column); break;
+        case 'd': out->ints = parseDateColumn(in, spec.column); break;
+        case 'f': out->floats = parseFloatColumn(in, spec.column); break;
+        default:  out->chars = parseCharColumn(in, spec.column, spec.width); break;
+    }
+    return out;
+}
+
+std::shared_ptr<ColumnData> parseLines(const DeltaRows& rows, const ColumnSpec& spec) {
+    std::string text;
+    for (const auto& line : rows.lines) { text += line; text += '\n'; }
+    std::istringstream in(text);
+    return parseColumn(in, spec);
+}
+
+template <typename T>
+void keepVisible(const std::vector<T>& main, const std::vector<T>* delta, const std::vector<uint64_t>* deleted,
+                 size_t width, std::vector<T>& out) {
+    const size_t mainRows = main.size() / width;
+    const size_t deltaRows = delta ? delta->size() / width : 0;
+    auto isDeleted = [&](size_t row) { return deleted && ((*deleted)[row >> 6] >> (row & 63)) & 1u; };
+    out.reserve((mainRows + deltaRows) * width);
+    for (size_t r = 0; r < mainRows; ++r) {
+        if (!isDeleted(r)) out.insert(out.end(), main.begin() + r * width, main.begin() + (r + 1) * width);
+    }
+    for (size_t r = 0; r < deltaRows; ++r) {
+        if (!isDeleted(mainRows + r)) out.insert(out.end(), delta->begin() + r * width, delta->begin() + (r + 1) * width);
+    }
+}
+
+// Main rows whose delete bit is clear, then delta rows whose delete bit is clear.
+// Used for merges, lineage replay and the visible (GPU upload) columns alike, so
+// all of them agree on row order.
+std::shared_ptr<ColumnData> applyDelta(const ColumnData& main, const ColumnData* delta,
+                                       const std::vector<uint64_t>* deleted, const ColumnSpec& spec) {
+    auto out = std::make_shared<ColumnData>();
+    const size_t w = spec.rowWidth();
+    keepVisible(main.ints, delta ? &delta->ints : nullptr, deleted, w, out->ints);
+    keepVisible(main.floats, delta ? &delta->floats : nullptr, deleted, w, out->floats);
+    keepVisible(main.chars, delta ? &delta->chars : nullptr, deleted, w, out->chars);
+    return out;
+}
+
+struct LazyColumn {
+    std::once_flag once;
+    std::shared_ptr<const ColumnData> data;
+    std::shared_ptr<const ColumnStats> stats; // int and date columns
+};
+
+// Statistics are collected whenever an int or date column is materialised.
+std::shared_ptr<const ColumnStats> collectStats(const ColumnData& data, const ColumnSpec& spec) {
+    if (spec.kind != 'i' && spec.kind != 'd') return nullptr;
+    return std::make_shared<const ColumnStats>(computeColumnStats(data.ints.data(), data.ints.size()));
+}
+
+struct BinaryHeader {
+    char magic[8];
+    char kind;
+    char pad[3];
+    uint32_t width;
+};
+static_assert(sizeof(BinaryHeader) == 16, "binary column header is 16 bytes");
+const char kBinaryMagic[8] = {'G', 'P', 'U', 'D', 'B', 'C', 'O', 'L'};
+
+template <typename To, typename From>
+std::vector<To> castValues(const std::vector<From>& in) {
+    std::vector<To> out(in.size());
+    for (size_t i = 0; i < in.size(); ++i) out[i] = (To)in[i];
+    return out;
+}
+
+// A raw column in the shape spec asks for: numbers cast like the text parsers
+// would read them ("17.00" as int is 17), char rows cut or NUL-padded to width,
+// or reduced to their first character for width 0.
+std::shared_ptr<ColumnData> convertColumn(const RawColumn& raw, const ColumnSpec& spec) {
+    auto out = std::make_shared<ColumnData>();
+    if (spec.kind == 'c') {
+        if (raw.kind != 'c') return out;
+        const size_t from = (size_t)std::max(1, raw.width), to = spec.rowWidth(), rows = raw.data.chars.size() / from;
+        if (from == to) { out->chars = raw.data.chars; return out; }
+        out->chars.assign(rows * to, '\0');
+        const size_t n = std::min(from, to);
+        for (size_t r = 0; r < rows; ++r) std::copy_n(raw.data.chars.data() + r * from, n, out->chars.data() + r * to);
+    } else if (spec.kind == 'f') {
+        out->floats = raw.kind == 'f' ? raw.data.floats : castValues<float>(raw.data.ints);
+    } else {
+        out->ints = raw.kind == 'f' ? castValues<int>(raw.data.floats) : raw.data.ints;
+    }
+    return out;
+}
+
+// The spec's field of every line in a sequence of file blocks, converted like
+// the istream parsers above; a line cut by a block boundary is carried over
+// into the next block.
+class BlockLineParser {
+public:
+    BlockLineParser(const ColumnSpec& spec, ColumnData& out, size_t fileBytes) : m_spec(spec), m_out(out), m_fileBytes(fileBytes) {}
+
+    void block(const char* data, size_t bytes) {
+        std::string_view rest(data, bytes);
+        if (!m_reserved) reserve(rest);
+        if (!m_carry.empty()) {
+            const size_t nl = rest.find('\n');
+            m_carry.append(rest.substr(0, nl));
+            if (nl == std::string_view::npos) return;
+            line(m_carry);
+            m_carry.clear();
+            rest.remove_prefix(nl + 1);
+        }
+        for (size_t nl; (nl = rest.find('\n')) != std::string_view::npos; rest.remove_prefix(nl + 1)) line(rest.substr(0, nl));
+        m_carry.assign(rest);
+    }
+
+    void finish() {
+        if (!m_carry.empty()) line(m_carry);
+        m_carry.clear();
+    }
+
+private:
+    // Same estimate as estimateRows(): file length over the first line's length
+    void reserve(std::string_view first) {
+        m_reserved = true;
+        const size_t nl = first.find('\n');
+        if (nl == std::string_view::npos || m_fileBytes == 0) return;
+        const size_t rows = m_fileBytes / (nl + 1);
+        const size_t n = (rows + rows / 8 + 1) * (m_spec.kind == 'c' ? m_spec.rowWidth() : 1);
+        if (m_spec.kind == 'f') m_out.floats.reserve(n);
+        else if (m_spec.kind == 'c') m_out.chars.reserve(n);
+        else m_out.ints.reserve(n);
+    }
+
+    void line(std::string_view text) {
+        size_t start = 0;
+        for (int col = 0; col < m_spec.column; ++col) {
+            start = text.find('|', start);
+            if (start == std::string_view::npos) return;
+            start += 1;
+        }
+        const size_t end = text.find('|', start);
+        if (end == std::string_view::npos) return; // fields are '|'-terminated
+        std::string_view token = text.substr(start, end - start);
+        if (m_spec.kind == 'c') {
+            if (m_spec.width > 0) {
+                for (int i = 0; i < m_spec.width; ++i) m_out.chars.push_back(i < (int)token.size() ? token[i] : '\0');
+            } else {
+                m_out.chars.push_back(token.empty() ? '\0' : token[0]);
+            }
+            return;
+        }
+        char buffer[64];
+        size_t n = 0;
+        for (char ch : token) {
+            if (n + 1 == sizeof(buffer)) break;
+            if (m_spec.kind != 'd' || ch != '-') buffer[n++] = ch;
+        }
+        buffer[n] = '\0';
+        if (m_spec.kind == 'f') m_out.floats.push_back(std::strtof(buffer, nullptr));
+        else m_out.ints.push_back((int)std::strtol(buffer, nullptr, 10));
+    }
+
+    const ColumnSpec& m_spec;
+    ColumnData& m_out;
+    size_t m_fileBytes;
+    std::string m_carry;
+    bool m_reserved = false;
+};
+
+size_t fileBytes(const std::string& path) {
+    std::error_code ec;
+    const auto bytes = std::filesystem::file_size(path, ec);
+    return ec ? 0 : (size_t)bytes;
+}
+
+// Main column of a table file: its binary column if present, else the parsed
+// .tbl text, read ahead asynchronously while the blocks already read are parsed.
+std::shared_ptr<ColumnData> loadColumn(const std::string& tblPath, const ColumnSpec& spec) {
+    RawColumn raw;
+    if (readBinaryColumn(binaryColumnPath(tblPath, spec.column), raw)) return convertColumn(raw, spec);
+    auto out = std::make_shared<ColumnData>();
+    BlockLineParser parser(spec, *out, fileBytes(tblPath));
+    if (!readFileBlocks(tblPath, 0, [&](const char* data, size_t bytes) { parser.block(data, bytes); })) {
+        std::cerr << "Error: Could not open file " << tblPath << std::endl;
+        return std::make_shared<ColumnData>();
+    }
+    parser.finish();
+    return out;
+}
+
+} // namespace
+
+
+// --- Binary Column Files ---
+std::string binaryColumnPath(const std::string& tblPath, int column) {
+    std::string base = tblPath;
+    if (base.size() >= 4 && base.compare(base.size() - 4, 4, ".tbl") == 0) base.resize(base.size() - 4);
+    return base + "." + std::to_string(column) + ".col";
+}
+
+bool writeBinaryColumnHeader(FILE* out, char kind, int width) {
+    BinaryHeader h{};
+    std::copy_n(kBinaryMagic, 8, h.magic);
+    h.kind = kind;
+    h.width = (uint32_t)std::max(1, width);
+    return fwrite(&h, sizeof(h), 1, out) == 1;
+}
+
+bool readBinaryColumn(const std::string& path, RawColumn& out) {
+    FILE* in = fopen(path.c_str(), "rb");
+    if (!in) return false;
+    BinaryHeader h{};
+    bool ok = fread(&h, sizeof(h), 1, in) == 1 && std::equal(kBinaryMagic, kBinaryMagic + 8, h.magic) &&
+              (h.kind == 'i' || h.kind == 'f' || h.kind == 'c') && h.width > 0;
+    size_t bytes = 0;
+    if (ok) {
+        fseek(in, 0, SEEK_END);
+        bytes = (size_t)ftell(in) - sizeof(h);
+    }
+    fclose(in);
+    if (ok) {
+        // Values are read in blocks with several reads in flight, straight after the header
+        out.kind = h.kind;
+        out.width = (int)h.width;
+        out.data = ColumnData{};
+        char* dest = nullptr;
+        if (h.kind == 'i') { out.data.ints.resize(bytes / sizeof(int)); dest = reinterpret_cast<char*>(out.data.ints.data()); bytes = out.data.ints.size() * sizeof(int); }
+        else if (h.kind == 'f') { out.data.floats.resize(bytes / sizeof(float)); dest = reinterpret_cast<char*>(out.data.floats.data()); bytes = out.data.floats.size() * sizeof(float); }
+        else { out.data.chars.resize(bytes / h.width * h.width); dest = out.data.chars.data(); bytes = out.data.chars.size(); }
+        size_t filled = 0;
+        ok = readFileBlocks(path, sizeof(h), [&](const char* data, size_t n) {
+            n = std::min(n, bytes - filled); // a trailing partial value is dropped
+            std::memcpy(dest + filled, data, n);
+            filled += n;
+        }) && filled == bytes;
+    }
+    if (!ok) std::cerr << "Error: malformed binary column " << path << std::endl;
+    return ok;
+}
+
+
+// --- Loaders: one column of a table file ---
+std::vector<int> loadIntColumn(const std::string& filePath, int columnIndex) {
+    return std::move(loadColumn(filePath, {columnIndex, 'i', 0})->ints);
+}
+
+std::vector<float> loadFloatColumn(const std::string& filePath, int columnIndex) {
+    return std::move(loadColumn(filePath, {columnIndex, 'f', 0})->floats);
+}
+
+std::vector<char> loadCharColumn(const std::string& filePath, int columnIndex, int fixed_width) {
+    return std::move(loadColumn(filePath, {columnIndex, 'c', fixed_width})->chars);
+}
+
+std::vector<int> loadDateColumn(const std::string& filePath, int columnIndex) {
+    return std::move(loadColumn(filePath, {columnIndex, 'd', 0})->ints);
+}
+
+// Main columns of one table generation: the base .tbl file plus the merges
+// folded into it, replayed when a column is first loaded.
+class MainStore {
+public:
+    MainStore(std::string path, std::vector<MergeStep> lineage, std::shared_ptr<const MemoryTable> memory = nullptr)
+        : m_path(std::move(path)), m_lineage(std::move(lineage)), m_memory(std::move(memory)) {}
+
+    std::shared_ptr<const ColumnData> column(const ColumnSpec& spec) { return load(spec).data; }
+    const ColumnStats& stats(const ColumnSpec& spec) { return *load(spec).stats; }
+
+    void preset(const ColumnSpec& spec, std::shared_ptr<const ColumnData> data) {
+        LazyColumn& c = slot(spec);
+        std::call_once(c.once, [&] {
+            placeColumn(*data, spec);
+            c.stats = collectStats(*data, spec);
+            c.data = std::move(data);
+        });
+    }
+
+    // Columns loaded so far (a merge folds these eagerly).
+    std::vector<std::pair<ColumnSpec, std::shared_ptr<const ColumnData>>> loaded() {
+        std::vector<std::pair<ColumnSpec, std::shared_ptr<const ColumnData>>> out;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto& [key, entry] : m_columns) {
+            if (entry.second->data) out.emplace_back(entry.first, entry.second->data);
+        }
+        return out;
+    }
+
+    const std::string& path() const { return m_path; }
+    const std::vector<MergeStep>& lineage() const { return m_lineage; }
+    const std::shared_ptr<const MemoryTable>& memory() const { return m_memory; }
+
+private:
+    LazyColumn& load(const ColumnSpec& spec) {
+        LazyColumn& c = slot(spec);
+        std::call_once(c.once, [&] {
+            TraceSpan span("load", "load");
+            if (span.active()) span.arg("column", m_path + " #" + spec.key());
+            std::shared_ptr<const ColumnData> data;
+            if (!m_memory) data = loadColumn(m_path, spec);
+            else if ((size_t)spec.column < m_memory->columns.size()) data = convertColumn(m_memory->columns[spec.column], spec);
+            else data = std::make_shared<ColumnData>();
+            for (const auto& step : m_lineage) {
+                auto delta = step.appended ? parseLines(*step.appended, spec) : nullptr;
+                data = applyDelta(*data, delta.get(), step.deleted.get(), spec);
+            }
+            placeColumn(*data, spec);
+            c.stats = collectStats(*data, spec);
+            c.data = data;
+        });
+        return c;
+    }
+
+    LazyColumn& slot(const ColumnSpec& spec) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto& entry = m_columns[spec.key()];
+        if (!entry.second) entry = {spec, std::make_unique<LazyColumn>()};
+        return *entry.second;
+    }
+
+    std::string m_path;
+    std::vector<MergeStep> m_lineage;
+    std::shared_ptr<const MemoryTable> m_memory; // null = load from the files at m_path
+    std::mutex m_mutex;
+    std::map<std::string, std::pair<ColumnSpec, std::unique_ptr<LazyColumn>>> m_columns;
+};
+
+// One immutable table version. Delta and visible columns are derived lazily and
+// cached for the lifetime of the version.
+class TableState {
+public:
+    uint64_t version = 0;
+    std::shared_ptr<MainStore> main;
+    std::shared_ptr<const DeltaRows> delta;                // null = no inserts
+    std::shared_ptr<const std::vector<uint64_t>> deleted;  // null = no deletes
+    size_t deletedRows = 0;
+
+    size_t mainRows() { return main->column({0, 'i', 0})->ints.size(); }
+    size_t deltaRows() const { return delta ? delta->lines.size() : 0; }
+    bool hasDeltas() const { return delta || deleted; }
+
+    std::shared_ptr<const ColumnData> deltaColumn(const ColumnSpec& spec) {
+        static const auto kEmpty = std::make_shared<const ColumnData>();
+        if (!delta) return kEmpty;
+        return deltaSlot(spec).data;
+    }
+
+    std::shared_ptr<const ColumnData> visibleColumn(const ColumnSpec& spec) {
+        if (!hasDeltas()) return main->column(spec);
+        return visible(spec).data;
+    }
+
+    // Whether the column is non-decreasing over all positions (main, then delta rows);
+    // deleted rows keep their place, so the visible rows are sorted as well.
+    bool sortedBy(const ColumnSpec& spec) {
+        const ColumnStats& m = main->stats(spec);
+        if (!m.sorted) return false;
+        if (!delta) return true;
+        const ColumnStats& d = *deltaSlot(spec).stats;
+        return d.sorted && (d.empty() || m.empty() || d.min >= m.max);
+    }
+
+    // Statistics of the visible rows: the main column's own without deltas.
+    const ColumnStats& visibleStats(const ColumnSpec& spec) {
+        if (!hasDeltas()) return main->stats(spec);
+        return *visible(spec).stats;
+    }
+
+private:
+    LazyColumn& deltaSlot(const ColumnSpec& spec) {
+        return derived(m_delta, spec, [&] { return parseLines(*delta, spec); });
+    }
+
+    LazyColumn& visible(const ColumnSpec& spec) {
+        return derived(m_visible, spec, [&] {
+            TraceSpan span("materialize visible", "load");
+            return applyDelta(*main->column(spec), deltaColumn(spec).get(), deleted.get(), spec);
+        });
+    }
+
+    template <typename Fn>
+    LazyColumn& derived(std::map<std::string, std::unique_ptr<LazyColumn>>& cache, const ColumnSpec& spec, Fn&& make) {
+        LazyColumn* c;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto& slot = cache[spec.key()];
+            if (!slot) slot = std::make_unique<LazyColumn>();
+            c = slot.get();
+        }
+        std::call_once(c->once, [&] {
+            c->data = make();
+            c->stats = collectStats(*c->data, spec);
+        });
+        return *c;
+    }
+
+    std::mutex m_mutex;
+    std::map<std::string, std::unique_ptr<LazyColumn>> m_delta, m_visible;
+};
+
+
+// --- Table Snapshot ---
+namespace {
+template <typename T>
+ColumnView<T> makeView(TableState& s, const ColumnSpec& spec, std::vector<T> ColumnData::*member) {
+    const std::vector<T>& main = (*s.main->column(spec)).*member;
+    const std::vector<T>& delta = (*s.deltaColumn(spec)).*member;
+    ColumnView<T> v;
+    v.width = spec.rowWidth();
+    v.main = main.data();
+    v.mainRows = main.size() / v.width;
+    v.delta = delta.data();
+    return v;
+}
+
+template <typename T>
+ColumnRef<T> makeRef(TableState& s, const ColumnSpec& spec, std::vector<T> ColumnData::*member) {
+    std::shared_ptr<const ColumnData> data = s.visibleColumn(spec);
+    const std::vector<T>* values = &((*data).*member);
+    return ColumnRef<T>(std::move(data), values);
+}
+} // namespace
+
+TableSnapshot::TableSnapshot(std::shared_ptr<TableState> state) : m_state(std::move(state)), m_deleted(m_state->deleted.get()) {}
+
+uint64_t TableSnapshot::version() const { return m_state->version; }
+size_t TableSnapshot::mainRows() const { return m_state->mainRows(); }
+size_t TableSnapshot::deltaRows() const { return m_state->deltaRows(); }
+size_t TableSnapshot::deletedRows() const { return m_state->deletedRows; }
+size_t TableSnapshot::mergeGeneration() const { return m_state->main->lineage().size(); }
+std::string TableSnapshot::sourcePath() const { return m_state->main->memory() ? std::string() : m_state->main->path(); }
+
+ColumnView<int> TableSnapshot::intView(int column) const { return makeView(*m_state, {column, 'i', 0}, &ColumnData::ints); }
+ColumnView<float> TableSnapshot::floatView(int column) const { return makeView(*m_state, {column, 'f', 0}, &ColumnData::floats); }
+ColumnView<int> TableSnapshot::dateView(int column) const { return makeView(*m_state, {column, 'd', 0}, &ColumnData::ints); }
+ColumnView<char> TableSnapshot::charView(int column, int fixedWidth) const { return makeView(*m_state, {column, 'c', fixedWidth}, &ColumnData::chars); }
+
+ColumnRef<int> TableSnapshot::intColumn(int column) const { return makeRef(*m_state, {column, 'i', 0}, &ColumnData::ints); }
+ColumnRef<float> TableSnapshot::floatColumn(int column) const { return makeRef(*m_state, {column, 'f', 0}, &ColumnData::floats); }
+ColumnRef<int> TableSnapshot::dateColumn(int column) const { return makeRef(*m_state, {column, 'd', 0}, &ColumnData::ints); }
+ColumnRef<char> TableSnapshot::charColumn(int column, int fixedWidth) const { return makeRef(*m_state, {column, 'c', fixedWidth}, &ColumnData::chars); }
+
+const ColumnStats& TableSnapshot::intStats(int column) const { return m_state->visibleStats({column, 'i', 0}); }
+const ColumnStats& TableSnapshot::dateStats(int column) const { return m_state->visibleStats({column, 'd', 0}); }
+bool TableSnapshot::isSortedBy(int column) const { return m_state->sortedBy({column, 'i', 0}); }
+
+
+// --- Clustering ---
+namespace {
+size_t lowerBound(const ColumnView<int>& keys, size_t begin, size_t end, int key) {
+    while (begin < end) {
+        const size_t mid = begin + (end - begin) / 2;
+        if (keys[mid] < key) begin = mid + 1;
+        else end = mid;
+    }
+    return begin;
+}
+} // namespace
+
+std::vector<KeyRange> coPartition(const TableSnapshot& outer, int outerKey, const TableSnapshot& inner, int innerKey, size_t ranges) {
+    const auto o = outer.intView(outerKey);
+    const auto i = inner.intView(innerKey);
+    const size_t O = outer.rows(), I = inner.rows();
+    ranges = std::max<size_t>(1, std::min(ranges, O));
+    std::vector<KeyRange> out;
+    out.reserve(ranges);
+    size_t outerBegin = 0, innerBegin = 0;
+    for (size_t p = 1; p <= ranges; ++p) {
+        size_t outerEnd = O, innerEnd = I;
+        if (p < ranges) {
+            // Cut in front of the first row holding the cut key, so equal keys never straddle two ranges
+            const int key = o[p * O / ranges];
+            outerEnd = lowerBound(o, outerBegin, p * O / ranges, key);
+            innerEnd = lowerBound(i, innerBegin, I, key);
+        }
+        if (outerEnd > outerBegin || innerEnd > innerBegin) out.push_back({outerBegin, outerEnd, innerBegin, innerEnd});
+        outerBegin = outerEnd;
+        innerBegin = innerEnd;
+    }
+    return out;
+}
+
+
+// --- Column Catalog ---
+ColumnCatalog::ColumnCatalog(std::string datasetPath) : m_datasetPath(std::move(datasetPath)) {}
+ColumnCatalog::~ColumnCatalog() = default;
+
+std::shared_ptr<TableState> ColumnCatalog::state(const std::string& table) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto& s = m_tables[table];
+    if (!s) {
+        s = std::make_shared<TableState>();
+        s->main = std::make_shared<MainStore>(m_datasetPath + table + ".tbl", std::vector<MergeStep>{});
+    }
+    return s;
+}
+
+void ColumnCatalog::attachMemoryTable(const std::string& table, std::shared_ptr<const MemoryTable> data) {
+    auto next = std::make_shared<TableState>();
+    next->main = std::make_shared<MainStore>(m_datasetPath + table + ".tbl", std::vector<MergeStep>{}, std::move(data));
+    publish(table, next);
+}
+
+void ColumnCatalog::publish(const std::string& table, std::shared_ptr<TableState> next) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_tables[table] = std::move(next);
+    }
+    m_buildCache.invalidateTable(table);
+}
+
+TableSnapshot ColumnCatalog::snapshot(const std::string& table) { return TableSnapshot(state(table)); }
+
+uint64_t ColumnCatalog::tableVersion(const std::string& table) { return state(table)->version; }
+
+void ColumnCatalog::appendRows(const std::string& table, std::vector<std::string> lines) {
+    if (lines.empty()) return;
+    std::lock_guard<std::mutex> write(m_writeMutex);
+    auto cur = state(table);
+    auto next = std::make_shared<TableState>();
+    next->version = cur->version + 1;
+    next->main = cur->main;
+    auto delta = std::make_shared<DeltaRows>();
+    if (cur->delta) delta->lines = cur->delta->lines;
+    delta->lines.insert(delta->lines.end(), std::make_move_iterator(lines.begin()), std::make_move_iterator(lines.end()));
+    next->delta = delta;
+    if (cur->deleted) { // grow the bitmap over the new positions
+        auto deleted = std::make_shared<std::vector<uint64_t>>(*cur->deleted);
+        deleted->resize((cur->mainRows() + delta->lines.size() + 63) / 64, 0);
+        next->deleted = deleted;
+    }
+    next->deletedRows = cur->deletedRows;
+    publish(table, next);
+}
+
+size_t ColumnCatalog::deleteRowsWhere(const std::string& table, int keyColumn, const std::unordered_set<int>& keys) {
+    if (keys.empty()) return 0;
+    std::lock_guard<std::mutex> write(m_writeMutex);
+    auto cur = state(table);
+    TableSnapshot snap(cur);
+    auto key = snap.intView(keyColumn);
+    const size_t rows = snap.rows();
+    auto deleted = cur->deleted ? std::make_shared<std::vector<uint64_t>>(*cur->deleted)
+                                : std::make_shared<std::vector<uint64_t>>((rows + 63) / 64, 0);
+    size_t count = 0;
+    for (size_t r = 0; r < rows; ++r) {
+        if (snap.isDeleted(r) || !keys.count(key[r])) continue;
+        (*deleted)[r >> 6] |= 1ull << (r & 63);
+        ++count;
+    }
+    if (count == 0) return 0;
+
+    auto next = std::make_shared<TableState>();
+    next->version = cur->version + 1;
+    next->main = cur->main;
+    next->delta = cur->delta;
+    next->deleted = deleted;
+    next->deletedRows = cur->deletedRows + count;
+    publish(table, next);
+    return count;
+}
+
+size_t ColumnCatalog::mergeDeltas(const std::string& table) {
+    std::lock_guard<std::mutex> write(m_writeMutex);
+    auto cur = state(table);
+    if (!cur->hasDeltas()) return 0;
+
+    TraceSpan span("merge deltas", "merge");
+    if (span.active()) span.arg("table", table);
+    std::vector<MergeStep> lineage = cur->main->lineage();
+    lineage.push_back({cur->deleted, cur->delta});
+    auto merged = std::make_shared<MainStore>(cur->main->path(), lineage, cur->main->memory());
+    for (const auto& [spec, data] : cur->main->loaded()) {
+        merged->preset(spec, applyDelta(*data, cur->deltaColumn(spec).get(), cur->deleted.get(), spec));
+    }
+
+    auto next = std::make_shared<TableState>();
+    next->version = cur->version + 1;
+    next->main = merged;
+    size_t rows = next->mainRows();
+    publish(table, next);
+    return rows;
+}
+
+DeltaStats ColumnCatalog::deltaStats(const std::string& table) {
+    auto s = state(table);
+    return {s->version, s->mainRows(), s->deltaRows(), s->deletedRows};
+}
@@ -0,0 +1,228 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <istream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "BuildCache.hpp"
+#include "ColumnStats.hpp"
+
+// --- .tbl Column Loaders ---
+// One pass over a pipe-delimited TPC-H file per call, returning a single column
+// (or the binary column beside it, when present).
+std::vector<int> loadIntColumn(const std::string& filePath, int columnIndex);
+std::vector<float> loadFloatColumn(const std::string& filePath, int columnIndex);
+std::vector<char> loadCharColumn(const std::string& filePath, int columnIndex, int fixed_width = 0);
+std::vector<int> loadDateColumn(const std::string& filePath, int columnIndex);
+
+// Same parsers over any stream of .tbl lines (used for delta rows).
+std::vector<int> parseIntColumn(std::istream& in, int columnIndex);
+std::vector<float> parseFloatColumn(std::istream& in, int columnIndex);
+std::vector<char> parseCharColumn(std::istream& in, int columnIndex, int fixed_width = 0);
+std::vector<int> parseDateColumn(std::istream& in, int columnIndex);
+
+// One column's values; exactly one of the vectors is used.
+struct ColumnData {
+    std::vector<int> ints; // int and date columns
+    std::vector<float> floats;
+    std::vector<char> chars; // width bytes per row
+};
+
+// --- Binary Columns ---
+// Columnar alternative to .tbl text: <table>.<column>.col next to (or instead
+// of) <table>.tbl, preferred by every loader when present. A 16-byte header
+// ("GPUDBCOL", kind, width) precedes the raw values: int32 for 'i' (dates as
+// YYYYMMDD), float for 'f', width bytes per row for 'c'. Loaders convert to
+// whatever width or kind a query asks for, as the text parsers do.
+struct RawColumn {
+    char kind = 'i'; // 'i', 'f' or 'c'
+    int width = 1;   // bytes per row of a 'c' column
+    ColumnData data;
+};
+
+// A table held in memory column by column (the data generator's output).
+struct MemoryTable {
+    std::vector<RawColumn> columns; // by .tbl column index
+};
+
+// "data/SF-1/lineitem.tbl", 4 -> "data/SF-1/lineitem.4.col"
+std::string binaryColumnPath(const std::string& tblPath, int column);
+bool writeBinaryColumnHeader(FILE* out, char kind, int width);
+// False if the file is missing or malformed.
+bool readBinaryColumn(const std::string& path, RawColumn& out);
+
+// Contiguous, shared, immutable column. Stays valid after the catalog moves on
+// to a newer table version (refresh functions, merges).
+template <typename T>
+class ColumnRef {
+public:
+    ColumnRef() = default;
+    ColumnRef(std::shared_ptr<const ColumnData> owner, const std::vector<T>* values) : m_owner(std::move(owner)), m_values(values) {}
+
+    const T* data() const { return m_values->data(); }
+    size_t size() const { return m_values->size(); }
+    bool empty() const { return m_values->empty(); }
+    const T& operator[](size_t i) const { return (*m_values)[i]; }
+    typename std::vector<T>::const_iterator begin() const { return m_values->begin(); }
+    typename std::vector<T>::const_iterator end() const { return m_values->end(); }
+
+private:
+    std::shared_ptr<const ColumnData> m_owner;
+    const std::vector<T>* m_values = nullptr;
+};
+
+// Position-addressed view over a table's main column followed by its delta
+// (appended) rows. Row r < mainRows is main row r; the rest are delta rows in
+// insertion order. Valid while the TableSnapshot it came from is alive.
+template <typename T>
+struct ColumnView {
+    const T* main = nullptr;
+    size_t mainRows = 0;
+    const T* delta = nullptr;
+    size_t width = 1; // elements per row (fixed-width char columns)
+
+    const T* at(size_t row) const { return row < mainRows ? main + row * width : delta + (row - mainRows) * width; }
+    T operator[](size_t row) const { return *at(row); }
+};
+
+// Rows inserted by refresh functions, kept in .tbl line format.
+struct DeltaRows {
+    std::vector<std::string> lines;
+};
+
+// One fold of a delta store into the main columns, replayed by columns that
+// were not loaded yet when the merge ran.
+struct MergeStep {
+    std::shared_ptr<const std::vector<uint64_t>> deleted; // over pre-merge main + delta rows, may be null
+    std::shared_ptr<const DeltaRows> appended;
+};
+
+struct DeltaStats {
+    uint64_t version = 0;
+    size_t mainRows = 0;
+    size_t deltaRows = 0;
+    size_t deletedRows = 0;
+};
+
+class TableState;
+
+// --- Table Snapshot ---
+// A consistent version of one table: main columns, delta rows and delete bitmap.
+// Queries take one snapshot per table and read every column through it, so
+// concurrent refresh functions and merges never tear a query's view.
+class TableSnapshot {
+public:
+    explicit TableSnapshot(std::shared_ptr<TableState> state);
+
+    uint64_t version() const;
+    size_t mainRows() const;
+    size_t deltaRows() const;
+    size_t rows() const { return mainRows() + deltaRows(); } // positions, including deleted rows
+    size_t deletedRows() const;
+    // Merges folded into the main columns so far; row positions are only
+    // comparable between snapshots of the same generation.
+    size_t mergeGeneration() const;
+    // .tbl path the main columns come from; empty for tables generated in memory.
+    std::string sourcePath() const;
+
+    bool hasDeletes() const { return m_deleted != nullptr; }
+    bool isDeleted(size_t row) const { return m_deleted && (((*m_deleted)[row >> 6] >> (row & 63)) & 1u); }
+    const std::vector<uint64_t>* deletedBitmap() const { return m_deleted; } // null = no deletes
+
+    // Scan access (CPU backend): main + delta positions; skip isDeleted() rows.
+    ColumnView<int> intView(int column) const;
+    ColumnView<float> floatView(int column) const;
+    ColumnView<int> dateView(int column) const;
+    ColumnView<char> charView(int column, int fixedWidth = 0) const;
+
+    // Visible rows only, contiguous (GPU upload). Without deltas this is the main
+    // column itself; otherwise it is materialised once per snapshot version.
+    ColumnRef<int> intColumn(int column) const;
+    ColumnRef<float> floatColumn(int column) const;
+    ColumnRef<int> dateColumn(int column) const;
+    ColumnRef<char> charColumn(int column, int fixedWidth = 0) const;
+
+    // Statistics of the visible rows, collected when the column is loaded
+    // (or materialised for this version); valid while the snapshot lives.
+    const ColumnStats& intStats(int column) const;
+    const ColumnStats& dateStats(int column) const;
+    // Clustering: whether the int column is non-decreasing over all positions.
+    bool isSortedBy(int column) const;
+
+private:
+    std::shared_ptr<TableState> m_state;
+    const std::vector<uint64_t>* m_deleted = nullptr;
+};
+
+// --- Clustering ---
+// Row ranges of two tables sorted on a shared key (orders and lineitem on
+// orderkey), cut at the same key values: range p of the outer table and range
+// p of the inner one hold the same keys, so a merge join runs on every pair
+// independently with sequential access only. Both tables must be sorted.
+struct KeyRange {
+    size_t outerBegin, outerEnd;
+    size_t innerBegin, innerEnd;
+};
+std::vector<KeyRange> coPartition(const TableSnapshot& outer, int outerKey, const TableSnapshot& inner, int innerKey, size_t ranges);
+
+// --- Shared Column Catalog ---
+// Loads each (table, column) at most once and hands out shared references.
+// Safe to call from concurrent query streams: the first caller loads, the
+// others block on that entry only.
+//
+// Tables accept TPC-H refresh functions: appendRows() (RF1) adds rows to an
+// append buffer and deleteRowsWhere() (RF2) sets bits in a delete bitmap. Every
+// change publishes a new table version (copy-on-write); mergeDeltas() folds the
+// deltas back into the main columns.
+class ColumnCatalog {
+public:
+    explicit ColumnCatalog(std::string datasetPath);
+    ~ColumnCatalog();
+
+    TableSnapshot snapshot(const std::string& table);
+
+    // Shortcuts for the visible column of the current version.
+    ColumnRef<int> intColumn(const std::string& table, int column) { return snapshot(table).intColumn(column); }
+    ColumnRef<float> floatColumn(const std::string& table, int column) { return snapshot(table).floatColumn(column); }
+    ColumnRef<int> dateColumn(const std::string& table, int column) { return snapshot(table).dateColumn(column); }
+    ColumnRef<char> charColumn(const std::string& table, int column, int fixedWidth = 0) { return snapshot(table).charColumn(column, fixedWidth); }
+    ColumnStats intStats(const std::string& table, int column) { return snapshot(table).intStats(column); }
+    ColumnStats dateStats(const std::string& table, int column) { return snapshot(table).dateStats(column); }
+
+    const std::string& datasetPath() const { return m_datasetPath; }
+
+    // Serves the table from memory instead of its files (before it is first read).
+    void attachMemoryTable(const std::string& table, std::shared_ptr<const MemoryTable> data);
+
+    // Data version of a table, part of every BuildKey derived from it. Each
+    // refresh or merge bumps it and drops the table's cached build structures.
+    uint64_t tableVersion(const std::string& table);
+
+    // RF1: append .tbl-format rows to the table's delta store.
+    void appendRows(const std::string& table, std::vector<std::string> lines);
+    // RF2: mark visible rows whose integer keyColumn is in keys as deleted; returns the count.
+    size_t deleteRowsWhere(const std::string& table, int keyColumn, const std::unordered_set<int>& keys);
+    // Fold the delta store into new main columns. Columns already loaded are merged
+    // eagerly (the merge cost); others replay the merge when first loaded.
+    // Queries keep running on their snapshots meanwhile. Returns rows merged.
+    size_t mergeDeltas(const std::string& table);
+    DeltaStats deltaStats(const std::string& table);
+
+    BuildCache& buildCache() { return m_buildCache; }
+
+private:
+    std::shared_ptr<TableState> state(const std::string& table);
+    void publish(const std::string& table, std::shared_ptr<TableState> next);
+
+    std::string m_datasetPath;
+    std::mutex m_mutex;      // guards m_tables
+    std::mutex m_writeMutex; // serialises refresh functions and merges
+    std::map<std::string, std::shared_ptr<TableState>> m_tables;
+    BuildCache m_buildCache;
+};
@@ -0,0 +1,108 @@
+#include "ColumnStats.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace {
+
+constexpr size_t kSampleRows = 16384;
+
+inline uint64_t mix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+double hyperLogLog(const int* values, size_t n) {
+    constexpr unsigned p = ColumnStats::kHllBits;
+    constexpr size_t m = size_t(1) << p;
+    std::vector<uint8_t> registers(m, 0);
+    for (size_t i = 0; i < n; ++i) {
+        const uint64_t h = mix64((uint64_t)(uint32_t)values[i]);
+        const size_t index = h >> (64 - p);
+        const uint64_t rest = (h << p) | (uint64_t(1) << (p - 1)); // guard bit bounds the rank
+        const uint8_t rank = (uint8_t)(__builtin_clzll(rest) + 1);
+        registers[index] = std::max(registers[index], rank);
+    }
+    double sum = 0.0;
+    size_t zeros = 0;
+    for (uint8_t r : registers) { sum += std::ldexp(1.0, -(int)r); zeros += r == 0; }
+    const double alpha = 0.7213 / (1.0 + 1.079 / m);
+    const double estimate = alpha * m * m / sum;
+    // Small cardinalities: linear counting over the empty registers
+    if (estimate <= 2.5 * m && zeros > 0) return m * std::log((double)m / zeros);
+    return estimate;
+}
+
+} // namespace
+
+
+// --- Collection ---
+ColumnStats computeColumnStats(const int* values, size_t n) {
+    ColumnStats s;
+    s.rows = n;
+    if (n == 0) return s;
+    auto [lo, hi] = std::minmax_element(values, values + n);
+    s.min = *lo;
+    s.max = *hi;
+    s.distinct = std::min((double)n, hyperLogLog(values, n));
+    s.sorted = std::is_sorted(values, values + n);
+
+    const size_t step = std::max<size_t>(1, n / kSampleRows);
+    std::vector<int> sample;
+    sample.reserve(n / step + 1);
+    for (size_t i = 0; i < n; i += step) sample.push_back(values[i]);
+    std::sort(sample.begin(), sample.end());
+    s.bounds.resize(ColumnStats::kBuckets);
+    for (unsigned b = 0; b < ColumnStats::kBuckets; ++b) {
+        s.bounds[b] = sample[(b + 1) * sample.size() / ColumnStats::kBuckets - 1];
+    }
+    s.bounds.back() = s.max;
+    return s;
+}
+
+uint64_t ColumnStats::rowsAbove(int64_t v) const {
+    if (empty() || v >= max) return 0;
+    if (v < min) return rows;
+    // Buckets whose upper bound exceeds v may hold such rows
+    unsigned buckets = 0;
+    for (int64_t bound : bounds) buckets += bound > v;
+    return std::min<uint64_t>(rows, (rows * (buckets + 1) + kBuckets - 1) / kBuckets);
+}
+
+uint64_t ColumnStats::rowsBelow(int64_t v) const {
+    if (empty() || v <= min) return 0;
+    if (v > max) return rows;
+    // Every bucket up to the first whose upper bound reaches v
+    unsigned buckets = 0;
+    while (buckets < bounds.size() && bounds[buckets] < v) ++buckets;
+    return std::min<uint64_t>(rows, (rows * (buckets + 2) + kBuckets - 1) / kBuckets);
+}
+
+
+// --- Sizing ---
+size_t hashTableSlots(double distinct, double loadFactor) {
+    const double sigma = 1.04 / std::sqrt((double)(1u << ColumnStats::kHllBits));
+    return (size_t)std::ceil(distinct * (1.0 + 3.0 * sigma) / loadFactor) + 1;
+}
+
+bool directMapFits(const ColumnStats& s, double maxSlotsPerRow) {
+    return !s.empty() && s.min >= 0 && (double)(s.max + 1) <= maxSlotsPerRow * (double)s.rows;
+}
+
+void printColumnStats(const std::vector<std::pair<std::string, ColumnStats>>& columns) {
+    const char* rule = "+------------------+------------+-------------+-------------+------------+-------------+-------------+-------------+--------+--------+\n";
+    printf("%s", rule);
+    printf("| %-16s | %10s | %11s | %11s | %10s | %11s | %11s | %11s | %-6s | %-6s |\n", "column", "rows", "min", "max", "distinct", "p25", "p50", "p75", "sorted",
+           "direct");
+    printf("%s", rule);
+    for (const auto& [name, s] : columns) {
+        auto quartile = [&](unsigned q) { return s.bounds.empty() ? 0ll : (long long)s.bounds[q * ColumnStats::kBuckets / 4 - 1]; };
+        printf("| %-16s | %10llu | %11lld | %11lld | %10.0f | %11lld | %11lld | %11lld | %-6s | %-6s |\n", name.c_str(),
+               (unsigned long long)s.rows, (long long)s.min, (long long)s.max, s.distinct, quartile(1), quartile(2), quartile(3),
+               s.sorted ? "yes" : "no", directMapFits(s) ? "yes" : "no");
+    }
+    printf("%s", rule);
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// --- Column Statistics ---
+// Collected for every int and date column when it is loaded (and for the
+// visible rows of a table version with deltas): row count, min/max, a
+// HyperLogLog distinct count (4096 registers, ~1.6% standard error) and an
+// equi-depth histogram cut from a strided sample. The planners size hash
+// tables, direct maps and intermediates from them instead of from multiples
+// of the input row count, and the estimates carry enough margin that the
+// structures cannot overflow (or are grown when an estimate is exceeded).
+
+struct ColumnStats {
+    static constexpr unsigned kHllBits = 12;
+    static constexpr unsigned kBuckets = 32;
+
+    uint64_t rows = 0;
+    uint64_t nulls = 0;            // the storage has no NULL marker; always 0 for now
+    int64_t min = 0, max = -1;     // max < min when empty
+    double distinct = 0.0;         // HyperLogLog estimate
+    std::vector<int64_t> bounds;   // upper value of each equi-depth bucket (ascending, kBuckets entries)
+    bool sorted = true;            // non-decreasing in row order (the table is clustered on this column)
+
+    bool empty() const { return rows == 0; }
+    // Estimated rows with value > v; rounded up to whole buckets, so an upper bound barring sampling error.
+    uint64_t rowsAbove(int64_t v) const;
+    uint64_t rowsBelow(int64_t v) const;  // same for value < v
+};
+
+ColumnStats computeColumnStats(const int* values, size_t n);
+
+// Open-addressing slots for `distinct` keys at loadFactor, plus the
+// HyperLogLog error margin (3 standard errors) so the table never fills.
+size_t hashTableSlots(double distinct, double loadFactor = 0.5);
+
+// A direct map over [0, max] pays off when keys are non-negative and it has at
+// most maxSlotsPerRow slots per row (TPC-H order keys: 4).
+bool directMapFits(const ColumnStats& s, double maxSlotsPerRow = 8.0);
+
+// Table of (name, stats): rows, min, max, distinct, histogram quartiles, sort order and whether a direct map fits.
+void printColumnStats(const std::vector<std::pair<std::string, ColumnStats>>& columns);
@@ -0,0 +1,1365 @@
+#include "CpuQueries.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <string_view>
+#include <unordered_map>
+
+#include "AsyncReader.hpp"
+#include "BenchConfig.hpp"
+#include "HugePages.hpp"
+#include "JoinIndex.hpp"
+#include "Numa.hpp"
+#include "PerfCounters.hpp"
+#include "Roofline.hpp"
+#include "ScratchArena.hpp"
+#include "Spill.hpp"
+#include "Trace.hpp"
+
+namespace {
+
+// Per-worker state padded to its own cache lines to avoid false sharing.
+template <typename T>
+struct alignas(64) WorkerLocal {
+    T value{};
+};
+
+inline bool bitmapTest(const LargeVector<uint32_t>& bitmap, int key) {
+    return (bitmap[(uint32_t)key / 32] >> ((uint32_t)key % 32)) & 1u;
+}
+
+// Fixed-width, NUL-padded string as a view up to the first NUL.
+inline std::string_view fixedString(const char* s, size_t width) {
+    return std::string_view(s, strnlen(s, width));
+}
+
+// LIKE '%word1%word2%'
+inline bool containsWordPair(std::string_view s, std::string_view word1, std::string_view word2) {
+    size_t p = s.find(word1);
+    return p != std::string_view::npos && s.find(word2, p + word1.size()) != std::string_view::npos;
+}
+
+// Hash partition of a join/group key for the spilling plans.
+inline unsigned spillPartition(int key, unsigned partitions) {
+    return (unsigned)(((uint64_t)((uint32_t)key * 0x9E3779B1u) * partitions) >> 32);
+}
+
+// Morsel of a query's main scan/probe: the tuned size, or the plan's default.
+size_t tunedMorsel(const char* query, size_t fallback = WorkerPool::kDefaultMorsel) {
+    const size_t morsel = cpuTuning(query).morsel;
+    return morsel ? morsel : fallback;
+}
+
+inline uint32_t partsuppHash(int partkey, int suppkey) {
+    return (uint32_t)partkey * 0x9E3779B1u ^ (uint32_t)suppkey * 0x85EBCA77u;
+}
+
+// Q9 partsupp build structure: packed (partkey << 32 | suppkey) keys, ~0 = empty.
+struct PartSuppTable {
+    explicit PartSuppTable(size_t n) : keys(n), rows(n, -1), size(n) {
+        for (auto& k : keys) k.store(~0ull, std::memory_order_relaxed);
+    }
+    LargeVector<std::atomic<uint64_t>> keys;
+    LargeVector<int> rows;
+    size_t size;
+};
+
+// Q9 build structure: key -> value (-1 = none). A direct map over [0, max]
+// when the key statistics allow one (TPC-H supplier and order keys), otherwise
+// an open-addressing table sized by hashTableSlots(distinct). insert() may run
+// concurrently for distinct keys.
+template <typename V>
+class KeyMap {
+public:
+    explicit KeyMap(const ColumnStats& keys)
+        : m_direct(keys.empty() || directMapFits(keys)),
+          m_slots(!m_direct ? hashTableSlots(keys.distinct) : keys.empty() ? 1 : (size_t)keys.max + 1),
+          m_keys(m_direct ? 0 : m_slots), m_values(m_slots, (V)-1) {
+        for (auto& k : m_keys) k.store(kEmpty, std::memory_order_relaxed);
+    }
+
+    size_t bytes() const { return m_slots * sizeof(V) + m_keys.size() * sizeof(int64_t); }
+
+    void insert(int key, V value) {
+        if (m_direct) { m_values[key] = value; return; }
+        for (size_t slot = home(key);; slot = (slot + 1 == m_slots) ? 0 : slot + 1) {
+            int64_t expected = kEmpty;
+            if (m_keys[slot].compare_exchange_strong(expected, key, std::memory_order_relaxed)) { m_values[slot] = value; return; }
+            if (expected == key) { m_values[slot] = value; return; }
+        }
+    }
+
+    V find(int key) const {
+        if (m_direct) return (size_t)key < m_slots ? m_values[key] : (V)-1;
+        for (size_t slot = home(key);; slot = (slot + 1 == m_slots) ? 0 : slot + 1) {
+            const int64_t k = m_keys[slot].load(std::memory_order_relaxed);
+            if (k == key) return m_values[slot];
+            if (k == kEmpty) return (V)-1;
+        }
+    }
+
+    // The line find(key) reads first
+    const void* slotAddress(int key) const {
+        if (m_direct) return &m_values[std::min((size_t)key, m_slots - 1)];
+        return &m_keys[home(key)];
+    }
+
+private:
+    static constexpr int64_t kEmpty = INT64_MIN;
+
+    size_t home(int key) const { return ((uint32_t)key * 0x9E3779B1u) % m_slots; }
+
+    bool m_direct;
+    size_t m_slots;
+    LargeVector<std::atomic<int64_t>> m_keys;
+    LargeVector<V> m_values;
+};
+
+// One query stage: a trace span, hardware counters and the roofline stage time, all free when disabled.
+struct Stage {
+    Stage(const char* name, const char* category) : span(name, category), perf(name) {
+        if (rooflineEnabled()) { m_name = name; m_start = std::chrono::steady_clock::now(); }
+    }
+    ~Stage() { close(); }
+    void close() {
+        perf.close();
+        span.close();
+        if (m_name) recordStageTime(m_name, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_start).count());
+        m_name = nullptr;
+    }
+
+    TraceSpan span;
+    PerfScope perf;
+
+private:
+    const char* m_name = nullptr;
+    std::chrono::steady_clock::time_point m_start;
+};
+
+// Bytes each stage of the plans below moves per execution. Build stages are
+// only declared with the build cache off: a cache hit moves nothing.
+std::vector<StageTraffic> stageTraffic(ColumnCatalog& catalog, const std::string& query, const std::string& color = "") {
+    auto rows = [&](const char* table) { return (uint64_t)catalog.snapshot(table).rows(); };
+    auto maxKey = [&](const char* table, int column) { return (uint64_t)std::max<int64_t>(0, catalog.intStats(table, column).max); };
+    const bool builds = catalog.buildCache().budgetBytes() == 0;
+    const uint64_t L = rows("lineitem");
+    std::vector<StageTraffic> t;
+    if (query == "q1") {
+        t.push_back({"q1 scan", L * (4 * 4 + 2 * 1 + 4), 0, 0});
+    } else if (query == "q3") {
+        const uint64_t C = rows("customer"), O = rows("orders"), mapBytes = (maxKey("orders", 0) + 1) * 4;
+        if (builds) t.push_back({"q3 build", C * (4 + 5) + O * (4 + 8), (maxKey("customer", 0) / 32 + 1) * 4 + mapBytes, 0});
+        // lineitem is clustered by orderkey, so the orders map and o_custkey are walked in order
+        t.push_back({"q3 probe", L * 4 * 4 + mapBytes + O * 4, 0, 0});
+    } else if (query == "q6") {
+        t.push_back({"q6 scan", L * 4 * 4, 0, 0});
+    } else if (query == "q9") {
+        const uint64_t P = rows("part"), S = rows("supplier"), PS = rows("partsupp"), O = rows("orders");
+        const uint64_t yearBytes = (maxKey("orders", 0) + 1) * 2;
+        if (builds) {
+            t.push_back({"q9 build", P * (4 + 4 + 55) + S * (4 + 8) + PS * 2 * 4 + O * 2 * 8,
+                         (maxKey("part", 0) / 32 + 1) * 4 + (maxKey("supplier", 0) + 1) * 4 + (PS * 2 + 1) * 12 + yearBytes, 0});
+        }
+        // Rows past the part bitmap probe the partsupp table and read ps_supplycost: ~2 random lines each
+        const auto p_name = catalog.charColumn("part", 1, 55);
+        uint64_t matching = 0;
+        for (size_t i = 0; i < P; ++i) matching += fixedString(p_name.data() + i * 55, 55).find(color) != std::string_view::npos;
+        const uint64_t probes = P ? L * matching / P : 0;
+        t.push_back({"q9 probe", L * 6 * 4 + yearBytes + probes * (12 + 4), 0, probes * 2});
+    } else if (query == "q13") {
+        const uint64_t C = rows("customer"), O = rows("orders");
+        t.push_back({"q13 count", O * (4 + 100), C * 4, 0});
+        t.push_back({"q13 histogram", C * 4, 0, 0});
+    }
+    return t;
+}
+
+// Local/remote split and per-node bandwidth of the measured executions; page
+// locations come from the column that drives the query's main scan.
+template <typename T>
+void reportNuma(const char* label, WorkerPool& pool, ColumnCatalog& catalog, const std::string& query, const ColumnView<T>& driver, size_t executions) {
+    if (!numaReportEnabled()) return;
+    uint64_t bytes = 0;
+    for (const auto& t : stageTraffic(catalog, query)) bytes += t.bytesRead + t.bytesWritten;
+    printNumaReport(label, takeNumaStats(), pageNodeShares(driver.main, driver.mainRows * driver.width * sizeof(T), numaParts()),
+                    pool.workersPerNode(), bytes, executions);
+}
+
+double elapsedMs(std::chrono::high_resolution_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+} // namespace
+
+
+// --- Materialization ---
+Materialization& cpuMaterialization() {
+    static Materialization mode = Materialization::Early;
+    return mode;
+}
+
+bool& cpuMaterializationRequested() {
+    static bool requested = false;
+    return requested;
+}
+
+bool parseMaterialization(const std::string& name, Materialization& out) {
+    if (name == "early") out = Materialization::Early;
+    else if (name == "late") out = Materialization::Late;
+    else return false;
+    return true;
+}
+
+const char* materializationName(Materialization mode) { return mode == Materialization::Late ? "late" : "early"; }
+
+
+// --- Join Strategy ---
+JoinStrategy& cpuJoinStrategy() {
+    static JoinStrategy strategy = JoinStrategy::Map;
+    return strategy;
+}
+
+bool parseJoinStrategy(const std::string& name, JoinStrategy& out) {
+    if (name == "map") out = JoinStrategy::Map;
+    else if (name == "merge") out = JoinStrategy::Merge;
+    else if (name == "index") out = JoinStrategy::Index;
+    else return false;
+    return true;
+}
+
+const char* joinStrategyName(JoinStrategy strategy) {
+    switch (strategy) {
+        case JoinStrategy::Merge: return "merge";
+        case JoinStrategy::Index: return "index";
+        default:                  return "map";
+    }
+}
+
+
+// --- Tuning ---
+CpuTuning& cpuTuning(const std::string& query) {
+    static std::map<std::string, CpuTuning> tunings{{"q1", {}}, {"q3", {}}, {"q6", {}}, {"q9", {}}, {"q13", {}}};
+    static CpuTuning unknown;
+    auto it = tunings.find(query);
+    return it != tunings.end() ? it->second : unknown;
+}
+
+namespace {
+
+// ", morsel 16384, prefetch 16" for the knobs a loaded profile set away from
+// the defaults, so tuned runs say so in their banner (threads show as the pool size).
+std::string tunedKnobs(const std::string& query) {
+    const CpuTuning& t = cpuTuning(query);
+    std::string knobs;
+    if (t.morsel) knobs += ", morsel " + std::to_string(t.morsel);
+    if (t.prefetch) knobs += ", prefetch " + std::to_string(t.prefetch);
+    if (t.localSlots) knobs += ", local " + std::to_string(t.localSlots);
+    return knobs;
+}
+
+} // namespace
+
+
+// --- TPC-H Q1 (CPU) ---
+std::vector<CpuQ1Row> cpuExecuteQ1(ColumnCatalog& catalog, WorkerPool& pool, const Q1Params& params) {
+    const TableSnapshot lineitem = catalog.snapshot("lineitem");
+    const auto l_returnflag = lineitem.charView(8);
+    const auto l_linestatus = lineitem.charView(9);
+    const auto l_quantity = lineitem.floatView(4);
+    const auto l_extendedprice = lineitem.floatView(5);
+    const auto l_discount = lineitem.floatView(6);
+    const auto l_tax = lineitem.floatView(7);
+    const auto l_shipdate = lineitem.dateView(10);
+    const int cutoffDate = params.cutoffDate();
+
+    ScratchArena& arena = scratchArena();
+    arena.reset();
+    Stage scan("q1 scan", "probe");
+    auto* locals = arena.allocZeroed<WorkerLocal<CpuQ1Bins>>(pool.size(), pool);
+    pool.parallelFor(lineitem.rows(), tunedMorsel("q1"), [&](size_t begin, size_t end, unsigned worker) {
+        CpuQ1Bins& b = locals[worker].value;
+        for (size_t i = begin; i < end; ++i) {
+            if (lineitem.isDeleted(i) || l_shipdate[i] > cutoffDate) continue;
+            b.add(l_returnflag[i], l_linestatus[i], l_quantity[i], l_extendedprice[i], l_discount[i], l_tax[i]);
+        }
+    });
+
+    scan.close();
+
+    Stage merge("q1 merge", "merge");
+    CpuQ1Bins total;
+    for (unsigned w = 0; w < pool.size(); ++w) total.merge(locals[w].value);
+    return total.rows();
+}
+
+void CpuQ1Bins::merge(const CpuQ1Bins& other) {
+    for (int bin = 0; bin < 6; ++bin) {
+        qty[bin] += other.qty[bin];
+        base[bin] += other.base[bin];
+        disc[bin] += other.disc[bin];
+        charge[bin] += other.charge[bin];
+        disc_bp[bin] += other.disc_bp[bin];
+        count[bin] += other.count[bin];
+    }
+}
+
+std::vector<CpuQ1Row> CpuQ1Bins::rows() const {
+    std::vector<CpuQ1Row> rows;
+    for (int bin = 0; bin < 6; ++bin) {
+        if (count[bin] <= 0) continue;
+        CpuQ1Row r;
+        r.returnflag = "ANR"[bin / 2];
+        r.linestatus = "FO"[bin % 2];
+        r.count = (uint64_t)count[bin];
+        r.sum_qty = (double)qty[bin] / 100.0;
+        r.sum_base_price = (double)base[bin] / 100.0;
+        r.sum_disc_price = (double)disc[bin] / 100.0;
+        r.sum_charge = (double)charge[bin] / 100.0;
+        r.avg_qty = r.sum_qty / (double)r.count;
+        r.avg_price = r.sum_base_price / (double)r.count;
+        r.avg_disc = ((double)disc_bp[bin] / 100.0) / (double)r.count;
+        rows.push_back(r);
+    }
+    return rows;
+}
+
+
+// --- TPC-H Q3 (CPU) ---
+namespace {
+
+// ORDER BY revenue DESC, o_orderdate
+bool q3Before(const CpuQ3Row& a, const CpuQ3Row& b) {
+    if (a.revenue != b.revenue) return a.revenue > b.revenue;
+    return a.orderdate < b.orderdate;
+}
+
+// Bytes of Q3 intermediates per execution, for comparing early and late materialization.
+struct IntermediateBytes {
+    uint64_t executions = 0;
+    uint64_t positions = 0; // late: selection and join position lists (morsel-local)
+    uint64_t written = 0;   // partials, group table and result rows
+    uint64_t read = 0;
+    uint64_t fetched = 0;   // payload column values gathered by position
+    // Executions on plans with a fixed layout, which --materialization does not switch
+    uint64_t fixedLate = 0;  // merge and index joins: groups by orders row, payload for the top groups
+    uint64_t fixedEarly = 0; // partitioned join: payload carried in the build rows
+};
+thread_local IntermediateBytes t_q3Intermediates;
+
+void recordIntermediates(const IntermediateBytes& e) {
+    IntermediateBytes& s = t_q3Intermediates;
+    s.executions += 1;
+    s.positions += e.positions;
+    s.written += e.written;
+    s.read += e.read;
+    s.fetched += e.fetched;
+}
+
+IntermediateBytes takeIntermediates() {
+    IntermediateBytes s = t_q3Intermediates;
+    t_q3Intermediates = IntermediateBytes{};
+    return s;
+}
+
+void printIntermediates(const char* label, const IntermediateBytes& s) {
+    // Overrides are noted only when --materialization asked for the other mode
+    const Materialization mode = cpuMaterialization();
+    const bool requested = cpuMaterializationRequested();
+    if (requested && s.fixedLate && mode == Materialization::Early) {
+        printf("%s: the %s join always materializes late; --materialization early applies to the map join only\n", label,
+               joinStrategyName(cpuJoinStrategy()));
+    }
+    if (requested && s.fixedEarly && mode == Materialization::Late) {
+        printf("%s: the partitioned (spilling) join carries its payload early; --materialization late applies to the map join only\n", label);
+    }
+    if (s.executions == 0) return;
+    const double mb = (double)s.executions * (1 << 20);
+    printf("%s (%s): written %.2f MB, read %.2f MB, payload fetched %.3f MB, position lists %.2f MB per execution\n", label,
+           materializationName(cpuMaterialization()), s.written / mb, s.read / mb, s.fetched / mb, s.positions / mb);
+}
+
+// In-memory plan: orders direct map (sparse keys, ~4 slots per order) plus the group table.
+constexpr size_t kQ3GroupBytes = 48;
+size_t q3StateBytes(size_t orders) { return orders * (4 * sizeof(int) + kQ3GroupBytes); }
+
+// Merge joins of orders with lineitem per execution, for comparing them with the map probes.
+struct MergeJoinStats {
+    uint64_t executions = 0;
+    uint64_t ranges = 0;
+    uint64_t ordersRows = 0;
+    uint64_t lineitemRows = 0;
+    uint64_t fallbacks = 0; // merge requested on unsorted tables
+};
+thread_local MergeJoinStats t_mergeJoins;
+
+MergeJoinStats takeMergeJoins() {
+    MergeJoinStats s = t_mergeJoins;
+    t_mergeJoins = MergeJoinStats{};
+    return s;
+}
+
+void printMergeJoins(const char* label, const MergeJoinStats& s) {
+    if (s.fallbacks) printf("%s: orders and lineitem are not both sorted by orderkey, probed the direct map instead\n", label);
+    if (s.executions == 0) return;
+    const double n = (double)s.executions;
+    printf("%s: %.0f co-partitioned ranges, %.0f orders and %.0f lineitem rows walked in order per execution\n", label,
+           s.ranges / n, s.ordersRows / n, s.lineitemRows / n);
+}
+
+// Co-partitioned orderkey ranges for a merge join of orders with lineitem; none
+// when the map is asked for or either table is not clustered by orderkey.
+std::vector<KeyRange> mergeJoinRanges(WorkerPool& pool, const TableSnapshot& orders, const TableSnapshot& lineitem) {
+    if (cpuJoinStrategy() != JoinStrategy::Merge) return {};
+    if (!orders.isSortedBy(0) || !lineitem.isSortedBy(0)) { t_mergeJoins.fallbacks += 1; return {}; }
+    // About a morsel of lineitem per range, and enough ranges to balance the workers
+    const size_t ranges = std::max<size_t>(pool.size() * 4, lineitem.rows() / WorkerPool::kDefaultMorsel);
+    std::vector<KeyRange> out = coPartition(orders, 0, lineitem, 0, ranges);
+    t_mergeJoins.executions += 1;
+    t_mergeJoins.ranges += out.size();
+    t_mergeJoins.ordersRows += orders.rows();
+    t_mergeJoins.lineitemRows += lineitem.rows();
+    return out;
+}
+
+// The orders side of a merge join: follows the non-decreasing orderkeys of one
+// lineitem range through the matching orders range.
+struct OrdersCursor {
+    const ColumnView<int>& orderkey;
+    const TableSnapshot& orders;
+    size_t row, end;
+
+    // Orders row of the key, or -1 when there is none.
+    long seek(int key) {
+        for (; row < end; ++row) {
+            const int current = orderkey[row];
+            if (current > key) return -1;
+            if (current == key && !orders.isDeleted(row)) return (long)row;
+        }
+        return -1;
+    }
+};
+
+// Grace/hybrid hash join fused with the GROUP BY orderkey (the join key is the
+// group key): qualifying orders and filtered lineitem partials are partitioned
+// by orderkey, then each partition builds its group table from the orders side
+// and streams the lineitem side through it. A one-byte-per-order bit filter of
+// qualifying orderkeys keeps non-matching lineitems out of the spill files.
+std::vector<CpuQ3Row> cpuExecuteQ3Partitioned(WorkerPool& pool, const TableSnapshot& orders, const TableSnapshot& lineitem,
+                                              const LargeVector<uint32_t>& customer_bitmap, int cutoff_date, size_t budget) {
+    const auto o_orderkey = orders.intView(0);
+    const auto o_custkey = orders.intView(1);
+    const auto o_orderdate = orders.dateView(4);
+    const auto o_shippriority = orders.intView(7);
+    const auto l_orderkey = lineitem.intView(0);
+    const auto l_shipdate = lineitem.dateView(10);
+    const auto l_extendedprice = lineitem.floatView(5);
+    const auto l_discount = lineitem.floatView(6);
+
+    struct BuildRow { int orderkey; int orderdate; int shippriority; };
+    struct ProbeRow { int orderkey; double revenue; };
+    const SpillPlan plan = planSpill(q3StateBytes(orders.rows()), budget, (unsigned)pool.size());
+    SpillStats spill;
+    spill.partitions = plan.partitions;
+    spill.resident = plan.resident;
+
+    Stage buildStage("q3 build", "build");
+    // ~8 bits per qualifying order, estimated from the o_orderdate histogram
+    const size_t buildRows = orders.dateStats(4).rowsBelow(cutoff_date);
+    size_t filterBits = 64;
+    while (filterBits < buildRows * 8) filterBits *= 2;
+    LargeVector<uint32_t> filter(filterBits / 32, 0u);
+    const uint32_t filterMask = (uint32_t)(filterBits - 1);
+    SpillPartitions<BuildRow> builds(plan, (unsigned)pool.size(), spill);
+    pool.parallelFor(orders.rows(), WorkerPool::kDefaultMorsel, [&](size_t begin, size_t end, unsigned worker) {
+        for (size_t i = begin; i < end; ++i) {
+            if (orders.isDeleted(i) || o_orderdate[i] >= cutoff_date || !bitmapTest(customer_bitmap, o_custkey[i])) continue;
+            const int orderkey = o_orderkey[i];
+            const uint32_t bit = ((uint32_t)orderkey * 0x9E3779B1u) & filterMask;
+            std::atomic_ref<uint32_t>(filter[bit / 32]).fetch_or(1u << (bit % 32), std::memory_order_relaxed);
+            builds.add(worker, spillPartition(orderkey, plan.partitions), {orderkey, o_orderdate[i], o_shippriority[i]});
+        }
+    });
+    builds.flush();
+    buildStage.close();
+
+    // Probe side: consecutive lineitems of one order collapse before they are partitioned
+    Stage probe("q3 probe", "probe");
+    SpillPartitions<ProbeRow> probes(plan, (unsigned)pool.size(), spill);
+    pool.parallelFor(lineitem.rows(), WorkerPool::kDefaultMorsel, [&](size_t begin, size_t end, unsigned worker) {
+        ProbeRow pending{0, -1.0};
+        for (size_t i = begin; i < end; ++i) {
+            if (lineitem.isDeleted(i) || l_shipdate[i] <= cutoff_date) continue;
+            const int orderkey = l_orderkey[i];
+            const uint32_t bit = ((uint32_t)orderkey * 0x9E3779B1u) & filterMask;
+            if (!((filter[bit / 32] >> (bit % 32)) & 1u)) continue;
+            double revenue = (double)l_extendedprice[i] * (1.0 - (double)l_discount[i]);
+            if (pending.revenue >= 0.0 && pending.orderkey == orderkey) { pending.revenue += revenue; continue; }
+            if (pending.revenue >= 0.0) probes.add(worker, spillPartition(pending.orderkey, plan.partitions), pending);
+            pending = {orderkey, revenue};
+        }
+        if (pending.revenue >= 0.0) probes.add(worker, spillPartition(pending.orderkey, plan.partitions), pending);
+    });
+    probes.flush();
+    probe.close();
+
+    // One partition at a time: build its groups, stream its partials through them
+    Stage merge("q3 merge", "merge");
+    std::vector<CpuQ3Row> rows;
+    std::unordered_map<int, CpuQ3Row> groups;
+    for (unsigned p = 0; p < plan.partitions; ++p) {
+        groups.clear();
+        builds.consume(p, [&](const BuildRow* r, size_t n) {
+            for (size_t i = 0; i < n; ++i) groups.emplace(r[i].orderkey, CpuQ3Row{r[i].orderkey, -1.0, r[i].orderdate, r[i].shippriority});
+        });
+        probes.consume(p, [&](const ProbeRow* r, size_t n) {
+            for (size_t i = 0; i < n; ++i) {
+                auto it = groups.find(r[i].orderkey);
+                if (it == groups.end()) continue; // bit filter false positive
+                it->second.revenue = it->second.revenue < 0.0 ? r[i].revenue : it->second.revenue + r[i].revenue;
+            }
+        });
+        for (auto& kv : groups) {
+            if (kv.second.revenue >= 0.0) rows.push_back(kv.second);
+        }
+    }
+    std::sort(rows.begin(), rows.end(), q3Before);
+    recordSpill(spill);
+    return rows;
+}
+
+} // namespace
+
+std::vector<CpuQ3Row> cpuExecuteQ3(ColumnCatalog& catalog, WorkerPool& pool, const Q3Params& params, BuildStats* build,
+                                   size_t limit, size_t* groups) {
+    const auto c_custkey = catalog.intColumn("customer", 0);
+    const auto c_mktsegment = catalog.charColumn("customer", 6);
+    const TableSnapshot orders = catalog.snapshot("orders");
+    const TableSnapshot lineitem = catalog.snapshot("lineitem");
+    const auto o_orderkey = orders.intView(0);
+    const auto o_custkey = orders.intView(1);
+    const auto o_orderdate = orders.dateView(4);
+    const auto o_shippriority = orders.intView(7);
+    const auto l_orderkey = lineitem.intView(0);
+    const auto l_shipdate = lineitem.dateView(10);
+    const auto l_extendedprice = lineitem.floatView(5);
+    const auto l_discount = lineitem.floatView(6);
+    const int cutoff_date = params.date;
+    const char segment_prefix = params.segmentPrefix();
+    BuildCache& cache = catalog.buildCache();
+    BuildStats localBuild;
+    if (!build) build = &localBuild;
+
+    // Build 1: customer bitmap for c_mktsegment = SEGMENT
+    Stage buildStage("q3 build", "build");
+    BuildKey customerKey{"cpu.q3.customer_bitmap", "customer", "c_custkey,c_mktsegment",
+                         std::string("c_mktsegment=") + segment_prefix, catalog.tableVersion("customer")};
+    auto customer_bitmap_ptr = cache.getOrBuild<LargeVector<uint32_t>>(customerKey, [&](size_t& bytes) {
+        const int64_t max_custkey = std::max<int64_t>(0, catalog.intStats("customer", 0).max);
+        auto bitmap = std::make_shared<LargeVector<uint32_t>>((size_t)max_custkey / 32 + 1, 0u);
+        for (size_t i = 0; i < c_custkey.size(); ++i) {
+            if (c_mktsegment[i] == segment_prefix) (*bitmap)[(uint32_t)c_custkey[i] / 32] |= 1u << ((uint32_t)c_custkey[i] % 32);
+        }
+        bytes = bitmap->size() * sizeof(uint32_t);
+        return bitmap;
+    }, build);
+    const auto& customer_bitmap = *customer_bitmap_ptr;
+
+    const std::vector<KeyRange> ranges = mergeJoinRanges(pool, orders, lineitem);
+    std::shared_ptr<const JoinIndex> orders_index;
+    if (cpuJoinStrategy() == JoinStrategy::Index) {
+        orders_index = lineitemJoinIndex(catalog, pool, lineitem, orders, JoinIndexTarget::Orders, build);
+    }
+    if (!ranges.empty() || orders_index) {
+        // Merge or index join: no orders build. Partials are keyed by orders
+        // row and only the top `limit` groups fetch their payload. Under the
+        // merge join a group's lineitems are adjacent and no group spans two
+        // ranges, so the partials are final groups; the index join's partials
+        // of one order may come from several morsels and are combined.
+        buildStage.close();
+        Stage probe("q3 probe", "probe");
+        struct Group { uint32_t orderRow; double revenue; };
+        std::vector<WorkerLocal<std::vector<Group>>> locals(pool.size());
+        // rowOf(i) is the orders row of lineitem row i (-1 = none), called in row order
+        auto probeRows = [&](size_t begin, size_t end, std::vector<Group>& out, auto&& rowOf) {
+            long checked = -1;
+            bool qualifies = false; // the orders predicates, evaluated once per order
+            for (size_t i = begin; i < end; ++i) {
+                if (lineitem.isDeleted(i) || l_shipdate[i] <= cutoff_date) continue;
+                const long row = rowOf(i);
+                if (row < 0) continue;
+                if (row != checked) {
+                    checked = row;
+                    qualifies = o_orderdate[row] < cutoff_date && bitmapTest(customer_bitmap, o_custkey[row]);
+                }
+                if (!qualifies) continue;
+                const double revenue = (double)l_extendedprice[i] * (1.0 - (double)l_discount[i]);
+                if (!out.empty() && out.back().orderRow == (uint32_t)row) out.back().revenue += revenue;
+                else out.push_back({(uint32_t)row, revenue});
+            }
+        };
+        if (orders_index) {
+            const JoinIndex& ordersRow = *orders_index;
+            pool.parallelFor(lineitem.rows(), tunedMorsel("q3"), [&](size_t begin, size_t end, unsigned worker) {
+                probeRows(begin, end, locals[worker].value, [&](size_t i) { return ordersRow[i] == kNoJoinRow ? -1L : (long)ordersRow[i]; });
+            });
+        } else {
+            pool.parallelFor(ranges.size(), 1, [&](size_t begin, size_t end, unsigned worker) {
+                for (size_t r = begin; r < end; ++r) {
+                    OrdersCursor cursor{o_orderkey, orders, ranges[r].outerBegin, ranges[r].outerEnd};
+                    probeRows(ranges[r].innerBegin, ranges[r].innerEnd, locals[worker].value,
+                              [&](size_t i) { return cursor.seek(l_orderkey[i]); });
+                }
+            });
+        }
+        probe.close();
+
+        Stage merge("q3 merge", "merge");
+        std::vector<Group> all;
+        for (const auto& l : locals) all.insert(all.end(), l.value.begin(), l.value.end());
+        if (orders_index) {
+            std::sort(all.begin(), all.end(), [](const Group& a, const Group& b) { return a.orderRow < b.orderRow; });
+            size_t n = 0;
+            for (size_t j = 0; j < all.size(); ++j) {
+                if (n && all[n - 1].orderRow == all[j].orderRow) all[n - 1].revenue += all[j].revenue;
+                else all[n++] = all[j];
+            }
+            all.resize(n);
+        }
+        const size_t k = limit ? std::min(limit, all.size()) : all.size();
+        std::partial_sort(all.begin(), all.begin() + k, all.end(), [&](const Group& a, const Group& b) {
+            if (a.revenue != b.revenue) return a.revenue > b.revenue;
+            return o_orderdate[a.orderRow] < o_orderdate[b.orderRow];
+        });
+        std::vector<CpuQ3Row> rows;
+        rows.reserve(k);
+        for (size_t j = 0; j < k; ++j) {
+            const uint32_t row = all[j].orderRow;
+            rows.push_back({o_orderkey[row], all[j].revenue, o_orderdate[row], o_shippriority[row]});
+        }
+        t_q3Intermediates.fixedLate += 1;
+        if (groups) *groups = all.size();
+        return rows;
+    }
+
+    const size_t budget = memoryBudget().queryBytes;
+    // A sparse order key range makes the direct map mostly empty slots: join by hash partitions instead
+    const ColumnStats& orderkeyStats = orders.intStats(0);
+    const bool directMap = directMapFits(orderkeyStats);
+    if ((budget && q3StateBytes(orders.rows()) > budget) || !directMap) {
+        buildStage.close();
+        const size_t joinBudget = budget ? budget : 4 * q3StateBytes(orders.rows());
+        std::vector<CpuQ3Row> rows = cpuExecuteQ3Partitioned(pool, orders, lineitem, customer_bitmap, cutoff_date, joinBudget);
+        t_q3Intermediates.fixedEarly += 1;
+        if (groups) *groups = rows.size();
+        if (limit && rows.size() > limit) rows.resize(limit);
+        return rows;
+    }
+
+    // Build 2: orders direct map (orderkey -> row) for o_orderdate < DATE; keys are unique, so no atomics
+    BuildKey ordersKey{"cpu.q3.orders_map", "orders", "o_orderkey,o_orderdate",
+                       "o_orderdate<" + std::to_string(cutoff_date), orders.version()};
+    auto orders_map_ptr = cache.getOrBuild<LargeVector<int>>(ordersKey, [&](size_t& bytes) {
+        auto map = std::make_shared<LargeVector<int>>((size_t)orderkeyStats.max + 1, -1);
+        pool.parallelFor(orders.rows(), WorkerPool::kDefaultMorsel, [&](size_t begin, size_t end, unsigned) {
+            for (size_t i = begin; i < end; ++i) {
+                if (!orders.isDeleted(i) && o_orderdate[i] < cutoff_date) (*map)[o_orderkey[i]] = (int)i;
+            }
+        });
+        bytes = map->size() * sizeof(int);
+        return map;
+    }, build);
+    const auto& orders_map = *orders_map_ptr;
+    buildStage.close();
+
+    if (cpuMaterialization() == Materialization::Late) {
+        // Late materialization. Per morsel: a selection vector of l_shipdate
+        // matches, then (lineitem, orders) position pairs for the join, then
+        // revenue gathered by lineitem position and grouped by orders row. Only
+        // the top `limit` groups fetch orderkey, orderdate and shippriority.
+        Stage probe("q3 probe", "probe");
+        const size_t morsel = tunedMorsel("q3");
+        const unsigned prefetch = cpuTuning("q3").prefetch;
+        ScratchArena& arena = scratchArena();
+        arena.reset();
+        uint32_t* positions = arena.alloc<uint32_t>(pool.size() * morsel * 3);
+        struct Partials { std::vector<uint32_t> orderRow; std::vector<double> revenue; uint64_t selected = 0, joined = 0; };
+        std::vector<WorkerLocal<Partials>> locals(pool.size());
+        pool.parallelFor(lineitem.rows(), morsel, [&](size_t begin, size_t end, unsigned worker) {
+            uint32_t* sel = positions + (size_t)worker * morsel * 3;
+            uint32_t* linePos = sel + morsel;
+            uint32_t* orderPos = linePos + morsel;
+            size_t n = 0, m = 0;
+            for (size_t i = begin; i < end; ++i) {
+                if (!lineitem.isDeleted(i) && l_shipdate[i] > cutoff_date) sel[n++] = (uint32_t)i;
+            }
+            for (size_t j = 0; j < n; ++j) {
+                if (prefetch && j + prefetch < n) {
+                    const int ahead = l_orderkey[sel[j + prefetch]];
+                    if ((size_t)ahead < orders_map.size()) __builtin_prefetch(&orders_map[ahead]);
+                }
+                const int orderkey = l_orderkey[sel[j]];
+                if ((size_t)orderkey >= orders_map.size()) continue;
+                const int row = orders_map[orderkey];
+                if (row < 0 || !bitmapTest(customer_bitmap, o_custkey[row])) continue;
+                linePos[m] = sel[j];
+                orderPos[m++] = (uint32_t)row;
+            }
+            auto& out = locals[worker].value;
+            for (size_t j = 0; j < m; ++j) {
+                const double revenue = (double)l_extendedprice[linePos[j]] * (1.0 - (double)l_discount[linePos[j]]);
+                if (!out.orderRow.empty() && out.orderRow.back() == orderPos[j]) out.revenue.back() += revenue;
+                else { out.orderRow.push_back(orderPos[j]); out.revenue.push_back(revenue); }
+            }
+            out.selected += n;
+            out.joined += m;
+        });
+        probe.close();
+
+        Stage merge("q3 merge", "merge");
+        IntermediateBytes bytes;
+        std::unordered_map<uint32_t, double> acc;
+        for (const auto& l : locals) {
+            for (size_t j = 0; j < l.value.orderRow.size(); ++j) acc[l.value.orderRow[j]] += l.value.revenue[j];
+            const uint64_t partials = l.value.orderRow.size() * (sizeof(uint32_t) + sizeof(double));
+            bytes.positions += l.value.selected * sizeof(uint32_t) + l.value.joined * 2 * sizeof(uint32_t);
+            bytes.written += partials;
+            bytes.read += partials;
+        }
+        std::vector<std::pair<uint32_t, double>> candidates(acc.begin(), acc.end());
+        const size_t k = limit ? std::min(limit, candidates.size()) : candidates.size();
+        std::partial_sort(candidates.begin(), candidates.begin() + k, candidates.end(), [&](const auto& a, const auto& b) {
+            if (a.second != b.second) return a.second > b.second;
+            return o_orderdate[a.first] < o_orderdate[b.first];
+        });
+        std::vector<CpuQ3Row> rows;
+        rows.reserve(k);
+        for (size_t j = 0; j < k; ++j) {
+            const uint32_t row = candidates[j].first;
+            rows.push_back({o_orderkey[row], candidates[j].second, o_orderdate[row], o_shippriority[row]});
+        }
+        const uint64_t groupBytes = acc.size() * (sizeof(uint32_t) + sizeof(double));
+        bytes.written += 2 * groupBytes + k * sizeof(CpuQ3Row); // group table, candidates, result
+        bytes.read += 2 * groupBytes;
+        bytes.fetched = k * 3 * sizeof(int);
+        recordIntermediates(bytes);
+        if (groups) *groups = acc.size();
+        return rows;
+    }
+
+    // Probe: lineitem is clustered by orderkey, so consecutive matches collapse into one entry
+    Stage probe("q3 probe", "probe");
+    struct Partial { int orderkey; int orderRow; double revenue; };
+    std::vector<WorkerLocal<std::vector<Partial>>> locals(pool.size());
+    const unsigned prefetch = cpuTuning("q3").prefetch;
+    pool.parallelFor(lineitem.rows(), tunedMorsel("q3"), [&](size_t begin, size_t end, unsigned worker) {
+        auto& out = locals[worker].value;
+        for (size_t i = begin; i < end; ++i) {
+            if (prefetch && i + prefetch < end) {
+                const int ahead = l_orderkey[i + prefetch];
+                if ((size_t)ahead < orders_map.size()) __builtin_prefetch(&orders_map[ahead]);
+            }
+            if (lineitem.isDeleted(i) || l_shipdate[i] <= cutoff_date) continue;
+            int orderkey = l_orderkey[i];
+            if ((size_t)orderkey >= orders_map.size()) continue;
+            int row = orders_map[orderkey];
+            if (row < 0 || !bitmapTest(customer_bitmap, o_custkey[row])) continue;
+            double revenue = (double)l_extendedprice[i] * (1.0 - (double)l_discount[i]);
+            if (!out.empty() && out.back().orderkey == orderkey) out.back().revenue += revenue;
+            else out.push_back({orderkey, row, revenue});
+        }
+    });
+
+    probe.close();
+
+    // Merge: groups may straddle morsel boundaries
+    Stage merge("q3 merge", "merge");
+    IntermediateBytes bytes;
+    std::unordered_map<int, CpuQ3Row> acc;
+    for (const auto& l : locals) {
+        for (const auto& p : l.value) {
+            auto it = acc.find(p.orderkey);
+            if (it == acc.end()) acc.emplace(p.orderkey, CpuQ3Row{p.orderkey, p.revenue, o_orderdate[p.orderRow], o_shippriority[p.orderRow]});
+            else it->second.revenue += p.revenue;
+        }
+        bytes.written += l.value.size() * sizeof(Partial);
+        bytes.read += l.value.size() * sizeof(Partial);
+    }
+    std::vector<CpuQ3Row> rows;
+    rows.reserve(acc.size());
+    for (auto& kv : acc) rows.push_back(kv.second);
+    std::sort(rows.begin(), rows.end(), q3Before);
+    // Every group carries its payload through the group table, the row copy and the sort
+    bytes.written += 2 * acc.size() * sizeof(CpuQ3Row);
+    bytes.read += 2 * acc.size() * sizeof(CpuQ3Row);
+    bytes.fetched = acc.size() * 2 * sizeof(int);
+    recordIntermediates(bytes);
+    if (groups) *groups = rows.size();
+    if (limit && rows.size() > limit) rows.resize(limit);
+    return rows;
+}
+
+
+// --- TPC-H Q6 (CPU) ---
+double cpuExecuteQ6(ColumnCatalog& catalog, WorkerPool& pool, const Q6Params& params) {
+    const TableSnapshot lineitem = catalog.snapshot("lineitem");
+    const auto l_shipdate = lineitem.dateView(10);
+    const auto l_discount = lineitem.floatView(6);
+    const auto l_quantity = lineitem.floatView(4);
+    const auto l_extendedprice = lineitem.floatView(5);
+    const int start_date = params.date, end_date = params.endDate();
+    const float min_discount = params.minDiscount(), max_discount = params.maxDiscount();
+    const float max_quantity = (float)params.quantity;
+
+    ScratchArena& arena = scratchArena();
+    arena.reset();
+    Stage scan("q6 scan", "probe");
+    auto* locals = arena.allocZeroed<WorkerLocal<double>>(pool.size(), pool);
+    pool.parallelFor(lineitem.rows(), tunedMorsel("q6"), [&](size_t begin, size_t end, unsigned worker) {
+        double revenue = 0.0;
+        for (size_t i = begin; i < end; ++i) {
+            if (!lineitem.isDeleted(i) && l_shipdate[i] >= start_date && l_shipdate[i] < end_date &&
+                l_discount[i] >= min_discount && l_discount[i] <= max_discount &&
+                l_quantity[i] < max_quantity) {
+                revenue += (double)l_extendedprice[i] * (double)l_discount[i];
+            }
+        }
+        locals[worker].value += revenue;
+    });
+
+    double total = 0.0;
+    for (unsigned w = 0; w < pool.size(); ++w) total += locals[w].value;
+    return total;
+}
+
+
+// --- TPC-H Q9 (CPU) ---
+std::vector<CpuQ9Row> cpuExecuteQ9(ColumnCatalog& catalog, WorkerPool& pool, const Q9Params& params, BuildStats* build) {
+    const auto p_partkey = catalog.intColumn("part", 0);
+    const auto p_name = catalog.charColumn("part", 1, 55);
+    const TableSnapshot supplier = catalog.snapshot("supplier");
+    const TableSnapshot partsupp = catalog.snapshot("partsupp");
+    const auto s_suppkey = supplier.intColumn(0);
+    const auto s_nationkey = supplier.intColumn(3);
+    const auto ps_partkey = partsupp.intColumn(0);
+    const auto ps_suppkey = partsupp.intColumn(1);
+    const auto ps_supplycost = partsupp.floatColumn(3);
+    const TableSnapshot orders = catalog.snapshot("orders");
+    const TableSnapshot lineitem = catalog.snapshot("lineitem");
+    const auto o_orderkey = orders.intView(0);
+    const auto o_orderdate = orders.dateView(4);
+    const auto l_partkey = lineitem.intView(1);
+    const auto l_suppkey = lineitem.intView(2);
+    const auto l_orderkey = lineitem.intView(0);
+    const auto l_quantity = lineitem.floatView(4);
+    const auto l_extendedprice = lineitem.floatView(5);
+    const auto l_discount = lineitem.floatView(6);
+    const std::string& color = params.color;
+    BuildCache& cache = catalog.buildCache();
+    BuildStats localBuild;
+    if (!build) build = &localBuild;
+
+    // Build 1: part bitmap for p_name LIKE '%COLOR%'
+    Stage buildStage("q9 build", "build");
+    BuildKey partKey{"cpu.q9.part_bitmap", "part", "p_partkey,p_name", "p_name~" + color, catalog.tableVersion("part")};
+    auto part_bitmap_ptr = cache.getOrBuild<LargeVector<uint32_t>>(partKey, [&](size_t& bytes) {
+        const int64_t max_partkey = std::max<int64_t>(0, catalog.intStats("part", 0).max);
+        auto bitmap = std::make_shared<LargeVector<uint32_t>>((size_t)max_partkey / 32 + 1, 0u);
+        for (size_t i = 0; i < p_partkey.size(); ++i) {
+            if (fixedString(p_name.data() + i * 55, 55).find(color) != std::string_view::npos) {
+                (*bitmap)[(uint32_t)p_partkey[i] / 32] |= 1u << ((uint32_t)p_partkey[i] % 32);
+            }
+        }
+        bytes = bitmap->size() * sizeof(uint32_t);
+        return bitmap;
+    }, build);
+    const auto& part_bitmap = *part_bitmap_ptr;
+
+    // Join indexes: lineitem -> supplier, partsupp and orders positions replace builds 2-4
+    std::shared_ptr<const JoinIndex> supp_index, ps_index, orders_index;
+    if (cpuJoinStrategy() == JoinStrategy::Index &&
+        (supp_index = lineitemJoinIndex(catalog, pool, lineitem, supplier, JoinIndexTarget::Supplier, build)) &&
+        (ps_index = lineitemJoinIndex(catalog, pool, lineitem, partsupp, JoinIndexTarget::PartSupp, build))) {
+        orders_index = lineitemJoinIndex(catalog, pool, lineitem, orders, JoinIndexTarget::Orders, build);
+    }
+    const bool indexed = orders_index != nullptr;
+
+    // Build 2: supplier map (suppkey -> nationkey); direct unless the key statistics rule it out
+    BuildKey suppKey{"cpu.q9.supplier_map", "supplier", "s_suppkey,s_nationkey", "", supplier.version()};
+    std::shared_ptr<const KeyMap<int>> supp_nation_ptr = std::make_shared<const KeyMap<int>>(ColumnStats{});
+    if (!indexed) supp_nation_ptr = cache.getOrBuild<KeyMap<int>>(suppKey, [&](size_t& bytes) {
+        auto map = std::make_shared<KeyMap<int>>(catalog.intStats("supplier", 0));
+        for (size_t i = 0; i < s_suppkey.size(); ++i) map->insert(s_suppkey[i], s_nationkey[i]);
+        bytes = map->bytes();
+        return map;
+    }, build);
+    const auto& supp_nation = *supp_nation_ptr;
+
+    // Build 3: partsupp open-addressing table on packed (partkey, suppkey), CAS-inserted in parallel
+    const uint64_t kEmpty = ~0ull;
+    BuildKey psKey{"cpu.q9.partsupp_ht", "partsupp", "ps_partkey,ps_suppkey", "", partsupp.version()};
+    std::shared_ptr<const PartSuppTable> ps_table_ptr = std::make_shared<const PartSuppTable>(1);
+    if (!indexed) ps_table_ptr = cache.getOrBuild<PartSuppTable>(psKey, [&](size_t& bytes) {
+        auto table = std::make_shared<PartSuppTable>(ps_partkey.size() * 2 + 1);
+        const size_t ht_size = table->size;
+        pool.parallelFor(ps_partkey.size(), WorkerPool::kDefaultMorsel, [&](size_t begin, size_t end, unsigned) {
+            for (size_t i = begin; i < end; ++i) {
+                uint64_t key = ((uint64_t)(uint32_t)ps_partkey[i] << 32) | (uint32_t)ps_suppkey[i];
+                size_t slot = partsuppHash(ps_partkey[i], ps_suppkey[i]) % ht_size;
+                for (;;) {
+                    uint64_t expected = kEmpty;
+                    if (table->keys[slot].compare_exchange_strong(expected, key, std::memory_order_relaxed)) { table->rows[slot] = (int)i; break; }
+                    if (expected == key) break;
+                    slot = (slot + 1 == ht_size) ? 0 : slot + 1;
+                }
+            }
+        });
+        bytes = ht_size * (sizeof(uint64_t) + sizeof(int));
+        return table;
+    }, build);
+    const PartSuppTable& ps_table = *ps_table_ptr;
+    const size_t partsupp_ht_size = ps_table.size;
+
+    // Build 4: orders map (orderkey -> year), direct unless the key statistics rule it
+    // out; skipped when the merge join walks orders instead
+    const std::vector<KeyRange> ranges = indexed ? std::vector<KeyRange>() : mergeJoinRanges(pool, orders, lineitem);
+    BuildKey yearKey{"cpu.q9.orders_year_map", "orders", "o_orderkey,o_orderdate", "", orders.version()};
+    std::shared_ptr<const KeyMap<int16_t>> order_year_ptr = std::make_shared<const KeyMap<int16_t>>(ColumnStats{});
+    if (!indexed && ranges.empty()) order_year_ptr = cache.getOrBuild<KeyMap<int16_t>>(yearKey, [&](size_t& bytes) {
+        auto map = std::make_shared<KeyMap<int16_t>>(orders.intStats(0));
+        pool.parallelFor(orders.rows(), WorkerPool::kDefaultMorsel, [&](size_t begin, size_t end, unsigned) {
+            for (size_t i = begin; i < end; ++i) {
+                if (!orders.isDeleted(i)) map->insert(o_orderkey[i], (int16_t)(o_orderdate[i] / 10000));
+            }
+        });
+        bytes = map->bytes();
+        return map;
+    }, build);
+    const auto& order_year = *order_year_ptr;
+    const ColumnStats& orderDates = orders.dateStats(4);
+    const int min_year = orderDates.empty() ? 0 : (int)(orderDates.min / 10000);
+    const int max_year = orderDates.empty() ? 0 : (int)(orderDates.max / 10000);
+    buildStage.close();
+
+    // Probe + per-worker (nation, year) accumulation in a dense array
+    ScratchArena& arena = scratchArena();
+    arena.reset();
+    Stage probe("q9 probe", "probe");
+    const int nations = (int)std::max<int64_t>(0, catalog.intStats("supplier", 3).max) + 1, years = std::max(1, max_year - min_year + 1);
+    // Per-worker slices of one zeroed arena range; each slice starts on its own cache line
+    const size_t groups = (size_t)nations * years;
+    const size_t profitStride = (groups + 7) / 8 * 8, hitStride = (groups + 63) / 64 * 64;
+    double* locals = arena.allocZeroed<double>(profitStride * pool.size(), pool);
+    uint8_t* seen = arena.allocZeroed<uint8_t>(hitStride * pool.size(), pool);
+
+    // Rows `prefetch` ahead of the map probes touch their partsupp and year slots early
+    const unsigned prefetch = indexed ? 0 : cpuTuning("q9").prefetch;
+    auto prefetchRow = [&](size_t i) {
+        const int partkey = l_partkey[i];
+        if (!bitmapTest(part_bitmap, partkey)) return;
+        __builtin_prefetch(&ps_table.keys[partsuppHash(partkey, l_suppkey[i]) % partsupp_ht_size]);
+        __builtin_prefetch(order_year.slotAddress(l_orderkey[i]));
+    };
+
+    // The dimension sides, per lineitem row i: nationOf and partsuppRowOf probe
+    // the maps or read the join indexes; yearOf is a direct map lookup, a merge
+    // cursor within one range or an index gather.
+    auto probeRows = [&](size_t begin, size_t end, unsigned worker, auto&& nationOf, auto&& partsuppRowOf, auto&& yearOf) {
+        double* profit = locals + (size_t)worker * profitStride;
+        uint8_t* hit = seen + (size_t)worker * hitStride;
+        for (size_t i = begin; i < end; ++i) {
+            if (prefetch && i + prefetch < end) prefetchRow(i + prefetch);
+            if (lineitem.isDeleted(i)) continue;
+            if (!bitmapTest(part_bitmap, l_partkey[i])) continue;
+            int nationkey = nationOf(i);
+            if (nationkey < 0) continue;
+            int ps_row = partsuppRowOf(i);
+            if (ps_row < 0) continue;
+            int year = yearOf(i);
+            if (year < 0) continue;
+
+            size_t g = (size_t)nationkey * years + (size_t)(year - min_year);
+            profit[g] += (double)l_extendedprice[i] * (1.0 - (double)l_discount[i]) - (double)ps_supplycost[ps_row] * (double)l_quantity[i];
+            hit[g] = 1;
+        }
+    };
+    auto mapNation = [&](size_t i) { return supp_nation.find(l_suppkey[i]); };
+    auto mapPartsuppRow = [&](size_t i) {
+        const int partkey = l_partkey[i], suppkey = l_suppkey[i];
+        const uint64_t key = ((uint64_t)(uint32_t)partkey << 32) | (uint32_t)suppkey;
+        size_t slot = partsuppHash(partkey, suppkey) % partsupp_ht_size;
+        for (;;) {
+            uint64_t k = ps_table.keys[slot].load(std::memory_order_relaxed);
+            if (k == key) return ps_table.rows[slot];
+            if (k == kEmpty) return -1;
+            slot = (slot + 1 == partsupp_ht_size) ? 0 : slot + 1;
+        }
+    };
+    if (indexed) {
+        const JoinIndex& supplierRow = *supp_index;
+        const JoinIndex& partsuppRow = *ps_index;
+        const JoinIndex& ordersRow = *orders_index;
+        pool.parallelFor(lineitem.rows(), tunedMorsel("q9"), [&](size_t begin, size_t end, unsigned worker) {
+            probeRows(begin, end, worker,
+                      [&](size_t i) { return supplierRow[i] == kNoJoinRow ? -1 : s_nationkey[supplierRow[i]]; },
+                      [&](size_t i) { return partsuppRow[i] == kNoJoinRow ? -1 : (int)partsuppRow[i]; },
+                      [&](size_t i) { return ordersRow[i] == kNoJoinRow ? -1 : o_orderdate[ordersRow[i]] / 10000; });
+        });
+    } else if (!ranges.empty()) {
+        pool.parallelFor(ranges.size(), 1, [&](size_t begin, size_t end, unsigned worker) {
+            for (size_t r = begin; r < end; ++r) {
+                OrdersCursor cursor{o_orderkey, orders, ranges[r].outerBegin, ranges[r].outerEnd};
+                probeRows(ranges[r].innerBegin, ranges[r].innerEnd, worker, mapNation, mapPartsuppRow, [&](size_t i) {
+                    const long row = cursor.seek(l_orderkey[i]);
+                    return row < 0 ? -1 : o_orderdate[row] / 10000;
+                });
+            }
+        });
+    } else {
+        pool.parallelFor(lineitem.rows(), tunedMorsel("q9"), [&](size_t begin, size_t end, unsigned worker) {
+            probeRows(begin, end, worker, mapNation, mapPartsuppRow, [&](size_t i) { return (int)order_year.find(l_orderkey[i]); });
+        });
+    }
+
+    probe.close();
+
+    Stage merge("q9 merge", "merge");
+    std::vector<CpuQ9Row> rows;
+    for (int n = 0; n < nations; ++n) {
+        for (int y = years - 1; y >= 0; --y) { // ORDER BY nation, o_year DESC
+            size_t g = (size_t)n * years + y;
+            double total = 0.0; bool any = false;
+            for (size_t w = 0; w < pool.size(); ++w) { total += locals[w * profitStride + g]; any |= seen[w * hitStride + g] != 0; }
+            if (any) rows.push_back({n, min_year + y, total});
+        }
+    }
+    return rows;
+}
+
+
+// --- TPC-H Q13 (CPU) ---
+std::vector<CpuQ13Row> cpuExecuteQ13(ColumnCatalog& catalog, WorkerPool& pool, const Q13Params& params) {
+    const TableSnapshot orders = catalog.snapshot("orders");
+    const auto o_custkey = orders.intView(1);
+    const auto o_comment = orders.charView(8, 100);
+    const auto c_custkey = catalog.intColumn("customer", 0);
+    const uint32_t customer_size = (uint32_t)c_custkey.size();
+    const std::string_view word1(params.word1), word2(params.word2);
+
+    std::map<uint32_t, uint32_t> histogram;
+    const size_t budget = memoryBudget().queryBytes;
+    if (budget && customer_size * sizeof(uint32_t) > budget) {
+        // External aggregation: custkeys of the counted orders are range-partitioned,
+        // then each partition's customers are counted in a dense array of its range.
+        const SpillPlan plan = planSpill(customer_size * sizeof(uint32_t) + orders.rows() * sizeof(uint32_t), budget, (unsigned)pool.size());
+        const uint32_t span = (customer_size + plan.partitions - 1) / plan.partitions;
+        SpillStats spill;
+        spill.partitions = plan.partitions;
+        spill.resident = plan.resident;
+        Stage count("q13 count", "probe");
+        SpillPartitions<uint32_t> keys(plan, (unsigned)pool.size(), spill);
+        pool.parallelFor(orders.rows(), tunedMorsel("q13", WorkerPool::kDefaultMorsel / 4), [&](size_t begin, size_t end, unsigned worker) {
+            for (size_t i = begin; i < end; ++i) {
+                if (orders.isDeleted(i)) continue;
+                uint32_t ck = (uint32_t)o_custkey[i];
+                if (ck < 1 || ck > customer_size) continue;
+                if (containsWordPair(fixedString(o_comment.at(i), 100), word1, word2)) continue;
+                keys.add(worker, (ck - 1) / span, ck - 1);
+            }
+        });
+        keys.flush();
+        count.close();
+
+        Stage post("q13 histogram", "post");
+        std::vector<uint32_t> counts(span);
+        for (unsigned p = 0; p < plan.partitions; ++p) {
+            const uint32_t first = p * span;
+            const uint32_t size = std::min(span, customer_size - std::min(customer_size, first));
+            std::fill(counts.begin(), counts.end(), 0u);
+            keys.consume(p, [&](const uint32_t* k, size_t n) {
+                for (size_t i = 0; i < n; ++i) counts[k[i] - first] += 1;
+            });
+            for (uint32_t i = 0; i < size; ++i) histogram[counts[i]] += 1;
+        }
+        recordSpill(spill);
+    } else {
+        // Direct per-customer order counts (index = custkey - 1), as in q13_fused_direct_count_kernel
+        Stage count("q13 count", "probe");
+        ScratchArena& arena = scratchArena();
+        arena.reset();
+        uint32_t* counts = arena.allocZeroed<uint32_t>(customer_size, pool);
+        // Optional per-worker direct-mapped table of (custkey, count) in front of
+        // the shared counts: repeats of a customer within a worker's rows cost no
+        // atomic, and an entry is added to the shared count when it is evicted.
+        const unsigned localSlots = cpuTuning("q13").localSlots;
+        struct LocalCount { uint32_t custkey, count; };
+        LocalCount* localTables = localSlots ? arena.allocZeroed<LocalCount>((size_t)localSlots * pool.size(), pool) : nullptr;
+        auto flush = [&](LocalCount& entry) {
+            if (entry.count) std::atomic_ref<uint32_t>(counts[entry.custkey - 1]).fetch_add(entry.count, std::memory_order_relaxed);
+            entry.count = 0;
+        };
+        pool.parallelFor(orders.rows(), tunedMorsel("q13", WorkerPool::kDefaultMorsel / 4), [&](size_t begin, size_t end, unsigned worker) {
+            LocalCount* local = localSlots ? localTables + (size_t)worker * localSlots : nullptr;
+            for (size_t i = begin; i < end; ++i) {
+                if (orders.isDeleted(i)) continue;
+                uint32_t ck = (uint32_t)o_custkey[i];
+                if (ck < 1 || ck > customer_size) continue;
+                if (containsWordPair(fixedString(o_comment.at(i), 100), word1, word2)) continue;
+                if (!local) {
+                    std::atomic_ref<uint32_t>(counts[ck - 1]).fetch_add(1, std::memory_order_relaxed);
+                    continue;
+                }
+                LocalCount& entry = local[ck % localSlots];
+                if (entry.count && entry.custkey != ck) flush(entry);
+                entry.custkey = ck;
+                entry.count += 1;
+            }
+        });
+        for (size_t e = 0; e < (size_t)localSlots * pool.size(); ++e) flush(localTables[e]);
+
+        count.close();
+
+        Stage post("q13 histogram", "post");
+        for (uint32_t i = 0; i < customer_size; ++i) histogram[counts[i]] += 1;
+    }
+    std::vector<CpuQ13Row> rows;
+    for (const auto& [c_count, custdist] : histogram) rows.push_back({c_count, custdist});
+    std::sort(rows.begin(), rows.end(), [](const CpuQ13Row& a, const CpuQ13Row& b) {
+        if (a.custdist != b.custdist) return a.custdist > b.custdist;
+        return a.c_count > b.c_count;
+    });
+    return rows;
+}
+
+
+// --- Benchmark wrappers ---
+void runCpuQ1Benchmark(ColumnCatalog& catalog, WorkerPool& pool, const Q1Params& params) {
+    std::cout << "--- Running TPC-H Query 1 Benchmark (CPU, " << pool.size() << " threads" << tunedKnobs("q1") << ") ---" << std::endl;
+    std::cout << "Parameters: " << describe(params) << std::endl;
+    std::vector<CpuQ1Row> rows;
+    scratchArena().takeStats(); // drop earlier queries' numbers
+    BenchLoop loop;
+    while (loop.next()) {
+        auto start = std::chrono::high_resolution_clock::now();
+        rows = cpuExecuteQ1(catalog, pool, params);
+        loop.record(elapsedMs(start));
+    }
+    printf("\n+----------+----------+------------+----------------+----------------+----------------+------------+------------+------------+----------+\n");
+    printf("| l_return | l_linest |    sum_qty | sum_base_price | sum_disc_price |     sum_charge |    avg_qty |  avg_price |   avg_disc | count    |\n");
+    printf("+----------+----------+------------+----------------+----------------+----------------+------------+------------+------------+----------+\n");
+    for (const auto& r : rows) {
+        printf("| %8c | %8c | %10.2f | %14.2f | %14.2f | %14.2f | %10.2f | %10.2f | %10.2f | %8llu |\n",
+               r.returnflag, r.linestatus, r.sum_qty, r.sum_base_price, r.sum_disc_price, r.sum_charge,
+               r.avg_qty, r.avg_price, r.avg_disc, (unsigned long long)r.count);
+    }
+    printf("+----------+----------+------------+----------------+----------------+----------------+------------+------------+------------+----------+\n");
+    const double ms = loop.stats().median;
+    loop.print("Q1 CPU backend time");
+    printReadStats("Q1 column loads", takeReadStats());
+    printScratchStats("Q1 scratch", scratchArena().takeStats());
+    printPerfStages("Q1 hardware counters", "q1 ");
+    printHugePageReport("Q1 huge pages");
+    reportNuma("Q1 NUMA", pool, catalog, "q1", catalog.snapshot("lineitem").dateView(10), loop.samples().size());
+    if (rooflineEnabled()) printRoofline("Q1 roofline", stageTraffic(catalog, "q1"));
+    printf("Total TPC-H Q1 CPU backend time: %0.2f ms\n", ms);
+    printf("Total TPC-H Q1 wall-clock: %0.2f ms\n", ms);
+    if (g_results.enabled()) {
+        ResultRecord rec = tpchResult("q1", "cpu", describe(params), loop, catalog, rows.size());
+        rec.threads = pool.size();
+        rec.stages.emplace_back("execute", ms);
+        g_results.emit(rec);
+    }
+}
+
+void runCpuQ3Benchmark(ColumnCatalog& catalog, WorkerPool& pool, const Q3Params& params) {
+    std::cout << "\n--- Running TPC-H Query 3 Benchmark (CPU, " << pool.size() << " threads" << tunedKnobs("q3") << ") ---" << std::endl;
+    std::cout << "Parameters: " << describe(params) << std::endl;
+    std::vector<CpuQ3Row> rows;
+    size_t groups = 0;
+    takeSpillStats();
+    takeIntermediates();
+    takeMergeJoins();
+    takeJoinIndexStats();
+    BuildPhaseTimer buildTimer;
+    BenchLoop loop;
+    while (loop.next()) {
+        BuildStats build;
+        auto start = std::chrono::high_resolution_clock::now();
+        rows = cpuExecuteQ3(catalog, pool, params, &build, 10, &groups);
+        loop.record(elapsedMs(start));
+        buildTimer.record(build);
+    }
+    printf("\nTPC-H Query 3 Results (Top 10):\n");
+    printf("+----------+------------+------------+--------------+\n");
+    printf("| orderkey |   revenue  | orderdate  | shippriority |\n");
+    printf("+----------+------------+------------+--------------+\n");
+    for (size_t i = 0; i < 10 && i < rows.size(); ++i) {
+        printf("| %8d | $%10.2f | %10d | %12d |\n", rows[i].orderkey, rows[i].revenue, rows[i].orderdate, rows[i].shippriority);
+    }
+    printf("+----------+------------+------------+--------------+\n");
+    printf("Total results found: %lu\n", groups);
+    buildTimer.print("Q3");
+    const double ms = loop.stats().median;
+    loop.print("Q3 CPU backend time");
+    printReadStats("Q3 column loads", takeReadStats());
+    printSpillStats("Q3 spill", takeSpillStats());
+    printIntermediates("Q3 intermediates", takeIntermediates());
+    printMergeJoins("Q3 merge join", takeMergeJoins());
+    printJoinIndexStats("Q3 join indexes", takeJoinIndexStats());
+    printPerfStages("Q3 hardware counters", "q3 ");
+    printHugePageReport("Q3 huge pages");
+    reportNuma("Q3 NUMA", pool, catalog, "q3", catalog.snapshot("lineitem").intView(0), loop.samples().size());
+    if (rooflineEnabled()) printRoofline("Q3 roofline", stageTraffic(catalog, "q3"));
+    printf("Total TPC-H Q3 CPU backend time: %0.2f ms\n", ms);
+    printf("Total TPC-H Q3 wall-clock: %0.2f ms\n", ms);
+    if (g_results.enabled()) {
+        ResultRecord rec = tpchResult("q3", "cpu", describe(params), loop, catalog, groups);
+        rec.threads = pool.size();
+        rec.addBuildStages(buildTimer);
+        rec.stages.emplace_back("execute", ms);
+        g_results.emit(rec);
+    }
+}
+
+void runCpuQ6Benchmark(ColumnCatalog& catalog, WorkerPool& pool, const Q6Params& params) {
+    std::cout << "--- Running TPC-H Query 6 Benchmark (CPU, " << pool.size() << " threads" << tunedKnobs("q6") << ") ---" << std::endl;
+    std::cout << "Parameters: " << describe(params) << std::endl;
+    double revenue = 0.0;
+    scratchArena().takeStats(); // drop earlier queries' numbers
+    BenchLoop loop;
+    while (loop.next()) {
+        auto start = std::chrono::high_resolution_clock::now();
+        revenue = cpuExecuteQ6(catalog, pool, params);
+        loop.record(elapsedMs(start));
+    }
+    printf("TPC-H Query 6 Result:\nTotal Revenue: $%.2f\n", revenue);
+    const double ms = loop.stats().median;
+    loop.print("Q6 CPU backend time");
+    printReadStats("Q6 column loads", takeReadStats());
+    printScratchStats("Q6 scratch", scratchArena().takeStats());
+    printPerfStages("Q6 hardware counters", "q6 ");
+    printHugePageReport("Q6 huge pages");
+    reportNuma("Q6 NUMA", pool, catalog, "q6", catalog.snapshot("lineitem").dateView(10), loop.samples().size());
+    if (rooflineEnabled()) printRoofline("Q6 roofline", stageTraffic(catalog, "q6"));
+    printf("Total TPC-H Q6 CPU backend time: %0.2f ms\n", ms);
+    printf("Total TPC-H Q6 wall-clock: %0.2f ms\n", ms);
+    if (g_results.enabled()) {
+        ResultRecord rec = tpchResult("q6", "cpu", describe(params), loop, catalog, 1);
+        rec.threads = pool.size();
+        rec.stages.emplace_back("execute", ms);
+        g_results.emit(rec);
+    }
+}
+
+void runCpuQ9Benchmark(ColumnCatalog& catalog, WorkerPool& pool, const Q9Params& params) {
+    std::cout << "\n--- Running TPC-H Query 9 Benchmark (CPU, " << pool.size() << " threads" << tunedKnobs("q9") << ") ---" << std::endl;
+    std::cout << "Parameters: " << describe(params) << std::endl;
+    std::vector<CpuQ9Row> rows;
+    BuildPhaseTimer buildTimer;
+    scratchArena().takeStats(); // drop earlier queries' numbers
+    takeMergeJoins();
+    takeJoinIndexStats();
+    BenchLoop loop;
+    while (loop.next()) {
+        BuildStats build;
+        auto start = std::chrono::high_resolution_clock::now();
+        rows = cpuExecuteQ9(catalog, pool, params, &build);
+        loop.record(elapsedMs(start));
+        buildTimer.record(build);
+    }
+    const auto n_nationkey = catalog.intColumn("nation", 0);
+    const auto n_name = catalog.charColumn("nation", 1, 25);
+    std::map<int, std::string> nation_names;
+    for (size_t i = 0; i < n_nationkey.size(); ++i) nation_names[n_nationkey[i]] = std::string(fixedString(n_name.data() + i * 25, 25));
+
+    printf("\nTPC-H Query 9 Results (Top 15):\n");
+    printf("+------------+------+---------------+\n");
+    printf("| Nation     | Year |        Profit |\n");
+    printf("+------------+------+---------------+\n");
+    for (size_t i = 0; i < 15 && i < rows.size(); ++i) {
+        printf("| %-10s | %4d | $%13.2f |\n", nation_names[rows[i].nationkey].c_str(), rows[i].year, rows[i].profit);
+    }
+    printf("+------------+------+---------------+\n");
+    printf("Total results found: %lu\n", rows.size());
+    std::map<int, double> year_totals;
+    for (const auto& r : rows) year_totals[r.year] += r.profit;
+    printf("\nComparable TPC-H Q9 (yearly sum_profit):\n");
+    printf("+--------+---------------+\n");
+    printf("| o_year |   sum_profit  |\n");
+    printf("+--------+---------------+\n");
+    for (const auto& kv : year_totals) printf("| %6d | %13.4f |\n", kv.first, kv.second);
+    printf("+--------+---------------+\n");
+    buildTimer.print("Q9");
+    const double ms = loop.stats().median;
+    loop.print("Q9 CPU backend time");
+    printReadStats("Q9 column loads", takeReadStats());
+    printScratchStats("Q9 scratch", scratchArena().takeStats());
+    printMergeJoins("Q9 merge join", takeMergeJoins());
+    printJoinIndexStats("Q9 join indexes", takeJoinIndexStats());
+    printPerfStages("Q9 hardware counters", "q9 ");
+    printHugePageReport("Q9 huge pages");
+    reportNuma("Q9 NUMA", pool, catalog, "q9", catalog.snapshot("lineitem").intView(1), loop.samples().size());
+    if (rooflineEnabled()) printRoofline("Q9 roofline", stageTraffic(catalog, "q9", params.color));
+    printf("Total TPC-H Q9 CPU backend time: %0.2f ms\n", ms);
+    printf("Total TPC-H Q9 wall-clock: %0.2f ms\n", ms);
+    if (g_results.enabled()) {
+        ResultRecord rec = tpchResult("q9", "cpu", describe(params), loop, catalog, rows.size());
+        rec.threads = pool.size();
+        rec.addBuildStages(buildTimer);
+        rec.stages.emplace_back("execute", ms);
+        g_results.emit(rec);
+    }
+}
+
+void runCpuQ13Benchmark(ColumnCatalog& catalog, WorkerPool& pool, const Q13Params& params) {
+    std::cout << "\n--- Running TPC-H Query 13 Benchmark (CPU, " << pool.size() << " threads" << tunedKnobs("q13") << ") ---" << std::endl;
+    std::cout << "Parameters: " << describe(params) << std::endl;
+    std::vector<CpuQ13Row> rows;
+    scratchArena().takeStats(); // drop earlier queries' numbers
+    takeSpillStats();
+    BenchLoop loop;
+    while (loop.next()) {
+        auto start = std::chrono::high_resolution_clock::now();
+        rows = cpuExecuteQ13(catalog, pool, params);
+        loop.record(elapsedMs(start));
+    }
+    printf("\nTPC-H Query 13 Results (Comparable histogram):\n");
+    printf("+---------+----------+\n");
+    printf("| c_count | custdist |\n");
+    printf("+---------+----------+\n");
+    for (const auto& r : rows) printf("| %7u | %8u |\n", r.c_count, r.custdist);
+    printf("+---------+----------+\n");
+    const double ms = loop.stats().median;
+    loop.print("Q13 CPU backend time");
+    printReadStats("Q13 column loads", takeReadStats());
+    printScratchStats("Q13 scratch", scratchArena().takeStats());
+    printSpillStats("Q13 spill", takeSpillStats());
+    printPerfStages("Q13 hardware counters", "q13 ");
+    printHugePageReport("Q13 huge pages");
+    reportNuma("Q13 NUMA", pool, catalog, "q13", catalog.snapshot("orders").intView(1), loop.samples().size());
+    if (rooflineEnabled()) printRoofline("Q13 roofline", stageTraffic(catalog, "q13"));
+    printf("Total TPC-H Q13 CPU backend time: %0.2f ms\n", ms);
+    printf("Total TPC-H Q13 wall-clock: %0.2f ms\n", ms);
+    if (g_results.enabled()) {
+        ResultRecord rec = tpchResult("q13", "cpu", describe(params), loop, catalog, rows.size());
+        rec.threads = pool.size();
+        rec.stages.emplace_back("execute", ms);
+        g_results.emit(rec);
+    }
+}
+
+bool cpuExecuteQuery(const std::string& query, ColumnCatalog& catalog, WorkerPool& pool, const TpchParams& params) {
+    if (query == "q1") cpuExecuteQ1(catalog, pool, params.q1);
+    else if (query == "q3") cpuExecuteQ3(catalog, pool, params.q3, nullptr, 10);
+    else if (query == "q6") cpuExecuteQ6(catalog, pool, params.q6);
+    else if (query == "q9") cpuExecuteQ9(catalog, pool, params.q9);
+    else if (query == "q13") cpuExecuteQ13(catalog, pool, params.q13);
+    else return false;
+    return true;
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ColumnCatalog.hpp"
+#include "TpchParams.hpp"
+#include "WorkerPool.hpp"
+
+// --- CPU Backend ---
+// Morsel-driven implementations of the TPC-H queries on the shared WorkerPool.
+// They follow the GPU plans (bitmaps / direct maps for dimensions, integer-cent
+// Q1 bins, per-worker local aggregation + merge) so the two backends are
+// comparable, and read their columns from the shared ColumnCatalog.
+
+struct CpuQ1Row {
+    char returnflag, linestatus;
+    double sum_qty, sum_base_price, sum_disc_price, sum_charge, avg_qty, avg_price, avg_disc;
+    uint64_t count;
+};
+
+// Q1 accumulators in the same integer-cent / hundredths fixed point as
+// q1_bins_accumulate_int_stage1, one bin per (returnflag, linestatus). Signed,
+// so incremental maintenance can subtract deleted rows exactly.
+struct CpuQ1Bins {
+    int64_t qty[6] = {}, base[6] = {}, disc[6] = {}, charge[6] = {}, disc_bp[6] = {}, count[6] = {};
+
+    void add(char returnflag, char linestatus, float quantity, float extendedprice, float discount, float tax, int sign = 1) {
+        int rfi = (returnflag == 'A') ? 0 : (returnflag == 'N') ? 1 : (returnflag == 'R') ? 2 : -1;
+        int lsi = (linestatus == 'F') ? 0 : (linestatus == 'O') ? 1 : -1;
+        if (rfi < 0 || lsi < 0) return;
+        int bin = rfi * 2 + lsi;
+
+        int64_t base_c = (int64_t)std::floor(extendedprice * 100.0f + 0.5f);
+        int64_t qty_c = (int64_t)std::floor(quantity * 100.0f + 0.5f);
+        int d_bp = (int)std::floor(discount * 100.0f + 0.5f);
+        int t_bp = (int)std::floor(tax * 100.0f + 0.5f);
+        int64_t disc_c = (base_c * (int64_t)(100 - d_bp) + 50) / 100;
+        int64_t charge_c = (disc_c * (int64_t)(100 + t_bp) + 50) / 100;
+
+        qty[bin] += sign * qty_c;
+        base[bin] += sign * base_c;
+        disc[bin] += sign * disc_c;
+        charge[bin] += sign * charge_c;
+        disc_bp[bin] += sign * d_bp;
+        count[bin] += sign;
+    }
+    void merge(const CpuQ1Bins& other);
+    std::vector<CpuQ1Row> rows() const; // non-empty bins in (returnflag, linestatus) order
+};
+
+struct CpuQ3Row {
+    int orderkey;
+    double revenue;
+    int orderdate;
+    int shippriority;
+};
+
+struct CpuQ9Row {
+    int nationkey;
+    int year;
+    double profit;
+};
+
+struct CpuQ13Row {
+    uint32_t c_count;
+    uint32_t custdist;
+};
+
+// Q3 payload materialization. Early: the probe carries orderkey and the
+// merge copies orderdate/shippriority into every group before sorting them
+// all. Late: filter and join pass position lists, groups are keyed by orders
+// row, and payload columns are fetched for the top-k groups only. Each Q3 run
+// reports the intermediate bytes of the chosen mode. The switch applies to the
+// map join only: the merge and index joins always materialize late and the
+// partitioned (spilling) join early; Q3 prints a note when a mode requested
+// with --materialization was overridden.
+enum class Materialization { Early, Late };
+Materialization& cpuMaterialization();
+bool& cpuMaterializationRequested(); // --materialization was given (not the default)
+bool parseMaterialization(const std::string& name, Materialization& out); // early, late
+const char* materializationName(Materialization mode);
+
+// Q3/Q9 join of lineitem with orders on orderkey. Map: probe the orders
+// direct map (random access). Merge: both tables are clustered by orderkey,
+// so co-partitioned key ranges of the two are walked with one cursor each
+// (sequential access, no build). Merge falls back to the map when either
+// table is not sorted by orderkey. Index: gather through the persisted
+// lineitem foreign-key indexes (JoinIndex.hpp), which Q9 also uses for
+// supplier and partsupp; falls back to the maps on tables with deltas.
+enum class JoinStrategy { Map, Merge, Index };
+JoinStrategy& cpuJoinStrategy();
+bool parseJoinStrategy(const std::string& name, JoinStrategy& out); // map, merge, index
+const char* joinStrategyName(JoinStrategy strategy);
+
+// Per-query knobs of the CPU plans ("q1", "q3", "q6", "q9", "q13"). Zero keeps
+// the hand-set default; the auto-tuner (AutoTuner.hpp) searches them and its
+// profile sets them at startup. None of them changes a result.
+struct CpuTuning {
+    size_t morsel = 0;       // rows per morsel of the main scan/probe (default 64K, Q13 16K)
+    unsigned prefetch = 0;   // Q3/Q9 map probes: rows ahead whose map slots are prefetched (the GPU probe's BATCH_SIZE)
+    unsigned localSlots = 0; // Q13: per-worker direct-mapped count table in front of the shared counts (the GPU local_ht_size)
+    unsigned threads = 0;    // workers for the query's benchmark runs; 0 = the --threads pool
+};
+// Unknown names get a shared all-default entry; the table never grows, so concurrent streams may read it.
+CpuTuning& cpuTuning(const std::string& query);
+
+std::vector<CpuQ1Row> cpuExecuteQ1(ColumnCatalog& catalog, WorkerPool& pool, const Q1Params& params);
+// Q3 and Q9 take their dimension build structures from catalog.buildCache();
+// build (optional) receives the build-phase time and hit/miss counts.
+// Q3 is sorted; limit > 0 keeps the first `limit` groups, groups (optional) receives the total.
+std::vector<CpuQ3Row> cpuExecuteQ3(ColumnCatalog& catalog, WorkerPool& pool, const Q3Params& params, BuildStats* build = nullptr,
+                                   size_t limit = 0, size_t* groups = nullptr);
+double cpuExecuteQ6(ColumnCatalog& catalog, WorkerPool& pool, const Q6Params& params);
+std::vector<CpuQ9Row> cpuExecuteQ9(ColumnCatalog& catalog, WorkerPool& pool, const Q9Params& params, BuildStats* build = nullptr);
+std::vector<CpuQ13Row> cpuExecuteQ13(ColumnCatalog& catalog, WorkerPool& pool, const Q13Params& params);
+
+// Benchmark wrappers: banner, g_harness warm-up + measured executions, result table,
+// timing statistics and the median timing lines.
+void runCpuQ1Benchmark(ColumnCatalog& catalog, WorkerPool& pool, const Q1Params& params);
+void runCpuQ3Benchmark(ColumnCatalog& catalog, WorkerPool& pool, const Q3Params& params);
+void runCpuQ6Benchmark(ColumnCatalog& catalog, WorkerPool& pool, const Q6Params& params);
+void runCpuQ9Benchmark(ColumnCatalog& catalog, WorkerPool& pool, const Q9Params& params);
+void runCpuQ13Benchmark(ColumnCatalog& catalog, WorkerPool& pool, const Q13Params& params);
+
+// Single quiet execution by name ("q1", "q3", ...); false for an unknown query.
+bool cpuExecuteQuery(const std::string& query, ColumnCatalog& catalog, WorkerPool& pool, const TpchParams& params);
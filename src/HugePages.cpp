@@ -0,0 +1,185 @@
+#include "HugePages.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <unordered_map>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+namespace {
+
+constexpr size_t k2M = size_t(2) << 20;
+constexpr size_t k1G = size_t(1) << 30;
+constexpr std::align_val_t kAlign{64}; // heap fallback keeps cache-line alignment
+
+#ifdef __linux__
+// <linux/mman.h> values, spelled out for older headers
+constexpr int kMapHugeShift = 26;
+constexpr int kMapHuge2M = 21 << kMapHugeShift;
+constexpr int kMapHuge1G = 30 << kMapHugeShift;
+constexpr int kMadvCollapse = 25;
+#endif
+
+enum class Backing { Explicit, Transparent, Regular };
+
+struct Mapping {
+    void* base = nullptr; // start of the mapping (may precede the returned pointer)
+    size_t length = 0;
+    Backing backing = Backing::Regular;
+    size_t bytes = 0;     // as requested
+};
+
+std::mutex g_mutex;
+std::unordered_map<void*, Mapping> g_mappings; // mmap'ed allocations, by returned pointer
+std::atomic<uint64_t> g_live[3];
+std::atomic<uint64_t> g_collapsed{0};
+
+size_t roundUp(size_t n, size_t a) { return (n + a - 1) / a * a; }
+
+#ifdef __linux__
+void* mapExplicit(size_t bytes, HugePageMode mode, Mapping& m) {
+    const size_t page = mode == HugePageMode::Explicit1G ? k1G : k2M;
+    const int sizeFlag = mode == HugePageMode::Explicit1G ? kMapHuge1G : kMapHuge2M;
+    m.length = roundUp(bytes, page);
+    void* p = mmap(nullptr, m.length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | sizeFlag, -1, 0);
+    if (p == MAP_FAILED) return nullptr;
+    m.base = p;
+    m.backing = Backing::Explicit;
+    return p;
+}
+
+// 2 MB aligned anonymous mapping: over-map by 2 MB, then trim both ends.
+void* mapTransparent(size_t bytes, Mapping& m) {
+    const size_t length = roundUp(bytes, k2M);
+    char* raw = (char*)mmap(nullptr, length + k2M, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == (char*)MAP_FAILED) return nullptr;
+    char* aligned = (char*)roundUp((uintptr_t)raw, k2M);
+    if (aligned > raw) munmap(raw, aligned - raw);
+    if (aligned + length < raw + length + k2M) munmap(aligned + length, raw + length + k2M - (aligned + length));
+    m.base = aligned;
+    m.length = length;
+    const bool advised = madvise(aligned, length, MADV_HUGEPAGE) == 0;
+    m.backing = advised ? Backing::Transparent : Backing::Regular;
+    return aligned;
+}
+#endif
+
+} // namespace
+
+
+// --- Configuration ---
+HugePageConfig& hugePageConfig() {
+    static HugePageConfig config;
+    return config;
+}
+
+bool parseHugePageMode(const std::string& name, HugePageMode& out) {
+    if (name == "off") out = HugePageMode::Off;
+    else if (name == "thp") out = HugePageMode::Transparent;
+    else if (name == "2m") out = HugePageMode::Explicit2M;
+    else if (name == "1g") out = HugePageMode::Explicit1G;
+    else return false;
+    return true;
+}
+
+const char* hugePageModeName(HugePageMode mode) {
+    switch (mode) {
+        case HugePageMode::Transparent: return "thp";
+        case HugePageMode::Explicit2M: return "2m";
+        case HugePageMode::Explicit1G: return "1g";
+        default: return "off";
+    }
+}
+
+
+// --- Allocation ---
+void* allocateLarge(size_t bytes) {
+    const HugePageConfig& config = hugePageConfig();
+    if (config.mode == HugePageMode::Off || bytes < config.minBytes) return ::operator new(bytes, kAlign);
+#ifdef __linux__
+    Mapping m;
+    m.bytes = bytes;
+    void* p = nullptr;
+    if (config.mode == HugePageMode::Explicit2M || config.mode == HugePageMode::Explicit1G) {
+        p = mapExplicit(bytes, config.mode, m);
+        if (!p) {
+            static std::once_flag warned;
+            std::call_once(warned, [] { fprintf(stderr, "Huge pages: MAP_HUGETLB failed (none reserved?); falling back to THP\n"); });
+        }
+    }
+    if (!p) p = mapTransparent(bytes, m);
+    if (!p) throw std::bad_alloc();
+    g_live[(int)m.backing].fetch_add(bytes, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(g_mutex);
+    g_mappings[p] = m;
+    return p;
+#else
+    return ::operator new(bytes, kAlign);
+#endif
+}
+
+void freeLarge(void* p, size_t) {
+    if (!p) return;
+    if (hugePageConfig().mode == HugePageMode::Off) { ::operator delete(p, kAlign); return; } // nothing was mapped
+    Mapping m;
+    {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        auto it = g_mappings.find(p);
+        if (it == g_mappings.end()) {
+            ::operator delete(p, kAlign);
+            return;
+        }
+        m = it->second;
+        g_mappings.erase(it);
+    }
+    g_live[(int)m.backing].fetch_sub(m.bytes, std::memory_order_relaxed);
+#ifdef __linux__
+    munmap(m.base, m.length);
+#endif
+}
+
+void adviseHugePages(const void* p, size_t bytes) {
+    const HugePageConfig& config = hugePageConfig();
+    if (config.mode == HugePageMode::Off || !p || bytes < config.minBytes) return;
+#ifdef __linux__
+    char* begin = (char*)roundUp((uintptr_t)p, k2M);
+    char* end = (char*)(((uintptr_t)p + bytes) / k2M * k2M);
+    if (end <= begin) return;
+    if (madvise(begin, end - begin, MADV_HUGEPAGE) != 0) return;
+    // Synchronous collapse (Linux 6.1+); older kernels leave it to khugepaged
+    if (madvise(begin, end - begin, kMadvCollapse) == 0) g_collapsed.fetch_add(end - begin, std::memory_order_relaxed);
+#endif
+}
+
+
+// --- Report ---
+HugePageStats hugePageStats() {
+    HugePageStats s;
+    s.explicitBytes = g_live[(int)Backing::Explicit].load(std::memory_order_relaxed);
+    s.transparentBytes = g_live[(int)Backing::Transparent].load(std::memory_order_relaxed);
+    s.regularBytes = g_live[(int)Backing::Regular].load(std::memory_order_relaxed);
+    s.collapsedBytes = g_collapsed.load(std::memory_order_relaxed);
+    return s;
+}
+
+void printHugePageReport(const char* label) {
+    const HugePageMode mode = hugePageConfig().mode;
+    if (mode == HugePageMode::Off) return;
+    const HugePageStats s = hugePageStats();
+    constexpr double MB = 1024.0 * 1024.0;
+    printf("%s (%s): explicit %.1f MB, THP %.1f MB, 4K fallback %.1f MB, columns collapsed %.1f MB",
+           label, hugePageModeName(mode), s.explicitBytes / MB, s.transparentBytes / MB, s.regularBytes / MB, s.collapsedBytes / MB);
+    // What the kernel actually backs with huge pages (THP only; explicit pages are not counted here)
+    std::ifstream rollup("/proc/self/smaps_rollup");
+    std::string line;
+    while (std::getline(rollup, line)) {
+        unsigned long long kb = 0;
+        if (sscanf(line.c_str(), "AnonHugePages: %llu kB", &kb) == 1) { printf("; process AnonHugePages %.1f MB", kb / 1024.0); break; }
+    }
+    printf("\n");
+}
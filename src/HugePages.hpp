@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <string>
+#include <vector>
+
+// --- Huge Pages ---
+// Large random-access structures (Q3/Q9 build maps and hash tables, scratch
+// arena blocks) and loaded columns can be backed by huge pages so probes stop
+// missing the TLB on every 4 KB page. Allocations of at least minBytes go to
+// explicit huge pages (mmap with MAP_HUGETLB, 2 MB or 1 GB), falling back to a
+// 2 MB aligned mapping with madvise(MADV_HUGEPAGE) (transparent huge pages),
+// and to regular pages when that fails too. Columns are already populated
+// when loaded, so they get MADV_HUGEPAGE and, where the kernel supports it,
+// MADV_COLLAPSE on their 2 MB aligned interior. The mode is process-wide and
+// set once before any data is loaded; running a benchmark with `off` and with
+// `thp`/`2m` (with --perf-counters for dTLB misses) is the A/B comparison.
+// Off Linux every mode behaves as `off`.
+
+enum class HugePageMode { Off, Transparent, Explicit2M, Explicit1G };
+
+struct HugePageConfig {
+    HugePageMode mode = HugePageMode::Off;
+    size_t minBytes = size_t(2) << 20;
+};
+
+HugePageConfig& hugePageConfig();
+bool parseHugePageMode(const std::string& name, HugePageMode& out); // off, thp, 2m, 1g
+const char* hugePageModeName(HugePageMode mode);
+
+// Cache-line (or page) aligned memory for large structures; release with freeLarge().
+void* allocateLarge(size_t bytes);
+void freeLarge(void* p, size_t bytes);
+
+// Hints an already-populated range (a loaded column) towards huge pages.
+void adviseHugePages(const void* p, size_t bytes);
+
+// Live bytes by backing, as allocated by allocateLarge (columns not included).
+struct HugePageStats {
+    uint64_t explicitBytes = 0;
+    uint64_t transparentBytes = 0; // THP requested; the kernel may still use 4 KB pages
+    uint64_t regularBytes = 0;     // at or above the threshold, but no huge pages available
+    uint64_t collapsedBytes = 0;   // column bytes collapsed into huge pages by MADV_COLLAPSE
+};
+HugePageStats hugePageStats();
+
+// "<label> (thp): explicit 0.0 MB, THP 412.0 MB, ...; process AnonHugePages 400.0 MB"; nothing when off.
+void printHugePageReport(const char* label);
+
+// std::allocator replacement routing through allocateLarge().
+template <typename T>
+struct HugePageAllocator {
+    using value_type = T;
+
+    HugePageAllocator() = default;
+    template <typename U>
+    HugePageAllocator(const HugePageAllocator<U>&) {}
+
+    T* allocate(size_t n) { return static_cast<T*>(allocateLarge(n * sizeof(T))); }
+    void deallocate(T* p, size_t n) { freeLarge(p, n * sizeof(T)); }
+
+    template <typename U>
+    bool operator==(const HugePageAllocator<U>&) const { return true; }
+};
+
+template <typename T>
+using LargeVector = std::vector<T, HugePageAllocator<T>>;
@@ -0,0 +1,239 @@
+#include "IncrementalAggregates.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+
+namespace {
+
+template <typename T>
+struct alignas(64) WorkerLocal {
+    T value{};
+};
+
+// Lineitem columns read by the Q1 and Q6 views
+struct LineitemViews {
+    explicit LineitemViews(const TableSnapshot& snap)
+        : returnflag(snap.charView(8)), linestatus(snap.charView(9)), quantity(snap.floatView(4)),
+          extendedprice(snap.floatView(5)), discount(snap.floatView(6)), tax(snap.floatView(7)), shipdate(snap.dateView(10)) {}
+
+    ColumnView<char> returnflag, linestatus;
+    ColumnView<float> quantity, extendedprice, discount, tax;
+    ColumnView<int> shipdate;
+};
+
+// Same predicate as cpuExecuteQ6; revenue as extendedprice cents x discount hundredths
+inline int64_t q6Revenue(const LineitemViews& v, size_t i, int date, int endDate, float minDiscount, float maxDiscount, float maxQuantity) {
+    if (v.shipdate[i] < date || v.shipdate[i] >= endDate) return 0;
+    if (v.discount[i] < minDiscount || v.discount[i] > maxDiscount || v.quantity[i] >= maxQuantity) return 0;
+    int64_t base_c = (int64_t)std::floor(v.extendedprice[i] * 100.0f + 0.5f);
+    int64_t d_bp = (int64_t)std::floor(v.discount[i] * 100.0f + 0.5f);
+    return base_c * d_bp;
+}
+
+Q6Params q6Params(const std::tuple<int, int, int>& key) {
+    Q6Params p;
+    std::tie(p.date, p.discountPct, p.quantity) = key;
+    return p;
+}
+
+double elapsedMs(std::chrono::high_resolution_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+bool sameQ1(const std::vector<CpuQ1Row>& a, const std::vector<CpuQ1Row>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].returnflag != b[i].returnflag || a[i].linestatus != b[i].linestatus || a[i].count != b[i].count ||
+            a[i].sum_qty != b[i].sum_qty || a[i].sum_base_price != b[i].sum_base_price ||
+            a[i].sum_disc_price != b[i].sum_disc_price || a[i].sum_charge != b[i].sum_charge) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+
+// --- Maintained Views ---
+IncrementalAggregates::IncrementalAggregates(ColumnCatalog& catalog, WorkerPool& pool)
+    : m_catalog(catalog), m_pool(pool), m_seen(catalog.snapshot("lineitem")) {}
+
+void IncrementalAggregates::trackQ1(const Q1Params& params) {
+    const int cutoff = params.cutoffDate();
+    if (m_q1.count(cutoff)) return;
+    const LineitemViews v(m_seen);
+    std::vector<WorkerLocal<CpuQ1Bins>> locals(m_pool.size());
+    m_pool.parallelFor(m_seen.rows(), WorkerPool::kDefaultMorsel, [&](size_t begin, size_t end, unsigned worker) {
+        CpuQ1Bins& b = locals[worker].value;
+        for (size_t i = begin; i < end; ++i) {
+            if (m_seen.isDeleted(i) || v.shipdate[i] > cutoff) continue;
+            b.add(v.returnflag[i], v.linestatus[i], v.quantity[i], v.extendedprice[i], v.discount[i], v.tax[i]);
+        }
+    });
+    m_q1Params.push_back(params);
+    CpuQ1Bins& bins = m_q1[cutoff];
+    for (const auto& l : locals) bins.merge(l.value);
+}
+
+void IncrementalAggregates::trackQ6(const Q6Params& params) {
+    const Q6Key key{params.date, params.discountPct, params.quantity};
+    if (m_q6.count(key)) return;
+    const LineitemViews v(m_seen);
+    const int endDate = params.endDate();
+    const float minDiscount = params.minDiscount(), maxDiscount = params.maxDiscount(), maxQuantity = (float)params.quantity;
+    std::vector<WorkerLocal<int64_t>> locals(m_pool.size());
+    m_pool.parallelFor(m_seen.rows(), WorkerPool::kDefaultMorsel, [&](size_t begin, size_t end, unsigned worker) {
+        int64_t revenue = 0;
+        for (size_t i = begin; i < end; ++i) {
+            if (!m_seen.isDeleted(i)) revenue += q6Revenue(v, i, params.date, endDate, minDiscount, maxDiscount, maxQuantity);
+        }
+        locals[worker].value += revenue;
+    });
+    int64_t& total = m_q6[key];
+    for (const auto& l : locals) total += l.value;
+}
+
+void IncrementalAggregates::applyRows(const TableSnapshot& snap, const std::vector<size_t>& rows, int sign) {
+    if (rows.empty()) return;
+    const LineitemViews v(snap);
+    for (auto& [cutoff, bins] : m_q1) {
+        for (size_t i : rows) {
+            if (v.shipdate[i] <= cutoff) bins.add(v.returnflag[i], v.linestatus[i], v.quantity[i], v.extendedprice[i], v.discount[i], v.tax[i], sign);
+        }
+    }
+    for (auto& [key, revenue] : m_q6) {
+        const Q6Params p = q6Params(key);
+        const int endDate = p.endDate();
+        const float minDiscount = p.minDiscount(), maxDiscount = p.maxDiscount(), maxQuantity = (float)p.quantity;
+        for (size_t i : rows) revenue += sign * q6Revenue(v, i, p.date, endDate, minDiscount, maxDiscount, maxQuantity);
+    }
+}
+
+void IncrementalAggregates::recomputeAll(const TableSnapshot& snap) {
+    std::vector<Q1Params> q1Views = m_q1Params;
+    std::vector<Q6Key> q6Keys;
+    for (const auto& kv : m_q6) q6Keys.push_back(kv.first);
+    m_q1.clear();
+    m_q1Params.clear();
+    m_q6.clear();
+    m_seen = snap;
+    for (const auto& p : q1Views) trackQ1(p);
+    for (const auto& key : q6Keys) trackQ6(q6Params(key));
+}
+
+IvmSyncStats IncrementalAggregates::sync() {
+    auto start = std::chrono::high_resolution_clock::now();
+    IvmSyncStats stats;
+    const TableSnapshot cur = m_catalog.snapshot("lineitem");
+    if (cur.version() == m_seen.version()) return stats;
+
+    if (cur.mergeGeneration() != m_seen.mergeGeneration()) {
+        // A merge keeps the visible rows and only renumbers them. If it folded
+        // exactly the version we had seen, the state is still exact.
+        if (cur.mergeGeneration() == m_seen.mergeGeneration() + 1 && cur.version() == m_seen.version() + 1) {
+            stats.rebased = true;
+            m_seen = cur;
+        } else {
+            stats.recomputed = true;
+            recomputeAll(cur);
+        }
+        stats.ms = elapsedMs(start);
+        return stats;
+    }
+
+    // Same generation: seen positions are unchanged, delta rows only append
+    const size_t seenRows = m_seen.rows();
+    std::vector<size_t> deleted, inserted;
+    const std::vector<uint64_t>* oldBits = m_seen.deletedBitmap();
+    const std::vector<uint64_t>* newBits = cur.deletedBitmap();
+    if (newBits && newBits != oldBits) {
+        const size_t words = (seenRows + 63) / 64;
+        for (size_t w = 0; w < words && w < newBits->size(); ++w) {
+            uint64_t diff = (*newBits)[w] & ~((oldBits && w < oldBits->size()) ? (*oldBits)[w] : 0ull);
+            if (w + 1 == words && (seenRows & 63)) diff &= (1ull << (seenRows & 63)) - 1;
+            for (; diff; diff &= diff - 1) deleted.push_back(w * 64 + (size_t)__builtin_ctzll(diff));
+        }
+    }
+    for (size_t i = seenRows; i < cur.rows(); ++i) {
+        if (!cur.isDeleted(i)) inserted.push_back(i);
+    }
+    applyRows(cur, deleted, -1);
+    applyRows(cur, inserted, +1);
+    m_seen = cur;
+
+    stats.insertedRows = inserted.size();
+    stats.deletedRows = deleted.size();
+    stats.ms = elapsedMs(start);
+    return stats;
+}
+
+std::vector<CpuQ1Row> IncrementalAggregates::q1(const Q1Params& params) const {
+    auto it = m_q1.find(params.cutoffDate());
+    return it == m_q1.end() ? std::vector<CpuQ1Row>{} : it->second.rows();
+}
+
+double IncrementalAggregates::q6(const Q6Params& params) const {
+    auto it = m_q6.find(Q6Key{params.date, params.discountPct, params.quantity});
+    return it == m_q6.end() ? 0.0 : (double)it->second / 10000.0;
+}
+
+
+// --- Incremental Aggregate Test ---
+bool runIncrementalAggregateTest(ColumnCatalog& catalog, WorkerPool& pool, const RefreshConfig& config,
+                                 const std::vector<TpchParams>& params) {
+    const int sets = std::max(1, config.refreshSets);
+    std::cout << "\n--- Running Incremental Q1/Q6 Maintenance Test (" << params.size() << " parameter sets, "
+              << sets << " refresh sets) ---" << std::endl;
+
+    IncrementalAggregates ivm(catalog, pool);
+    auto start = std::chrono::high_resolution_clock::now();
+    for (const auto& p : params) { ivm.trackQ1(p.q1); ivm.trackQ6(p.q6); }
+    printf("Initial full scan of %zu views: %0.2f ms\n", params.size() * 2, elapsedMs(start));
+
+    // Answers from the maintained state vs a full recompute of the same version
+    bool allOk = true;
+    auto check = [&](const char* label, const IvmSyncStats& s) {
+        auto t0 = std::chrono::high_resolution_clock::now();
+        std::vector<std::vector<CpuQ1Row>> q1(params.size());
+        std::vector<double> q6(params.size());
+        for (size_t i = 0; i < params.size(); ++i) { q1[i] = ivm.q1(params[i].q1); q6[i] = ivm.q6(params[i].q6); }
+        double answerUs = elapsedMs(t0) * 1000.0;
+
+        t0 = std::chrono::high_resolution_clock::now();
+        bool ok = true;
+        for (size_t i = 0; i < params.size(); ++i) {
+            ok &= sameQ1(q1[i], cpuExecuteQ1(catalog, pool, params[i].q1));
+            double full = cpuExecuteQ6(catalog, pool, params[i].q6);
+            ok &= std::fabs(full - q6[i]) <= 1e-6 * std::max(1.0, std::fabs(full)); // full scan sums float products
+        }
+        double recomputeMs = elapsedMs(t0);
+        printf("| %-9s | %8zu | %8zu | %9.3f | %9.2f | %12.2f | %-9s |\n", label, s.insertedRows, s.deletedRows, s.ms,
+               answerUs, recomputeMs, ok ? (s.rebased ? "OK/rebase" : s.recomputed ? "OK/rescan" : "OK") : "MISMATCH");
+        if (!ok) std::cerr << "Incremental Q1/Q6 state differs from a full recompute (" << label << ")" << std::endl;
+        allOk &= ok;
+    };
+
+    printf("+-----------+----------+----------+-----------+-----------+--------------+-----------+\n");
+    printf("| step      | inserted | deleted  |  apply ms | answer us | recompute ms | check     |\n");
+    printf("+-----------+----------+----------+-----------+-----------+--------------+-----------+\n");
+    check("initial", IvmSyncStats{});
+
+    const size_t ordersPerSet = config.ordersPerSet ? config.ordersPerSet
+                                                    : std::max<size_t>(1, catalog.deltaStats("orders").mainRows / 1000);
+    RefreshGenerator generator(catalog, config.seed);
+    for (int k = 1; k <= sets; ++k) {
+        RefreshSet set = generator.next(ordersPerSet);
+        applyRF1(catalog, set);
+        applyRF2(catalog, set);
+        char label[32];
+        snprintf(label, sizeof(label), "refresh %d", k);
+        check(label, ivm.sync());
+    }
+    catalog.mergeDeltas("orders");
+    catalog.mergeDeltas("lineitem");
+    check("merge", ivm.sync());
+    printf("+-----------+----------+----------+-----------+-----------+--------------+-----------+\n");
+    return allOk;
+}
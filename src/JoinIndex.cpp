@@ -0,0 +1,225 @@
+#include "JoinIndex.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+
+namespace {
+
+constexpr uint64_t kEmpty = ~0ull;
+
+std::mutex g_statsMutex;
+JoinIndexStats g_stats;
+
+void count(uint64_t JoinIndexStats::*field, uint64_t bytes = 0) {
+    std::lock_guard<std::mutex> lock(g_statsMutex);
+    g_stats.*field += 1;
+    g_stats.bytes += bytes;
+}
+
+inline uint64_t mix64(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xFF51AFD7ED558CCDull;
+    x ^= x >> 33;
+    return x;
+}
+
+// Home slot of a key: the hash scaled onto [0, slots) by a multiply instead of a division.
+inline size_t slotOf(uint64_t key, size_t slots) {
+    return (size_t)(((unsigned __int128)mix64(key) * slots) >> 64);
+}
+
+// Key columns of each side: lineitem's foreign key and the target's primary key.
+struct KeyColumns {
+    std::vector<int> lineitem;
+    std::vector<int> target;
+};
+
+KeyColumns keyColumns(JoinIndexTarget kind) {
+    switch (kind) {
+        case JoinIndexTarget::Orders:   return {{0}, {0}};       // l_orderkey -> o_orderkey
+        case JoinIndexTarget::PartSupp: return {{1, 2}, {0, 1}}; // (l_partkey, l_suppkey) -> (ps_partkey, ps_suppkey)
+        default:                        return {{2}, {0}};       // l_suppkey -> s_suppkey
+    }
+}
+
+// A table's key per row, packed into 64 bits: one column as is, two as (first << 32 | second).
+struct PackedKey {
+    ColumnRef<int> firstColumn, secondColumn; // keep the columns alive
+    const int* first;
+    const int* second;
+    size_t rows;
+    bool paired;
+
+    PackedKey(const TableSnapshot& table, const std::vector<int>& columns)
+        : firstColumn(table.intColumn(columns[0])), secondColumn(columns.size() > 1 ? table.intColumn(columns[1]) : ColumnRef<int>()),
+          first(firstColumn.data()), second(columns.size() > 1 ? secondColumn.data() : nullptr), rows(firstColumn.size()),
+          paired(columns.size() > 1) {}
+    size_t size() const { return rows; }
+    uint64_t operator()(size_t i) const {
+        const uint64_t key = (uint32_t)first[i];
+        return paired ? key << 32 | (uint32_t)second[i] : key;
+    }
+};
+
+// Per lineitem row, the target position found by lookup(key), on the pool.
+template <typename Lookup>
+std::shared_ptr<JoinIndex> probeIndex(WorkerPool& pool, const PackedKey& lineitemKey, Lookup&& lookup) {
+    auto index = std::make_shared<JoinIndex>(lineitemKey.size());
+    pool.parallelFor(lineitemKey.size(), WorkerPool::kDefaultMorsel, [&](size_t begin, size_t end, unsigned) {
+        for (size_t i = begin; i < end; ++i) (*index)[i] = lookup(lineitemKey(i));
+    });
+    return index;
+}
+
+// Target keys go into a direct map when the key is one dense column (orders,
+// supplier), otherwise into an open-addressing table CAS-inserted in parallel
+// (keys are unique); then the lineitem keys probe it. All of it runs on the pool.
+std::shared_ptr<JoinIndex> buildIndex(WorkerPool& pool, const TableSnapshot& lineitem, const TableSnapshot& target, JoinIndexTarget kind) {
+    const KeyColumns columns = keyColumns(kind);
+    const PackedKey targetKey(target, columns.target);
+    const PackedKey lineitemKey(lineitem, columns.lineitem);
+
+    if (!targetKey.paired && directMapFits(target.intStats(columns.target[0]))) {
+        const uint64_t slots = (uint64_t)target.intStats(columns.target[0]).max + 1;
+        LargeVector<uint32_t> rows(slots, kNoJoinRow);
+        pool.parallelFor(targetKey.size(), WorkerPool::kDefaultMorsel, [&](size_t begin, size_t end, unsigned) {
+            for (size_t i = begin; i < end; ++i) rows[targetKey(i)] = (uint32_t)i;
+        });
+        return probeIndex(pool, lineitemKey, [&](uint64_t key) { return key < slots ? rows[key] : kNoJoinRow; });
+    }
+
+    const size_t slots = hashTableSlots((double)targetKey.size());
+    LargeVector<std::atomic<uint64_t>> keys(slots);
+    LargeVector<uint32_t> rows(slots);
+    pool.parallelFor(slots, WorkerPool::kDefaultMorsel, [&](size_t begin, size_t end, unsigned) {
+        for (size_t s = begin; s < end; ++s) keys[s].store(kEmpty, std::memory_order_relaxed);
+    });
+    pool.parallelFor(targetKey.size(), WorkerPool::kDefaultMorsel, [&](size_t begin, size_t end, unsigned) {
+        for (size_t i = begin; i < end; ++i) {
+            const uint64_t key = targetKey(i);
+            for (size_t slot = slotOf(key, slots);; slot = (slot + 1 == slots) ? 0 : slot + 1) {
+                uint64_t expected = kEmpty;
+                if (keys[slot].compare_exchange_strong(expected, key, std::memory_order_relaxed)) { rows[slot] = (uint32_t)i; break; }
+                if (expected == key) break;
+            }
+        }
+    });
+    return probeIndex(pool, lineitemKey, [&](uint64_t key) {
+        for (size_t slot = slotOf(key, slots);; slot = (slot + 1 == slots) ? 0 : slot + 1) {
+            const uint64_t k = keys[slot].load(std::memory_order_relaxed);
+            if (k == key) return rows[slot];
+            if (k == kEmpty) return kNoJoinRow;
+        }
+    });
+}
+
+// Latest modification of a table's .tbl file and the binary key columns beside it.
+std::filesystem::file_time_type newestSource(const std::string& tblPath, const std::vector<int>& columns) {
+    auto newest = std::filesystem::file_time_type::min();
+    std::error_code ec;
+    auto consider = [&](const std::string& path) {
+        const auto t = std::filesystem::last_write_time(path, ec);
+        if (!ec) newest = std::max(newest, t);
+    };
+    consider(tblPath);
+    for (int c : columns) consider(binaryColumnPath(tblPath, c));
+    return newest;
+}
+
+// The persisted index, if it is complete and newer than the files of both tables.
+std::shared_ptr<JoinIndex> loadIndex(const std::string& path, const TableSnapshot& lineitem, const TableSnapshot& target, JoinIndexTarget kind) {
+    std::error_code ec;
+    const auto written = std::filesystem::last_write_time(path, ec);
+    if (ec) return nullptr;
+    const KeyColumns columns = keyColumns(kind);
+    if (written < newestSource(lineitem.sourcePath(), columns.lineitem) || written < newestSource(target.sourcePath(), columns.target)) {
+        return nullptr;
+    }
+    RawColumn raw;
+    if (!readBinaryColumn(path, raw) || raw.kind != 'i' || raw.data.ints.size() != lineitem.rows()) return nullptr;
+    // Stored as int32 with -1 for no row, which is kNoJoinRow bit for bit
+    auto index = std::make_shared<JoinIndex>(raw.data.ints.size());
+    if (!index->empty()) memcpy(index->data(), raw.data.ints.data(), index->size() * sizeof(uint32_t));
+    return index;
+}
+
+// Written to a temporary name and renamed, so concurrent runs never see a partial file.
+bool persistIndex(const std::string& path, const JoinIndex& index) {
+    const std::string temporary = path + ".tmp";
+    FILE* out = fopen(temporary.c_str(), "wb");
+    if (!out) return false;
+    bool ok = writeBinaryColumnHeader(out, 'i', 1) && fwrite(index.data(), sizeof(uint32_t), index.size(), out) == index.size();
+    ok = (fclose(out) == 0) && ok;
+    std::error_code ec;
+    if (ok) std::filesystem::rename(temporary, path, ec);
+    if (!ok || ec) {
+        std::filesystem::remove(temporary, ec);
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+
+const char* joinIndexTableName(JoinIndexTarget target) {
+    switch (target) {
+        case JoinIndexTarget::Orders:   return "orders";
+        case JoinIndexTarget::PartSupp: return "partsupp";
+        default:                        return "supplier";
+    }
+}
+
+std::string joinIndexPath(const std::string& lineitemTblPath, JoinIndexTarget target) {
+    std::string base = lineitemTblPath;
+    if (base.size() >= 4 && base.compare(base.size() - 4, 4, ".tbl") == 0) base.resize(base.size() - 4);
+    return base + ".fk-" + joinIndexTableName(target) + ".col";
+}
+
+std::shared_ptr<const JoinIndex> lineitemJoinIndex(ColumnCatalog& catalog, WorkerPool& pool, const TableSnapshot& lineitem,
+                                                   const TableSnapshot& target, JoinIndexTarget kind, BuildStats* build) {
+    if (lineitem.deltaRows() || lineitem.hasDeletes() || target.deltaRows() || target.hasDeletes()) {
+        count(&JoinIndexStats::unavailable);
+        return nullptr;
+    }
+    const std::string table = joinIndexTableName(kind);
+    BuildKey key{std::string("fk.lineitem.") + table, "lineitem", "lineitem->" + table,
+                 table + "@v" + std::to_string(target.version()), lineitem.version()};
+    return catalog.buildCache().getOrBuild<JoinIndex>(key, [&](size_t& bytes) {
+        // Index files describe the tables as stored: file-backed and never merged
+        const bool stored = !lineitem.sourcePath().empty() && !target.sourcePath().empty() &&
+                            lineitem.mergeGeneration() == 0 && target.mergeGeneration() == 0;
+        const std::string path = stored ? joinIndexPath(lineitem.sourcePath(), kind) : std::string();
+        std::shared_ptr<JoinIndex> index = stored ? loadIndex(path, lineitem, target, kind) : nullptr;
+        bytes = lineitem.rows() * sizeof(uint32_t);
+        if (index) {
+            count(&JoinIndexStats::loaded, bytes);
+            return index;
+        }
+        index = buildIndex(pool, lineitem, target, kind);
+        count(&JoinIndexStats::built, bytes);
+        if (stored) {
+            if (persistIndex(path, *index)) count(&JoinIndexStats::persisted);
+            else std::cerr << "Warning: cannot write join index " << path << std::endl;
+        }
+        return index;
+    }, build);
+}
+
+JoinIndexStats takeJoinIndexStats() {
+    std::lock_guard<std::mutex> lock(g_statsMutex);
+    JoinIndexStats s = g_stats;
+    g_stats = JoinIndexStats{};
+    return s;
+}
+
+void printJoinIndexStats(const char* label, const JoinIndexStats& stats) {
+    if (stats.unavailable) printf("%s: tables have refresh deltas, probed the maps instead\n", label);
+    if (stats.loaded + stats.built == 0) return;
+    printf("%s: %llu loaded, %llu built (%llu written), %.1f MB\n", label, (unsigned long long)stats.loaded,
+           (unsigned long long)stats.built, (unsigned long long)stats.persisted, stats.bytes / (double)(1 << 20));
+}
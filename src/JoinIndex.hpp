@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ColumnCatalog.hpp"
+#include "HugePages.hpp"
+#include "WorkerPool.hpp"
+
+// --- Foreign-Key Join Indexes ---
+// Per lineitem row, the position of its orders, partsupp or supplier row
+// (kNoJoinRow = none): the fact -> dimension relationships Q3 and Q9 otherwise derive
+// every execution through maps and hash probes. An index is computed once and
+// persisted beside the binary columns as lineitem.fk-<table>.col (a 'i' binary
+// column); later runs load it while it is newer than both tables' files, and
+// the build cache keeps it across executions. Queries then gather by position,
+// with no build and no probe. An index covers table versions without refresh
+// deltas; queries fall back to their maps otherwise. Tables generated in
+// memory get their indexes built in memory only.
+
+enum class JoinIndexTarget { Orders, PartSupp, Supplier };
+using JoinIndex = LargeVector<uint32_t>;
+constexpr uint32_t kNoJoinRow = ~0u;
+
+const char* joinIndexTableName(JoinIndexTarget target); // "orders", "partsupp", "supplier"
+
+// "data/SF-1/lineitem.tbl", PartSupp -> "data/SF-1/lineitem.fk-partsupp.col"
+std::string joinIndexPath(const std::string& lineitemTblPath, JoinIndexTarget target);
+
+// Index from the lineitem snapshot's rows to the target snapshot's positions;
+// null when either has deltas. Lookups and builds count as build time; builds
+// run on the pool.
+std::shared_ptr<const JoinIndex> lineitemJoinIndex(ColumnCatalog& catalog, WorkerPool& pool, const TableSnapshot& lineitem,
+                                                   const TableSnapshot& target, JoinIndexTarget kind, BuildStats* build = nullptr);
+
+// Where the indexes came from since the last take, from all threads.
+struct JoinIndexStats {
+    uint64_t loaded = 0;      // read from index files
+    uint64_t built = 0;       // computed from the columns
+    uint64_t persisted = 0;   // of those, written to index files
+    uint64_t bytes = 0;       // loaded or built
+    uint64_t unavailable = 0; // requests on tables with deltas
+};
+JoinIndexStats takeJoinIndexStats();
+
+// "<label>: 2 loaded, 1 built (1 written), 68.6 MB"; nothing when no index was requested.
+void printJoinIndexStats(const char* label, const JoinIndexStats& stats);
@@ -0,0 +1,284 @@
+#include "Numa.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// <numaif.h> values; the syscalls are issued directly so there is no libnuma dependency
+constexpr int kMpolBind = 2;
+constexpr int kMpolInterleave = 3;
+constexpr unsigned kMpolMfMove = 1u << 1;
+
+// "0-3,8-11" -> {0, 1, 2, 3, 8, 9, 10, 11}
+std::vector<unsigned> parseCpuList(const std::string& list) {
+    std::vector<unsigned> out;
+    std::stringstream ss(list);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (item.empty() || item == "\n") continue;
+        size_t dash = item.find('-');
+        try {
+            unsigned lo = (unsigned)std::stoul(item.substr(0, dash));
+            unsigned hi = dash == std::string::npos ? lo : (unsigned)std::stoul(item.substr(dash + 1));
+            for (unsigned c = lo; c <= hi; ++c) out.push_back(c);
+        } catch (...) {
+        }
+    }
+    return out;
+}
+
+NumaTopology detectTopology() {
+    NumaTopology t;
+    std::ifstream online("/sys/devices/system/node/online");
+    std::string nodes;
+    if (online && std::getline(online, nodes)) {
+        for (unsigned node : parseCpuList(nodes)) {
+            std::ifstream cpulist("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+            std::string cpus;
+            if (!cpulist || !std::getline(cpulist, cpus)) continue;
+            auto list = parseCpuList(cpus);
+            if (list.empty()) continue; // memory-only node
+            if (t.nodeCpus.size() <= node) t.nodeCpus.resize(node + 1);
+            t.nodeCpus[node] = std::move(list);
+        }
+        // Keep node numbers as indices, but drop trailing gaps and CPU-less nodes at the end
+        while (!t.nodeCpus.empty() && t.nodeCpus.back().empty()) t.nodeCpus.pop_back();
+    }
+    if (t.nodeCpus.empty()) {
+        t.nodeCpus.emplace_back();
+        for (unsigned c = 0; c < std::max(1u, std::thread::hardware_concurrency()); ++c) t.nodeCpus[0].push_back(c);
+    }
+    return t;
+}
+
+std::vector<int> cpuToNode(const NumaTopology& t) {
+    std::vector<int> map;
+    for (unsigned node = 0; node < t.nodes(); ++node) {
+        for (unsigned cpu : t.nodeCpus[node]) {
+            if (map.size() <= cpu) map.resize(cpu + 1, 0);
+            map[cpu] = (int)node;
+        }
+    }
+    return map;
+}
+
+size_t pageSize() {
+#ifdef __linux__
+    static const size_t size = (size_t)sysconf(_SC_PAGESIZE);
+    return size;
+#else
+    return 4096;
+#endif
+}
+
+#ifdef __linux__
+// mbind over the whole pages covering [begin, begin + bytes)
+bool mbindRange(const void* begin, size_t bytes, int mode, const std::vector<unsigned long>& mask) {
+    if (bytes == 0) return true;
+    const uintptr_t page = pageSize();
+    const uintptr_t start = (uintptr_t)begin / page * page;
+    const uintptr_t end = ((uintptr_t)begin + bytes + page - 1) / page * page;
+    return syscall(SYS_mbind, (void*)start, end - start, mode, mask.data(), mask.size() * 64 + 1, kMpolMfMove) == 0;
+}
+
+std::vector<unsigned long> nodeMask(unsigned first, unsigned count) {
+    std::vector<unsigned long> mask((first + count + 63) / 64, 0);
+    for (unsigned n = first; n < first + count; ++n) mask[n / 64] |= 1ul << (n % 64);
+    return mask;
+}
+#endif
+
+struct ScanCounters {
+    unsigned nodes = 0;
+    std::unique_ptr<std::atomic<uint64_t>[]> rows;   // nodes * nodes
+    std::unique_ptr<std::atomic<uint64_t>[]> busyNs; // nodes
+};
+
+ScanCounters& scanCounters() {
+    static ScanCounters counters = [] {
+        ScanCounters c;
+        c.nodes = numaTopology().nodes();
+        c.rows.reset(new std::atomic<uint64_t>[(size_t)c.nodes * c.nodes]());
+        c.busyNs.reset(new std::atomic<uint64_t>[c.nodes]());
+        return c;
+    }();
+    return counters;
+}
+
+} // namespace
+
+
+// --- Configuration and Topology ---
+NumaConfig& numaConfig() {
+    static NumaConfig config;
+    return config;
+}
+
+bool parseNumaPolicy(const std::string& name, NumaPolicy& out) {
+    if (name == "off") out = NumaPolicy::Off;
+    else if (name == "interleave") out = NumaPolicy::Interleave;
+    else if (name == "partition") out = NumaPolicy::Partition;
+    else return false;
+    return true;
+}
+
+const char* numaPolicyName(NumaPolicy policy) {
+    switch (policy) {
+        case NumaPolicy::Interleave: return "interleave";
+        case NumaPolicy::Partition: return "partition";
+        default: return "off";
+    }
+}
+
+const NumaTopology& numaTopology() {
+    static const NumaTopology topology = detectTopology();
+    return topology;
+}
+
+unsigned numaParts() {
+    return numaConfig().policy == NumaPolicy::Partition ? numaTopology().nodes() : 1;
+}
+
+bool pinCurrentThread(unsigned cpu) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+unsigned currentNode() {
+#ifdef __linux__
+    static const std::vector<int> map = cpuToNode(numaTopology());
+    int cpu = sched_getcpu();
+    return (cpu >= 0 && (size_t)cpu < map.size()) ? (unsigned)map[cpu] : 0;
+#else
+    return 0;
+#endif
+}
+
+
+// --- Page Placement ---
+void placeColumnPages(const void* data, size_t rows, size_t rowBytes) {
+    const NumaPolicy policy = numaConfig().policy;
+    if (policy == NumaPolicy::Off || !data || rows == 0) return;
+#ifdef __linux__
+    const unsigned nodes = numaTopology().nodes();
+    static std::once_flag warned;
+    bool ok = true;
+    if (policy == NumaPolicy::Interleave) {
+        ok = mbindRange(data, rows * rowBytes, kMpolInterleave, nodeMask(0, nodes));
+    } else {
+        for (unsigned k = 0; k < nodes && ok; ++k) {
+            const size_t begin = numaRangeBegin(rows, k, nodes), end = numaRangeBegin(rows, k + 1, nodes);
+            ok = mbindRange((const char*)data + begin * rowBytes, (end - begin) * rowBytes, kMpolBind, nodeMask(k, 1));
+        }
+    }
+    if (!ok) std::call_once(warned, [] { fprintf(stderr, "NUMA: mbind failed; columns keep their first-touch placement\n"); });
+#else
+    (void)rowBytes;
+#endif
+}
+
+std::vector<std::vector<double>> pageNodeShares(const void* data, size_t bytes, unsigned parts) {
+    std::vector<std::vector<double>> shares;
+#ifdef __linux__
+    const unsigned nodes = numaTopology().nodes();
+    if (!data || bytes == 0 || parts == 0) return shares;
+    constexpr size_t kSamplesPerPart = 1024;
+    const size_t page = pageSize();
+    for (unsigned p = 0; p < parts; ++p) {
+        const size_t begin = numaRangeBegin(bytes, p, parts), end = numaRangeBegin(bytes, p + 1, parts);
+        const size_t pages = std::max<size_t>(1, (end - begin) / page);
+        const size_t step = std::max<size_t>(1, pages / kSamplesPerPart);
+        std::vector<void*> addrs;
+        for (size_t i = 0; i < pages; i += step) addrs.push_back((void*)(((uintptr_t)data + begin + i * page) / page * page));
+        std::vector<int> status(addrs.size(), -1);
+        if (syscall(SYS_move_pages, 0, addrs.size(), addrs.data(), nullptr, status.data(), 0) != 0) return {};
+        std::vector<double> share(nodes, 0.0);
+        size_t located = 0;
+        for (int s : status) {
+            if (s >= 0 && (unsigned)s < nodes) { share[s] += 1.0; ++located; }
+        }
+        if (located == 0) return {};
+        for (double& v : share) v /= (double)located;
+        shares.push_back(std::move(share));
+    }
+#else
+    (void)data; (void)bytes; (void)parts;
+#endif
+    return shares;
+}
+
+
+// --- Per-Node Scan Accounting ---
+void recordNumaMorsel(unsigned part, unsigned workerNode, size_t rows, uint64_t busyNs) {
+    ScanCounters& c = scanCounters();
+    if (part >= c.nodes || workerNode >= c.nodes) return;
+    c.rows[(size_t)part * c.nodes + workerNode].fetch_add(rows, std::memory_order_relaxed);
+    c.busyNs[workerNode].fetch_add(busyNs, std::memory_order_relaxed);
+}
+
+void resetNumaStats() {
+    if (!numaReportEnabled()) return;
+    ScanCounters& c = scanCounters();
+    for (size_t i = 0; i < (size_t)c.nodes * c.nodes; ++i) c.rows[i].store(0, std::memory_order_relaxed);
+    for (unsigned n = 0; n < c.nodes; ++n) c.busyNs[n].store(0, std::memory_order_relaxed);
+}
+
+NumaScanStats takeNumaStats() {
+    ScanCounters& c = scanCounters();
+    NumaScanStats s;
+    s.nodes = c.nodes;
+    for (size_t i = 0; i < (size_t)c.nodes * c.nodes; ++i) s.rows.push_back(c.rows[i].exchange(0, std::memory_order_relaxed));
+    for (unsigned n = 0; n < c.nodes; ++n) s.busyNs.push_back(c.busyNs[n].exchange(0, std::memory_order_relaxed));
+    return s;
+}
+
+void printNumaReport(const char* label, const NumaScanStats& stats, const std::vector<std::vector<double>>& pageShares,
+                     const std::vector<unsigned>& workersPerNode, uint64_t bytesPerExecution, size_t executions) {
+    const unsigned nodes = stats.nodes;
+    double total = 0.0, local = 0.0;
+    std::vector<double> nodeRows(nodes, 0.0);
+    for (unsigned part = 0; part < nodes; ++part) {
+        for (unsigned n = 0; n < nodes; ++n) {
+            const double r = (double)stats.rows[(size_t)part * nodes + n];
+            if (r == 0.0) continue;
+            total += r;
+            nodeRows[n] += r;
+            if (part < pageShares.size()) local += r * pageShares[part][n];
+            else if (pageShares.empty() && part == n) local += r;
+        }
+    }
+    if (total == 0.0) return;
+    printf("%s (%s, %u node%s%s): local %.1f%%, remote %.1f%%%s\n", label, numaPolicyName(numaConfig().policy), nodes,
+           nodes == 1 ? "" : "s", numaPinned() ? ", pinned" : "", 100.0 * local / total, 100.0 * (total - local) / total,
+           pageShares.empty() ? " (page locations unavailable; by range owner)" : "");
+    const double bytes = (double)bytesPerExecution * (double)executions;
+    for (unsigned n = 0; n < nodes; ++n) {
+        const unsigned workers = n < workersPerNode.size() ? workersPerNode[n] : 0;
+        const double busySec = workers ? (double)stats.busyNs[n] / workers / 1e9 : 0.0;
+        const double share = nodeRows[n] / total;
+        printf("  node %u: %u worker%s, %5.1f%% of rows", n, workers, workers == 1 ? "" : "s", 100.0 * share);
+        if (busySec > 0.0 && bytes > 0.0) printf(", %.2f GB/s", bytes * share / busySec / 1e9);
+        printf("\n");
+    }
+}
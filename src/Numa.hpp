@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// --- NUMA Placement ---
+// Column pages and worker threads on multi-socket machines. With the default
+// policy nothing changes: columns land wherever the loading thread's first
+// touch put them and workers float. `interleave` spreads every loaded column's
+// pages round-robin over the nodes; `partition` binds rows [n*k/N, n*(k+1)/N)
+// of each column to node k and pins the workers, and the worker pool then
+// splits every parallelFor the same way so each worker takes morsels from its
+// own node's range first and steals from the others when it runs dry. Pages are
+// moved with mbind(2) and located with move_pages(2) (raw syscalls, no libnuma);
+// on other platforms, or when the kernel refuses, there is one node and the
+// policies are no-ops. While a policy or pinning is on, the pool counts the
+// rows each node's workers processed per range owner, and the CPU wrappers
+// report local/remote access ratios and per-node bandwidth.
+
+enum class NumaPolicy { Off, Interleave, Partition };
+
+struct NumaConfig {
+    NumaPolicy policy = NumaPolicy::Off;
+    bool pinWorkers = false; // implied by Partition
+};
+
+// Set before the catalog and the worker pools are created.
+NumaConfig& numaConfig();
+bool parseNumaPolicy(const std::string& name, NumaPolicy& out);
+const char* numaPolicyName(NumaPolicy policy);
+inline bool numaPinned() { return numaConfig().pinWorkers || numaConfig().policy == NumaPolicy::Partition; }
+inline bool numaReportEnabled() { return numaConfig().policy != NumaPolicy::Off || numaConfig().pinWorkers; }
+
+// Online CPUs per node, from /sys/devices/system/node; one node with every
+// CPU when that is unavailable.
+struct NumaTopology {
+    std::vector<std::vector<unsigned>> nodeCpus;
+
+    unsigned nodes() const { return (unsigned)nodeCpus.size(); }
+};
+const NumaTopology& numaTopology();
+
+// Row ranges the pool splits each parallelFor into: one per node under
+// Partition, otherwise one. Range k starts at numaRangeBegin(n, k, parts).
+unsigned numaParts();
+inline size_t numaRangeBegin(size_t n, unsigned part, unsigned parts) { return (size_t)((unsigned __int128)n * part / parts); }
+
+// Pins the calling thread; false when the platform does not support it.
+bool pinCurrentThread(unsigned cpu);
+// Node of the CPU the calling thread runs on (0 when unknown).
+unsigned currentNode();
+
+// Applies the configured policy to a freshly loaded column (rows of rowBytes).
+void placeColumnPages(const void* data, size_t rows, size_t rowBytes);
+
+// For each of `parts` row ranges of a column, the share of its pages on each
+// node (sampled with move_pages); empty when page locations are unknown.
+std::vector<std::vector<double>> pageNodeShares(const void* data, size_t bytes, unsigned parts);
+
+// --- Per-node scan accounting ---
+// Filled by the worker pool while numaReportEnabled(); reset when a
+// benchmark's warm-up ends, like the roofline stage times.
+void recordNumaMorsel(unsigned part, unsigned workerNode, size_t rows, uint64_t busyNs);
+void resetNumaStats();
+
+struct NumaScanStats {
+    unsigned nodes = 0;
+    std::vector<uint64_t> rows;    // [part * nodes + workerNode]
+    std::vector<uint64_t> busyNs;  // per worker node
+};
+NumaScanStats takeNumaStats();
+
+// "<label>: local x%, remote y%" plus one line per node with its share of the
+// rows and its bandwidth (its share of bytesPerExecution x executions over
+// the node's mean busy time per worker). Locality weighs each range's rows by
+// where its pages are; without page locations, by the range's owner node.
+void printNumaReport(const char* label, const NumaScanStats& stats, const std::vector<std::vector<double>>& pageShares,
+                     const std::vector<unsigned>& workersPerNode, uint64_t bytesPerExecution, size_t executions);
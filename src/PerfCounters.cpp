@@ -0,0 +1,189 @@
+#include "PerfCounters.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+std::atomic<bool> g_perfEnabled{false};
+
+namespace {
+
+constexpr int kEvents = 5;
+const char* const kEventNames[kEvents] = {"cycles", "instructions", "LLC misses", "dTLB misses", "branch misses"};
+
+struct StageTotals {
+    uint64_t executions = 0;
+    double values[kEvents] = {};
+};
+
+// One thread's counter group; fd[e] < 0 = event e unavailable on this thread.
+struct ThreadGroup {
+    int leader = -1;
+    int fd[kEvents] = {-1, -1, -1, -1, -1};
+    int slot[kEvents] = {-1, -1, -1, -1, -1}; // position in the group read
+    int opened = 0;
+};
+
+std::mutex g_perfMutex;
+std::vector<std::unique_ptr<ThreadGroup>> g_groups;
+std::vector<std::pair<std::string, StageTotals>> g_stages; // first-seen (pipeline) order
+bool g_available[kEvents] = {};
+thread_local ThreadGroup* t_group = nullptr;
+
+#ifdef __linux__
+void eventConfig(int e, perf_event_attr& attr) {
+    auto cache = [](uint64_t id) {
+        return id | ((uint64_t)PERF_COUNT_HW_CACHE_OP_READ << 8) | ((uint64_t)PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    };
+    switch (e) {
+        case 0: attr.type = PERF_TYPE_HARDWARE; attr.config = PERF_COUNT_HW_CPU_CYCLES; break;
+        case 1: attr.type = PERF_TYPE_HARDWARE; attr.config = PERF_COUNT_HW_INSTRUCTIONS; break;
+        case 2: attr.type = PERF_TYPE_HW_CACHE; attr.config = cache(PERF_COUNT_HW_CACHE_LL); break;
+        case 3: attr.type = PERF_TYPE_HW_CACHE; attr.config = cache(PERF_COUNT_HW_CACHE_DTLB); break;
+        default: attr.type = PERF_TYPE_HARDWARE; attr.config = PERF_COUNT_HW_BRANCH_MISSES; break;
+    }
+}
+
+std::unique_ptr<ThreadGroup> openGroup() {
+    auto group = std::make_unique<ThreadGroup>();
+    for (int e = 0; e < kEvents; ++e) {
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        eventConfig(e, attr);
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        attr.disabled = group->leader < 0 ? 1 : 0;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        int fd = (int)syscall(SYS_perf_event_open, &attr, 0 /* this thread */, -1, group->leader, 0);
+        if (fd < 0) continue;
+        if (group->leader < 0) group->leader = fd;
+        group->fd[e] = fd;
+        group->slot[e] = group->opened++;
+    }
+    if (group->leader < 0) return nullptr;
+    ioctl(group->leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    return group;
+}
+
+// Adds one group's multiplexing-scaled counts to out.
+void readGroup(const ThreadGroup& g, double* out) {
+    uint64_t buf[3 + kEvents] = {};
+    if (read(g.leader, buf, sizeof(buf)) < (ssize_t)(3 * sizeof(uint64_t))) return;
+    const double scale = buf[2] ? (double)buf[1] / (double)buf[2] : 0.0; // enabled / running
+    for (int e = 0; e < kEvents; ++e) {
+        if (g.slot[e] >= 0 && (uint64_t)g.slot[e] < buf[0]) out[e] += (double)buf[3 + g.slot[e]] * scale;
+    }
+}
+#endif
+
+void readAll(double* out) {
+    for (int e = 0; e < kEvents; ++e) out[e] = 0.0;
+#ifdef __linux__
+    std::lock_guard<std::mutex> lock(g_perfMutex);
+    for (const auto& g : g_groups) readGroup(*g, out);
+#endif
+}
+
+} // namespace
+
+
+bool startPerfCounters(std::string& why) {
+#ifdef __linux__
+    auto group = openGroup();
+    if (!group) {
+        why = std::string("perf_event_open failed (") + strerror(errno) + "); check /proc/sys/kernel/perf_event_paranoid";
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(g_perfMutex);
+        for (int e = 0; e < kEvents; ++e) g_available[e] = group->fd[e] >= 0;
+        t_group = group.get();
+        g_groups.push_back(std::move(group));
+    }
+    g_perfEnabled.store(true, std::memory_order_relaxed);
+    return true;
+#else
+    why = "perf_event_open is Linux-only";
+    return false;
+#endif
+}
+
+void attachPerfCounters() {
+#ifdef __linux__
+    if (!perfEnabled() || t_group) return;
+    auto group = openGroup();
+    if (!group) return; // this thread goes uncounted
+    std::lock_guard<std::mutex> lock(g_perfMutex);
+    t_group = group.get();
+    g_groups.push_back(std::move(group));
+#endif
+}
+
+void resetPerfStages() {
+    std::lock_guard<std::mutex> lock(g_perfMutex);
+    g_stages.clear();
+}
+
+void printPerfStages(const std::string& title, const std::string& prefix) {
+    if (!perfEnabled()) return;
+    std::vector<std::pair<std::string, StageTotals>> rows;
+    bool available[kEvents];
+    {
+        std::lock_guard<std::mutex> lock(g_perfMutex);
+        for (const auto& kv : g_stages) {
+            if (kv.first.compare(0, prefix.size(), prefix) == 0) rows.push_back(kv);
+        }
+        std::copy(g_available, g_available + kEvents, available);
+    }
+    if (rows.empty()) return;
+
+    printf("%s (per execution):\n", title.c_str());
+    printf("+------------------+----------------+----------------+-------+----------------+----------------+----------------+\n");
+    printf("| stage            | %14s | %14s |   IPC | %14s | %14s | %14s |\n", kEventNames[0], kEventNames[1], kEventNames[2],
+           kEventNames[3], kEventNames[4]);
+    printf("+------------------+----------------+----------------+-------+----------------+----------------+----------------+\n");
+    for (const auto& [stage, t] : rows) {
+        char cells[kEvents][24];
+        double avg[kEvents];
+        for (int e = 0; e < kEvents; ++e) {
+            avg[e] = t.values[e] / (double)t.executions;
+            if (available[e]) snprintf(cells[e], sizeof(cells[e]), "%14.0f", avg[e]);
+            else snprintf(cells[e], sizeof(cells[e]), "%14s", "n/a");
+        }
+        char ipc[16] = "  n/a";
+        if (available[0] && available[1] && avg[0] > 0.0) snprintf(ipc, sizeof(ipc), "%5.2f", avg[1] / avg[0]);
+        printf("| %-16s | %s | %s | %s | %s | %s | %s |\n", stage.c_str(), cells[0], cells[1], ipc, cells[2], cells[3], cells[4]);
+    }
+    printf("+------------------+----------------+----------------+-------+----------------+----------------+----------------+\n");
+}
+
+
+// --- Perf Scope ---
+void PerfScope::begin(const char* stage) {
+    m_stage = stage;
+    readAll(m_start);
+}
+
+void PerfScope::end() {
+    double now[kEvents];
+    readAll(now);
+    std::lock_guard<std::mutex> lock(g_perfMutex);
+    auto it = std::find_if(g_stages.begin(), g_stages.end(), [&](const auto& kv) { return kv.first == m_stage; });
+    if (it == g_stages.end()) it = g_stages.insert(g_stages.end(), {m_stage, StageTotals{}});
+    StageTotals& t = it->second;
+    t.executions += 1;
+    for (int e = 0; e < kEvents; ++e) t.values[e] += now[e] - m_start[e];
+    m_stage = nullptr;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// --- Hardware Performance Counters ---
+// Optional per-stage cycles, instructions, LLC misses, dTLB misses and branch
+// mispredicts via perf_event_open (Linux). Every participating thread (main
+// and the WorkerPool workers) opens one counter group for itself; a PerfScope
+// reads all groups at its start and end and charges the difference to its
+// stage, so a parallel stage is counted across every worker. Counters that
+// the kernel or PMU refuses are reported as n/a; without any, collection is
+// disabled with a message and the benchmark runs unchanged. Totals are
+// process-wide, so concurrent streams blur the attribution.
+
+extern std::atomic<bool> g_perfEnabled;
+
+inline bool perfEnabled() { return g_perfEnabled.load(std::memory_order_relaxed); }
+
+// Opens the calling thread's group and enables collection; false (with the
+// reason in `why`) when no counter can be opened.
+bool startPerfCounters(std::string& why);
+// Opens a group for the calling thread (no-op when disabled or already attached).
+void attachPerfCounters();
+
+// Drops the per-stage totals (the harness calls this when warm-up ends).
+void resetPerfStages();
+// Table of per-execution averages for the stages whose name starts with prefix.
+void printPerfStages(const std::string& title, const std::string& prefix);
+
+class PerfScope {
+public:
+    explicit PerfScope(const char* stage) {
+        if (perfEnabled()) begin(stage);
+    }
+    ~PerfScope() { close(); }
+
+    PerfScope(const PerfScope&) = delete;
+    PerfScope& operator=(const PerfScope&) = delete;
+
+    void close() {
+        if (m_stage) end();
+    }
+
+private:
+    static constexpr int kEvents = 5;
+
+    void begin(const char* stage);
+    void end();
+
+    const char* m_stage = nullptr;
+    double m_start[kEvents] = {};
+};
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "ColumnCatalog.hpp"
+#include "ThroughputTest.hpp"
+
+// --- TPC-H Refresh Functions ---
+// RF1 inserts new orders with their lineitems, RF2 deletes old orders with
+// their lineitems. Both go through the catalog's delta store: inserts land in
+// the append buffer, deletes in the delete bitmap, and queries scan main +
+// delta until mergeDeltas() folds them back into the main columns.
+
+// One refresh pair: .tbl lines for RF1 and the order keys for RF2.
+struct RefreshSet {
+    std::vector<std::string> orders;
+    std::vector<std::string> lineitem;
+    std::unordered_set<int> deleteKeys;
+};
+
+// dbgen-style RF1/RF2 data: new order keys above the current maximum, custkeys
+// that skip every third customer, partkey/suppkey pairs that exist in partsupp,
+// retail-price based extended prices and the 1995-06-17 status cut-off. RF2
+// deletes the lowest original order keys in ascending order, never twice.
+class RefreshGenerator {
+public:
+    RefreshGenerator(ColumnCatalog& catalog, uint64_t seed);
+
+    RefreshSet next(size_t orders);
+
+private:
+    std::string makeLineitem(int orderkey, int linenumber, int orderdate, double& totalprice, char& linestatus);
+
+    std::mt19937_64 m_rng;
+    int m_nextOrderkey = 1;
+    int m_customers = 0, m_parts = 0, m_suppliers = 0;
+    std::vector<int> m_originalKeys; // sorted
+    size_t m_deleteCursor = 0;
+};
+
+size_t applyRF1(ColumnCatalog& catalog, const RefreshSet& set); // returns rows inserted
+size_t applyRF2(ColumnCatalog& catalog, const RefreshSet& set); // returns rows deleted
+
+
+// --- Refresh Test ---
+// Measures query slowdown while deltas accumulate over several refresh sets,
+// then the cost of a background merge that runs while queries keep executing,
+// and the query times after the merge.
+
+// Scalar fingerprint of one query's result, compared before and after the merge
+// (NaN = not checked); false when one differs.
+using QueryChecksum = std::function<double(const std::string& query)>;
+
+struct RefreshConfig {
+    int refreshSets = 2;
+    size_t ordersPerSet = 0; // 0 = orders rows / 1000 (TPC-H: SF x 1500)
+    uint64_t seed = 0;
+    std::vector<std::string> queries{"q1", "q3", "q6", "q9", "q13"};
+    std::string backend;
+};
+
+bool runRefreshTest(ColumnCatalog& catalog, const RefreshConfig& config, const QueryExecutor& execute,
+                    const QueryChecksum& checksum = {});
@@ -0,0 +1,160 @@
+#include "ResultLog.hpp"
+
+#include <sys/resource.h>
+
+#include "BenchConfig.hpp"
+#include "ColumnCatalog.hpp"
+
+namespace {
+
+struct ScannedTable {
+    const char* table;
+    uint64_t rowBytes; // widths of the columns the query reads
+};
+
+// Same columns as the GPU kernels and cpuExecuteQn read
+const std::vector<ScannedTable>& scannedTables(const std::string& query) {
+    static const std::vector<ScannedTable> none;
+    static const std::vector<ScannedTable> q1{{"lineitem", 4 * 4 + 2 * 1 + 4}};
+    static const std::vector<ScannedTable> q3{{"customer", 4 + 1}, {"orders", 4 * 4}, {"lineitem", 4 * 4}};
+    static const std::vector<ScannedTable> q6{{"lineitem", 4 * 4}};
+    static const std::vector<ScannedTable> q9{{"part", 4 + 55}, {"supplier", 2 * 4}, {"partsupp", 3 * 4},
+                                              {"orders", 2 * 4}, {"lineitem", 6 * 4}};
+    static const std::vector<ScannedTable> q13{{"customer", 4}, {"orders", 4 + 100}};
+    if (query == "q1") return q1;
+    if (query == "q3") return q3;
+    if (query == "q6") return q6;
+    if (query == "q9") return q9;
+    if (query == "q13") return q13;
+    return none;
+}
+
+std::string jsonString(const std::string& s) {
+    std::string out = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\') { out += '\\'; out += c; }
+        else if ((unsigned char)c < 0x20) { char buf[8]; snprintf(buf, sizeof(buf), "\\u%04x", c); out += buf; }
+        else out += c;
+    }
+    return out + "\"";
+}
+
+std::string csvString(const std::string& s) {
+    std::string out = "\"";
+    for (char c : s) { out += c; if (c == '"') out += '"'; }
+    return out + "\"";
+}
+
+const char* kCsvHeader =
+    "query,backend,threads,scale_factor,params,samples,outliers_rejected,min_ms,median_ms,mean_ms,ci95_ms,p95_ms,p99_ms,"
+    "max_ms,stddev_ms,stages,rows_in,rows_out,bytes_scanned,peak_memory_bytes\n";
+
+} // namespace
+
+
+ScanVolume tpchScanVolume(const std::string& query, ColumnCatalog& catalog) {
+    ScanVolume v;
+    for (const auto& t : scannedTables(query)) {
+        const DeltaStats s = catalog.deltaStats(t.table);
+        const uint64_t rows = s.mainRows + s.deltaRows - s.deletedRows;
+        v.rows += rows;
+        v.bytes += rows * t.rowBytes;
+    }
+    return v;
+}
+
+ResultRecord tpchResult(const std::string& query, const std::string& backend, const std::string& params,
+                        const BenchLoop& loop, ColumnCatalog& catalog, uint64_t rowsOut) {
+    const ScanVolume scan = tpchScanVolume(query, catalog);
+    ResultRecord r;
+    r.query = query;
+    r.backend = backend;
+    r.params = params;
+    r.time = loop.stats();
+    r.rowsIn = scan.rows;
+    r.rowsOut = rowsOut;
+    r.bytesScanned = scan.bytes;
+    return r;
+}
+
+uint64_t peakResidentBytes() {
+    struct rusage usage {};
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+    return (uint64_t)usage.ru_maxrss; // bytes
+#else
+    return (uint64_t)usage.ru_maxrss * 1024; // kilobytes
+#endif
+}
+
+
+// --- Result Log ---
+ResultLog::~ResultLog() {
+    if (m_ownsFile) fclose(m_out);
+}
+
+bool ResultLog::open(const std::string& path, ResultFormat format) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_ownsFile) fclose(m_out);
+    m_out = nullptr;
+    m_ownsFile = false;
+    m_format = format;
+    if (path == "-") {
+        m_out = stdout;
+    } else {
+        m_out = fopen(path.c_str(), "a");
+        if (!m_out) return false;
+        m_ownsFile = true;
+    }
+    if (m_format == ResultFormat::Csv && (m_out == stdout || (fseek(m_out, 0, SEEK_END) == 0 && ftell(m_out) == 0))) {
+        fputs(kCsvHeader, m_out);
+    }
+    return true;
+}
+
+void ResultLog::emit(const ResultRecord& r) {
+    if (!enabled()) return;
+    const double sf = datasetScaleFactor();
+    const uint64_t peak = peakResidentBytes();
+    const SampleStats& t = r.time;
+    std::string line;
+    char buf[512];
+
+    if (m_format == ResultFormat::Json) {
+        line = "{\"query\":" + jsonString(r.query) + ",\"backend\":" + jsonString(r.backend);
+        snprintf(buf, sizeof(buf), ",\"threads\":%u,\"scale_factor\":%g,\"params\":", r.threads, sf);
+        line += buf + jsonString(r.params);
+        snprintf(buf, sizeof(buf),
+                 ",\"time_ms\":{\"n\":%zu,\"rejected\":%zu,\"min\":%.4f,\"median\":%.4f,\"mean\":%.4f,\"ci95\":%.4f,"
+                 "\"p95\":%.4f,\"p99\":%.4f,\"max\":%.4f,\"stddev\":%.4f},\"stages_ms\":{",
+                 t.n, t.rejected, t.min, t.median, t.mean, t.ciHalfWidth, t.p95, t.p99, t.max, t.stddev);
+        line += buf;
+        for (size_t i = 0; i < r.stages.size(); ++i) {
+            snprintf(buf, sizeof(buf), "%s%s:%.4f", i ? "," : "", jsonString(r.stages[i].first).c_str(), r.stages[i].second);
+            line += buf;
+        }
+        snprintf(buf, sizeof(buf), "},\"rows_in\":%llu,\"rows_out\":%llu,\"bytes_scanned\":%llu,\"peak_memory_bytes\":%llu}\n",
+                 (unsigned long long)r.rowsIn, (unsigned long long)r.rowsOut, (unsigned long long)r.bytesScanned,
+                 (unsigned long long)peak);
+        line += buf;
+    } else {
+        std::string stages;
+        for (size_t i = 0; i < r.stages.size(); ++i) {
+            snprintf(buf, sizeof(buf), "%s%s=%.4f", i ? ";" : "", r.stages[i].first.c_str(), r.stages[i].second);
+            stages += buf;
+        }
+        line = r.query + "," + r.backend;
+        snprintf(buf, sizeof(buf), ",%u,%g,", r.threads, sf);
+        line += buf + csvString(r.params);
+        snprintf(buf, sizeof(buf), ",%zu,%zu,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,", t.n, t.rejected, t.min, t.median, t.mean,
+                 t.ciHalfWidth, t.p95, t.p99, t.max, t.stddev);
+        line += buf + csvString(stages);
+        snprintf(buf, sizeof(buf), ",%llu,%llu,%llu,%llu\n", (unsigned long long)r.rowsIn, (unsigned long long)r.rowsOut,
+                 (unsigned long long)r.bytesScanned, (unsigned long long)peak);
+        line += buf;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    fputs(line.c_str(), m_out);
+    fflush(m_out);
+}
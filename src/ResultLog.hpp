@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "BenchHarness.hpp"
+#include "BuildCache.hpp"
+
+class ColumnCatalog;
+
+// --- Structured Results ---
+// One machine-readable record per query run, written next to the human-readable
+// tables: JSON Lines (one object per line) or CSV with a fixed header. Tooling
+// reads these instead of scraping the "Total TPC-H ..." lines.
+
+struct ResultRecord {
+    std::string query;     // "q1", "q3", ...
+    std::string backend;   // "gpu" or "cpu"
+    unsigned threads = 0;  // CPU worker threads, 0 on the GPU backend
+    std::string params;    // describe(params)
+    SampleStats time;      // distribution of the measured execution time (ms)
+    std::vector<std::pair<std::string, double>> stages; // per-stage ms in pipeline order, e.g. build, probe, merge
+    uint64_t rowsIn = 0;   // visible rows of every scanned table
+    uint64_t rowsOut = 0;  // result rows
+    uint64_t bytesScanned = 0; // column bytes read per execution
+
+    // Appends "build_cold" / "build_warm" for the phases that occurred.
+    void addBuildStages(const BuildPhaseTimer& build) {
+        if (build.coldMs >= 0.0) stages.emplace_back("build_cold", build.coldMs);
+        if (build.warmMs >= 0.0) stages.emplace_back("build_warm", build.warmMs);
+    }
+};
+
+// Rows and column bytes a TPC-H query reads in the current table versions.
+struct ScanVolume {
+    uint64_t rows = 0;
+    uint64_t bytes = 0;
+};
+ScanVolume tpchScanVolume(const std::string& query, ColumnCatalog& catalog);
+
+// Record for a finished TPC-H benchmark loop: timing distribution and scan volume filled in.
+ResultRecord tpchResult(const std::string& query, const std::string& backend, const std::string& params,
+                        const BenchLoop& loop, ColumnCatalog& catalog, uint64_t rowsOut);
+
+// Peak resident set size of the process so far.
+uint64_t peakResidentBytes();
+
+enum class ResultFormat { Json, Csv };
+
+class ResultLog {
+public:
+    ResultLog() = default;
+    ~ResultLog();
+
+    ResultLog(const ResultLog&) = delete;
+    ResultLog& operator=(const ResultLog&) = delete;
+
+    // "-" writes to stdout; a file is appended to (CSV gets a header when empty).
+    bool open(const std::string& path, ResultFormat format);
+    bool enabled() const { return m_out != nullptr; }
+
+    // Adds the scale factor and peak memory, then writes one line. Thread-safe.
+    void emit(const ResultRecord& record);
+
+private:
+    std::mutex m_mutex;
+    FILE* m_out = nullptr;
+    bool m_ownsFile = false;
+    ResultFormat m_format = ResultFormat::Json;
+};
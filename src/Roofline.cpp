@@ -0,0 +1,147 @@
+#include "Roofline.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <utility>
+
+#include "WorkerPool.hpp"
+
+std::atomic<bool> g_rooflineEnabled{false};
+MachineProfile g_machine;
+
+namespace {
+
+constexpr int kTrials = 5;
+constexpr double kAtLimit = 0.8; // fraction of peak reported as bandwidth-bound
+
+struct StageTime {
+    uint64_t executions = 0;
+    double ms = 0.0;
+};
+
+std::mutex g_timesMutex;
+std::vector<std::pair<std::string, StageTime>> g_times; // first-seen (pipeline) order
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Best-of-kTrials GB/s of kernel(begin, end) over n elements moving bytesPerElement each.
+template <typename Kernel>
+double streamBandwidth(WorkerPool& pool, size_t n, size_t morsel, double bytesPerElement, Kernel kernel) {
+    double best = 0.0;
+    for (int t = 0; t < kTrials; ++t) {
+        auto start = std::chrono::steady_clock::now();
+        pool.parallelFor(n, morsel, [&](size_t begin, size_t end, unsigned) { kernel(begin, end); });
+        const double s = secondsSince(start);
+        if (s > 0.0) best = std::max(best, bytesPerElement * (double)n / s / 1e9);
+    }
+    return best;
+}
+
+// One node per cache line so every hop is a separate line fill.
+struct alignas(64) ChaseNode {
+    size_t next;
+};
+
+// Average ns per dependent load along a single random cycle (Sattolo) over bytes of memory.
+double chaseLatency(size_t bytes) {
+    const size_t nodes = std::max<size_t>(2, bytes / sizeof(ChaseNode));
+    std::unique_ptr<ChaseNode[]> chain(new ChaseNode[nodes]);
+    std::vector<size_t> order(nodes);
+    std::iota(order.begin(), order.end(), 0);
+    std::mt19937_64 rng(0x5eed);
+    for (size_t i = nodes - 1; i > 0; --i) std::swap(order[i], order[rng() % i]);
+    for (size_t i = 0; i < nodes; ++i) chain[order[i]].next = order[(i + 1) % nodes];
+
+    const size_t hops = std::min<size_t>(nodes, 1 << 21);
+    size_t p = 0;
+    for (size_t i = 0; i < hops / 8; ++i) p = chain[p].next; // warm the TLB walk caches a little
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < hops; ++i) p = chain[p].next;
+    const double s = secondsSince(start);
+    volatile size_t sink = p;
+    (void)sink;
+    return s * 1e9 / (double)hops;
+}
+
+} // namespace
+
+
+MachineProfile measureMachine(WorkerPool& pool, size_t arrayBytes) {
+    MachineProfile m;
+    m.threads = pool.size();
+    const size_t n = std::max<size_t>(1, arrayBytes / sizeof(double));
+    const size_t morsel = std::max<size_t>(WorkerPool::kDefaultMorsel, n / ((size_t)pool.size() * 8));
+    std::unique_ptr<double[]> a(new double[n]), b(new double[n]), c(new double[n]);
+    // First touch on the workers, so pages land where the kernels run
+    pool.parallelFor(n, morsel, [&](size_t begin, size_t end, unsigned) {
+        for (size_t i = begin; i < end; ++i) { a[i] = 1.0; b[i] = 2.0; c[i] = 0.0; }
+    });
+    const double scalar = 3.0;
+    m.copyGBs = streamBandwidth(pool, n, morsel, 2 * sizeof(double), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) c[i] = a[i];
+    });
+    m.triadGBs = streamBandwidth(pool, n, morsel, 3 * sizeof(double), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) a[i] = b[i] + scalar * c[i];
+    });
+    m.latencyNs = chaseLatency(arrayBytes);
+    return m;
+}
+
+void printMachineProfile(const MachineProfile& m) {
+    printf("Machine profile (%u threads): copy %.1f GB/s, triad %.1f GB/s, random access latency %.1f ns\n\n", m.threads,
+           m.copyGBs, m.triadGBs, m.latencyNs);
+}
+
+void recordStageTime(const char* stage, double ms) {
+    if (!rooflineEnabled()) return;
+    std::lock_guard<std::mutex> lock(g_timesMutex);
+    auto it = std::find_if(g_times.begin(), g_times.end(), [&](const auto& kv) { return kv.first == stage; });
+    if (it == g_times.end()) it = g_times.insert(g_times.end(), {stage, StageTime{}});
+    it->second.executions += 1;
+    it->second.ms += ms;
+}
+
+void resetStageTimes() {
+    std::lock_guard<std::mutex> lock(g_timesMutex);
+    g_times.clear();
+}
+
+void printRoofline(const std::string& title, const std::vector<StageTraffic>& traffic) {
+    if (!rooflineEnabled()) return;
+    std::vector<std::pair<const StageTraffic*, double>> rows; // declared stage, average ms
+    {
+        std::lock_guard<std::mutex> lock(g_timesMutex);
+        for (const auto& kv : g_times) {
+            auto t = std::find_if(traffic.begin(), traffic.end(), [&](const StageTraffic& s) { return kv.first == s.stage; });
+            if (t != traffic.end()) rows.emplace_back(&*t, kv.second.ms / (double)kv.second.executions);
+        }
+    }
+    if (rows.empty()) return;
+
+    const double peak = g_machine.peakGBs();
+    printf("%s (per execution, peak %.1f GB/s, latency %.1f ns, %u threads):\n", title.c_str(), peak, g_machine.latencyNs,
+           g_machine.threads);
+    printf("+------------------+----------+----------+----------+--------+--------+------------+------------+-----------+\n");
+    printf("| stage            |  time ms |  read MB | write MB |   GB/s | %% peak | random acc | latency ms | bound     |\n");
+    printf("+------------------+----------+----------+----------+--------+--------+------------+------------+-----------+\n");
+    for (const auto& [t, ms] : rows) {
+        const double bytes = (double)t->bytesRead + (double)t->bytesWritten;
+        const double gbs = ms > 0.0 ? bytes / (ms * 1e6) : 0.0;
+        const double fraction = peak > 0.0 ? gbs / peak : 0.0;
+        // Every random access as a full miss with no overlap within a thread: a pessimistic floor
+        const double latencyMs = (double)t->randomAccesses * g_machine.latencyNs / std::max(1u, g_machine.threads) / 1e6;
+        const char* bound = fraction >= kAtLimit ? "bandwidth" : latencyMs >= 0.5 * ms ? "latency" : "headroom";
+        char latency[16] = "-";
+        if (t->randomAccesses) snprintf(latency, sizeof(latency), "%.2f", latencyMs);
+        printf("| %-16s | %8.2f | %8.1f | %8.1f | %6.2f | %5.1f%% | %10.3g | %10s | %-9s |\n", t->stage, ms,
+               t->bytesRead / 1e6, t->bytesWritten / 1e6, gbs, 100.0 * fraction, (double)t->randomAccesses, latency, bound);
+    }
+    printf("+------------------+----------+----------+----------+--------+--------+------------+------------+-----------+\n");
+}
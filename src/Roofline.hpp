@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class WorkerPool;
+
+// --- Roofline Report ---
+// A STREAM-style copy/triad run and a pointer-chasing latency probe measure
+// what the memory system delivers at startup; each query stage then declares
+// the bytes it reads and writes per execution, and the report puts the
+// stage's achieved bandwidth next to that peak. A stage near 100% is at the
+// hardware limit; one far below it has headroom (or waits on latency rather
+// than bandwidth). Stage times are only collected while the report is on.
+
+struct MachineProfile {
+    unsigned threads = 0;
+    double copyGBs = 0.0;   // best of the trials, STREAM byte counting (no write-allocate)
+    double triadGBs = 0.0;
+    double latencyNs = 0.0; // one dependent load into a working set far beyond the LLC
+
+    double peakGBs() const { return copyGBs > triadGBs ? copyGBs : triadGBs; }
+};
+
+extern std::atomic<bool> g_rooflineEnabled;
+extern MachineProfile g_machine;
+
+inline bool rooflineEnabled() { return g_rooflineEnabled.load(std::memory_order_relaxed); }
+
+// Runs the probes on every pool thread; arrayBytes is the size of each of the three STREAM arrays.
+MachineProfile measureMachine(WorkerPool& pool, size_t arrayBytes);
+void printMachineProfile(const MachineProfile& machine);
+
+// Bytes one execution of a stage moves to and from memory, counted from the
+// columns and build structures it touches; randomAccesses are the data-dependent
+// lookups into structures whose order does not follow the scan (upper bound,
+// before selective filters).
+struct StageTraffic {
+    const char* stage; // same name as the stage's trace span, e.g. "q9 probe"
+    uint64_t bytesRead = 0;
+    uint64_t bytesWritten = 0;
+    uint64_t randomAccesses = 0;
+};
+
+// Adds one execution of a stage (a no-op while the report is off).
+void recordStageTime(const char* stage, double ms);
+// Drops the per-stage times (the harness calls this when warm-up ends).
+void resetStageTimes();
+// Achieved GB/s and fraction of g_machine's peak for every declared stage that ran.
+void printRoofline(const std::string& title, const std::vector<StageTraffic>& traffic);
@@ -0,0 +1,117 @@
+#include "ScalingSweep.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <thread>
+
+#include "BenchConfig.hpp"
+#include "ColumnCatalog.hpp"
+#include "CpuQueries.hpp"
+#include "Roofline.hpp"
+#include "WorkerPool.hpp"
+
+namespace {
+
+struct SweepPoint {
+    std::string scaleFactor;
+    unsigned threads;
+    double ms;          // median of the measured executions
+    uint64_t rows;      // visible rows of the scanned tables
+    uint64_t bytes;     // column bytes read
+};
+
+std::string describeQuery(const std::string& query, const TpchParams& p) {
+    if (query == "q1") return describe(p.q1);
+    if (query == "q3") return describe(p.q3);
+    if (query == "q6") return describe(p.q6);
+    if (query == "q9") return describe(p.q9);
+    return describe(p.q13);
+}
+
+std::vector<unsigned> defaultThreadCounts() {
+    const unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<unsigned> counts;
+    for (unsigned t = 1; t < cores; t *= 2) counts.push_back(t);
+    counts.push_back(cores);
+    return counts;
+}
+
+void printQuerySweep(const std::string& query, const std::vector<SweepPoint>& points) {
+    const bool roofline = rooflineEnabled() && g_machine.peakGBs() > 0.0;
+    std::string label = query;
+    std::transform(label.begin(), label.end(), label.begin(), ::toupper);
+    printf("\n%s scaling (median ms; speedup and efficiency against the first thread count of each SF):\n", label.c_str());
+    printf("+--------+---------+------------+------------+----------+---------+------------+-------------+%s\n",
+           roofline ? "---------+" : "");
+    printf("|     SF | threads |    time ms |   Mrows/s  |     GB/s | speedup | efficiency | serial frac |%s\n",
+           roofline ? "  % peak |" : "");
+    printf("+--------+---------+------------+------------+----------+---------+------------+-------------+%s\n",
+           roofline ? "---------+" : "");
+    const SweepPoint* base = nullptr;
+    for (const auto& p : points) {
+        if (!base || base->scaleFactor != p.scaleFactor) base = &p;
+        const double speedup = p.ms > 0.0 ? base->ms / p.ms : 0.0;
+        const double scale = (double)p.threads / (double)base->threads;
+        const double gbs = p.ms > 0.0 ? (double)p.bytes / (p.ms * 1e6) : 0.0;
+        char serial[16] = "-";
+        // Karp-Flatt: experimentally determined serial fraction
+        if (scale > 1.0 && speedup > 0.0) snprintf(serial, sizeof(serial), "%.3f", (1.0 / speedup - 1.0 / scale) / (1.0 - 1.0 / scale));
+        printf("| %6s | %7u | %10.2f | %10.1f | %8.2f | %6.2fx | %9.0f%% | %11s |", p.scaleFactor.c_str(), p.threads, p.ms,
+               p.ms > 0.0 ? (double)p.rows / (p.ms * 1e3) : 0.0, gbs, speedup, 100.0 * speedup / scale, serial);
+        if (roofline) printf("  %5.1f%% |", 100.0 * gbs / g_machine.peakGBs());
+        printf("\n");
+    }
+    printf("+--------+---------+------------+------------+----------+---------+------------+-------------+%s\n",
+           roofline ? "---------+" : "");
+}
+
+} // namespace
+
+void runScalingSweep(const SweepConfig& config, const TpchParams& params) {
+    const std::vector<unsigned> threadCounts = config.threads.empty() ? defaultThreadCounts() : config.threads;
+    std::cout << "\n--- Running Scale-Factor / Thread-Count Sweep (CPU) ---" << std::endl;
+    const std::string savedPath = g_dataset_path;
+
+    std::vector<std::vector<SweepPoint>> byQuery(config.queries.size());
+    for (const auto& sf : config.scaleFactors) {
+        g_dataset_path = "data/SF-" + sf + "/";
+        if (!std::filesystem::is_directory(g_dataset_path)) {
+            std::cerr << "Skipping SF " << sf << ": " << g_dataset_path << " not found" << std::endl;
+            continue;
+        }
+        ColumnCatalog catalog(g_dataset_path);
+        catalog.buildCache().setBudgetBytes(config.buildCacheBytes);
+        for (unsigned threads : threadCounts) {
+            WorkerPool pool(threads);
+            for (size_t q = 0; q < config.queries.size(); ++q) {
+                const std::string& query = config.queries[q];
+                std::cout << "SF " << sf << ", " << threads << " threads: " << query << std::endl;
+                // Columns load on first use; keep that out of the first point
+                if (threads == threadCounts.front()) cpuExecuteQuery(query, catalog, pool, params);
+                BenchLoop loop;
+                while (loop.next()) {
+                    auto start = std::chrono::high_resolution_clock::now();
+                    cpuExecuteQuery(query, catalog, pool, params);
+                    loop.record(std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+                }
+                const ScanVolume scan = tpchScanVolume(query, catalog);
+                byQuery[q].push_back({sf, threads, loop.stats().median, scan.rows, scan.bytes});
+                if (g_results.enabled()) {
+                    ResultRecord rec = tpchResult(query, "cpu", describeQuery(query, params), loop, catalog, 0);
+                    rec.threads = pool.size();
+                    rec.stages.emplace_back("execute", loop.stats().median);
+                    g_results.emit(rec);
+                }
+            }
+        }
+    }
+    g_dataset_path = savedPath;
+
+    for (size_t q = 0; q < config.queries.size(); ++q) {
+        if (!byQuery[q].empty()) printQuerySweep(config.queries[q], byQuery[q]);
+    }
+}
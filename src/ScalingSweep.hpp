@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "TpchParams.hpp"
+
+// --- Scale-Factor and Thread-Count Sweep ---
+// Runs every query on the CPU backend for each dataset in a list of scale
+// factors (data/SF-<sf>/) and each worker count in a list of thread counts,
+// with the measurement harness settings. For every query it reports median
+// time, throughput in rows/s and GB/s, speedup and parallel efficiency against
+// the smallest thread count, and the Karp-Flatt serial fraction: a constant
+// serial fraction points at serial post-processing, one that grows with the
+// thread count at contention or a memory-bandwidth ceiling (compare GB/s with
+// the --roofline peak).
+
+struct SweepConfig {
+    std::vector<std::string> scaleFactors;  // as in the directory name: "0.1", "1", "10"
+    std::vector<unsigned> threads;          // empty = 1, 2, 4, ... and the hardware concurrency
+    std::vector<std::string> queries{"q1", "q3", "q6", "q9", "q13"};
+    size_t buildCacheBytes = 0;
+};
+
+void runScalingSweep(const SweepConfig& config, const TpchParams& params);
@@ -0,0 +1,106 @@
+#include "ScratchArena.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include "HugePages.hpp"
+#include "WorkerPool.hpp"
+
+namespace {
+
+double msSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+size_t alignUp(size_t n, size_t a) { return (n + a - 1) / a * a; }
+
+// Below this a single memset beats waking the pool.
+constexpr size_t kParallelZeroBytes = 1 << 20;
+constexpr size_t kZeroMorselBytes = 256 << 10;
+
+} // namespace
+
+
+// --- Arena ---
+ScratchArena::~ScratchArena() {
+    for (const Block& b : m_blocks) freeLarge(b.data, b.size);
+}
+
+void ScratchArena::reset() {
+    if (m_blocks.size() > 1) {
+        // The last execution overflowed the first block: replace all of them by
+        // one block of the combined size, allocated on the next request.
+        size_t total = 0;
+        for (const Block& b : m_blocks) { total += b.size; freeLarge(b.data, b.size); }
+        m_blocks.clear();
+        m_blocks.push_back({nullptr, total});
+    }
+    m_current = 0;
+    m_offset = 0;
+    m_used = 0;
+    m_stats.executions += 1;
+}
+
+void* ScratchArena::allocBytes(size_t bytes) {
+    bytes = alignUp(std::max<size_t>(bytes, 1), kAlignment);
+    while (m_current < m_blocks.size()) {
+        Block& b = m_blocks[m_current];
+        if (b.data && m_offset + bytes <= b.size) break;
+        if (!b.data && bytes <= b.size) break; // pending coalesced block
+        ++m_current;
+        m_offset = 0;
+    }
+    if (m_current == m_blocks.size()) {
+        size_t last = m_blocks.empty() ? 0 : m_blocks.back().size;
+        m_blocks.push_back({nullptr, std::max({kMinBlockBytes, last * 2, alignUp(bytes, kMinBlockBytes)})});
+    }
+    Block& b = m_blocks[m_current];
+    if (!b.data) {
+        auto start = std::chrono::steady_clock::now();
+        b.data = static_cast<std::byte*>(allocateLarge(b.size)); // huge pages when enabled
+        m_stats.allocMs += msSince(start);
+        m_stats.blockAllocations += 1;
+    }
+    void* p = b.data + m_offset;
+    m_offset += bytes;
+    m_used += bytes;
+    m_stats.peakBytes = std::max(m_stats.peakBytes, m_used);
+    return p;
+}
+
+void ScratchArena::zero(void* p, size_t bytes, WorkerPool& pool) {
+    auto start = std::chrono::steady_clock::now();
+    if (bytes < kParallelZeroBytes || pool.size() < 2) {
+        std::memset(p, 0, bytes);
+    } else {
+        auto* base = static_cast<std::byte*>(p);
+        pool.parallelFor(bytes, kZeroMorselBytes, [&](size_t begin, size_t end, unsigned) {
+            std::memset(base + begin, 0, end - begin);
+        });
+    }
+    m_stats.zeroMs += msSince(start);
+}
+
+ScratchStats ScratchArena::takeStats() {
+    ScratchStats s = m_stats;
+    m_stats = ScratchStats{};
+    return s;
+}
+
+ScratchArena& scratchArena() {
+    static thread_local ScratchArena arena;
+    return arena;
+}
+
+void printScratchStats(const char* label, const ScratchStats& stats) {
+    if (stats.executions == 0) return;
+    const double n = (double)stats.executions;
+    const bool mb = stats.peakBytes >= (1 << 20);
+    printf("%s: %.2f %s per execution, %llu block allocation%s, alloc %.3f ms, zero %.3f ms per execution\n",
+           label, stats.peakBytes / (mb ? 1024.0 * 1024.0 : 1024.0), mb ? "MB" : "KB", (unsigned long long)stats.blockAllocations,
+           stats.blockAllocations == 1 ? "" : "s", stats.allocMs / n, stats.zeroMs / n);
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+class WorkerPool;
+
+// --- Per-Execution Scratch Arena ---
+// Scratch memory for one query execution on the CPU backend: per-worker
+// partials, dense count arrays and intermediates. Allocation bumps a pointer
+// through large cache-line-aligned blocks that stay mapped across iterations
+// and queries; reset() at the start of the next execution rewinds in O(1).
+// When an execution needed more than one block, the next reset coalesces them
+// into a single block of the combined size, so steady-state iterations allocate
+// nothing. Blocks come from allocateLarge() (huge pages when enabled). Zeroed allocations are cleared on the worker pool in parallel.
+// Allocation and zeroing time are accounted separately per execution. Each
+// thread (the main thread, every throughput stream) has its own arena.
+
+struct ScratchStats {
+    uint64_t executions = 0;
+    uint64_t blockAllocations = 0; // malloc calls for arena blocks
+    size_t peakBytes = 0;          // largest single execution
+    double allocMs = 0.0;          // block allocation
+    double zeroMs = 0.0;           // clearing allocZeroed ranges
+};
+
+class ScratchArena {
+public:
+    static constexpr size_t kAlignment = 64;
+    static constexpr size_t kMinBlockBytes = 4 << 20;
+
+    ScratchArena() = default;
+    ~ScratchArena();
+
+    ScratchArena(const ScratchArena&) = delete;
+    ScratchArena& operator=(const ScratchArena&) = delete;
+
+    // Starts a new execution; every pointer handed out before is invalidated.
+    void reset();
+
+    // Uninitialised, kAlignment-aligned storage for n trivially destructible T.
+    template <typename T>
+    T* alloc(size_t n) {
+        static_assert(std::is_trivially_destructible_v<T>, "arena memory is never destroyed");
+        static_assert(alignof(T) <= kAlignment);
+        return static_cast<T*>(allocBytes(n * sizeof(T)));
+    }
+
+    // As alloc(), cleared to zero bytes (in parallel on the pool when large).
+    template <typename T>
+    T* allocZeroed(size_t n, WorkerPool& pool) {
+        static_assert(std::is_trivially_copyable_v<T>, "zero bytes must be a valid T");
+        T* p = alloc<T>(n);
+        zero(p, n * sizeof(T), pool);
+        return p;
+    }
+
+    // Returns the accumulated statistics and clears them.
+    ScratchStats takeStats();
+
+private:
+    struct Block {
+        std::byte* data = nullptr;
+        size_t size = 0;
+    };
+
+    void* allocBytes(size_t bytes);
+    void zero(void* p, size_t bytes, WorkerPool& pool);
+
+    std::vector<Block> m_blocks;
+    size_t m_current = 0;   // block being bumped
+    size_t m_offset = 0;    // within m_blocks[m_current]
+    size_t m_used = 0;      // bytes handed out this execution
+    ScratchStats m_stats;
+};
+
+// The calling thread's arena.
+ScratchArena& scratchArena();
+
+// "<label>: X MB (or KB) per execution, N block allocations, alloc Y ms, zero Z ms per execution"
+void printScratchStats(const char* label, const ScratchStats& stats);
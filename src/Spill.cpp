@@ -0,0 +1,99 @@
+#include "Spill.hpp"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <unistd.h>
+
+namespace {
+
+constexpr size_t kMinBufferBytes = 16 << 10;
+constexpr size_t kMaxBufferBytes = 1 << 20;
+// One file per spilled partition and input; beyond this partitions outgrow the budget instead.
+constexpr size_t kMaxPartitions = 256;
+
+thread_local SpillStats t_spillStats;
+
+[[noreturn]] void spillError(const char* what, const std::string& detail) {
+    throw std::runtime_error(std::string("spill: ") + what + " " + detail + ": " + std::strerror(errno));
+}
+
+} // namespace
+
+
+// --- Budget ---
+MemoryBudgetConfig& memoryBudget() {
+    static MemoryBudgetConfig config;
+    return config;
+}
+
+SpillPlan planSpill(size_t stateBytes, size_t budgetBytes, unsigned workers) {
+    SpillPlan plan;
+    const size_t half = std::max<size_t>(budgetBytes / 2, 1);
+    plan.partitions = (unsigned)std::clamp<size_t>((stateBytes + half - 1) / half, 2, kMaxPartitions);
+    const size_t perPartition = std::max<size_t>(stateBytes / plan.partitions, 1);
+    plan.resident = (unsigned)std::min<size_t>(plan.partitions - 1, half / perPartition);
+    // Write buffers share a quarter of the budget; clamp to sensible I/O sizes
+    size_t buffer = budgetBytes / 4 / ((size_t)std::max(1u, workers) * plan.partitions);
+    plan.bufferBytes = std::clamp(buffer, kMinBufferBytes, kMaxBufferBytes);
+    return plan;
+}
+
+
+// --- Statistics ---
+void recordSpill(const SpillStats& execution) {
+    SpillStats& s = t_spillStats;
+    s.executions += 1;
+    s.partitions = execution.partitions;
+    s.resident = execution.resident;
+    s.bytesWritten += execution.bytesWritten;
+    s.bytesRead += execution.bytesRead;
+    s.writeMs += execution.writeMs;
+    s.readMs += execution.readMs;
+}
+
+SpillStats takeSpillStats() {
+    SpillStats s = t_spillStats;
+    t_spillStats = SpillStats{};
+    return s;
+}
+
+void printSpillStats(const char* label, const SpillStats& stats) {
+    if (stats.executions == 0) return;
+    const double n = (double)stats.executions;
+    printf("%s: %u partitions (%u in memory), wrote %.1f MB, read %.1f MB, write %.2f ms, read %.2f ms per execution\n",
+           label, stats.partitions, stats.resident, stats.bytesWritten / n / (1 << 20), stats.bytesRead / n / (1 << 20),
+           stats.writeMs / n, stats.readMs / n);
+}
+
+
+// --- Spill Files ---
+SpillFile::SpillFile(const std::string& directory, size_t bufferBytes) : m_buffer(std::max(bufferBytes, kMinBufferBytes)) {
+    std::string path = directory + "/gpudb-spill-XXXXXX";
+    int fd = mkstemp(path.data());
+    if (fd < 0) spillError("cannot create a file in", directory);
+    unlink(path.c_str()); // anonymous from here on; the space is freed when closed
+    m_file = fdopen(fd, "w+b");
+    if (!m_file) { close(fd); spillError("cannot open", path); }
+    setvbuf(m_file, m_buffer.data(), _IOFBF, m_buffer.size());
+}
+
+SpillFile::~SpillFile() {
+    if (m_file) std::fclose(m_file);
+}
+
+void SpillFile::append(const void* data, size_t bytes) {
+    if (std::fwrite(data, 1, bytes, m_file) != bytes) spillError("write failed after", std::to_string(m_size) + " bytes");
+    m_size += bytes;
+}
+
+void SpillFile::rewind() {
+    if (std::fflush(m_file) != 0 || std::fseek(m_file, 0, SEEK_SET) != 0) spillError("cannot rewind", "file");
+}
+
+size_t SpillFile::read(void* out, size_t bytes) {
+    size_t n = std::fread(out, 1, bytes, m_file);
+    if (n < bytes && std::ferror(m_file)) spillError("read failed after", std::to_string(n) + " bytes");
+    return n;
+}
@@ -0,0 +1,190 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// --- Memory Budget and Spilling ---
+// The CPU plans size their join and aggregation state to the input (Q3's
+// orders direct map and group table, Q13's per-customer counts). With a
+// per-query budget, a query whose estimated state exceeds it switches to a
+// partitioned plan: rows are hash- or range-partitioned by the join/group key,
+// partitions that fit in half the budget stay in memory (hybrid) and the rest
+// are appended to spill files with large sequential writes, then each
+// partition is joined/aggregated on its own. The number of spilled partitions
+// grows with the overshoot, so time degrades gradually instead of failing
+// when the scale factor outgrows memory. Spill files live in the spill
+// directory and are unlinked as soon as they are created.
+
+struct MemoryBudgetConfig {
+    size_t queryBytes = 0;           // 0 = unlimited (always the in-memory plan)
+    std::string directory = "/tmp";
+};
+
+MemoryBudgetConfig& memoryBudget();
+
+// Partition count for `stateBytes` of join/aggregation state: every partition
+// fits in half the budget when processed (up to 256 partitions), and as many
+// partitions as fit in the other half stay resident. Write buffers take what
+// is left.
+struct SpillPlan {
+    unsigned partitions = 1;
+    unsigned resident = 1;
+    size_t bufferBytes = 0;  // per (worker, partition) write buffer and per read chunk
+
+    bool spills() const { return resident < partitions; }
+};
+SpillPlan planSpill(size_t stateBytes, size_t budgetBytes, unsigned workers);
+
+// Per-thread totals over the executions that took a spilling plan.
+struct SpillStats {
+    uint64_t executions = 0;
+    unsigned partitions = 0;   // of the last execution
+    unsigned resident = 0;
+    uint64_t bytesWritten = 0;
+    uint64_t bytesRead = 0;
+    double writeMs = 0.0;
+    double readMs = 0.0;
+};
+void recordSpill(const SpillStats& execution);
+SpillStats takeSpillStats();
+
+// "<label>: 8 partitions (2 in memory), wrote 120.4 MB, read 120.4 MB, write 41.2 ms, read 18.0 ms per execution"; nothing when no execution spilled.
+void printSpillStats(const char* label, const SpillStats& stats);
+
+// An anonymous file in the spill directory, written and read sequentially
+// through a stdio buffer. I/O errors throw std::runtime_error.
+class SpillFile {
+public:
+    SpillFile(const std::string& directory, size_t bufferBytes);
+    ~SpillFile();
+
+    SpillFile(const SpillFile&) = delete;
+    SpillFile& operator=(const SpillFile&) = delete;
+
+    void append(const void* data, size_t bytes);
+    void rewind();                             // flushes; reads start at the beginning
+    size_t read(void* out, size_t bytes);      // 0 at the end
+    size_t size() const { return m_size; }
+
+private:
+    std::FILE* m_file = nullptr;
+    std::vector<char> m_buffer;
+    size_t m_size = 0;
+};
+
+// Rows of type T split into partitions [0, resident) kept in memory and
+// [resident, partitions) spilled to one file each. Workers append into their
+// own buffer per partition; a full buffer is moved into the partition under
+// its lock, so files see only bufferBytes-sized sequential writes. add() runs
+// on pool workers and never throws: the first I/O error is kept (later rows
+// are dropped) and flush() rethrows it on the calling thread.
+template <typename T>
+class SpillPartitions {
+    static_assert(std::is_trivially_copyable_v<T>, "rows are written as raw bytes");
+
+public:
+    SpillPartitions(const SpillPlan& plan, unsigned workers, SpillStats& stats)
+        : m_plan(plan), m_stats(stats), m_bufferRows(std::max<size_t>(1, plan.bufferBytes / sizeof(T))),
+          m_parts(plan.partitions), m_buffers((size_t)workers * plan.partitions) {
+        for (unsigned p = plan.resident; p < plan.partitions; ++p) {
+            m_parts[p].file = std::make_unique<SpillFile>(memoryBudget().directory, plan.bufferBytes);
+        }
+    }
+
+    void add(unsigned worker, unsigned partition, const T& row) {
+        std::vector<T>& buffer = m_buffers[(size_t)worker * m_plan.partitions + partition];
+        if (buffer.capacity() == 0) buffer.reserve(m_bufferRows);
+        buffer.push_back(row);
+        if (buffer.size() < m_bufferRows) return;
+        try {
+            drain(partition, buffer);
+        } catch (...) {
+            std::lock_guard<std::mutex> guard(m_errorLock);
+            if (!m_error) m_error = std::current_exception();
+            buffer.clear();
+        }
+    }
+
+    // Drains every worker buffer; call once all producers are done. Throws the
+    // first error a worker hit in add().
+    void flush() {
+        {
+            std::lock_guard<std::mutex> guard(m_errorLock);
+            if (m_error) std::rethrow_exception(m_error);
+        }
+        for (size_t b = 0; b < m_buffers.size(); ++b) {
+            drain((unsigned)(b % m_plan.partitions), m_buffers[b]);
+            std::vector<T>().swap(m_buffers[b]);
+        }
+        for (Part& part : m_parts) {
+            m_stats.bytesWritten += part.written;
+            m_stats.writeMs += part.writeMs;
+            part.written = 0;
+            part.writeMs = 0.0;
+        }
+    }
+
+    // Calls fn(rows, count) over the partition in chunks, then releases it.
+    template <typename Fn>
+    void consume(unsigned partition, Fn&& fn) {
+        Part& part = m_parts[partition];
+        if (!part.file) {
+            fn(part.rows.data(), part.rows.size());
+            std::vector<T>().swap(part.rows);
+            return;
+        }
+        auto start = std::chrono::steady_clock::now();
+        part.file->rewind();
+        std::vector<T> chunk(m_bufferRows);
+        double fnMs = 0.0;
+        while (size_t bytes = part.file->read(chunk.data(), chunk.size() * sizeof(T))) {
+            m_stats.bytesRead += bytes;
+            auto fnStart = std::chrono::steady_clock::now();
+            fn(chunk.data(), bytes / sizeof(T));
+            fnMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - fnStart).count();
+        }
+        part.file.reset();
+        m_stats.readMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() - fnMs;
+    }
+
+private:
+    struct Part {
+        std::mutex lock;
+        std::vector<T> rows;               // resident
+        std::unique_ptr<SpillFile> file;   // spilled
+        uint64_t written = 0;
+        double writeMs = 0.0;              // summed over the writing workers
+    };
+
+    void drain(unsigned partition, std::vector<T>& buffer) {
+        if (buffer.empty()) return;
+        Part& part = m_parts[partition];
+        std::lock_guard<std::mutex> guard(part.lock);
+        if (part.file) {
+            auto start = std::chrono::steady_clock::now();
+            part.file->append(buffer.data(), buffer.size() * sizeof(T));
+            part.written += buffer.size() * sizeof(T);
+            part.writeMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        } else {
+            part.rows.insert(part.rows.end(), buffer.begin(), buffer.end());
+        }
+        buffer.clear();
+    }
+
+    SpillPlan m_plan;
+    SpillStats& m_stats;
+    size_t m_bufferRows;
+    std::vector<Part> m_parts;
+    std::vector<std::vector<T>> m_buffers;
+    std::mutex m_errorLock;
+    std::exception_ptr m_error;
+};
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdio>
+#include <iostream>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+// Discards everything written to stdout (printf and std::cout alike) while alive,
+// so the per-query banners and result tables of measured executions stay out of
+// a report. Errors on stderr still come through.
+class StdoutSilencer {
+public:
+    StdoutSilencer() {
+        std::cout.flush(); fflush(stdout);
+        m_saved = dup(STDOUT_FILENO);
+        int devnull = open("/dev/null", O_WRONLY);
+        if (m_saved >= 0 && devnull >= 0) dup2(devnull, STDOUT_FILENO);
+        if (devnull >= 0) close(devnull);
+    }
+    ~StdoutSilencer() {
+        std::cout.flush(); fflush(stdout);
+        if (m_saved >= 0) { dup2(m_saved, STDOUT_FILENO); close(m_saved); }
+    }
+
+    StdoutSilencer(const StdoutSilencer&) = delete;
+    StdoutSilencer& operator=(const StdoutSilencer&) = delete;
+
+private:
+    int m_saved = -1;
+};
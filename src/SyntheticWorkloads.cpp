@@ -0,0 +1,300 @@
+#include "SyntheticWorkloads.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <random>
+
+#include "BenchHarness.hpp"
+#include "WorkerPool.hpp"
+
+namespace {
+
+// Rank sampler with P(rank k) proportional to 1 / (k + 1)^theta; theta 0 = uniform.
+class ZipfSampler {
+public:
+    ZipfSampler(size_t n, double theta) : m_n(n) {
+        if (theta <= 0.0) return;
+        m_cdf.resize(n);
+        double sum = 0.0;
+        for (size_t k = 0; k < n; ++k) m_cdf[k] = (sum += std::pow((double)(k + 1), -theta));
+        for (auto& c : m_cdf) c /= sum;
+    }
+
+    size_t operator()(std::mt19937_64& rng) const {
+        if (m_cdf.empty()) return std::uniform_int_distribution<size_t>(0, m_n - 1)(rng);
+        const double u = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+        return std::min<size_t>(std::lower_bound(m_cdf.begin(), m_cdf.end(), u) - m_cdf.begin(), m_n - 1);
+    }
+
+private:
+    size_t m_n;
+    std::vector<double> m_cdf;
+};
+
+bool domainFits(size_t keys, uint32_t stride) {
+    return (double)keys * stride + 1.0 <= (double)std::numeric_limits<int>::max();
+}
+
+int keyAt(size_t index, uint32_t stride) { return (int)(1 + (uint64_t)index * stride); }
+
+// Random permutation of [0, n): maps Zipf ranks to key indexes.
+std::vector<uint32_t> shuffledIndexes(size_t n, std::mt19937_64& rng) {
+    std::vector<uint32_t> p(n);
+    std::iota(p.begin(), p.end(), 0u);
+    std::shuffle(p.begin(), p.end(), rng);
+    return p;
+}
+
+double msSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+double median(const std::vector<double>& samples) { return samples.empty() ? 0.0 : percentile(samples, 0.5); }
+
+// --- Sweep Parameters ---
+struct SweepAxis {
+    const char* name;
+    const char* label;
+    std::vector<double> values;
+};
+
+const std::vector<SweepAxis> kJoinAxes{
+    {"theta", "Zipf theta of the probe keys", {0.0, 0.5, 0.75, 0.9, 0.99, 1.25, 1.5}},
+    {"stride", "key stride (sparse domain)", {1, 2, 10, 100, 1000}},
+    {"ratio", "probe rows per build row", {0.25, 1, 4, 16}},
+    {"match", "probe match rate", {0.0, 0.1, 0.5, 0.9, 1.0}},
+};
+const std::vector<SweepAxis> kAggregationAxes{
+    {"theta", "Zipf theta of the group keys", {0.0, 0.5, 0.75, 0.9, 0.99, 1.25, 1.5}},
+    {"stride", "key stride (sparse domain)", {1, 2, 10, 100, 1000}},
+    {"groups", "number of groups", {16, 1024, 65536, 1 << 20}},
+};
+
+// The axes named in `parameters` (all when empty); false on an unknown name.
+bool selectAxes(const std::vector<SweepAxis>& axes, const std::vector<std::string>& parameters, std::vector<const SweepAxis*>& out) {
+    for (const auto& axis : axes) {
+        if (parameters.empty() || std::find(parameters.begin(), parameters.end(), axis.name) != parameters.end()) out.push_back(&axis);
+    }
+    for (const auto& p : parameters) {
+        if (std::none_of(axes.begin(), axes.end(), [&](const SweepAxis& a) { return p == a.name; })) {
+            std::cerr << "Unknown sweep parameter for this benchmark: " << p << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+
+JoinWorkload makeJoinWorkload(const JoinSpec& spec) {
+    JoinWorkload w;
+    const size_t n = std::max<size_t>(1, spec.buildRows);
+    // Non-matching probe keys continue the same domain past the build keys
+    if (!domainFits(2 * n, spec.keyStride)) return w;
+    std::mt19937_64 rng(spec.seed);
+    const std::vector<uint32_t> order = shuffledIndexes(n, rng);
+    w.buildKeys.resize(n);
+    for (size_t i = 0; i < n; ++i) w.buildKeys[i] = keyAt(order[i], spec.keyStride);
+
+    const std::vector<uint32_t> hot = shuffledIndexes(n, rng);
+    const ZipfSampler zipf(n, spec.zipfTheta);
+    std::bernoulli_distribution matches(std::clamp(spec.matchRate, 0.0, 1.0));
+    std::uniform_int_distribution<size_t> miss(n, 2 * n - 1);
+    w.probeKeys.resize((size_t)std::llround(spec.probeRatio * (double)n));
+    for (auto& key : w.probeKeys) {
+        if (matches(rng)) {
+            key = keyAt(hot[zipf(rng)], spec.keyStride);
+            ++w.expectedMatches;
+        } else {
+            key = keyAt(miss(rng), spec.keyStride);
+        }
+    }
+    return w;
+}
+
+AggregationWorkload makeAggregationWorkload(const AggregationSpec& spec) {
+    AggregationWorkload w;
+    const size_t groups = std::max<size_t>(1, spec.groups);
+    if (!domainFits(groups, spec.keyStride)) return w;
+    std::mt19937_64 rng(spec.seed);
+    const std::vector<uint32_t> hot = shuffledIndexes(groups, rng);
+    const ZipfSampler zipf(groups, spec.zipfTheta);
+    std::uniform_int_distribution<int> value(1, 50);
+    std::vector<bool> seen(groups, false);
+    w.keys.resize(spec.rows);
+    w.values.resize(spec.rows);
+    for (size_t i = 0; i < spec.rows; ++i) {
+        const uint32_t g = hot[zipf(rng)];
+        w.keys[i] = keyAt(g, spec.keyStride);
+        w.values[i] = value(rng);
+        w.expectedSum += (uint64_t)w.values[i];
+        if (!seen[g]) { seen[g] = true; ++w.expectedGroups; }
+    }
+    return w;
+}
+
+bool runJoinSweep(const MicroSweepConfig& config, const JoinRunner& run) {
+    std::vector<const SweepAxis*> axes;
+    if (!selectAxes(kJoinAxes, config.parameters, axes)) return false;
+    const JoinSpec& base = config.join;
+    printf("\n--- Join Distribution Sweep ---\n");
+    printf("Base: %zu build rows, %.2f probe rows per build row, match rate %.2f, theta %.2f, key stride %u\n",
+           base.buildRows, base.probeRatio, base.matchRate, base.zipfTheta, base.keyStride);
+    for (const SweepAxis* axis : axes) {
+        printf("\nJoin vs %s:\n", axis->label);
+        printf("+----------+------------+------------+------------+------------+-------+\n");
+        printf("|    value |   build ms |   probe ms | Mprobes/s  |    matches | check |\n");
+        printf("+----------+------------+------------+------------+------------+-------+\n");
+        for (double v : axis->values) {
+            JoinSpec spec = base;
+            const std::string name = axis->name;
+            if (name == "theta") spec.zipfTheta = v;
+            else if (name == "stride") spec.keyStride = (uint32_t)v;
+            else if (name == "ratio") spec.probeRatio = v;
+            else spec.matchRate = v;
+            const JoinWorkload w = makeJoinWorkload(spec);
+            if (w.buildKeys.empty()) {
+                printf("| %8.8g | skipped: keys do not fit in int32                           |\n", v);
+                continue;
+            }
+            const MicroTiming t = run(w);
+            printf("| %8.8g | %10.3f | %10.3f | %10.1f | %10llu | %5s |\n", v, t.buildMs, t.probeMs,
+                   t.probeMs > 0.0 ? w.probeKeys.size() / (t.probeMs * 1e3) : 0.0, (unsigned long long)t.result,
+                   t.result == w.expectedMatches ? "ok" : "WRONG");
+        }
+        printf("+----------+------------+------------+------------+------------+-------+\n");
+    }
+    return true;
+}
+
+bool runAggregationSweep(const MicroSweepConfig& config, const AggregationRunner& run) {
+    std::vector<const SweepAxis*> axes;
+    if (!selectAxes(kAggregationAxes, config.parameters, axes)) return false;
+    const AggregationSpec& base = config.aggregation;
+    printf("\n--- Aggregation Distribution Sweep ---\n");
+    printf("Base: %zu rows, %zu groups, theta %.2f, key stride %u\n", base.rows, base.groups, base.zipfTheta, base.keyStride);
+    for (const SweepAxis* axis : axes) {
+        printf("\nGROUP BY aggregation vs %s:\n", axis->label);
+        printf("+----------+------------+------------+------------+-------+\n");
+        printf("|    value |  aggr. ms  |  Mrows/s   |     groups | check |\n");
+        printf("+----------+------------+------------+------------+-------+\n");
+        for (double v : axis->values) {
+            AggregationSpec spec = base;
+            const std::string name = axis->name;
+            if (name == "theta") spec.zipfTheta = v;
+            else if (name == "stride") spec.keyStride = (uint32_t)v;
+            else spec.groups = (size_t)v;
+            const AggregationWorkload w = makeAggregationWorkload(spec);
+            if (w.keys.empty()) {
+                printf("| %8.8g | skipped: keys do not fit in int32             |\n", v);
+                continue;
+            }
+            const MicroTiming t = run(w);
+            printf("| %8.8g | %10.3f | %10.1f | %10llu | %5s |\n", v, t.probeMs, t.probeMs > 0.0 ? w.keys.size() / (t.probeMs * 1e3) : 0.0,
+                   (unsigned long long)t.result, t.result == w.expectedGroups && t.checksum == w.expectedSum ? "ok" : "WRONG");
+        }
+        printf("+----------+------------+------------+------------+-------+\n");
+    }
+    return true;
+}
+
+JoinRunner cpuJoinRunner(WorkerPool& pool) {
+    return [&pool](const JoinWorkload& w) {
+        const size_t size = w.buildKeys.size() * 2;
+        std::vector<std::atomic<int>> keys(size);
+        std::vector<int> rows(size);
+        std::vector<uint64_t> matches(pool.size());
+        std::vector<double> buildMs, probeMs;
+        BenchLoop loop;
+        while (loop.next()) {
+            for (auto& k : keys) k.store(-1, std::memory_order_relaxed);
+            std::fill(matches.begin(), matches.end(), 0);
+
+            auto start = std::chrono::steady_clock::now();
+            pool.parallelFor(w.buildKeys.size(), WorkerPool::kDefaultMorsel, [&](size_t begin, size_t end, unsigned) {
+                for (size_t i = begin; i < end; ++i) {
+                    const int key = w.buildKeys[i];
+                    for (size_t slot = (uint32_t)key % size;; slot = slot + 1 == size ? 0 : slot + 1) {
+                        int expected = -1;
+                        if (keys[slot].compare_exchange_strong(expected, key, std::memory_order_relaxed)) {
+                            rows[slot] = (int)i;
+                            break;
+                        }
+                    }
+                }
+            });
+            const double build = msSince(start);
+
+            start = std::chrono::steady_clock::now();
+            pool.parallelFor(w.probeKeys.size(), WorkerPool::kDefaultMorsel, [&](size_t begin, size_t end, unsigned worker) {
+                uint64_t local = 0;
+                for (size_t i = begin; i < end; ++i) {
+                    const int key = w.probeKeys[i];
+                    for (size_t slot = (uint32_t)key % size;; slot = slot + 1 == size ? 0 : slot + 1) {
+                        const int k = keys[slot].load(std::memory_order_relaxed);
+                        if (k == key) { ++local; break; }
+                        if (k == -1) break;
+                    }
+                }
+                matches[worker] += local;
+            });
+            const double probe = msSince(start);
+            loop.record(build + probe);
+            if (!loop.warmup()) { buildMs.push_back(build); probeMs.push_back(probe); }
+        }
+        MicroTiming t;
+        t.buildMs = median(buildMs);
+        t.probeMs = median(probeMs);
+        t.result = std::accumulate(matches.begin(), matches.end(), (uint64_t)0);
+        return t;
+    };
+}
+
+AggregationRunner cpuAggregationRunner(WorkerPool& pool) {
+    return [&pool](const AggregationWorkload& w) {
+        // Sized like the join table: twice the distinct keys
+        const size_t size = std::max<size_t>(2, w.expectedGroups * 2);
+        std::vector<std::atomic<int>> keys(size);
+        std::vector<std::atomic<uint32_t>> counts(size);
+        std::vector<std::atomic<uint64_t>> sums(size);
+        BenchLoop loop;
+        while (loop.next()) {
+            for (size_t s = 0; s < size; ++s) {
+                keys[s].store(-1, std::memory_order_relaxed);
+                counts[s].store(0, std::memory_order_relaxed);
+                sums[s].store(0, std::memory_order_relaxed);
+            }
+            const auto start = std::chrono::steady_clock::now();
+            pool.parallelFor(w.keys.size(), WorkerPool::kDefaultMorsel, [&](size_t begin, size_t end, unsigned) {
+                for (size_t i = begin; i < end; ++i) {
+                    const int key = w.keys[i];
+                    for (size_t slot = (uint32_t)key % size;; slot = slot + 1 == size ? 0 : slot + 1) {
+                        int current = keys[slot].load(std::memory_order_relaxed);
+                        if (current == -1 && keys[slot].compare_exchange_strong(current, key, std::memory_order_relaxed)) current = key;
+                        if (current == key) {
+                            counts[slot].fetch_add(1, std::memory_order_relaxed);
+                            sums[slot].fetch_add((uint64_t)w.values[i], std::memory_order_relaxed);
+                            break;
+                        }
+                    }
+                }
+            });
+            loop.record(msSince(start));
+        }
+        MicroTiming t;
+        t.probeMs = loop.stats().median;
+        for (size_t s = 0; s < size; ++s) {
+            if (keys[s].load(std::memory_order_relaxed) == -1) continue;
+            ++t.result;
+            t.checksum += sums[s].load(std::memory_order_relaxed);
+        }
+        return t;
+    };
+}
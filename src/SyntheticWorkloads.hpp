@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+class WorkerPool;
+
+// --- Synthetic Join and Aggregation Workloads ---
+// Generated inputs for the join and aggregation micro benchmarks. Without them,
+// these benchmarks only see o_orderkey x l_orderkey: unique, dense keys with
+// about four matches each. Build keys are 1, 1 + stride, 1 + 2 stride, ... (a
+// sparse domain for stride > 1), stored in random order. Probe rows and group
+// keys pick their key by Zipf rank (theta 0 = uniform); ranks map to a random
+// permutation of the keys, so hot keys are not neighbours. A sweep varies one
+// parameter at a time from a base spec and reports a backend's build and probe
+// times as a function of it. Both backends use the same linear-probing table
+// with `key % size`, which is what the sweep is meant to break.
+
+struct JoinSpec {
+    size_t buildRows = 1 << 20;
+    double probeRatio = 4.0;  // probe rows per build row
+    double matchRate = 1.0;   // fraction of probe rows whose key is on the build side
+    double zipfTheta = 0.0;   // skew of the build key each matching probe row picks
+    uint32_t keyStride = 1;
+    uint64_t seed = 42;
+};
+
+struct JoinWorkload {
+    std::vector<int> buildKeys;  // unique
+    std::vector<int> probeKeys;
+    uint64_t expectedMatches = 0;
+};
+
+struct AggregationSpec {
+    size_t rows = 8 << 20;
+    size_t groups = 1 << 16;
+    double zipfTheta = 0.0;   // skew of the group each row falls into
+    uint32_t keyStride = 1;
+    uint64_t seed = 42;
+};
+
+struct AggregationWorkload {
+    std::vector<int> keys;
+    std::vector<int> values;     // 1..50, like l_quantity
+    uint64_t expectedGroups = 0; // distinct keys present
+    uint64_t expectedSum = 0;
+};
+
+// Empty vectors when the key domain does not fit in int32.
+JoinWorkload makeJoinWorkload(const JoinSpec& spec);
+AggregationWorkload makeAggregationWorkload(const AggregationSpec& spec);
+
+// One backend's median times for a workload, plus its result for checking:
+// join: result = matches; aggregation: result = groups, checksum = SUM(value).
+struct MicroTiming {
+    double buildMs = 0.0;
+    double probeMs = 0.0;  // probe, or the aggregation pass
+    uint64_t result = 0;
+    uint64_t checksum = 0;
+};
+using JoinRunner = std::function<MicroTiming(const JoinWorkload&)>;
+using AggregationRunner = std::function<MicroTiming(const AggregationWorkload&)>;
+
+struct MicroSweepConfig {
+    JoinSpec join;
+    AggregationSpec aggregation;
+    // theta, stride, ratio, match (join), groups (aggregation); empty = all that apply
+    std::vector<std::string> parameters;
+};
+
+// false when a parameter name is unknown
+bool runJoinSweep(const MicroSweepConfig& config, const JoinRunner& run);
+bool runAggregationSweep(const MicroSweepConfig& config, const AggregationRunner& run);
+
+// CPU backend: the GPU kernels' tables, built and probed on the worker pool.
+JoinRunner cpuJoinRunner(WorkerPool& pool);
+AggregationRunner cpuAggregationRunner(WorkerPool& pool);
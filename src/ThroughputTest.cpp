@@ -0,0 +1,144 @@
+#include "ThroughputTest.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <exception>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <thread>
+
+#include "BenchHarness.hpp"
+#include "StdoutSilencer.hpp"
+#include "Trace.hpp"
+
+namespace {
+
+struct QueryTiming {
+    std::string query;
+    double ms;
+};
+
+// Starts all streams at the same instant and returns the measurement interval Ts
+// in seconds (first stream start to last stream finish). A query that throws
+// ends its stream; the first such error is rethrown once all streams are done.
+double runStreams(const std::vector<std::vector<std::string>>& streamOrder, const std::vector<TpchParams>& streamParams,
+                  const QueryExecutor& execute, std::vector<std::vector<QueryTiming>>& timings, std::vector<double>& streamMs) {
+    std::mutex goMutex;
+    std::condition_variable goCv;
+    bool go = false;
+    std::vector<std::exception_ptr> errors(streamOrder.size());
+
+    std::vector<std::thread> threads;
+    for (size_t s = 0; s < streamOrder.size(); ++s) {
+        threads.emplace_back([&, s] {
+            setTraceThreadName("stream " + std::to_string(s));
+            {
+                std::unique_lock<std::mutex> lock(goMutex);
+                goCv.wait(lock, [&] { return go; });
+            }
+            auto streamStart = std::chrono::high_resolution_clock::now();
+            for (const auto& q : streamOrder[s]) {
+                auto start = std::chrono::high_resolution_clock::now();
+                TraceSpan span("stream query", "query");
+                if (span.active()) span.arg("query", q);
+                try {
+                    execute(q, streamParams[s]);
+                } catch (...) {
+                    errors[s] = std::current_exception();
+                    break;
+                }
+                span.close();
+                auto end = std::chrono::high_resolution_clock::now();
+                timings[s].push_back({q, std::chrono::duration<double, std::milli>(end - start).count()});
+            }
+            streamMs[s] = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - streamStart).count();
+        });
+    }
+
+    auto testStart = std::chrono::high_resolution_clock::now();
+    {
+        std::lock_guard<std::mutex> lock(goMutex);
+        go = true;
+    }
+    goCv.notify_all();
+    for (auto& t : threads) t.join();
+    for (const auto& error : errors) {
+        if (error) std::rethrow_exception(error);
+    }
+    return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - testStart).count();
+}
+
+} // namespace
+
+void runThroughputTest(const ThroughputConfig& config, const QueryExecutor& execute) {
+    const int streams = std::max(1, config.streams);
+    std::cout << "\n--- Running TPC-H Throughput Test (" << config.backend << ", " << streams << " streams) ---" << std::endl;
+
+    // Per-stream parameter sets and query orders, derived from the seed only
+    std::vector<TpchParams> streamParams;
+    std::vector<std::vector<std::string>> streamOrder;
+    for (int s = 0; s < streams; ++s) {
+        streamParams.push_back(QgenParameterGenerator(config.seed + (uint64_t)s + 1).next());
+        std::vector<std::string> order = config.queries;
+        std::mt19937_64 rng(config.seed * 1000003ull + (uint64_t)s);
+        std::shuffle(order.begin(), order.end(), rng);
+        streamOrder.push_back(order);
+    }
+
+    // Warm-up: one execution per query so column loading and pipeline creation
+    // are outside the measurement interval
+    std::cout << "Warm-up pass..." << std::endl;
+    std::vector<std::vector<QueryTiming>> timings(streams);
+    std::vector<double> streamMs(streams, 0.0);
+    double tsSeconds = 0.0;
+    {
+        StdoutSilencer silence;
+        for (const auto& q : config.queries) execute(q, TpchParams{});
+        tsSeconds = runStreams(streamOrder, streamParams, execute, timings, streamMs);
+    }
+
+    // --- Throughput ---
+    const double totalQueries = (double)streams * (double)config.queries.size();
+    const double queriesPerHour = totalQueries * 3600.0 / tsSeconds;
+    printf("\nScale factor: %g, streams: %d, queries per stream: %zu\n", config.scaleFactor, streams, config.queries.size());
+    printf("Measurement interval Ts: %0.3f s\n", tsSeconds);
+    printf("Throughput: %0.1f queries/hour\n", queriesPerHour);
+    printf("Throughput@Size (queries/hour x SF): %0.1f\n", queriesPerHour * config.scaleFactor);
+
+    // --- Per-query latency under concurrency ---
+    std::map<std::string, std::vector<double>> byQuery;
+    for (const auto& st : timings) for (const auto& t : st) byQuery[t.query].push_back(t.ms);
+    printf("\nPer-query latency (ms):\n");
+    printf("+-------+-----+------------+------------+------------+------------+------------+\n");
+    printf("| query |   n |        min |     median |        p95 |        max |       mean |\n");
+    printf("+-------+-----+------------+------------+------------+------------+------------+\n");
+    for (const auto& q : config.queries) {
+        const auto& v = byQuery[q];
+        if (v.empty()) continue;
+        double mean = std::accumulate(v.begin(), v.end(), 0.0) / (double)v.size();
+        printf("| %-5s | %3zu | %10.2f | %10.2f | %10.2f | %10.2f | %10.2f |\n", q.c_str(), v.size(),
+               *std::min_element(v.begin(), v.end()), percentile(v, 0.5), percentile(v, 0.95),
+               *std::max_element(v.begin(), v.end()), mean);
+    }
+    printf("+-------+-----+------------+------------+------------+------------+------------+\n");
+
+    // --- Per-stream fairness ---
+    printf("\nPer-stream elapsed (ms):\n");
+    for (int s = 0; s < streams; ++s) {
+        std::string order;
+        for (const auto& q : streamOrder[s]) order += (order.empty() ? "" : ",") + q;
+        printf("  stream %2d: %10.2f  [%s]\n", s, streamMs[s], order.c_str());
+    }
+    // Jain's fairness index over per-stream rates (1.0 = perfectly fair)
+    double sum = 0.0, sumSq = 0.0;
+    for (double ms : streamMs) { double rate = 1.0 / std::max(ms, 1e-9); sum += rate; sumSq += rate * rate; }
+    double jain = (sum * sum) / ((double)streams * sumSq);
+    double slowest = *std::max_element(streamMs.begin(), streamMs.end());
+    double fastest = *std::min_element(streamMs.begin(), streamMs.end());
+    printf("Stream fairness: Jain index %0.3f, slowest/fastest %0.2fx\n", jain, slowest / std::max(fastest, 1e-9));
+}
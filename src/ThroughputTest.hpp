@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "TpchParams.hpp"
+
+// --- TPC-H Throughput Test ---
+// Runs S concurrent query streams against one shared executor (the GPU command
+// queue or the CPU worker pool). Every stream executes each query once, in its
+// own permuted order and with its own qgen parameter set, all streams starting
+// at the same instant. Reports the measurement interval Ts, QphH-style
+// throughput, per-query latency distribution and per-stream fairness.
+
+// Executes one query by name ("q1", "q3", ...) quietly. Must be safe to call
+// from several threads at once.
+using QueryExecutor = std::function<void(const std::string& query, const TpchParams& params)>;
+
+struct ThroughputConfig {
+    int streams = 2;
+    uint64_t seed = 0;
+    std::vector<std::string> queries{"q1", "q3", "q6", "q9", "q13"};
+    double scaleFactor = 1.0;
+    std::string backend;
+};
+
+void runThroughputTest(const ThroughputConfig& config, const QueryExecutor& execute);
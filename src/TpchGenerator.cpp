@@ -0,0 +1,457 @@
+#include "TpchGenerator.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <string_view>
+#include <vector>
+
+#include "TpchParams.hpp"
+#include "Trace.hpp"
+#include "WorkerPool.hpp"
+
+const char* const kOrderPriorities[5] = {"1-URGENT", "2-HIGH", "3-MEDIUM", "4-NOT SPECIFIED", "5-LOW"};
+const char* const kShipInstructions[4] = {"DELIVER IN PERSON", "COLLECT COD", "NONE", "TAKE BACK RETURN"};
+const char* const kShipModes[7] = {"REG AIR", "AIR", "RAIL", "SHIP", "TRUCK", "MAIL", "FOB"};
+
+namespace {
+
+const size_t kChunkRows = 16 * 1024; // driving rows (parts, orders, ...) per chunk
+const size_t kTextPoolBytes = 16 << 20;
+
+// --- Column Layouts (.tbl column order; dates as YYYYMMDD ints) ---
+struct ColumnDef {
+    char kind;
+    int width;
+};
+const std::vector<ColumnDef> kRegionColumns{{'i', 1}, {'c', 25}, {'c', 152}};
+const std::vector<ColumnDef> kNationColumns{{'i', 1}, {'c', 25}, {'i', 1}, {'c', 152}};
+const std::vector<ColumnDef> kSupplierColumns{{'i', 1}, {'c', 25}, {'c', 40}, {'i', 1}, {'c', 15}, {'f', 1}, {'c', 101}};
+const std::vector<ColumnDef> kCustomerColumns{{'i', 1}, {'c', 25}, {'c', 40}, {'i', 1}, {'c', 15}, {'f', 1}, {'c', 10}, {'c', 117}};
+const std::vector<ColumnDef> kPartColumns{{'i', 1}, {'c', 55}, {'c', 25}, {'c', 10}, {'c', 25}, {'i', 1}, {'c', 10}, {'f', 1}, {'c', 23}};
+const std::vector<ColumnDef> kPartSuppColumns{{'i', 1}, {'i', 1}, {'i', 1}, {'f', 1}, {'c', 199}};
+const std::vector<ColumnDef> kOrdersColumns{{'i', 1}, {'i', 1}, {'c', 1}, {'f', 1}, {'i', 1}, {'c', 15}, {'c', 15}, {'i', 1}, {'c', 79}};
+const std::vector<ColumnDef> kLineitemColumns{{'i', 1}, {'i', 1}, {'i', 1}, {'i', 1}, {'f', 1}, {'f', 1}, {'f', 1}, {'f', 1},
+                                              {'c', 1}, {'c', 1}, {'i', 1}, {'i', 1}, {'i', 1}, {'c', 25}, {'c', 10}, {'c', 44}};
+
+// --- dbgen distributions (dists.dss) ---
+const char* const kRegions[5] = {"AFRICA", "AMERICA", "ASIA", "EUROPE", "MIDDLE EAST"};
+const struct { const char* name; int region; } kNations[25] = {
+    {"ALGERIA", 0}, {"ARGENTINA", 1}, {"BRAZIL", 1}, {"CANADA", 1}, {"EGYPT", 4}, {"ETHIOPIA", 0}, {"FRANCE", 3},
+    {"GERMANY", 3}, {"INDIA", 2}, {"INDONESIA", 2}, {"IRAN", 4}, {"IRAQ", 4}, {"JAPAN", 2}, {"JORDAN", 4},
+    {"KENYA", 0}, {"MOROCCO", 0}, {"MOZAMBIQUE", 0}, {"PERU", 1}, {"CHINA", 2}, {"ROMANIA", 3}, {"SAUDI ARABIA", 4},
+    {"VIETNAM", 2}, {"RUSSIA", 3}, {"UNITED KINGDOM", 3}, {"UNITED STATES", 1}};
+const char* const kTypeSize[] = {"STANDARD", "SMALL", "MEDIUM", "LARGE", "ECONOMY", "PROMO"};
+const char* const kTypeFinish[] = {"ANODIZED", "BURNISHED", "PLATED", "POLISHED", "BRUSHED"};
+const char* const kTypeMaterial[] = {"TIN", "NICKEL", "BRASS", "STEEL", "COPPER"};
+const char* const kContainerSize[] = {"SM", "LG", "MED", "JUMBO", "WRAP"};
+const char* const kContainerType[] = {"CASE", "BOX", "BAG", "JAR", "PKG", "PACK", "CAN", "DRUM"};
+
+struct Weighted {
+    const char* word;
+    int weight;
+};
+const std::vector<Weighted> kNouns{
+    {"packages", 40}, {"requests", 40}, {"accounts", 40}, {"deposits", 40}, {"foxes", 20}, {"ideas", 20},
+    {"theodolites", 20}, {"pinto beans", 20}, {"instructions", 20}, {"dependencies", 10}, {"excuses", 10},
+    {"platelets", 10}, {"asymptotes", 10}, {"courts", 5}, {"dolphins", 5}, {"multipliers", 1}, {"sauternes", 1},
+    {"warthogs", 1}, {"frets", 1}, {"dinos", 1}, {"attainments", 1}, {"somas", 1}, {"Tiresias", 1}, {"patterns", 1},
+    {"forges", 1}, {"braids", 1}, {"frays", 1}, {"warhorses", 1}, {"dugouts", 1}, {"notornis", 1}, {"epitaphs", 1},
+    {"pearls", 1}, {"tithes", 1}, {"waters", 1}, {"orbits", 1}, {"gifts", 1}, {"sheaves", 1}, {"depths", 1},
+    {"sentiments", 1}, {"decoys", 1}, {"realms", 1}, {"pains", 1}, {"grouches", 1}, {"escapades", 1}, {"hockey players", 1}};
+const std::vector<Weighted> kVerbs{
+    {"sleep", 20}, {"wake", 20}, {"are", 20}, {"cajole", 20}, {"haggle", 20}, {"nag", 10}, {"use", 10}, {"boost", 10},
+    {"affix", 5}, {"detect", 5}, {"integrate", 5}, {"maintain", 1}, {"nod", 1}, {"was", 1}, {"lose", 1}, {"sublate", 1},
+    {"solve", 1}, {"thrash", 1}, {"promise", 1}, {"engage", 1}, {"hinder", 1}, {"print", 1}, {"x-ray", 1}, {"breach", 1},
+    {"eat", 1}, {"grow", 1}, {"impress", 1}, {"mold", 1}, {"poach", 1}, {"serve", 1}, {"run", 1}, {"dazzle", 1},
+    {"snooze", 1}, {"doze", 1}, {"unwind", 1}, {"kindle", 1}, {"play", 1}, {"hang", 1}, {"believe", 1}, {"doubt", 1}};
+const std::vector<Weighted> kAdjectives{
+    {"special", 20}, {"pending", 20}, {"unusual", 20}, {"express", 20}, {"furious", 1}, {"sly", 1}, {"careful", 1},
+    {"blithe", 1}, {"quick", 1}, {"fluffy", 1}, {"slow", 1}, {"quiet", 1}, {"ruthless", 1}, {"thin", 1}, {"close", 1},
+    {"dogged", 1}, {"daring", 1}, {"brave", 1}, {"stealthy", 1}, {"permanent", 1}, {"enticing", 1}, {"idle", 1},
+    {"busy", 1}, {"regular", 50}, {"final", 40}, {"ironic", 40}, {"even", 30}, {"bold", 20}, {"silent", 10}};
+const std::vector<Weighted> kAdverbs{
+    {"sometimes", 1}, {"always", 1}, {"never", 1}, {"furiously", 50}, {"slyly", 50}, {"carefully", 50},
+    {"blithely", 40}, {"quickly", 30}, {"fluffily", 20}, {"slowly", 1}, {"quietly", 1}, {"ruthlessly", 1},
+    {"thinly", 1}, {"closely", 1}, {"doggedly", 1}, {"daringly", 1}, {"bravely", 1}, {"stealthily", 1},
+    {"permanently", 1}, {"enticingly", 1}, {"idly", 1}, {"busily", 1}, {"regularly", 1}, {"finally", 1},
+    {"ironically", 1}, {"evenly", 1}, {"boldly", 1}, {"silently", 1}};
+const std::vector<Weighted> kPrepositions{
+    {"about", 50}, {"above", 50}, {"according to", 50}, {"across", 50}, {"after", 50}, {"against", 40}, {"along", 40},
+    {"alongside of", 30}, {"among", 30}, {"around", 20}, {"at", 10}, {"atop", 1}, {"before", 1}, {"behind", 1},
+    {"beneath", 1}, {"beside", 1}, {"besides", 1}, {"between", 1}, {"beyond", 1}, {"by", 1}, {"despite", 1},
+    {"during", 1}, {"except", 1}, {"for", 1}, {"from", 1}, {"in place of", 1}, {"inside", 1}, {"instead of", 1},
+    {"into", 1}, {"near", 1}, {"of", 1}, {"on", 1}, {"outside", 1}, {"over", 1}, {"past", 1}, {"since", 1},
+    {"through", 1}, {"throughout", 1}, {"to", 1}, {"toward", 1}, {"under", 1}, {"until", 1}, {"up", 1}, {"upon", 1},
+    {"without", 1}, {"with", 1}, {"within", 1}};
+const std::vector<Weighted> kAuxiliaries{
+    {"do", 1}, {"may", 1}, {"might", 1}, {"shall", 1}, {"will", 1}, {"would", 1}, {"can", 1}, {"could", 1},
+    {"should", 1}, {"ought to", 1}, {"must", 1}, {"will have to", 1}, {"shall have to", 1}, {"could have to", 1},
+    {"should have to", 1}, {"must have to", 1}, {"need to", 1}, {"try to", 1}};
+const std::vector<Weighted> kTerminators{{".", 50}, {";", 1}, {":", 1}, {"?", 1}, {"!", 1}, {"--", 1}};
+// Grammar symbols: N noun phrase, V verb phrase, P prepositional phrase, T terminator
+const std::vector<Weighted> kSentences{{"NVT", 3}, {"NVPT", 3}, {"NVNT", 3}, {"NPVNT", 1}, {"NPVPT", 1}};
+// J adjective, D adverb, X auxiliary, ',' a comma after the previous word
+const std::vector<Weighted> kNounPhrases{{"N", 10}, {"JN", 20}, {"J,JN", 10}, {"DJN", 50}};
+const std::vector<Weighted> kVerbPhrases{{"V", 30}, {"XV", 1}, {"VD", 40}, {"XVD", 1}};
+
+// splitmix64 stream; one per (table, chunk) so output does not depend on scheduling.
+class ChunkRng {
+public:
+    ChunkRng(uint64_t stream, uint64_t chunk) : m_state(stream * 0x9E3779B97F4A7C15ull ^ (chunk + 1) * 0xD1B54A32D192ED03ull) {}
+
+    uint64_t next() {
+        uint64_t z = (m_state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+    int64_t uniform(int64_t lo, int64_t hi) { return lo + (int64_t)(next() % (uint64_t)(hi - lo + 1)); }
+    const char* pick(const std::vector<Weighted>& list) {
+        int total = 0;
+        for (const auto& w : list) total += w.weight;
+        int r = (int)uniform(0, total - 1);
+        for (const auto& w : list) {
+            if ((r -= w.weight) < 0) return w.word;
+        }
+        return list.back().word;
+    }
+    template <size_t N>
+    const char* pick(const char* const (&list)[N]) { return list[uniform(0, (int64_t)N - 1)]; }
+
+private:
+    uint64_t m_state;
+};
+
+// --- Text Pool ---
+// dbgen cuts every comment from one pre-generated text at a random offset.
+void appendPhrase(std::string& out, ChunkRng& rng, const std::vector<Weighted>& phrases) {
+    for (const char* p = rng.pick(phrases); *p; ++p) {
+        if (*p == ',') { out += ','; continue; }
+        if (!out.empty() && out.back() != ' ') out += ' ';
+        switch (*p) {
+            case 'N': out += rng.pick(kNouns); break;
+            case 'V': out += rng.pick(kVerbs); break;
+            case 'J': out += rng.pick(kAdjectives); break;
+            case 'D': out += rng.pick(kAdverbs); break;
+            default:  out += rng.pick(kAuxiliaries); break;
+        }
+    }
+}
+
+const std::string& textPool() {
+    static const std::string pool = [] {
+        ChunkRng rng(0x7e47, 0);
+        std::string text;
+        text.reserve(kTextPoolBytes + 256);
+        while (text.size() < kTextPoolBytes) {
+            for (const char* s = rng.pick(kSentences); *s; ++s) {
+                switch (*s) {
+                    case 'N': appendPhrase(text, rng, kNounPhrases); break;
+                    case 'V': appendPhrase(text, rng, kVerbPhrases); break;
+                    case 'P': text += ' '; text += rng.pick(kPrepositions); text += " the"; appendPhrase(text, rng, kNounPhrases); break;
+                    default:  text += rng.pick(kTerminators); text += ' '; break;
+                }
+            }
+        }
+        return text;
+    }();
+    return pool;
+}
+
+// dbgen TEXT(avg): length uniform in [0.4 avg, 1.6 avg], from a random pool offset
+std::string_view comment(ChunkRng& rng, int avg) {
+    const std::string& pool = textPool();
+    const size_t len = (size_t)rng.uniform((int64_t)(avg * 0.4), (int64_t)(avg * 1.6));
+    return std::string_view(pool).substr((size_t)rng.uniform(0, (int64_t)(pool.size() - len)), len);
+}
+
+// dbgen V_STR(avg): random alphanumerics, length uniform in [0.4 avg, 1.6 avg]
+std::string vstring(ChunkRng& rng, int avg) {
+    static const char kAlphabet[] = "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ,";
+    std::string s((size_t)rng.uniform((int64_t)(avg * 0.4), (int64_t)(avg * 1.6)), ' ');
+    for (auto& c : s) c = kAlphabet[rng.uniform(0, sizeof(kAlphabet) - 2)];
+    return s;
+}
+
+std::string phone(ChunkRng& rng, int nationkey) {
+    char buf[24];
+    snprintf(buf, sizeof(buf), "%02d-%03d-%03d-%04d", nationkey + 10, (int)rng.uniform(100, 999), (int)rng.uniform(100, 999),
+             (int)rng.uniform(1000, 9999));
+    return buf;
+}
+
+std::string numbered(const char* prefix, int64_t key) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%s#%09lld", prefix, (long long)key);
+    return buf;
+}
+
+// YYYYMMDD for STARTDATE + d, for every offset an order or lineitem can reach
+int dateAt(int days) {
+    static const std::vector<int> table = [] {
+        std::vector<int> t(kOrderDays + 121 + 30 + 1);
+        for (size_t d = 0; d < t.size(); ++d) t[d] = dateAddDays(kStartDate, (int)d);
+        return t;
+    }();
+    return table[days];
+}
+
+int64_t retailCents(int64_t partkey) { return 90000 + ((partkey / 10) % 20001) + 100 * (partkey % 1000); }
+
+// dbgen PART_SUPP_BRIDGE: the i-th of the four suppliers stocking a part
+int64_t partSupplier(int64_t partkey, int64_t i, int64_t suppliers) {
+    return (partkey + i * (suppliers / 4 + (partkey - 1) / suppliers)) % suppliers + 1;
+}
+
+// Sparse order keys: dbgen uses the first 8 of every 32 keys
+int64_t orderKey(int64_t index) { return ((index >> 3) << 5) + (index & 7) + 1; }
+
+// One chunk of one table, appended column by column.
+class TableChunk {
+public:
+    explicit TableChunk(const std::vector<ColumnDef>& defs) {
+        table.columns.resize(defs.size());
+        for (size_t c = 0; c < defs.size(); ++c) { table.columns[c].kind = defs[c].kind; table.columns[c].width = defs[c].width; }
+    }
+    void putInt(int c, int64_t v) { table.columns[c].data.ints.push_back((int)v); }
+    void putFloat(int c, double v) { table.columns[c].data.floats.push_back((float)v); }
+    void putText(int c, std::string_view s) {
+        RawColumn& col = table.columns[c];
+        const size_t n = std::min(s.size(), (size_t)col.width);
+        col.data.chars.insert(col.data.chars.end(), s.begin(), s.begin() + n);
+        col.data.chars.resize(col.data.chars.size() + (size_t)col.width - n, '\0');
+    }
+
+    MemoryTable table;
+};
+
+struct Cardinalities {
+    int64_t suppliers, parts, customers, orders;
+};
+
+// --- Table Groups ---
+// Tables generated together from one driving row: part drives partsupp, orders drives lineitem.
+struct TableGroup {
+    std::vector<std::pair<const char*, const std::vector<ColumnDef>*>> tables;
+    int64_t rows; // driving rows
+    std::function<void(ChunkRng& rng, int64_t begin, int64_t end, std::vector<TableChunk>& out)> make;
+};
+
+std::vector<TableGroup> tableGroups(const Cardinalities& n) {
+    std::vector<TableGroup> groups;
+    groups.push_back({{{"region", &kRegionColumns}}, 5, [](ChunkRng& rng, int64_t begin, int64_t end, std::vector<TableChunk>& out) {
+        for (int64_t r = begin; r < end; ++r) {
+            out[0].putInt(0, r); out[0].putText(1, kRegions[r]); out[0].putText(2, comment(rng, 72));
+        }
+    }});
+    groups.push_back({{{"nation", &kNationColumns}}, 25, [](ChunkRng& rng, int64_t begin, int64_t end, std::vector<TableChunk>& out) {
+        for (int64_t r = begin; r < end; ++r) {
+            out[0].putInt(0, r); out[0].putText(1, kNations[r].name); out[0].putInt(2, kNations[r].region);
+            out[0].putText(3, comment(rng, 72));
+        }
+    }});
+    groups.push_back({{{"supplier", &kSupplierColumns}}, n.suppliers, [](ChunkRng& rng, int64_t begin, int64_t end, std::vector<TableChunk>& out) {
+        TableChunk& s = out[0];
+        for (int64_t key = begin + 1; key <= end; ++key) {
+            const int nation = (int)rng.uniform(0, 24);
+            s.putInt(0, key); s.putText(1, numbered("Supplier", key)); s.putText(2, vstring(rng, 25)); s.putInt(3, nation);
+            s.putText(4, phone(rng, nation)); s.putFloat(5, rng.uniform(-99999, 999999) / 100.0);
+            // 5 in 10000 suppliers carry "Customer ... Complaints", 5 "Customer ... Recommends"
+            const int64_t bbb = rng.uniform(1, 10000);
+            std::string text(comment(rng, 63));
+            if (bbb <= 10 && text.size() >= 30) text = "Customer " + text.substr(0, text.size() - 20) + (bbb <= 5 ? "Complaints" : "Recommends");
+            s.putText(6, text);
+        }
+    }});
+    groups.push_back({{{"part", &kPartColumns}, {"partsupp", &kPartSuppColumns}}, n.parts,
+                      [n](ChunkRng& rng, int64_t begin, int64_t end, std::vector<TableChunk>& out) {
+        TableChunk &p = out[0], &ps = out[1];
+        for (int64_t key = begin + 1; key <= end; ++key) {
+            int colors[5];
+            std::string name;
+            for (int w = 0; w < 5; ++w) {
+                do { colors[w] = (int)rng.uniform(0, 91); } while (std::find(colors, colors + w, colors[w]) != colors + w);
+                if (w) name += ' ';
+                name += kPartColors[colors[w]];
+            }
+            const int m = (int)rng.uniform(1, 5);
+            p.putInt(0, key); p.putText(1, name); p.putText(2, "Manufacturer#" + std::to_string(m));
+            p.putText(3, "Brand#" + std::to_string(m) + std::to_string(rng.uniform(1, 5)));
+            p.putText(4, std::string(rng.pick(kTypeSize)) + " " + rng.pick(kTypeFinish) + " " + rng.pick(kTypeMaterial));
+            p.putInt(5, rng.uniform(1, 50)); p.putText(6, std::string(rng.pick(kContainerSize)) + " " + rng.pick(kContainerType));
+            p.putFloat(7, retailCents(key) / 100.0); p.putText(8, comment(rng, 14));
+            for (int64_t i = 0; i < 4; ++i) {
+                ps.putInt(0, key); ps.putInt(1, partSupplier(key, i, n.suppliers)); ps.putInt(2, rng.uniform(1, 9999));
+                ps.putFloat(3, rng.uniform(100, 100000) / 100.0); ps.putText(4, comment(rng, 124));
+            }
+        }
+    }});
+    groups.push_back({{{"customer", &kCustomerColumns}}, n.customers, [](ChunkRng& rng, int64_t begin, int64_t end, std::vector<TableChunk>& out) {
+        TableChunk& c = out[0];
+        for (int64_t key = begin + 1; key <= end; ++key) {
+            const int nation = (int)rng.uniform(0, 24);
+            c.putInt(0, key); c.putText(1, numbered("Customer", key)); c.putText(2, vstring(rng, 25)); c.putInt(3, nation);
+            c.putText(4, phone(rng, nation)); c.putFloat(5, rng.uniform(-99999, 999999) / 100.0);
+            c.putText(6, rng.pick(kMarketSegments)); c.putText(7, comment(rng, 73));
+        }
+    }});
+    groups.push_back({{{"orders", &kOrdersColumns}, {"lineitem", &kLineitemColumns}}, n.orders,
+                      [n](ChunkRng& rng, int64_t begin, int64_t end, std::vector<TableChunk>& out) {
+        TableChunk &o = out[0], &l = out[1];
+        const int64_t clerks = std::max<int64_t>(1, n.suppliers / 10); // SF * 1000
+        for (int64_t index = begin; index < end; ++index) {
+            const int64_t orderkey = orderKey(index);
+            int64_t custkey;
+            do { custkey = rng.uniform(1, n.customers); } while (custkey % 3 == 0 && n.customers >= 3);
+            const int orderDay = (int)rng.uniform(0, kOrderDays);
+            const int lines = (int)rng.uniform(1, 7);
+            double totalprice = 0.0;
+            int open = 0;
+            for (int line = 1; line <= lines; ++line) {
+                const int64_t partkey = rng.uniform(1, n.parts);
+                const int64_t quantity = rng.uniform(1, 50);
+                const double extendedprice = quantity * retailCents(partkey) / 100.0;
+                const double discount = rng.uniform(0, 10) / 100.0, tax = rng.uniform(0, 8) / 100.0;
+                const int shipDay = orderDay + (int)rng.uniform(1, 121);
+                const int shipdate = dateAt(shipDay), receiptdate = dateAt(shipDay + (int)rng.uniform(1, 30));
+                const char returnflag = receiptdate <= kCurrentDate ? (rng.uniform(0, 1) ? 'R' : 'A') : 'N';
+                const char linestatus = shipdate > kCurrentDate ? 'O' : 'F';
+                open += linestatus == 'O';
+                totalprice += extendedprice * (1.0 + tax) * (1.0 - discount);
+                l.putInt(0, orderkey); l.putInt(1, partkey); l.putInt(2, partSupplier(partkey, rng.uniform(0, 3), n.suppliers));
+                l.putInt(3, line); l.putFloat(4, (double)quantity); l.putFloat(5, extendedprice); l.putFloat(6, discount);
+                l.putFloat(7, tax); l.putText(8, std::string_view(&returnflag, 1)); l.putText(9, std::string_view(&linestatus, 1));
+                l.putInt(10, shipdate); l.putInt(11, dateAt(orderDay + (int)rng.uniform(30, 90))); l.putInt(12, receiptdate);
+                l.putText(13, rng.pick(kShipInstructions)); l.putText(14, rng.pick(kShipModes)); l.putText(15, comment(rng, 27));
+            }
+            const char status = open == lines ? 'O' : open == 0 ? 'F' : 'P';
+            o.putInt(0, orderkey); o.putInt(1, custkey); o.putText(2, std::string_view(&status, 1));
+            o.putFloat(3, std::round(totalprice * 100.0) / 100.0); o.putInt(4, dateAt(orderDay));
+            o.putText(5, rng.pick(kOrderPriorities)); o.putText(6, numbered("Clerk", rng.uniform(1, clerks)));
+            o.putInt(7, 0); o.putText(8, comment(rng, 49));
+        }
+    }});
+    return groups;
+}
+
+Cardinalities cardinalities(double sf) {
+    auto rows = [sf](double base) { return std::max<int64_t>(1, (int64_t)std::llround(base * sf)); };
+    return {rows(10000), rows(200000), rows(150000), rows(1500000)};
+}
+
+// Receives each table's chunks in order.
+using ChunkSink = std::function<bool(size_t table, const MemoryTable& chunk)>;
+
+// Generates batches of chunks in parallel and hands them to sink in chunk order.
+bool generateGroup(WorkerPool& pool, const TableGroup& group, uint64_t stream, const ChunkSink& sink) {
+    const size_t chunks = (size_t)((group.rows + (int64_t)kChunkRows - 1) / (int64_t)kChunkRows);
+    const size_t batch = (size_t)pool.size() * 2;
+    for (size_t first = 0; first < chunks; first += batch) {
+        const size_t n = std::min(batch, chunks - first);
+        std::vector<std::vector<TableChunk>> out(n);
+        pool.parallelFor(n, 1, [&](size_t begin, size_t end, unsigned) {
+            for (size_t c = begin; c < end; ++c) {
+                const size_t chunk = first + c;
+                for (const auto& t : group.tables) out[c].emplace_back(*t.second);
+                ChunkRng rng(stream, chunk);
+                group.make(rng, (int64_t)(chunk * kChunkRows), std::min(group.rows, (int64_t)((chunk + 1) * kChunkRows)), out[c]);
+            }
+        });
+        for (auto& chunk : out) {
+            for (size_t t = 0; t < chunk.size(); ++t) {
+                if (!sink(t, chunk[t].table)) return false;
+            }
+        }
+    }
+    return true;
+}
+
+template <typename T>
+void appendValues(std::vector<T>& to, const std::vector<T>& from) { to.insert(to.end(), from.begin(), from.end()); }
+
+template <typename T>
+bool writeValues(FILE* out, const std::vector<T>& values) { return fwrite(values.data(), sizeof(T), values.size(), out) == values.size(); }
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+
+GeneratedTables generateTpch(WorkerPool& pool, double scaleFactor) {
+    TraceSpan span("generate", "load");
+    GeneratedTables result;
+    uint64_t stream = 0;
+    for (const auto& group : tableGroups(cardinalities(scaleFactor))) {
+        std::vector<std::shared_ptr<MemoryTable>> tables;
+        for (const auto& t : group.tables) {
+            tables.push_back(std::make_shared<MemoryTable>());
+            tables.back()->columns = TableChunk(*t.second).table.columns;
+        }
+        generateGroup(pool, group, ++stream, [&](size_t t, const MemoryTable& chunk) {
+            for (size_t c = 0; c < chunk.columns.size(); ++c) {
+                ColumnData& to = tables[t]->columns[c].data;
+                appendValues(to.ints, chunk.columns[c].data.ints);
+                appendValues(to.floats, chunk.columns[c].data.floats);
+                appendValues(to.chars, chunk.columns[c].data.chars);
+            }
+            return true;
+        });
+        for (size_t t = 0; t < tables.size(); ++t) result.tables[group.tables[t].first] = tables[t];
+    }
+    return result;
+}
+
+bool writeTpch(WorkerPool& pool, double scaleFactor, const std::string& directory) {
+    TraceSpan span("generate", "load");
+    const auto start = std::chrono::steady_clock::now();
+    uint64_t stream = 0, totalBytes = 0;
+    for (const auto& group : tableGroups(cardinalities(scaleFactor))) {
+        const auto groupStart = std::chrono::steady_clock::now();
+        std::vector<std::vector<FILE*>> files(group.tables.size());
+        std::vector<uint64_t> rows(group.tables.size(), 0);
+        bool ok = true;
+        for (size_t t = 0; t < group.tables.size() && ok; ++t) {
+            const std::string tbl = directory + group.tables[t].first + ".tbl";
+            for (size_t c = 0; c < group.tables[t].second->size() && ok; ++c) {
+                const ColumnDef& def = (*group.tables[t].second)[c];
+                FILE* f = fopen(binaryColumnPath(tbl, (int)c).c_str(), "wb");
+                if (!f) { std::cerr << "Error: cannot create " << binaryColumnPath(tbl, (int)c) << std::endl; ok = false; break; }
+                setvbuf(f, nullptr, _IOFBF, 1 << 20);
+                files[t].push_back(f);
+                ok = writeBinaryColumnHeader(f, def.kind, def.width);
+            }
+        }
+        if (ok) {
+            ok = generateGroup(pool, group, ++stream, [&](size_t t, const MemoryTable& chunk) {
+                rows[t] += chunk.columns[0].data.ints.size();
+                for (size_t c = 0; c < chunk.columns.size(); ++c) {
+                    const ColumnData& d = chunk.columns[c].data;
+                    totalBytes += d.ints.size() * sizeof(int) + d.floats.size() * sizeof(float) + d.chars.size();
+                    if (!writeValues(files[t][c], d.ints) || !writeValues(files[t][c], d.floats) || !writeValues(files[t][c], d.chars)) return false;
+                }
+                return true;
+            });
+        }
+        for (auto& table : files) {
+            for (FILE* f : table) ok = fclose(f) == 0 && ok;
+        }
+        if (!ok) {
+            std::cerr << "Error: writing " << group.tables[0].first << " to " << directory << " failed" << std::endl;
+            return false;
+        }
+        for (size_t t = 0; t < group.tables.size(); ++t) {
+            printf("  %-9s %12llu rows", group.tables[t].first, (unsigned long long)rows[t]);
+            if (t + 1 == group.tables.size()) printf("  %8.2f s", secondsSince(groupStart));
+            printf("\n");
+        }
+    }
+    const double seconds = secondsSince(start);
+    printf("Wrote %.1f MB of binary columns in %.2f s (%.1f MB/s)\n", totalBytes / 1e6, seconds, totalBytes / 1e6 / seconds);
+    return true;
+}
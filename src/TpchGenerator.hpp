@@ -0,0 +1,37 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+
+#include "ColumnCatalog.hpp"
+
+class WorkerPool;
+
+// --- TPC-H Data Generator ---
+// In-tree replacement for dbgen + .tbl parsing. Follows the dbgen rules for
+// every column of the eight tables: cardinalities per scale factor, sparse
+// order keys, customers skipping every third key, the partsupp supplier
+// bridge, retail-price based extended prices, date offsets and the
+// 1995-06-17 status cut-off, and comments cut from a text pool built with
+// dbgen's grammar and weighted word lists. Rows are produced in fixed-size
+// chunks, each with its own seed, so output is identical for any thread
+// count (though not byte-identical to dbgen). Columns are written as binary
+// column files or kept in memory, never as text.
+
+// dbgen dates and value lists shared with the refresh functions.
+constexpr int kStartDate = 19920101;
+constexpr int kCurrentDate = 19950617; // dbgen CURRENTDATE: status and return-flag cut-off
+constexpr int kOrderDays = 2405;       // STARTDATE .. ENDDATE - 151 days
+extern const char* const kOrderPriorities[5];
+extern const char* const kShipInstructions[4];
+extern const char* const kShipModes[7];
+
+struct GeneratedTables {
+    std::map<std::string, std::shared_ptr<const MemoryTable>> tables;
+};
+
+// Generates every table into memory (attach with ColumnCatalog::attachMemoryTable).
+GeneratedTables generateTpch(WorkerPool& pool, double scaleFactor);
+// Streams every table to <directory>/<table>.<column>.col; false (with a message) on I/O errors.
+bool writeTpch(WorkerPool& pool, double scaleFactor, const std::string& directory);
@@ -0,0 +1,146 @@
+#include "TpchParams.hpp"
+
+#include <cstdio>
+
+namespace {
+
+constexpr int64_t kModulus = 2147483647; // 2^31 - 1
+constexpr int64_t kMultiplier = 16807;
+
+enum ParamStream { kStreamQ1 = 0, kStreamQ3, kStreamQ6, kStreamQ9, kStreamQ13 };
+
+const char* const kQ13Word1[] = {"special", "pending", "unusual", "express"};
+const char* const kQ13Word2[] = {"packages", "requests", "accounts", "deposits"};
+
+// Days since 1970-01-01 for a proleptic Gregorian date (H. Hinnant's days_from_civil).
+int64_t daysFromCivil(int y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    const int64_t era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = (unsigned)(y - era * 400);
+    const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (int64_t)doe - 719468;
+}
+
+void civilFromDays(int64_t z, int& y, unsigned& m, unsigned& d) {
+    z += 719468;
+    const int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    const unsigned doe = (unsigned)(z - era * 146097);
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp = (5 * doy + 2) / 153;
+    d = doy - (153 * mp + 2) / 5 + 1;
+    m = mp < 10 ? mp + 3 : mp - 9;
+    y = (int)(yoe + era * 400) + (m <= 2);
+}
+
+} // namespace
+
+const char* const kMarketSegments[5] = {"AUTOMOBILE", "BUILDING", "FURNITURE", "MACHINERY", "HOUSEHOLD"};
+
+// p_name colors from dbgen's dists.dss ("colors" distribution).
+const char* const kPartColors[92] = {
+    "almond", "antique", "aquamarine", "azure", "beige", "bisque", "black", "blanched", "blue",
+    "blush", "brown", "burlywood", "burnished", "chartreuse", "chiffon", "chocolate", "coral",
+    "cornflower", "cornsilk", "cream", "cyan", "dark", "deep", "dim", "dodger", "drab", "firebrick",
+    "floral", "forest", "frosted", "gainsboro", "ghost", "goldenrod", "green", "grey", "honeydew",
+    "hot", "indian", "ivory", "khaki", "lace", "lavender", "lawn", "lemon", "light", "lime", "linen",
+    "magenta", "maroon", "medium", "metallic", "midnight", "mint", "misty", "moccasin", "navajo",
+    "navy", "olive", "orange", "orchid", "pale", "papaya", "peach", "peru", "pink", "plum", "powder",
+    "puff", "purple", "red", "rose", "rosy", "royal", "saddle", "salmon", "sandy", "seashell",
+    "sienna", "sky", "slate", "smoke", "snow", "spring", "steel", "tan", "thistle", "tomato",
+    "turquoise", "violet", "wheat", "white", "yellow"};
+static_assert(sizeof(kPartColors) / sizeof(kPartColors[0]) == 92, "TPC-H defines 92 p_name colors");
+
+int dateAddDays(int yyyymmdd, int days) {
+    int64_t z = daysFromCivil(yyyymmdd / 10000, (unsigned)(yyyymmdd / 100 % 100), (unsigned)(yyyymmdd % 100)) + days;
+    int y; unsigned m, d;
+    civilFromDays(z, y, m, d);
+    return y * 10000 + (int)m * 100 + (int)d;
+}
+
+std::string formatDate(int yyyymmdd) {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%04d-%02d-%02d", yyyymmdd / 10000, yyyymmdd / 100 % 100, yyyymmdd % 100);
+    return buf;
+}
+
+int Q1Params::cutoffDate() const { return dateAddDays(19981201, -delta); }
+
+QgenParameterGenerator::QgenParameterGenerator(uint64_t seed) {
+    for (int s = 0; s < 5; ++s) {
+        int64_t v = (int64_t)((seed + (uint64_t)s * 1000003ull) % (uint64_t)kModulus);
+        m_streams[s] = v == 0 ? 1 : v;
+    }
+}
+
+// dbgen's UnifInt: scale the next Park-Miller draw into [low, high].
+int64_t QgenParameterGenerator::unifInt(int stream, int64_t low, int64_t high) {
+    int64_t& seed = m_streams[stream];
+    seed = (seed * kMultiplier) % kModulus;
+    const double range = (double)(high - low + 1);
+    int64_t v = low + (int64_t)(((double)seed / (double)kModulus) * range);
+    return v > high ? high : v;
+}
+
+Q1Params QgenParameterGenerator::nextQ1() {
+    Q1Params p;
+    p.delta = (int)unifInt(kStreamQ1, 60, 120);
+    return p;
+}
+
+Q3Params QgenParameterGenerator::nextQ3() {
+    Q3Params p;
+    p.segment = kMarketSegments[unifInt(kStreamQ3, 0, 4)];
+    p.date = dateAddDays(19950301, (int)unifInt(kStreamQ3, 0, 30));
+    return p;
+}
+
+Q6Params QgenParameterGenerator::nextQ6() {
+    Q6Params p;
+    p.date = (int)unifInt(kStreamQ6, 1993, 1997) * 10000 + 101;
+    p.discountPct = (int)unifInt(kStreamQ6, 2, 9);
+    p.quantity = (int)unifInt(kStreamQ6, 24, 25);
+    return p;
+}
+
+Q9Params QgenParameterGenerator::nextQ9() {
+    Q9Params p;
+    p.color = kPartColors[unifInt(kStreamQ9, 0, 91)];
+    return p;
+}
+
+Q13Params QgenParameterGenerator::nextQ13() {
+    Q13Params p;
+    p.word1 = kQ13Word1[unifInt(kStreamQ13, 0, 3)];
+    p.word2 = kQ13Word2[unifInt(kStreamQ13, 0, 3)];
+    return p;
+}
+
+TpchParams QgenParameterGenerator::next() {
+    TpchParams p;
+    p.q1 = nextQ1();
+    p.q3 = nextQ3();
+    p.q6 = nextQ6();
+    p.q9 = nextQ9();
+    p.q13 = nextQ13();
+    return p;
+}
+
+std::string describe(const Q1Params& p) {
+    return "DELTA=" + std::to_string(p.delta) + " (l_shipdate <= " + formatDate(p.cutoffDate()) + ")";
+}
+
+std::string describe(const Q3Params& p) {
+    return "SEGMENT=" + p.segment + " DATE=" + formatDate(p.date);
+}
+
+std::string describe(const Q6Params& p) {
+    char buf[96];
+    snprintf(buf, sizeof(buf), "DATE=%s DISCOUNT=0.%02d QUANTITY=%d", formatDate(p.date).c_str(), p.discountPct, p.quantity);
+    return buf;
+}
+
+std::string describe(const Q9Params& p) { return "COLOR=" + p.color; }
+
+std::string describe(const Q13Params& p) { return "WORD1=" + p.word1 + " WORD2=" + p.word2; }
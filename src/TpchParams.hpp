@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// --- TPC-H Substitution Parameters ---
+// Each query entry point takes its parameters from these structs instead of
+// hard-coded constants. Defaults are the TPC-H validation values (spec 2.4.x),
+// so a run without --seed reproduces the historical results exactly.
+
+struct Q1Params {
+    int delta = 90;                // DELTA in [60, 120] days
+    int cutoffDate() const;        // DATE '1998-12-01' - INTERVAL DELTA DAY, as YYYYMMDD
+};
+
+struct Q3Params {
+    std::string segment = "BUILDING"; // one of the 5 c_mktsegment values
+    int date = 19950315;              // random day in [1995-03-01, 1995-03-31]
+    // c_mktsegment is loaded as its first character; the 5 segments have distinct initials.
+    char segmentPrefix() const { return segment.empty() ? '\0' : segment[0]; }
+};
+
+struct Q6Params {
+    int date = 19940101;    // January 1st of a year in [1993, 1997]
+    int discountPct = 6;    // DISCOUNT in [0.02, 0.09], kept in hundredths to avoid float drift
+    int quantity = 24;      // QUANTITY in [24, 25]
+    int endDate() const { return date + 10000; } // DATE + INTERVAL '1' YEAR
+    float minDiscount() const { return (discountPct - 1) / 100.0f; }
+    float maxDiscount() const { return (discountPct + 1) / 100.0f; }
+};
+
+struct Q9Params {
+    std::string color = "green"; // one of the 92 p_name colors
+};
+
+struct Q13Params {
+    std::string word1 = "special";  // one of: special, pending, unusual, express
+    std::string word2 = "requests"; // one of: packages, requests, accounts, deposits
+};
+
+struct TpchParams {
+    Q1Params q1;
+    Q3Params q3;
+    Q6Params q6;
+    Q9Params q9;
+    Q13Params q13;
+};
+
+// dbgen value lists shared by qgen and the data generator.
+extern const char* const kMarketSegments[5]; // c_mktsegment
+extern const char* const kPartColors[92];    // p_name words
+
+// Seeded generator following qgen's substitution rules. Uses the same
+// Park-Miller minimal standard generator as dbgen/qgen (seed * 16807 mod 2^31-1),
+// with an independent stream per query so adding a query does not shift the others.
+class QgenParameterGenerator {
+public:
+    explicit QgenParameterGenerator(uint64_t seed);
+
+    Q1Params nextQ1();
+    Q3Params nextQ3();
+    Q6Params nextQ6();
+    Q9Params nextQ9();
+    Q13Params nextQ13();
+    TpchParams next();
+
+private:
+    int64_t unifInt(int stream, int64_t low, int64_t high);
+    int64_t m_streams[5];
+};
+
+// Date helpers on YYYYMMDD integers (the encoding used by loadDateColumn).
+int dateAddDays(int yyyymmdd, int days);
+std::string formatDate(int yyyymmdd);
+
+// Human-readable one-liners for logging which parameters a run used.
+std::string describe(const Q1Params& p);
+std::string describe(const Q3Params& p);
+std::string describe(const Q6Params& p);
+std::string describe(const Q9Params& p);
+std::string describe(const Q13Params& p);
@@ -0,0 +1,136 @@
+#include "Trace.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+std::atomic<bool> g_traceEnabled{false};
+
+namespace {
+
+struct TraceEvent {
+    const char* name;
+    const char* category;
+    int64_t startUs;
+    int64_t durationUs;
+    std::string args; // pre-rendered "key":"value" pairs
+};
+
+// One per thread that recorded a span; kept until the trace is written.
+struct ThreadTrace {
+    int tid = 0;
+    std::string name;
+    std::mutex mutex; // uncontended except against finishTrace()
+    std::vector<TraceEvent> events;
+};
+
+std::mutex g_threadsMutex;
+std::vector<std::unique_ptr<ThreadTrace>> g_threads;
+std::string g_tracePath;
+std::chrono::steady_clock::time_point g_traceStart;
+
+thread_local ThreadTrace* t_thread = nullptr;
+thread_local std::string t_threadName;
+thread_local const char* t_currentSpan = nullptr;
+
+int64_t nowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - g_traceStart).count();
+}
+
+ThreadTrace& threadTrace() {
+    if (!t_thread) {
+        std::lock_guard<std::mutex> lock(g_threadsMutex);
+        g_threads.push_back(std::make_unique<ThreadTrace>());
+        t_thread = g_threads.back().get();
+        t_thread->tid = (int)g_threads.size();
+        t_thread->name = t_threadName.empty() ? "thread " + std::to_string(t_thread->tid) : t_threadName;
+    }
+    return *t_thread;
+}
+
+std::string jsonEscape(const std::string& s) {
+    std::string out;
+    for (char c : s) {
+        if (c == '"' || c == '\\') { out += '\\'; out += c; }
+        else if ((unsigned char)c < 0x20) out += ' ';
+        else out += c;
+    }
+    return out;
+}
+
+} // namespace
+
+
+bool startTrace(const std::string& path) {
+    FILE* probe = fopen(path.c_str(), "w");
+    if (!probe) return false;
+    fclose(probe);
+    g_tracePath = path;
+    g_traceStart = std::chrono::steady_clock::now();
+    g_traceEnabled.store(true, std::memory_order_relaxed);
+    return true;
+}
+
+void finishTrace() {
+    if (!traceEnabled()) return;
+    g_traceEnabled.store(false, std::memory_order_relaxed);
+    FILE* out = fopen(g_tracePath.c_str(), "w");
+    if (!out) return;
+
+    std::lock_guard<std::mutex> lock(g_threadsMutex);
+    fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", out);
+    bool first = true;
+    for (const auto& t : g_threads) {
+        std::lock_guard<std::mutex> threadLock(t->mutex);
+        fprintf(out, "%s{\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"name\":\"thread_name\",\"args\":{\"name\":\"%s\"}}",
+                first ? "" : ",\n", t->tid, jsonEscape(t->name).c_str());
+        first = false;
+        for (const auto& e : t->events) {
+            fprintf(out, ",\n{\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"name\":\"%s\",\"cat\":\"%s\",\"ts\":%lld,\"dur\":%lld,\"args\":{%s}}",
+                    t->tid, e.name, e.category, (long long)e.startUs, (long long)e.durationUs, e.args.c_str());
+        }
+    }
+    fputs("\n]}\n", out);
+    fclose(out);
+}
+
+void setTraceThreadName(const std::string& name) {
+    t_threadName = name;
+    if (t_thread) {
+        std::lock_guard<std::mutex> lock(t_thread->mutex);
+        t_thread->name = name;
+    }
+}
+
+const char* currentTraceSpan() { return t_currentSpan; }
+
+
+// --- Trace Span ---
+void TraceSpan::begin(const char* name, const char* category) {
+    m_name = name;
+    m_category = category;
+    m_parent = t_currentSpan;
+    t_currentSpan = name;
+    m_startUs = nowUs();
+}
+
+void TraceSpan::arg(const char* key, const std::string& value) {
+    if (!m_name) return;
+    if (!m_args.empty()) m_args += ',';
+    m_args += '"';
+    m_args += jsonEscape(key);
+    m_args += "\":\"";
+    m_args += jsonEscape(value);
+    m_args += '"';
+}
+
+void TraceSpan::end() {
+    const int64_t endUs = nowUs();
+    t_currentSpan = m_parent;
+    ThreadTrace& t = threadTrace();
+    std::lock_guard<std::mutex> lock(t.mutex);
+    t.events.push_back({m_name, m_category, m_startUs, endUs - m_startUs, std::move(m_args)});
+    m_name = nullptr;
+}
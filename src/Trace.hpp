@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// --- Execution Trace ---
+// Scoped spans around load, build, probe, merge and post-processing, recorded
+// per thread (worker morsels included) and written as Chrome trace events for
+// chrome://tracing or ui.perfetto.dev. While tracing is off a span costs one
+// relaxed atomic load; names and categories must be string literals.
+
+extern std::atomic<bool> g_traceEnabled;
+
+inline bool traceEnabled() { return g_traceEnabled.load(std::memory_order_relaxed); }
+
+// Starts recording; the file is written by finishTrace(). False if path cannot be created.
+bool startTrace(const std::string& path);
+// Writes every recorded span and stops recording.
+void finishTrace();
+
+// Label of the calling thread's track ("main", "worker 3", "stream 1").
+void setTraceThreadName(const std::string& name);
+// Name of the innermost open span on the calling thread, or nullptr.
+const char* currentTraceSpan();
+
+class TraceSpan {
+public:
+    explicit TraceSpan(const char* name, const char* category = "query") {
+        if (name && traceEnabled()) begin(name, category);
+    }
+    ~TraceSpan() { close(); }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+    bool active() const { return m_name != nullptr; }
+    // Ends the span before scope exit (sequential phases in one scope); spans must close innermost first.
+    void close() {
+        if (m_name) end();
+    }
+    // Attaches a string argument; build the value only when active().
+    void arg(const char* key, const std::string& value);
+
+private:
+    void begin(const char* name, const char* category);
+    void end();
+
+    const char* m_name = nullptr;
+    const char* m_category = nullptr;
+    const char* m_parent = nullptr;
+    int64_t m_startUs = 0;
+    std::string m_args;
+};
@@ -0,0 +1,125 @@
+#include "WorkerPool.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+
+#include "Numa.hpp"
+#include "PerfCounters.hpp"
+#include "Trace.hpp"
+
+WorkerPool::WorkerPool(unsigned numThreads) {
+    if (numThreads == 0) numThreads = std::max(1u, std::thread::hardware_concurrency());
+
+    // Pinned workers go round-robin over the nodes that have CPUs
+    const NumaTopology& topology = numaTopology();
+    std::vector<unsigned> nodes;
+    size_t cpus = 0;
+    for (unsigned n = 0; n < topology.nodes(); ++n) {
+        if (!topology.nodeCpus[n].empty()) nodes.push_back(n);
+        cpus += topology.nodeCpus[n].size();
+    }
+    m_workerNode.assign(numThreads, -1);
+    m_workersPerNode.assign(topology.nodes(), 0);
+    if (numaPinned()) {
+        for (unsigned w = 0; w < numThreads; ++w) {
+            m_workerNode[w] = (int)nodes[w % nodes.size()];
+            m_workersPerNode[m_workerNode[w]] += 1;
+        }
+    } else {
+        for (unsigned n : nodes) m_workersPerNode[n] = std::max(1u, (unsigned)(numThreads * topology.nodeCpus[n].size() / cpus));
+    }
+
+    m_threads.reserve(numThreads);
+    for (unsigned w = 0; w < numThreads; ++w) {
+        m_threads.emplace_back([this, w] { workerLoop(w); });
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_cv.notify_all();
+    for (auto& t : m_threads) t.join();
+}
+
+void WorkerPool::parallelFor(size_t n, size_t morselSize, const MorselFn& fn) {
+    if (n == 0) return;
+    auto job = std::make_shared<Job>();
+    job->n = n;
+    job->morsel = std::max<size_t>(1, morselSize);
+    job->fn = &fn;
+    // Range boundaries on morsel multiples, so morsels never straddle two nodes' rows
+    const unsigned parts = numaParts();
+    for (unsigned p = 0; p < parts; ++p) {
+        const size_t begin = numaRangeBegin(n, p, parts) / job->morsel * job->morsel;
+        const size_t end = p + 1 == parts ? n : numaRangeBegin(n, p + 1, parts) / job->morsel * job->morsel;
+        job->parts.push_back({begin, end});
+    }
+    if (traceEnabled()) job->traceLabel = currentTraceSpan() ? currentTraceSpan() : "morsel";
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_jobs.push_back(job);
+    }
+    m_cv.notify_all();
+
+    std::unique_lock<std::mutex> lock(job->doneMutex);
+    job->doneCv.wait(lock, [&] { return job->done; });
+}
+
+void WorkerPool::workerLoop(unsigned worker) {
+    setTraceThreadName("worker " + std::to_string(worker));
+    if (m_workerNode[worker] >= 0) {
+        // The k-th worker of a node takes the node's k-th CPU
+        unsigned rank = 0;
+        for (unsigned w = 0; w < worker; ++w) rank += m_workerNode[w] == m_workerNode[worker];
+        const auto& cpus = numaTopology().nodeCpus[m_workerNode[worker]];
+        pinCurrentThread(cpus[rank % cpus.size()]);
+    }
+    attachPerfCounters();
+    const bool track = numaReportEnabled();
+    for (;;) {
+        std::shared_ptr<Job> job;
+        size_t begin = 0, end = 0;
+        unsigned part = 0;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [&] { return m_stop || !m_jobs.empty(); });
+            if (m_jobs.empty()) return; // only reached when stopping
+
+            // Claim one morsel from the front job, then rotate it to the back (round-robin).
+            // The worker's own node range goes first; the others are stolen from in order.
+            job = m_jobs.front();
+            m_jobs.pop_front();
+            const unsigned home = m_workerNode[worker] >= 0 ? (unsigned)m_workerNode[worker] : 0;
+            part = home < job->parts.size() && job->parts[home].next < job->parts[home].end ? home : 0;
+            while (job->parts[part].next == job->parts[part].end) ++part;
+            Range& range = job->parts[part];
+            begin = range.next;
+            end = std::min(range.end, begin + job->morsel);
+            range.next = end;
+            bool remaining = false;
+            for (const Range& r : job->parts) remaining |= r.next < r.end;
+            if (remaining) m_jobs.push_back(job);
+        }
+
+        {
+            TraceSpan span(job->traceLabel, "morsel");
+            const auto start = track ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
+            (*job->fn)(begin, end, worker);
+            if (track) {
+                const unsigned node = m_workerNode[worker] >= 0 ? (unsigned)m_workerNode[worker] : currentNode();
+                recordNumaMorsel(part, node, end - begin,
+                                 (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+            }
+        }
+
+        if (job->completed.fetch_add(end - begin) + (end - begin) == job->n) {
+            std::lock_guard<std::mutex> lock(job->doneMutex);
+            job->done = true;
+            job->doneCv.notify_all();
+        }
+    }
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// --- Morsel-Driven Worker Pool ---
+// A fixed set of worker threads shared by every query on the CPU backend,
+// including concurrent query streams. parallelFor() splits [0, n) into morsels
+// and blocks until all of them ran. Workers take one morsel at a time and rotate
+// between active jobs, so concurrent streams share the cores fairly instead of
+// one query monopolising the pool. Under the NUMA `partition` policy (Numa.hpp)
+// workers are pinned round-robin over the nodes and every job is split into one
+// row range per node; a worker claims morsels from its node's range first.
+class WorkerPool {
+public:
+    // fn(begin, end, worker): worker is in [0, size()) and stable for the call,
+    // so queries can keep per-worker local state without synchronisation.
+    using MorselFn = std::function<void(size_t begin, size_t end, unsigned worker)>;
+
+    explicit WorkerPool(unsigned numThreads = 0); // 0 = std::thread::hardware_concurrency()
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    unsigned size() const { return (unsigned)m_threads.size(); }
+    // Workers per NUMA node: pinned placement, or the pool spread by CPU count.
+    const std::vector<unsigned>& workersPerNode() const { return m_workersPerNode; }
+
+    void parallelFor(size_t n, size_t morselSize, const MorselFn& fn);
+
+    static constexpr size_t kDefaultMorsel = 64 * 1024;
+
+private:
+    struct Range {
+        size_t next = 0;
+        size_t end = 0;
+    };
+
+    struct Job {
+        size_t n = 0;
+        size_t morsel = 0;
+        const MorselFn* fn = nullptr;
+        const char* traceLabel = nullptr; // caller's open span, repeated on each morsel while tracing
+        std::vector<Range> parts;        // one per NUMA node under partitioning; guarded by the pool mutex
+        std::atomic<size_t> completed{0};
+        std::mutex doneMutex;
+        std::condition_variable doneCv;
+        bool done = false;
+    };
+
+    void workerLoop(unsigned worker);
+
+    std::vector<std::thread> m_threads;
+    std::vector<int> m_workerNode; // pinned node, -1 = floating
+    std::vector<unsigned> m_workersPerNode;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::deque<std::shared_ptr<Job>> m_jobs;
+    bool m_stop = false;
+};
@@ -2,134 +2,126 @@
 #define CA_PRIVATE_IMPLEMENTATION
 #define MTL_PRIVATE_IMPLEMENTATION
 
+#ifndef GPUDB_CPU_ONLY
 #include "Metal/Metal.hpp"
 #include "Foundation/Foundation.hpp"
+#endif
 #include <iostream>
 #include <fstream>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <map>
 #include <algorithm>
 #include <chrono>
 #include <iomanip>
 #include <cmath>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <limits>
+#include <stdexcept>
+#include <filesystem>
+#include <cstdlib>
+
+#include "AsyncReader.hpp"
+#include "AutoTuner.hpp"
+#include "BenchConfig.hpp"
+#include "ColumnCatalog.hpp"
+#include "CpuQueries.hpp"
+#include "HugePages.hpp"
+#include "IncrementalAggregates.hpp"
+#include "Numa.hpp"
+#include "PerfCounters.hpp"
+#include "RefreshFunctions.hpp"
+#include "Roofline.hpp"
+#include "ScalingSweep.hpp"
+#include "Spill.hpp"
+#include "SyntheticWorkloads.hpp"
+#include "ThroughputTest.hpp"
+#include "TpchGenerator.hpp"
+#include "TpchParams.hpp"
+#include "Trace.hpp"
+#include "WorkerPool.hpp"
 
 // Global dataset configuration
 std::string g_dataset_path = "data/SF-1/"; // Default to SF-10
+HarnessConfig g_harness;
+ResultLog g_results;
 
-// --- Helper to Load Integer Column ---
-std::vector<int> loadIntColumn(const std::string& filePath, int columnIndex) {
-    std::vector<int> data;
-    std::ifstream file(filePath);
-    if (!file.is_open()) { std::cerr << "Error: Could not open file " << filePath << std::endl; return data; }
-    std::string line;
-    while (std::getline(file, line)) {
-        std::string token; int currentCol = 0; size_t start = 0; size_t end = line.find('|');
-        while (end != std::string::npos) {
-            if (currentCol == columnIndex) { token = line.substr(start, end - start); data.push_back(std::stoi(token)); break; }
-            start = end + 1; end = line.find('|', start); currentCol++;
-        }
-    }
-    return data;
-}
-
-// --- Helper to Load Float Column ---
-std::vector<float> loadFloatColumn(const std::string& filePath, int columnIndex) {
-    std::vector<float> data;
-    std::ifstream file(filePath);
-    if (!file.is_open()) { std::cerr << "Error: Could not open file " << filePath << std::endl; return data; }
-    std::string line;
-    while (std::getline(file, line)) {
-        std::string token; int currentCol = 0; size_t start = 0; size_t end = line.find('|');
-        while (end != std::string::npos) {
-            if (currentCol == columnIndex) { token = line.substr(start, end - start); data.push_back(std::stof(token)); break; }
-            start = end + 1; end = line.find('|', start); currentCol++;
-        }
-    }
-    return data;
+double datasetScaleFactor() {
+    size_t pos = g_dataset_path.find("SF-");
+    if (pos == std::string::npos) return 1.0;
+    try { return std::stod(g_dataset_path.substr(pos + 3)); } catch (...) { return 1.0; }
 }
 
-// Helper to Load char columns
-std::vector<char> loadCharColumn(const std::string& filePath, int columnIndex, int fixed_width = 0) {
-    std::vector<char> data; std::ifstream file(filePath); if (!file.is_open()) {
-        std::cerr << "Error: Could not open file " << filePath << std::endl; return data;
-    }
-    std::string line; while (std::getline(file, line)) { std::string token; int currentCol = 0; size_t start = 0; size_t end = line.find('|');
-        while (end != std::string::npos) { if (currentCol == columnIndex) { token = line.substr(start, end - start);
-            if (fixed_width > 0) { for(int i=0; i < fixed_width; ++i) data.push_back(i < token.length() ? token[i] : '\0'); }
-            else { data.push_back(token[0]);
-            }
-            break;
-        }
-            start = end + 1; end = line.find('|', start); currentCol++;
-        }
-    }
-    return data;
-}
+#ifndef GPUDB_CPU_ONLY
+
+// --- Selection Benchmark ---
+// Output modes of `l_partkey < filterValue`, swept over selectivity:
+//   flags        4-byte 0/1 per row (selection_kernel), the original output
+//   bitmap       1 bit per row from a simdgroup ballot
+//   row ids      ordered row-id list: block counts, block-offset scan, compaction
+//   materialize  the same compaction writing l_extendedprice of matching rows
+const char* const kSelectionModes[4] = {"flags", "bitmap", "row ids", "materialize"};
+const uint32_t kSelectionBlock = 256; // rows per compaction block (one threadgroup)
+
+struct SelectionPoint {
+    double target;     // requested selectivity, percent
+    uint32_t matches;
+    double ms[4];      // median GPU time per mode
+};
 
-// Helper to Load date columns (as integers for simplicity, e.g., 19980315)
-std::vector<int> loadDateColumn(const std::string& filePath, int columnIndex) {
-    std::vector<int> data;
-    std::ifstream file(filePath);
-    if (!file.is_open()) { std::cerr << "Error: Could not open file " << filePath << std::endl; return data; }
-    std::string line;
-    while (std::getline(file, line)) {
-        std::string token; int currentCol = 0; size_t start = 0; size_t end = line.find('|');
-        while (end != std::string::npos) {
-            if (currentCol == columnIndex) {
-                token = line.substr(start, end - start);
-                token.erase(std::remove(token.begin(), token.end(), '-'), token.end());
-                data.push_back(std::stoi(token));
-                break;
-            }
-            start = end + 1; end = line.find('|', start); currentCol++;
+MTL::ComputePipelineState* makeComputePipeline(MTL::Device* device, MTL::Library* library, const char* name) {
+    NS::Error* error = nullptr;
+    NS::String* functionName = NS::String::string(name, NS::UTF8StringEncoding);
+    MTL::Function* function = library->newFunction(functionName);
+    MTL::ComputePipelineState* pipeline = function ? device->newComputePipelineState(function, &error) : nullptr;
+    if (!pipeline) {
+        std::cerr << "Failed to create " << name << " pipeline state" << std::endl;
+        if (error) {
+            std::cerr << "Error: " << error->localizedDescription()->utf8String() << std::endl;
         }
     }
-    return data;
+    if (function) function->release();
+    functionName->release();
+    return pipeline;
 }
 
-
-// --- Selection Benchmark Test Function ---
-void runSingleSelectionTest(MTL::Device* device, MTL::CommandQueue* commandQueue, MTL::ComputePipelineState* pipelineState,
-                            MTL::Buffer* inBuffer, MTL::Buffer* resultBuffer,
-                            const std::vector<int>& cpuData, int filterValue) {
-    
-    double gpuExecutionTime = 0.0;
-    for(int iter = 0; iter < 3; ++iter) {
+// Median GPU time of one command buffer holding whatever encode records
+double timeSelectionMode(MTL::CommandQueue* commandQueue, const std::function<void(MTL::ComputeCommandEncoder*)>& encode) {
+    BenchLoop loop;
+    while (loop.next()) {
         MTL::CommandBuffer* commandBuffer = commandQueue->commandBuffer();
-        MTL::ComputeCommandEncoder* commandEncoder = commandBuffer->computeCommandEncoder();
-        commandEncoder->setComputePipelineState(pipelineState);
-        commandEncoder->setBuffer(inBuffer, 0, 0);
-        commandEncoder->setBuffer(resultBuffer, 0, 1);
-        commandEncoder->setBytes(&filterValue, sizeof(filterValue), 2);
-        
-        MTL::Size gridSize = MTL::Size::Make(cpuData.size(), 1, 1);
-        NS::UInteger threadGroupSize = pipelineState->maxTotalThreadsPerThreadgroup();
-        if (threadGroupSize > cpuData.size()) { threadGroupSize = cpuData.size(); }
-        MTL::Size threadgroupSize = MTL::Size::Make(threadGroupSize, 1, 1);
-        commandEncoder->dispatchThreads(gridSize, threadgroupSize);
-        commandEncoder->endEncoding();
-        
+        MTL::ComputeCommandEncoder* encoder = commandBuffer->computeCommandEncoder();
+        encode(encoder);
+        encoder->endEncoding();
         commandBuffer->commit();
         commandBuffer->waitUntilCompleted();
+        loop.record((commandBuffer->GPUEndTime() - commandBuffer->GPUStartTime()) * 1000.0);
+    }
+    return loop.stats().median;
+}
 
-        if (iter == 2) {
-            gpuExecutionTime = commandBuffer->GPUEndTime() - commandBuffer->GPUStartTime();
+// Selectivities (log-interpolated between sweep points) where two modes swap places
+void printSelectionCrossovers(const std::vector<SelectionPoint>& points) {
+    std::cout << "Crossover points:" << std::endl;
+    bool any = false;
+    for (int a = 0; a < 4; ++a) {
+        for (int b = a + 1; b < 4; ++b) {
+            for (size_t p = 0; p + 1 < points.size(); ++p) {
+                const double d0 = points[p].ms[a] - points[p].ms[b];
+                const double d1 = points[p + 1].ms[a] - points[p + 1].ms[b];
+                if (d0 == 0.0 || d0 * d1 >= 0.0) continue;
+                const double x0 = std::log10(points[p].target), x1 = std::log10(points[p + 1].target);
+                const double at = std::pow(10.0, x0 + (x1 - x0) * d0 / (d0 - d1));
+                printf("  %-11s vs %-11s ~%.3g%% (%s faster below)\n", kSelectionModes[a], kSelectionModes[b], at,
+                       kSelectionModes[d0 > 0.0 ? b : a]);
+                any = true;
+            }
         }
     }
-    double dataSizeBytes = (double)cpuData.size() * sizeof(int);
-    double dataSizeGB = dataSizeBytes / (1024.0 * 1024.0 * 1024.0);
-    double bandwidth = dataSizeGB / gpuExecutionTime;
-    
-    unsigned int *resultData = (unsigned int *)resultBuffer->contents();
-    unsigned int passCount = 0;
-    for (size_t i = 0; i < cpuData.size(); ++i) { if (resultData[i] == 1) { passCount++; } }
-    float selectivity = 100.0f * (float)passCount / (float)cpuData.size();
-    
-    std::cout << "--- Filter Value: < " << filterValue << " ---" << std::endl;
-    std::cout << "Selectivity: " << selectivity << "% (" << passCount << " rows matched)" << std::endl;
-    std::cout << "GPU execution time: " << gpuExecutionTime * 1000.0 << " ms" << std::endl;
-    std::cout << "Effective Bandwidth: " << bandwidth << " GB/s" << std::endl << std::endl;
+    if (!any) std::cout << "  none: the fastest mode is the same at every selectivity" << std::endl;
 }
 
 // --- Main Function for Selection Benchmark ---
@@ -139,34 +131,144 @@ void runSelectionBenchmark(MTL::Device* device, MTL::CommandQueue* commandQueue,
     //Select tpch data file
     std::vector<int> cpuData = loadIntColumn(g_dataset_path + "lineitem.tbl", 1);
     if (cpuData.empty()) { return; }
+    std::vector<float> payloadData = loadFloatColumn(g_dataset_path + "lineitem.tbl", 5);
+    if (payloadData.size() != cpuData.size()) { return; }
     std::cout << "Loaded " << cpuData.size() << " rows for selection." << std::endl;
 
-    NS::Error* error = nullptr;
-    NS::String* functionName = NS::String::string("selection_kernel", NS::UTF8StringEncoding);
-    MTL::Function* selectionFunction = library->newFunction(functionName);
-    MTL::ComputePipelineState* pipelineState = device->newComputePipelineState(selectionFunction, &error);
-    if (!pipelineState) { 
-        std::cerr << "Failed to create selection pipeline state" << std::endl; 
-        if (error) {
-            std::cerr << "Error: " << error->localizedDescription()->utf8String() << std::endl;
+    MTL::ComputePipelineState* flagsPipeline = makeComputePipeline(device, library, "selection_kernel");
+    MTL::ComputePipelineState* bitmapPipeline = makeComputePipeline(device, library, "selection_bitmap_kernel");
+    MTL::ComputePipelineState* countPipeline = makeComputePipeline(device, library, "selection_block_count_kernel");
+    MTL::ComputePipelineState* scanPipeline = makeComputePipeline(device, library, "selection_scan_blocks_kernel");
+    MTL::ComputePipelineState* compactPipeline = makeComputePipeline(device, library, "selection_compact_kernel");
+    if (!flagsPipeline || !bitmapPipeline || !countPipeline || !scanPipeline || !compactPipeline) { return; }
+    if (bitmapPipeline->threadExecutionWidth() != 32) {
+        std::cerr << "selection_bitmap_kernel needs 32-wide simdgroups (got " << bitmapPipeline->threadExecutionWidth() << ")" << std::endl;
+        return;
+    }
+
+    const uint32_t dataSize = (uint32_t)cpuData.size();
+    const uint32_t numBlocks = (dataSize + kSelectionBlock - 1) / kSelectionBlock;
+    const uint32_t bitmapWords = (dataSize + 31) / 32;
+    MTL::Buffer* inBuffer = device->newBuffer(cpuData.data(), dataSize * sizeof(int), MTL::ResourceStorageModeShared);
+    MTL::Buffer* payloadBuffer = device->newBuffer(payloadData.data(), dataSize * sizeof(float), MTL::ResourceStorageModeShared);
+    MTL::Buffer* flagsBuffer = device->newBuffer(dataSize * sizeof(uint32_t), MTL::ResourceStorageModeShared);
+    MTL::Buffer* bitmapBuffer = device->newBuffer(bitmapWords * sizeof(uint32_t), MTL::ResourceStorageModeShared);
+    MTL::Buffer* blockBuffer = device->newBuffer(numBlocks * sizeof(uint32_t), MTL::ResourceStorageModeShared);
+    MTL::Buffer* totalBuffer = device->newBuffer(sizeof(uint32_t), MTL::ResourceStorageModeShared);
+    MTL::Buffer* rowIdBuffer = device->newBuffer(dataSize * sizeof(uint32_t), MTL::ResourceStorageModeShared);
+    MTL::Buffer* valueBuffer = device->newBuffer(dataSize * sizeof(uint32_t), MTL::ResourceStorageModeShared);
+
+    // Filter values hitting each target selectivity: the value at that rank
+    std::vector<int> sorted = cpuData;
+    std::sort(sorted.begin(), sorted.end());
+    const double targets[] = {0.01, 0.1, 1.0, 5.0, 10.0, 25.0, 50.0, 75.0, 100.0};
+
+    const MTL::Size blockGrid = MTL::Size::Make(numBlocks, 1, 1);
+    const MTL::Size blockSize = MTL::Size::Make(kSelectionBlock, 1, 1);
+    auto encodeCompaction = [&](MTL::ComputeCommandEncoder* enc, const int& filterValue, MTL::Buffer* out, const uint32_t& emitPayload) {
+        enc->setComputePipelineState(countPipeline);
+        enc->setBuffer(inBuffer, 0, 0);
+        enc->setBuffer(blockBuffer, 0, 1);
+        enc->setBytes(&filterValue, sizeof(filterValue), 2);
+        enc->setBytes(&dataSize, sizeof(dataSize), 3);
+        enc->dispatchThreadgroups(blockGrid, blockSize);
+
+        enc->setComputePipelineState(scanPipeline);
+        enc->setBuffer(blockBuffer, 0, 0);
+        enc->setBuffer(totalBuffer, 0, 1);
+        enc->setBytes(&numBlocks, sizeof(numBlocks), 2);
+        enc->dispatchThreadgroups(MTL::Size::Make(1, 1, 1), MTL::Size::Make(std::min<NS::UInteger>(1024, scanPipeline->maxTotalThreadsPerThreadgroup()), 1, 1));
+
+        enc->setComputePipelineState(compactPipeline);
+        enc->setBuffer(inBuffer, 0, 0);
+        enc->setBuffer(payloadBuffer, 0, 1);
+        enc->setBuffer(blockBuffer, 0, 2);
+        enc->setBuffer(out, 0, 3);
+        enc->setBytes(&filterValue, sizeof(filterValue), 4);
+        enc->setBytes(&dataSize, sizeof(dataSize), 5);
+        enc->setBytes(&emitPayload, sizeof(emitPayload), 6);
+        enc->dispatchThreadgroups(blockGrid, blockSize);
+    };
+
+    std::vector<SelectionPoint> points;
+    for (double target : targets) {
+        const size_t rank = (size_t)std::llround(target / 100.0 * dataSize);
+        const int filterValue = rank >= dataSize ? std::numeric_limits<int>::max() : sorted[rank];
+        const uint32_t expected = (uint32_t)(std::lower_bound(sorted.begin(), sorted.end(), filterValue) - sorted.begin());
+        SelectionPoint point{target, expected, {}};
+
+        point.ms[0] = timeSelectionMode(commandQueue, [&](MTL::ComputeCommandEncoder* enc) {
+            enc->setComputePipelineState(flagsPipeline);
+            enc->setBuffer(inBuffer, 0, 0);
+            enc->setBuffer(flagsBuffer, 0, 1);
+            enc->setBytes(&filterValue, sizeof(filterValue), 2);
+            enc->dispatchThreads(MTL::Size::Make(dataSize, 1, 1), MTL::Size::Make(std::min<NS::UInteger>(dataSize, flagsPipeline->maxTotalThreadsPerThreadgroup()), 1, 1));
+        });
+        point.ms[1] = timeSelectionMode(commandQueue, [&](MTL::ComputeCommandEncoder* enc) {
+            enc->setComputePipelineState(bitmapPipeline);
+            enc->setBuffer(inBuffer, 0, 0);
+            enc->setBuffer(bitmapBuffer, 0, 1);
+            enc->setBytes(&filterValue, sizeof(filterValue), 2);
+            enc->setBytes(&dataSize, sizeof(dataSize), 3);
+            enc->dispatchThreadgroups(blockGrid, blockSize);
+        });
+        const uint32_t rowIds = 0, values = 1;
+        point.ms[2] = timeSelectionMode(commandQueue, [&](MTL::ComputeCommandEncoder* enc) { encodeCompaction(enc, filterValue, rowIdBuffer, rowIds); });
+        point.ms[3] = timeSelectionMode(commandQueue, [&](MTL::ComputeCommandEncoder* enc) { encodeCompaction(enc, filterValue, valueBuffer, values); });
+
+        // Every mode must select exactly the expected rows
+        const uint32_t* flags = (const uint32_t*)flagsBuffer->contents();
+        const uint32_t* bitmap = (const uint32_t*)bitmapBuffer->contents();
+        const uint32_t* ids = (const uint32_t*)rowIdBuffer->contents();
+        const uint32_t* vals = (const uint32_t*)valueBuffer->contents();
+        const uint32_t* payloadBits = (const uint32_t*)payloadData.data();
+        uint32_t flagCount = 0, bitCount = 0;
+        for (uint32_t i = 0; i < dataSize; ++i) flagCount += flags[i];
+        for (uint32_t w = 0; w < bitmapWords; ++w) bitCount += (uint32_t)__builtin_popcount(bitmap[w]);
+        bool listOk = *(const uint32_t*)totalBuffer->contents() == expected;
+        for (uint32_t i = 0; listOk && i < expected; ++i) {
+            listOk = ids[i] < dataSize && cpuData[ids[i]] < filterValue && (i == 0 || ids[i] > ids[i - 1]) && vals[i] == payloadBits[ids[i]];
         }
-        return; 
+        if (flagCount != expected || bitCount != expected || !listOk) {
+            std::cerr << "Warning: selection modes disagree at " << target << "% (expected " << expected << " rows, flags "
+                      << flagCount << ", bitmap " << bitCount << ", row ids " << (listOk ? "ok" : "wrong") << ")" << std::endl;
+        }
+        points.push_back(point);
     }
 
-    const unsigned long dataSizeBytes = cpuData.size() * sizeof(int);
-    MTL::Buffer* inBuffer = device->newBuffer(cpuData.data(), dataSizeBytes, MTL::ResourceStorageModeShared);
-    MTL::Buffer* resultBuffer = device->newBuffer(cpuData.size() * sizeof(unsigned int), MTL::ResourceStorageModeShared);
+    printf("\nSelection output modes (median GPU ms; GB/s of the %.0f MB input column):\n", dataSize * sizeof(int) / 1e6);
+    printf("+-------------+------------+---------------------+---------------------+---------------------+---------------------+-------------+\n");
+    printf("| selectivity |    matches |        flags        |       bitmap        |       row ids       |     materialize     |   fastest   |\n");
+    printf("+-------------+------------+---------------------+---------------------+---------------------+---------------------+-------------+\n");
+    for (const auto& p : points) {
+        printf("| %10.4f%% | %10u |", 100.0 * p.matches / dataSize, p.matches);
+        int fastest = 0;
+        for (int m = 0; m < 4; ++m) {
+            printf(" %8.3f ms %6.1f GB/s |", p.ms[m], p.ms[m] > 0.0 ? dataSize * sizeof(int) / (p.ms[m] * 1e6) : 0.0);
+            if (p.ms[m] < p.ms[fastest]) fastest = m;
+        }
+        printf(" %-11s |\n", kSelectionModes[fastest]);
+    }
+    printf("+-------------+------------+---------------------+---------------------+---------------------+---------------------+-------------+\n");
+    printf("Output bytes: flags %u, bitmap %u, row ids / materialize 4 per match (+%u block offsets)\n",
+           dataSize * 4, bitmapWords * 4, numBlocks * 4);
+    printSelectionCrossovers(points);
+    std::cout << std::endl;
 
-    runSingleSelectionTest(device, commandQueue, pipelineState, inBuffer, resultBuffer, cpuData, 1000);
-    runSingleSelectionTest(device, commandQueue, pipelineState, inBuffer, resultBuffer, cpuData, 10000);
-    runSingleSelectionTest(device, commandQueue, pipelineState, inBuffer, resultBuffer, cpuData, 50000);
-    
     // Cleanup
-    selectionFunction->release();
-    pipelineState->release();
+    flagsPipeline->release();
+    bitmapPipeline->release();
+    countPipeline->release();
+    scanPipeline->release();
+    compactPipeline->release();
     inBuffer->release();
-    resultBuffer->release();
-    functionName->release();
+    payloadBuffer->release();
+    flagsBuffer->release();
+    bitmapBuffer->release();
+    blockBuffer->release();
+    totalBuffer->release();
+    rowIdBuffer->release();
+    valueBuffer->release();
 }
 
 
@@ -209,37 +311,42 @@ void runAggregationBenchmark(MTL::Device* device, MTL::CommandQueue* commandQueu
     MTL::Buffer* partialSumsBuffer = device->newBuffer(numThreadgroups * sizeof(float), MTL::ResourceStorageModeShared);
     MTL::Buffer* resultBuffer = device->newBuffer(sizeof(float), MTL::ResourceStorageModeShared);
 
-    MTL::CommandBuffer* commandBuffer = commandQueue->commandBuffer();
-
-    // Use a single encoder for both stages to reduce encoder churn
-    MTL::ComputeCommandEncoder* enc = commandBuffer->computeCommandEncoder();
-    enc->setComputePipelineState(stage1Pipeline);
-    enc->setBuffer(inBuffer, 0, 0);
-    enc->setBuffer(partialSumsBuffer, 0, 1);
-    enc->setBytes(&dataSize, sizeof(dataSize), 2);
-
-    NS::UInteger stage1ThreadGroupSize = stage1Pipeline->maxTotalThreadsPerThreadgroup();
-    MTL::Size stage1GridSize = MTL::Size::Make(numThreadgroups, 1, 1);
-    MTL::Size stage1GroupSize = MTL::Size::Make(stage1ThreadGroupSize, 1, 1);
-    enc->dispatchThreadgroups(stage1GridSize, stage1GroupSize);
-
-    // Switch to stage 2 on the same encoder
-    enc->setComputePipelineState(stage2Pipeline);
-    enc->setBuffer(partialSumsBuffer, 0, 0);
-    enc->setBuffer(resultBuffer, 0, 1);
-    enc->dispatchThreads(MTL::Size::Make(1, 1, 1), MTL::Size::Make(1, 1, 1));
-    enc->endEncoding();
-
-    commandBuffer->commit();
-    commandBuffer->waitUntilCompleted();
-    
-    double gpuExecutionTime = commandBuffer->GPUEndTime() - commandBuffer->GPUStartTime();
+    BenchLoop loop;
+    while (loop.next()) {
+        MTL::CommandBuffer* commandBuffer = commandQueue->commandBuffer();
+
+        // Use a single encoder for both stages to reduce encoder churn
+        MTL::ComputeCommandEncoder* enc = commandBuffer->computeCommandEncoder();
+        enc->setComputePipelineState(stage1Pipeline);
+        enc->setBuffer(inBuffer, 0, 0);
+        enc->setBuffer(partialSumsBuffer, 0, 1);
+        enc->setBytes(&dataSize, sizeof(dataSize), 2);
+
+        NS::UInteger stage1ThreadGroupSize = stage1Pipeline->maxTotalThreadsPerThreadgroup();
+        MTL::Size stage1GridSize = MTL::Size::Make(numThreadgroups, 1, 1);
+        MTL::Size stage1GroupSize = MTL::Size::Make(stage1ThreadGroupSize, 1, 1);
+        enc->dispatchThreadgroups(stage1GridSize, stage1GroupSize);
+
+        // Switch to stage 2 on the same encoder
+        enc->setComputePipelineState(stage2Pipeline);
+        enc->setBuffer(partialSumsBuffer, 0, 0);
+        enc->setBuffer(resultBuffer, 0, 1);
+        enc->dispatchThreads(MTL::Size::Make(1, 1, 1), MTL::Size::Make(1, 1, 1));
+        enc->endEncoding();
+
+        commandBuffer->commit();
+        commandBuffer->waitUntilCompleted();
+        loop.record((commandBuffer->GPUEndTime() - commandBuffer->GPUStartTime()) * 1000.0);
+    }
+
+    double gpuExecutionTime = loop.stats().median / 1000.0;
     double dataSizeGB = (double)dataSizeBytes / (1024.0 * 1024.0 * 1024.0);
     double bandwidth = dataSizeGB / gpuExecutionTime;
 
     float *finalSum = (float *)resultBuffer->contents();
     std::cout << "Final SUM(l_quantity): " << finalSum[0] << std::endl;
     std::cout << "GPU execution time: " << gpuExecutionTime * 1000.0 << " ms" << std::endl;
+    loop.print("GPU execution time");
     std::cout << "Effective Bandwidth: " << bandwidth << " GB/s" << std::endl << std::endl;
     
     // Cleanup
@@ -272,8 +379,8 @@ void runJoinBenchmark(MTL::Device* device, MTL::CommandQueue* commandQueue, MTL:
     const uint buildDataSize = (uint)buildKeys.size();
     std::cout << "Loaded " << buildDataSize << " rows from orders.tbl for build phase." << std::endl;
 
-    // 2. Setup Hash Table
-    const uint hashTableSize = buildDataSize * 2;
+    // 2. Setup Hash Table, sized from the distinct build keys at load factor 0.5
+    const uint hashTableSize = (uint)hashTableSlots(computeColumnStats(buildKeys.data(), buildKeys.size()).distinct);
     const unsigned long hashTableSizeBytes = hashTableSize * sizeof(int) * 2;
     std::vector<int> cpuHashTable(hashTableSize * 2, -1);
 
@@ -401,6 +508,128 @@ void runJoinBenchmark(MTL::Device* device, MTL::CommandQueue* commandQueue, MTL:
     probeFunctionName->release();
 }
 
+// --- Synthetic Workload Runners (GPU) ---
+// The join benchmark's kernels and hash_aggregate_kernel on generated keys; the
+// tables are reset on the host between executions, outside the GPU times.
+JoinRunner gpuJoinRunner(MTL::Device* device, MTL::CommandQueue* commandQueue,
+                         MTL::ComputePipelineState* buildPipeline, MTL::ComputePipelineState* probePipeline) {
+    return [=](const JoinWorkload& w) {
+        const uint buildDataSize = (uint)w.buildKeys.size();
+        const uint probeDataSize = (uint)w.probeKeys.size();
+        const uint hashTableSize = (uint)hashTableSlots(computeColumnStats(w.buildKeys.data(), w.buildKeys.size()).distinct);
+        std::vector<int> rowIds(buildDataSize);
+        for (uint i = 0; i < buildDataSize; ++i) rowIds[i] = (int)i;
+        MTL::Buffer* buildKeysBuffer = device->newBuffer(w.buildKeys.data(), buildDataSize * sizeof(int), MTL::ResourceStorageModeShared);
+        MTL::Buffer* buildValuesBuffer = device->newBuffer(rowIds.data(), buildDataSize * sizeof(int), MTL::ResourceStorageModeShared);
+        MTL::Buffer* hashTableBuffer = device->newBuffer(hashTableSize * sizeof(int) * 2, MTL::ResourceStorageModeShared);
+        MTL::Buffer* probeKeysBuffer = device->newBuffer(std::max<uint>(1, probeDataSize) * sizeof(int), MTL::ResourceStorageModeShared);
+        if (probeDataSize) memcpy(probeKeysBuffer->contents(), w.probeKeys.data(), probeDataSize * sizeof(int));
+        MTL::Buffer* matchCountBuffer = device->newBuffer(sizeof(unsigned int), MTL::ResourceStorageModeShared);
+
+        std::vector<double> buildMs, probeMs;
+        BenchLoop loop;
+        while (loop.next()) {
+            memset(hashTableBuffer->contents(), 0xff, hashTableSize * sizeof(int) * 2); // all -1
+            memset(matchCountBuffer->contents(), 0, sizeof(unsigned int));
+
+            MTL::CommandBuffer* buildCommandBuffer = commandQueue->commandBuffer();
+            MTL::ComputeCommandEncoder* buildEncoder = buildCommandBuffer->computeCommandEncoder();
+            buildEncoder->setComputePipelineState(buildPipeline);
+            buildEncoder->setBuffer(buildKeysBuffer, 0, 0);
+            buildEncoder->setBuffer(buildValuesBuffer, 0, 1);
+            buildEncoder->setBuffer(hashTableBuffer, 0, 2);
+            buildEncoder->setBytes(&buildDataSize, sizeof(buildDataSize), 3);
+            buildEncoder->setBytes(&hashTableSize, sizeof(hashTableSize), 4);
+            buildEncoder->dispatchThreads(MTL::Size::Make(buildDataSize, 1, 1),
+                                          MTL::Size::Make(std::min<NS::UInteger>(buildDataSize, buildPipeline->maxTotalThreadsPerThreadgroup()), 1, 1));
+            buildEncoder->endEncoding();
+            buildCommandBuffer->commit();
+            buildCommandBuffer->waitUntilCompleted();
+
+            double probeTime = 0.0;
+            if (probeDataSize) {
+                MTL::CommandBuffer* probeCommandBuffer = commandQueue->commandBuffer();
+                MTL::ComputeCommandEncoder* probeEncoder = probeCommandBuffer->computeCommandEncoder();
+                probeEncoder->setComputePipelineState(probePipeline);
+                probeEncoder->setBuffer(probeKeysBuffer, 0, 0);
+                probeEncoder->setBuffer(hashTableBuffer, 0, 1);
+                probeEncoder->setBuffer(matchCountBuffer, 0, 2);
+                probeEncoder->setBytes(&probeDataSize, sizeof(probeDataSize), 3);
+                probeEncoder->setBytes(&hashTableSize, sizeof(hashTableSize), 4);
+                probeEncoder->dispatchThreads(MTL::Size::Make(probeDataSize, 1, 1),
+                                              MTL::Size::Make(std::min<NS::UInteger>(probeDataSize, probePipeline->maxTotalThreadsPerThreadgroup()), 1, 1));
+                probeEncoder->endEncoding();
+                probeCommandBuffer->commit();
+                probeCommandBuffer->waitUntilCompleted();
+                probeTime = (probeCommandBuffer->GPUEndTime() - probeCommandBuffer->GPUStartTime()) * 1000.0;
+            }
+            const double buildTime = (buildCommandBuffer->GPUEndTime() - buildCommandBuffer->GPUStartTime()) * 1000.0;
+            loop.record(buildTime + probeTime);
+            if (!loop.warmup()) { buildMs.push_back(buildTime); probeMs.push_back(probeTime); }
+        }
+        MicroTiming t;
+        t.buildMs = percentile(buildMs, 0.5);
+        t.probeMs = percentile(probeMs, 0.5);
+        t.result = *(unsigned int*)matchCountBuffer->contents();
+
+        buildKeysBuffer->release();
+        buildValuesBuffer->release();
+        hashTableBuffer->release();
+        probeKeysBuffer->release();
+        matchCountBuffer->release();
+        return t;
+    };
+}
+
+// Host view of the kernel's GroupEntry
+struct GroupEntry_CPU {
+    int key;
+    unsigned int count;
+    unsigned int sum;
+};
+
+AggregationRunner gpuAggregationRunner(MTL::Device* device, MTL::CommandQueue* commandQueue, MTL::ComputePipelineState* pipeline) {
+    return [=](const AggregationWorkload& w) {
+        const uint dataSize = (uint)w.keys.size();
+        const uint tableSize = (uint)std::max<uint64_t>(2, w.expectedGroups * 2); // like the join: twice the distinct keys
+        MTL::Buffer* keysBuffer = device->newBuffer(w.keys.data(), dataSize * sizeof(int), MTL::ResourceStorageModeShared);
+        MTL::Buffer* valuesBuffer = device->newBuffer(w.values.data(), dataSize * sizeof(int), MTL::ResourceStorageModeShared);
+        MTL::Buffer* tableBuffer = device->newBuffer(tableSize * sizeof(GroupEntry_CPU), MTL::ResourceStorageModeShared);
+        GroupEntry_CPU* table = (GroupEntry_CPU*)tableBuffer->contents();
+
+        BenchLoop loop;
+        while (loop.next()) {
+            std::fill(table, table + tableSize, GroupEntry_CPU{-1, 0, 0});
+            MTL::CommandBuffer* commandBuffer = commandQueue->commandBuffer();
+            MTL::ComputeCommandEncoder* encoder = commandBuffer->computeCommandEncoder();
+            encoder->setComputePipelineState(pipeline);
+            encoder->setBuffer(keysBuffer, 0, 0);
+            encoder->setBuffer(valuesBuffer, 0, 1);
+            encoder->setBuffer(tableBuffer, 0, 2);
+            encoder->setBytes(&dataSize, sizeof(dataSize), 3);
+            encoder->setBytes(&tableSize, sizeof(tableSize), 4);
+            encoder->dispatchThreads(MTL::Size::Make(dataSize, 1, 1),
+                                     MTL::Size::Make(std::min<NS::UInteger>(dataSize, pipeline->maxTotalThreadsPerThreadgroup()), 1, 1));
+            encoder->endEncoding();
+            commandBuffer->commit();
+            commandBuffer->waitUntilCompleted();
+            loop.record((commandBuffer->GPUEndTime() - commandBuffer->GPUStartTime()) * 1000.0);
+        }
+        MicroTiming t;
+        t.probeMs = loop.stats().median;
+        for (uint s = 0; s < tableSize; ++s) {
+            if (table[s].key == -1) continue;
+            ++t.result;
+            t.checksum += table[s].sum;
+        }
+
+        keysBuffer->release();
+        valuesBuffer->release();
+        tableBuffer->release();
+        return t;
+    };
+}
+
 
 // C++ equivalent of the Metal struct for reading results.
 // Note: no atomics here, as we are just reading the final values.
@@ -414,15 +643,149 @@ struct Q1Aggregates_CPU {
     unsigned int  count;
 };
 
+// --- GPU Scratch Pool ---
+// Query scratch (partials, finals, intermediate hash tables) comes from pooled
+// shared buffers instead of a newBuffer/release pair per run. The pool keeps
+// returned buffers by power-of-two size class and hands them out again to later
+// queries. A GpuArena takes one pooled buffer and cuts it into 256-byte aligned
+// slices, bound with setBuffer(buffer, offset, index); reset() rewinds it in
+// O(1). Slices that must start at zero are cleared on the GPU by a blit fill in
+// a command buffer committed ahead of the query's own, so the CPU no longer
+// memsets them every iteration and the clear is timed apart from the query.
+// The pool is shared by the throughput streams, so a mutex guards the free lists.
+class GpuBufferPool {
+public:
+    static constexpr size_t kMinClass = 64 * 1024;
+
+    ~GpuBufferPool() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto& [size, buffers] : m_free) for (MTL::Buffer* b : buffers) b->release();
+    }
+
+    // A shared buffer of at least bytes; reused when one of its class is free.
+    MTL::Buffer* acquire(MTL::Device* device, size_t bytes, bool* reused = nullptr) {
+        size_t size = kMinClass;
+        while (size < bytes) size *= 2;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto& list = m_free[size];
+            if (reused) *reused = !list.empty();
+            if (!list.empty()) { MTL::Buffer* b = list.back(); list.pop_back(); return b; }
+        }
+        return device->newBuffer(size, MTL::ResourceStorageModeShared);
+    }
+
+    void recycle(MTL::Buffer* buffer) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_free[buffer->length()].push_back(buffer);
+    }
+
+private:
+    std::mutex m_mutex;
+    std::map<size_t, std::vector<MTL::Buffer*>> m_free;
+};
+
+GpuBufferPool& gpuBufferPool() {
+    static GpuBufferPool pool;
+    return pool;
+}
+
+struct GpuSlice {
+    MTL::Buffer* buffer = nullptr;
+    size_t offset = 0;
+    size_t bytes = 0;
+
+    template <typename T> T* data() const { return (T*)((char*)buffer->contents() + offset); }
+};
+
+class GpuArena {
+public:
+    static constexpr size_t kAlignment = 256;
+
+    static size_t align(size_t bytes) { return (bytes + kAlignment - 1) / kAlignment * kAlignment; }
+
+    GpuArena(MTL::Device* device, size_t capacity) : m_capacity(capacity) {
+        auto start = std::chrono::high_resolution_clock::now();
+        m_buffer = gpuBufferPool().acquire(device, capacity, &m_reused);
+        m_allocMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+    ~GpuArena() { gpuBufferPool().recycle(m_buffer); }
+
+    GpuArena(const GpuArena&) = delete;
+    GpuArena& operator=(const GpuArena&) = delete;
+
+    // Callers size the arena with align() per slice; running past it is a bug.
+    GpuSlice alloc(size_t bytes) {
+        const size_t size = align(bytes);
+        if (m_offset + size > m_capacity) { std::cerr << "GpuArena: capacity exceeded" << std::endl; std::abort(); }
+        GpuSlice s{m_buffer, m_offset, bytes};
+        m_offset += size;
+        return s;
+    }
+
+    // As alloc(), cleared by every zero(); adjacent slices share one fill.
+    GpuSlice allocZeroed(size_t bytes) {
+        GpuSlice s = alloc(bytes);
+        const size_t size = align(bytes);
+        if (!m_zero.empty() && m_zero.back().location + m_zero.back().length == s.offset) m_zero.back().length += size;
+        else m_zero.push_back(NS::Range::Make(s.offset, size));
+        return s;
+    }
+
+    void reset() { m_offset = 0; m_zero.clear(); }
+
+    // Encodes the fills into their own command buffer and commits it; work the
+    // caller commits afterwards on the same queue sees zeroed slices.
+    void zero(MTL::CommandQueue* queue) {
+        if (m_zero.empty()) return;
+        m_pendingZero = queue->commandBuffer();
+        MTL::BlitCommandEncoder* blit = m_pendingZero->blitCommandEncoder();
+        for (const NS::Range& r : m_zero) blit->fillBuffer(m_buffer, r, 0);
+        blit->endEncoding();
+        m_pendingZero->commit();
+    }
+
+    // Accounts the GPU time of the last zero(); call after the caller's wait.
+    void collectZeroTime() {
+        if (!m_pendingZero) return;
+        m_pendingZero->waitUntilCompleted();
+        m_zeroMs += (m_pendingZero->GPUEndTime() - m_pendingZero->GPUStartTime()) * 1000.0;
+        m_zeroPasses += 1;
+        m_pendingZero = nullptr;
+    }
+
+    void printStats(const char* label) const {
+        printf("%s: %.1f KB arena (%s buffer), alloc %.3f ms, zero %.3f ms per iteration (GPU blit)\n",
+               label, m_capacity / 1024.0, m_reused ? "pooled" : "new", m_allocMs,
+               m_zeroPasses ? m_zeroMs / (double)m_zeroPasses : 0.0);
+    }
+
+private:
+    MTL::Buffer* m_buffer = nullptr;
+    size_t m_capacity = 0;
+    size_t m_offset = 0;
+    std::vector<NS::Range> m_zero;
+    MTL::CommandBuffer* m_pendingZero = nullptr;
+    bool m_reused = false;
+    double m_allocMs = 0.0;
+    double m_zeroMs = 0.0;
+    uint64_t m_zeroPasses = 0;
+};
+
+
 // --- Main Function for TPC-H Q1 Benchmark ---
-void runQ1Benchmark(MTL::Device* device, MTL::CommandQueue* commandQueue, MTL::Library* library) {
+void runQ1Benchmark(MTL::Device* device, MTL::CommandQueue* commandQueue, MTL::Library* library, ColumnCatalog& catalog, const Q1Params& params) {
     std::cout << "--- Running TPC-H Query 1 Benchmark ---" << std::endl;
-
-    const std::string filepath = g_dataset_path + "lineitem.tbl";
-    auto l_returnflag = loadCharColumn(filepath, 8), l_linestatus = loadCharColumn(filepath, 9);
-    auto l_quantity = loadFloatColumn(filepath, 4), l_extendedprice = loadFloatColumn(filepath, 5);
-    auto l_discount = loadFloatColumn(filepath, 6), l_tax = loadFloatColumn(filepath, 7);
-    auto l_shipdate = loadDateColumn(filepath, 10);
+    std::cout << "Parameters: " << describe(params) << std::endl;
+
+    const TableSnapshot lineitem = catalog.snapshot("lineitem");
+    const auto l_returnflag = lineitem.charColumn(8);
+    const auto l_linestatus = lineitem.charColumn(9);
+    const auto l_quantity = lineitem.floatColumn(4);
+    const auto l_extendedprice = lineitem.floatColumn(5);
+    const auto l_discount = lineitem.floatColumn(6);
+    const auto l_tax = lineitem.floatColumn(7);
+    const auto l_shipdate = lineitem.dateColumn(10);
     const uint data_size = (uint)l_shipdate.size();
     if (data_size == 0) { std::cerr << "Q1: no data loaded" << std::endl; return; }
 
@@ -448,57 +811,37 @@ void runQ1Benchmark(MTL::Device* device, MTL::CommandQueue* commandQueue, MTL::L
     const uint bins = 6;
     const uint num_threadgroups = 1024; // also passed to stage2
 
-    // Stage 1 partials: size = num_threadgroups * bins
-    MTL::Buffer* p_sumQtyCents = device->newBuffer(num_threadgroups * bins * sizeof(long), MTL::ResourceStorageModeShared);
-    MTL::Buffer* p_sumBaseCents = device->newBuffer(num_threadgroups * bins * sizeof(long), MTL::ResourceStorageModeShared);
-    MTL::Buffer* p_sumDiscPriceCents = device->newBuffer(num_threadgroups * bins * sizeof(long), MTL::ResourceStorageModeShared);
-    MTL::Buffer* p_sumChargeCents = device->newBuffer(num_threadgroups * bins * sizeof(long), MTL::ResourceStorageModeShared);
-    MTL::Buffer* p_sumDiscountBP = device->newBuffer(num_threadgroups * bins * sizeof(uint32_t), MTL::ResourceStorageModeShared);
-    MTL::Buffer* p_counts = device->newBuffer(num_threadgroups * bins * sizeof(uint32_t), MTL::ResourceStorageModeShared);
-    // Zero initialize partials (defensive)
-    memset(p_sumQtyCents->contents(), 0, num_threadgroups * bins * sizeof(long));
-    memset(p_sumBaseCents->contents(), 0, num_threadgroups * bins * sizeof(long));
-    memset(p_sumDiscPriceCents->contents(), 0, num_threadgroups * bins * sizeof(long));
-    memset(p_sumChargeCents->contents(), 0, num_threadgroups * bins * sizeof(long));
-    memset(p_sumDiscountBP->contents(), 0, num_threadgroups * bins * sizeof(uint32_t));
-    memset(p_counts->contents(), 0, num_threadgroups * bins * sizeof(uint32_t));
-
-    // Stage 2 finals: size = bins
-    MTL::Buffer* f_sumQtyCents = device->newBuffer(bins * sizeof(long), MTL::ResourceStorageModeShared);
-    MTL::Buffer* f_sumBaseCents = device->newBuffer(bins * sizeof(long), MTL::ResourceStorageModeShared);
-    MTL::Buffer* f_sumDiscPriceCents = device->newBuffer(bins * sizeof(long), MTL::ResourceStorageModeShared);
-    MTL::Buffer* f_sumChargeCents = device->newBuffer(bins * sizeof(long), MTL::ResourceStorageModeShared);
-    MTL::Buffer* f_sumDiscountBP = device->newBuffer(bins * sizeof(uint32_t), MTL::ResourceStorageModeShared);
-    MTL::Buffer* f_counts = device->newBuffer(bins * sizeof(uint32_t), MTL::ResourceStorageModeShared);
-    memset(f_sumQtyCents->contents(), 0, bins * sizeof(long));
-    memset(f_sumBaseCents->contents(), 0, bins * sizeof(long));
-    memset(f_sumDiscPriceCents->contents(), 0, bins * sizeof(long));
-    memset(f_sumChargeCents->contents(), 0, bins * sizeof(long));
-    memset(f_sumDiscountBP->contents(), 0, bins * sizeof(uint32_t));
-    memset(f_counts->contents(), 0, bins * sizeof(uint32_t));
-
-    const int cutoffDate = 19980902; // DATE '1998-12-01' - INTERVAL '90' DAY
+    // Stage 1 partials (num_threadgroups * bins) and stage 2 finals (bins), all
+    // slices of one pooled arena, cleared by a single blit fill per iteration
+    const size_t partialLong = num_threadgroups * bins * sizeof(long), partialUint = num_threadgroups * bins * sizeof(uint32_t);
+    const size_t finalLong = bins * sizeof(long), finalUint = bins * sizeof(uint32_t);
+    GpuArena arena(device, 4 * GpuArena::align(partialLong) + 2 * GpuArena::align(partialUint) +
+                           4 * GpuArena::align(finalLong) + 2 * GpuArena::align(finalUint));
+    const GpuSlice p_sumQtyCents = arena.allocZeroed(partialLong);
+    const GpuSlice p_sumBaseCents = arena.allocZeroed(partialLong);
+    const GpuSlice p_sumDiscPriceCents = arena.allocZeroed(partialLong);
+    const GpuSlice p_sumChargeCents = arena.allocZeroed(partialLong);
+    const GpuSlice p_sumDiscountBP = arena.allocZeroed(partialUint);
+    const GpuSlice p_counts = arena.allocZeroed(partialUint);
+    const GpuSlice f_sumQtyCents = arena.allocZeroed(finalLong);
+    const GpuSlice f_sumBaseCents = arena.allocZeroed(finalLong);
+    const GpuSlice f_sumDiscPriceCents = arena.allocZeroed(finalLong);
+    const GpuSlice f_sumChargeCents = arena.allocZeroed(finalLong);
+    const GpuSlice f_sumDiscountBP = arena.allocZeroed(finalUint);
+    const GpuSlice f_counts = arena.allocZeroed(finalUint);
+
+    const int cutoffDate = params.cutoffDate(); // DATE '1998-12-01' - INTERVAL DELTA DAY
 
     // Dispatch kernels
     double q1_gpu_ms = 0.0;
     
-    for(int iter = 0; iter < 3; ++iter) {
+    BenchLoop loop;
+    while (loop.next()) {
         // Reset partials and finals
-        memset(p_sumQtyCents->contents(), 0, num_threadgroups * bins * sizeof(long));
-        memset(p_sumBaseCents->contents(), 0, num_threadgroups * bins * sizeof(long));
-        memset(p_sumDiscPriceCents->contents(), 0, num_threadgroups * bins * sizeof(long));
-        memset(p_sumChargeCents->contents(), 0, num_threadgroups * bins * sizeof(long));
-        memset(p_sumDiscountBP->contents(), 0, num_threadgroups * bins * sizeof(uint32_t));
-        memset(p_counts->contents(), 0, num_threadgroups * bins * sizeof(uint32_t));
-        
-        memset(f_sumQtyCents->contents(), 0, bins * sizeof(long));
-        memset(f_sumBaseCents->contents(), 0, bins * sizeof(long));
-        memset(f_sumDiscPriceCents->contents(), 0, bins * sizeof(long));
-        memset(f_sumChargeCents->contents(), 0, bins * sizeof(long));
-        memset(f_sumDiscountBP->contents(), 0, bins * sizeof(uint32_t));
-        memset(f_counts->contents(), 0, bins * sizeof(uint32_t));
+        arena.zero(commandQueue);
 
         MTL::CommandBuffer* commandBuffer = commandQueue->commandBuffer();
+        TraceSpan scanSpan("q1 scan", "probe");
         MTL::ComputeCommandEncoder* enc = commandBuffer->computeCommandEncoder();
         
         // Stage 1: accumulate partials
@@ -510,12 +853,12 @@ void runQ1Benchmark(MTL::Device* device, MTL::CommandQueue* commandQueue, MTL::L
         enc->setBuffer(priceBuffer, 0, 4);
         enc->setBuffer(discBuffer, 0, 5);
         enc->setBuffer(taxBuffer, 0, 6);
-        enc->setBuffer(p_sumQtyCents, 0, 7);
-        enc->setBuffer(p_sumBaseCents, 0, 8);
-        enc->setBuffer(p_sumDiscPriceCents, 0, 9);
-        enc->setBuffer(p_sumChargeCents, 0, 10);
-        enc->setBuffer(p_sumDiscountBP, 0, 11);
-        enc->setBuffer(p_counts, 0, 12);
+        enc->setBuffer(p_sumQtyCents.buffer, p_sumQtyCents.offset, 7);
+        enc->setBuffer(p_sumBaseCents.buffer, p_sumBaseCents.offset, 8);
+        enc->setBuffer(p_sumDiscPriceCents.buffer, p_sumDiscPriceCents.offset, 9);
+        enc->setBuffer(p_sumChargeCents.buffer, p_sumChargeCents.offset, 10);
+        enc->setBuffer(p_sumDiscountBP.buffer, p_sumDiscountBP.offset, 11);
+        enc->setBuffer(p_counts.buffer, p_counts.offset, 12);
         enc->setBytes(&data_size, sizeof(data_size), 13);
         enc->setBytes(&cutoffDate, sizeof(cutoffDate), 14);
         enc->setBytes(&num_threadgroups, sizeof(num_threadgroups), 15);
@@ -525,40 +868,41 @@ void runQ1Benchmark(MTL::Device* device, MTL::CommandQueue* commandQueue, MTL::L
 
         // Stage 2: reduce partials to finals on the same encoder
         enc->setComputePipelineState(stage2PSO);
-        enc->setBuffer(p_sumQtyCents, 0, 0);
-        enc->setBuffer(p_sumBaseCents, 0, 1);
-        enc->setBuffer(p_sumDiscPriceCents, 0, 2);
-        enc->setBuffer(p_sumChargeCents, 0, 3);
-        enc->setBuffer(p_sumDiscountBP, 0, 4);
-        enc->setBuffer(p_counts, 0, 5);
-        enc->setBuffer(f_sumQtyCents, 0, 6);
-        enc->setBuffer(f_sumBaseCents, 0, 7);
-        enc->setBuffer(f_sumDiscPriceCents, 0, 8);
-        enc->setBuffer(f_sumChargeCents, 0, 9);
-        enc->setBuffer(f_sumDiscountBP, 0, 10);
-        enc->setBuffer(f_counts, 0, 11);
+        enc->setBuffer(p_sumQtyCents.buffer, p_sumQtyCents.offset, 0);
+        enc->setBuffer(p_sumBaseCents.buffer, p_sumBaseCents.offset, 1);
+        enc->setBuffer(p_sumDiscPriceCents.buffer, p_sumDiscPriceCents.offset, 2);
+        enc->setBuffer(p_sumChargeCents.buffer, p_sumChargeCents.offset, 3);
+        enc->setBuffer(p_sumDiscountBP.buffer, p_sumDiscountBP.offset, 4);
+        enc->setBuffer(p_counts.buffer, p_counts.offset, 5);
+        enc->setBuffer(f_sumQtyCents.buffer, f_sumQtyCents.offset, 6);
+        enc->setBuffer(f_sumBaseCents.buffer, f_sumBaseCents.offset, 7);
+        enc->setBuffer(f_sumDiscPriceCents.buffer, f_sumDiscPriceCents.offset, 8);
+        enc->setBuffer(f_sumChargeCents.buffer, f_sumChargeCents.offset, 9);
+        enc->setBuffer(f_sumDiscountBP.buffer, f_sumDiscountBP.offset, 10);
+        enc->setBuffer(f_counts.buffer, f_counts.offset, 11);
         enc->setBytes(&num_threadgroups, sizeof(num_threadgroups), 12);
         enc->dispatchThreads(MTL::Size::Make(1, 1, 1), MTL::Size::Make(1, 1, 1));
         enc->endEncoding();
 
         commandBuffer->commit();
         commandBuffer->waitUntilCompleted();
+        arena.collectZeroTime();
         
-        if (iter == 2) {
-            q1_gpu_ms = (commandBuffer->GPUEndTime() - commandBuffer->GPUStartTime()) * 1000.0;
-        }
+        loop.record((commandBuffer->GPUEndTime() - commandBuffer->GPUStartTime()) * 1000.0);
     }
+    q1_gpu_ms = loop.stats().median;
 
     // CPU post-processing (build final results) timing start
     auto q1_cpu_post_start = std::chrono::high_resolution_clock::now();
+    TraceSpan postSpan("q1 post", "post");
 
     // Read back final results
-    long* sum_qty_c = (long*)f_sumQtyCents->contents();
-    long* sum_base_c = (long*)f_sumBaseCents->contents();
-    long* sum_disc_c = (long*)f_sumDiscPriceCents->contents();
-    long* sum_charge_c = (long*)f_sumChargeCents->contents();
-    uint32_t* sum_discount_bp = (uint32_t*)f_sumDiscountBP->contents();
-    uint32_t* counts = (uint32_t*)f_counts->contents();
+    long* sum_qty_c = f_sumQtyCents.data<long>();
+    long* sum_base_c = f_sumBaseCents.data<long>();
+    long* sum_disc_c = f_sumDiscPriceCents.data<long>();
+    long* sum_charge_c = f_sumChargeCents.data<long>();
+    uint32_t* sum_discount_bp = f_sumDiscountBP.data<uint32_t>();
+    uint32_t* counts = f_counts.data<uint32_t>();
 
     struct Q1Result { double sum_qty, sum_base_price, sum_disc_price, sum_charge, avg_qty, avg_price, avg_disc; uint count; };
     std::map<std::pair<char,char>, Q1Result> final_results;
@@ -584,6 +928,7 @@ void runQ1Benchmark(MTL::Device* device, MTL::CommandQueue* commandQueue, MTL::L
     emit_bin(2,0,4); // R/F
     emit_bin(2,1,5); // R/O
 
+    postSpan.close();
     auto q1_cpu_post_end = std::chrono::high_resolution_clock::now();
     double q1_cpu_ms = std::chrono::duration<double, std::milli>(q1_cpu_post_end - q1_cpu_post_start).count();
 
@@ -597,20 +942,55 @@ void runQ1Benchmark(MTL::Device* device, MTL::CommandQueue* commandQueue, MTL::L
     }
     printf("+----------+----------+------------+----------------+----------------+----------------+------------+------------+------------+----------+\n");
     // Standardized timing prints
+    loop.print("Q1 GPU time");
+    arena.printStats("Q1 scratch");
     printf("Total TPC-H Q1 GPU time: %0.2f ms\n", q1_gpu_ms);
     printf("Q1 CPU time: %0.2f ms\n", q1_cpu_ms);
     printf("Total TPC-H Q1 wall-clock: %0.2f ms\n", q1_gpu_ms + q1_cpu_ms);
+    if (g_results.enabled()) {
+        ResultRecord rec = tpchResult("q1", "gpu", describe(params), loop, catalog, final_results.size());
+        rec.stages.emplace_back("scan", q1_gpu_ms);
+        rec.stages.emplace_back("post", q1_cpu_ms);
+        g_results.emit(rec);
+    }
 
     // Cleanup
     stage1Fn->release(); stage1PSO->release(); stage2Fn->release(); stage2PSO->release();
     shipdateBuffer->release(); flagBuffer->release(); statusBuffer->release();
     qtyBuffer->release(); priceBuffer->release(); discBuffer->release(); taxBuffer->release();
-    p_sumQtyCents->release(); p_sumBaseCents->release(); p_sumDiscPriceCents->release(); p_sumChargeCents->release(); p_sumDiscountBP->release(); p_counts->release();
-    f_sumQtyCents->release(); f_sumBaseCents->release(); f_sumDiscPriceCents->release(); f_sumChargeCents->release(); f_sumDiscountBP->release(); f_counts->release();
 }
 
 
 
+// --- Cached GPU Build Structures ---
+// Build-side buffer owned by the catalog's BuildCache, released with the last reference.
+struct GpuBuildBuffer {
+    explicit GpuBuildBuffer(MTL::Buffer* b) : buffer(b) {}
+    ~GpuBuildBuffer() { buffer->release(); }
+    MTL::Buffer* buffer;
+};
+
+// Returns the cached structure for key, or allocates a bufferBytes buffer filled
+// with fillByte, lets encode() dispatch the build kernel into it, and waits.
+std::shared_ptr<const GpuBuildBuffer> getOrBuildGpu(MTL::Device* device, MTL::CommandQueue* commandQueue, ColumnCatalog& catalog,
+                                                    const BuildKey& key, size_t bufferBytes, int fillByte,
+                                                    const std::function<void(MTL::ComputeCommandEncoder*, MTL::Buffer*)>& encode,
+                                                    BuildStats& stats) {
+    return catalog.buildCache().getOrBuild<GpuBuildBuffer>(key, [&](size_t& bytes) {
+        auto out = std::make_shared<GpuBuildBuffer>(device->newBuffer(bufferBytes, MTL::ResourceStorageModeShared));
+        std::memset(out->buffer->contents(), fillByte, bufferBytes);
+        MTL::CommandBuffer* commandBuffer = commandQueue->commandBuffer();
+        MTL::ComputeCommandEncoder* enc = commandBuffer->computeCommandEncoder();
+        encode(enc, out->buffer);
+        enc->endEncoding();
+        commandBuffer->commit();
+        commandBuffer->waitUntilCompleted();
+        bytes = bufferBytes;
+        return out;
+    }, &stats);
+}
+
+
 // C++ structs for reading final results
 struct Q3Result {
     int orderkey;
@@ -628,23 +1008,25 @@ struct Q3Aggregates_CPU {
 
 
 // --- Main Function for TPC-H Q3 Benchmark ---
-void runQ3Benchmark(MTL::Device* pDevice, MTL::CommandQueue* pCommandQueue, MTL::Library* pLibrary) {
+void runQ3Benchmark(MTL::Device* pDevice, MTL::CommandQueue* pCommandQueue, MTL::Library* pLibrary, ColumnCatalog& catalog, const Q3Params& params) {
     std::cout << "\n--- Running TPC-H Query 3 Benchmark ---" << std::endl;
+    std::cout << "Parameters: " << describe(params) << std::endl;
 
     // 1. Load data for all three tables
-    const std::string sf_path = g_dataset_path;
-    auto c_custkey = loadIntColumn(sf_path + "customer.tbl", 0);
-    auto c_mktsegment = loadCharColumn(sf_path + "customer.tbl", 6);
-
-    auto o_orderkey = loadIntColumn(sf_path + "orders.tbl", 0);
-    auto o_custkey = loadIntColumn(sf_path + "orders.tbl", 1);
-    auto o_orderdate = loadDateColumn(sf_path + "orders.tbl", 4);
-    auto o_shippriority = loadIntColumn(sf_path + "orders.tbl", 7);
-
-    auto l_orderkey = loadIntColumn(sf_path + "lineitem.tbl", 0);
-    auto l_shipdate = loadDateColumn(sf_path + "lineitem.tbl", 10);
-    auto l_extendedprice = loadFloatColumn(sf_path + "lineitem.tbl", 5);
-    auto l_discount = loadFloatColumn(sf_path + "lineitem.tbl", 6);
+    const auto c_custkey = catalog.intColumn("customer", 0);
+    const auto c_mktsegment = catalog.charColumn("customer", 6);
+
+    const TableSnapshot orders = catalog.snapshot("orders");
+    const auto o_orderkey = orders.intColumn(0);
+    const auto o_custkey = orders.intColumn(1);
+    const auto o_orderdate = orders.dateColumn(4);
+    const auto o_shippriority = orders.intColumn(7);
+
+    const TableSnapshot lineitem = catalog.snapshot("lineitem");
+    const auto l_orderkey = lineitem.intColumn(0);
+    const auto l_shipdate = lineitem.dateColumn(10);
+    const auto l_extendedprice = lineitem.floatColumn(5);
+    const auto l_discount = lineitem.floatColumn(6);
     
     const uint customer_size = (uint)c_custkey.size();
     const uint orders_size = (uint)o_orderkey.size();
@@ -666,25 +1048,7 @@ void runQ3Benchmark(MTL::Device* pDevice, MTL::CommandQueue* pCommandQueue, MTL:
     MTL::ComputePipelineState* pMergePipe = pDevice->newComputePipelineState(pMergeFn, &pError);
 
     // 3. Create Buffers
-    // Optimization 1: Bitmap for Customer (filter 'BUILDING')
-    int max_custkey = 0;
-    for(int k : c_custkey) max_custkey = std::max(max_custkey, k);
-    const uint customer_bitmap_ints = (max_custkey + 31) / 32 + 1;
-    MTL::Buffer* pCustomerBitmapBuffer = pDevice->newBuffer(customer_bitmap_ints * sizeof(uint), MTL::ResourceStorageModeShared);
-    std::memset(pCustomerBitmapBuffer->contents(), 0, customer_bitmap_ints * sizeof(uint));
-
-    MTL::Buffer* pCustKeyBuffer = pDevice->newBuffer(c_custkey.data(), customer_size * sizeof(int), MTL::ResourceStorageModeShared);
-    MTL::Buffer* pCustMktBuffer = pDevice->newBuffer(c_mktsegment.data(), customer_size * sizeof(char), MTL::ResourceStorageModeShared);
-
-    // Optimization 2: Direct Map for Orders
-    int max_orderkey = 0;
-    for(int k : o_orderkey) max_orderkey = std::max(max_orderkey, k);
-    const uint orders_map_size = max_orderkey + 1;
-    MTL::Buffer* pOrdersMapBuffer = pDevice->newBuffer(orders_map_size * sizeof(int), MTL::ResourceStorageModeShared);
-    // Initialize with -1
-    std::memset(pOrdersMapBuffer->contents(), -1, orders_map_size * sizeof(int));
-
-    MTL::Buffer* pOrdKeyBuffer = pDevice->newBuffer(o_orderkey.data(), orders_size * sizeof(int), MTL::ResourceStorageModeShared);
+    // Build-side structures (customer bitmap, orders direct map) come from the build cache in the loop below
     MTL::Buffer* pOrdCustKeyBuffer = pDevice->newBuffer(o_custkey.data(), orders_size * sizeof(int), MTL::ResourceStorageModeShared);
     MTL::Buffer* pOrdDateBuffer = pDevice->newBuffer(o_orderdate.data(), orders_size * sizeof(int), MTL::ResourceStorageModeShared);
     MTL::Buffer* pOrdPrioBuffer = pDevice->newBuffer(o_shippriority.data(), orders_size * sizeof(int), MTL::ResourceStorageModeShared);
@@ -695,60 +1059,83 @@ void runQ3Benchmark(MTL::Device* pDevice, MTL::CommandQueue* pCommandQueue, MTL:
     MTL::Buffer* pLineDiscBuffer = pDevice->newBuffer(l_discount.data(), lineitem_size * sizeof(float), MTL::ResourceStorageModeShared);
     
     const uint num_threadgroups = 2048;
-    // Allocate intermediate as an append-only buffer up to lineitem_size
-    const uint intermediate_capacity = lineitem_size;
+    const int cutoff_date = params.date;
+    // Append-only intermediate: at most one entry per lineitem past the cutoff, estimated from
+    // the l_shipdate histogram; an execution that overflows it grows it and runs again
+    uint intermediate_capacity = (uint)std::max<uint64_t>(1, lineitem.dateStats(10).rowsAbove(cutoff_date));
     MTL::Buffer* pIntermediateBuffer = pDevice->newBuffer(intermediate_capacity * sizeof(Q3Aggregates_CPU), MTL::ResourceStorageModeShared);
     MTL::Buffer* pOutCountBuffer = pDevice->newBuffer(sizeof(uint), MTL::ResourceStorageModeShared);
     // Initialize out counter to 0
     memset(pOutCountBuffer->contents(), 0, sizeof(uint));
 
-    const uint final_ht_size = orders_size;
-    std::vector<int> cpu_final_ht(final_ht_size * (sizeof(Q3Aggregates_CPU)/sizeof(int)), -1);
-    MTL::Buffer* pFinalHTBuffer = pDevice->newBuffer(cpu_final_ht.data(), final_ht_size * sizeof(Q3Aggregates_CPU), MTL::ResourceStorageModeShared);
-
-    const int cutoff_date = 19950315;
+    const char segment_prefix = params.segmentPrefix();
 
     // 4. Dispatch full pipeline (Warm-up + Measure)
-    // We run 3 times and measure the last one to eliminate driver initialization overhead
+    // Warm-up executions absorb driver initialization overhead; measured ones feed the statistics
     double gpuExecutionTime = 0.0;
+    double buildMs = 0.0;
+    BuildPhaseTimer buildTimer;
     
-    for(int iter = 0; iter < 3; ++iter) {
+    BenchLoop loop;
+    while (loop.next()) {
         // Reset Atomic Counter
         std::memset(pOutCountBuffer->contents(), 0, sizeof(uint));
         
-        // auto q3_start = std::chrono::high_resolution_clock::now();
-        
+        // Build phase: reuse cached structures, building (and caching) only what is missing
+        BuildStats build;
+        TraceSpan buildSpan("q3 build", "build");
+        BuildKey customerKey{"gpu.q3.customer_bitmap", "customer", "c_custkey,c_mktsegment",
+                             std::string("c_mktsegment=") + segment_prefix, catalog.tableVersion("customer")};
+        const uint customer_bitmap_ints = (uint)(std::max<int64_t>(0, catalog.intStats("customer", 0).max) + 31) / 32 + 1;
+        auto customerBitmap = getOrBuildGpu(pDevice, pCommandQueue, catalog, customerKey, customer_bitmap_ints * sizeof(uint), 0,
+            [&](MTL::ComputeCommandEncoder* enc, MTL::Buffer* pCustomerBitmapBuffer) {
+                // Customer HT build (Bitmap)
+                MTL::Buffer* pCustKeyBuffer = pDevice->newBuffer(c_custkey.data(), customer_size * sizeof(int), MTL::ResourceStorageModeShared);
+                MTL::Buffer* pCustMktBuffer = pDevice->newBuffer(c_mktsegment.data(), customer_size * sizeof(char), MTL::ResourceStorageModeShared);
+                enc->setComputePipelineState(pCustBuildPipe);
+                enc->setBuffer(pCustKeyBuffer, 0, 0);
+                enc->setBuffer(pCustMktBuffer, 0, 1);
+                enc->setBuffer(pCustomerBitmapBuffer, 0, 2);
+                enc->setBytes(&customer_size, sizeof(customer_size), 3);
+                enc->setBytes(&segment_prefix, sizeof(segment_prefix), 4);
+                NS::UInteger threadGroupSize = pCustBuildPipe->maxTotalThreadsPerThreadgroup();
+                if (threadGroupSize > 256) threadGroupSize = 256;
+                MTL::Size threadgroupSize = MTL::Size(threadGroupSize, 1, 1);
+                MTL::Size threadgroups = MTL::Size((customer_size + threadGroupSize - 1) / threadGroupSize, 1, 1);
+                enc->dispatchThreadgroups(threadgroups, threadgroupSize);
+                pCustKeyBuffer->release(); // retained by the encoder until the build completes
+                pCustMktBuffer->release();
+            }, build);
+        MTL::Buffer* pCustomerBitmapBuffer = customerBitmap->buffer;
+
+        BuildKey ordersKey{"gpu.q3.orders_map", "orders", "o_orderkey,o_orderdate",
+                           "o_orderdate<" + std::to_string(cutoff_date), orders.version()};
+        const uint orders_map_size = (uint)std::max<int64_t>(0, orders.intStats(0).max) + 1;
+        auto ordersMap = getOrBuildGpu(pDevice, pCommandQueue, catalog, ordersKey, orders_map_size * sizeof(int), -1,
+            [&](MTL::ComputeCommandEncoder* enc, MTL::Buffer* pOrdersMapBuffer) {
+                // Orders HT build (Direct Map)
+                MTL::Buffer* pOrdKeyBuffer = pDevice->newBuffer(o_orderkey.data(), orders_size * sizeof(int), MTL::ResourceStorageModeShared);
+                enc->setComputePipelineState(pOrdersBuildPipe);
+                enc->setBuffer(pOrdKeyBuffer, 0, 0);
+                enc->setBuffer(pOrdDateBuffer, 0, 1);
+                enc->setBuffer(pOrdersMapBuffer, 0, 2);
+                enc->setBytes(&orders_size, sizeof(orders_size), 3);
+                enc->setBytes(&cutoff_date, sizeof(cutoff_date), 4);
+                NS::UInteger threadGroupSize = pOrdersBuildPipe->maxTotalThreadsPerThreadgroup();
+                if (threadGroupSize > 256) threadGroupSize = 256;
+                MTL::Size threadgroupSize = MTL::Size(threadGroupSize, 1, 1);
+                MTL::Size threadgroups = MTL::Size((orders_size + threadGroupSize - 1) / threadGroupSize, 1, 1);
+                enc->dispatchThreadgroups(threadgroups, threadgroupSize);
+                pOrdKeyBuffer->release();
+            }, build);
+        MTL::Buffer* pOrdersMapBuffer = ordersMap->buffer;
+        buildTimer.record(build);
+        buildMs = build.ms;
+        buildSpan.close();
+
         MTL::CommandBuffer* pCommandBuffer = pCommandQueue->commandBuffer();
+        TraceSpan probeSpan("q3 probe", "probe");
         MTL::ComputeCommandEncoder* enc = pCommandBuffer->computeCommandEncoder();
-        
-        // Customer HT build (Bitmap)
-        enc->setComputePipelineState(pCustBuildPipe);
-        enc->setBuffer(pCustKeyBuffer, 0, 0);
-        enc->setBuffer(pCustMktBuffer, 0, 1);
-        enc->setBuffer(pCustomerBitmapBuffer, 0, 2);
-        enc->setBytes(&customer_size, sizeof(customer_size), 3);
-        {
-            NS::UInteger threadGroupSize = pCustBuildPipe->maxTotalThreadsPerThreadgroup();
-            if (threadGroupSize > 256) threadGroupSize = 256;
-            MTL::Size threadgroupSize = MTL::Size(threadGroupSize, 1, 1);
-            MTL::Size threadgroups = MTL::Size((customer_size + threadGroupSize - 1) / threadGroupSize, 1, 1);
-            enc->dispatchThreadgroups(threadgroups, threadgroupSize);
-        }
-
-        // Orders HT build (Direct Map)
-        enc->setComputePipelineState(pOrdersBuildPipe);
-        enc->setBuffer(pOrdKeyBuffer, 0, 0);
-        enc->setBuffer(pOrdDateBuffer, 0, 1);
-        enc->setBuffer(pOrdersMapBuffer, 0, 2);
-        enc->setBytes(&orders_size, sizeof(orders_size), 3);
-        enc->setBytes(&cutoff_date, sizeof(cutoff_date), 4);
-        {
-            NS::UInteger threadGroupSize = pOrdersBuildPipe->maxTotalThreadsPerThreadgroup();
-            if (threadGroupSize > 256) threadGroupSize = 256;
-            MTL::Size threadgroupSize = MTL::Size(threadGroupSize, 1, 1);
-            MTL::Size threadgroups = MTL::Size((orders_size + threadGroupSize - 1) / threadGroupSize, 1, 1);
-            enc->dispatchThreadgroups(threadgroups, threadgroupSize);
-        }
 
         // Probe + local aggregation
         enc->setComputePipelineState(pProbeAggPipe);
@@ -771,11 +1158,20 @@ void runQ3Benchmark(MTL::Device* pDevice, MTL::CommandQueue* pCommandQueue, MTL:
         
         pCommandBuffer->commit();
         pCommandBuffer->waitUntilCompleted();
-        
-        if (iter == 2) { // Only record the last run
-             gpuExecutionTime = pCommandBuffer->GPUEndTime() - pCommandBuffer->GPUStartTime();
+
+        const uint appended = *(uint*)pOutCountBuffer->contents();
+        if (appended > intermediate_capacity) {
+            // The histogram estimate fell short: grow to the observed count and repeat this execution
+            std::cerr << "Q3 intermediate overflow (" << appended << " > " << intermediate_capacity << "), growing" << std::endl;
+            pIntermediateBuffer->release();
+            intermediate_capacity = appended;
+            pIntermediateBuffer = pDevice->newBuffer(intermediate_capacity * sizeof(Q3Aggregates_CPU), MTL::ResourceStorageModeShared);
+            loop.retry();
+            continue;
         }
+        loop.record((pCommandBuffer->GPUEndTime() - pCommandBuffer->GPUStartTime()) * 1000.0);
     }
+    gpuExecutionTime = loop.stats().median / 1000.0;
     
     // Start Wall-Clock Timer (CPU Merge Phase)
     auto q3_e2e_start = std::chrono::high_resolution_clock::now();
@@ -784,6 +1180,7 @@ void runQ3Benchmark(MTL::Device* pDevice, MTL::CommandQueue* pCommandQueue, MTL:
 
     // 6. CPU merge for determinism and correctness
     auto cpuMergeStart = std::chrono::high_resolution_clock::now();
+    TraceSpan mergeSpan("q3 merge", "merge");
     std::unordered_map<int, Q3Result> acc;
     acc.reserve(*(uint*)pOutCountBuffer->contents() * 2);
     uint out_count = *(uint*)pOutCountBuffer->contents();
@@ -805,6 +1202,7 @@ void runQ3Benchmark(MTL::Device* pDevice, MTL::CommandQueue* pCommandQueue, MTL:
         if (a.revenue != b.revenue) return a.revenue > b.revenue;
         return a.orderdate < b.orderdate;
     });
+    mergeSpan.close();
     auto cpuMergeEnd = std::chrono::high_resolution_clock::now();
     double cpuMergeMs = std::chrono::duration<double, std::milli>(cpuMergeEnd - cpuMergeStart).count();
     auto q3_e2e_end = std::chrono::high_resolution_clock::now();
@@ -821,9 +1219,18 @@ void runQ3Benchmark(MTL::Device* pDevice, MTL::CommandQueue* pCommandQueue, MTL:
     printf("+----------+------------+------------+--------------+\n");
     printf("Total results found: %lu\n", final_results.size());
     // Standardized timing prints
+    buildTimer.print("Q3");
+    loop.print("Q3 GPU time");
     printf("Total TPC-H Q3 GPU time: %0.2f ms\n", gpuExecutionTime * 1000.0);
     printf("Q3 CPU time: %0.2f ms\n", cpuMergeMs);
-    printf("Total TPC-H Q3 wall-clock: %0.2f ms\n", gpuExecutionTime * 1000.0 + cpuMergeMs);
+    printf("Total TPC-H Q3 wall-clock: %0.2f ms\n", buildMs + gpuExecutionTime * 1000.0 + cpuMergeMs);
+    if (g_results.enabled()) {
+        ResultRecord rec = tpchResult("q3", "gpu", describe(params), loop, catalog, final_results.size());
+        rec.addBuildStages(buildTimer);
+        rec.stages.emplace_back("probe", gpuExecutionTime * 1000.0);
+        rec.stages.emplace_back("merge", cpuMergeMs);
+        g_results.emit(rec);
+    }
     
     //Cleanup
     pCustBuildFn->release();
@@ -835,33 +1242,29 @@ void runQ3Benchmark(MTL::Device* pDevice, MTL::CommandQueue* pCommandQueue, MTL:
     pMergeFn->release();
     pMergePipe->release();
 
-    pCustKeyBuffer->release();
-    pCustMktBuffer->release();
-    pCustomerBitmapBuffer->release();
-    pOrdKeyBuffer->release();
     pOrdCustKeyBuffer->release();
     pOrdDateBuffer->release();
     pOrdPrioBuffer->release();
-    pOrdersMapBuffer->release();
     pLineOrdKeyBuffer->release();
     pLineShipDateBuffer->release();
     pLinePriceBuffer->release();
     pLineDiscBuffer->release();
     pIntermediateBuffer->release();
     pOutCountBuffer->release();
-    pFinalHTBuffer->release();
 }
 
 
 // --- Main Function for TPC-H Query 6 Benchmark ---
-void runQ6Benchmark(MTL::Device* device, MTL::CommandQueue* commandQueue, MTL::Library* library) {
+void runQ6Benchmark(MTL::Device* device, MTL::CommandQueue* commandQueue, MTL::Library* library, ColumnCatalog& catalog, const Q6Params& params) {
     std::cout << "--- Running TPC-H Query 6 Benchmark ---" << std::endl;
+    std::cout << "Parameters: " << describe(params) << std::endl;
     
     // Load required columns from lineitem table
-    std::vector<int> l_shipdate = loadDateColumn(g_dataset_path + "lineitem.tbl", 10);    // Column 10: l_shipdate
-    std::vector<float> l_discount = loadFloatColumn(g_dataset_path + "lineitem.tbl", 6);  // Column 6: l_discount
-    std::vector<float> l_quantity = loadFloatColumn(g_dataset_path + "lineitem.tbl", 4);  // Column 4: l_quantity
-    std::vector<float> l_extendedprice = loadFloatColumn(g_dataset_path + "lineitem.tbl", 5); // Column 5: l_extendedprice
+    const TableSnapshot lineitem = catalog.snapshot("lineitem");
+    const auto l_shipdate = lineitem.dateColumn(10);        // Column 10: l_shipdate
+    const auto l_discount = lineitem.floatColumn(6);        // Column 6: l_discount
+    const auto l_quantity = lineitem.floatColumn(4);        // Column 4: l_quantity
+    const auto l_extendedprice = lineitem.floatColumn(5);   // Column 5: l_extendedprice
 
     if (l_shipdate.empty() || l_discount.empty() || l_quantity.empty() || l_extendedprice.empty()) {
         std::cerr << "Error: Could not load required columns for Q6 benchmark" << std::endl;
@@ -872,11 +1275,11 @@ void runQ6Benchmark(MTL::Device* device, MTL::CommandQueue* commandQueue, MTL::L
     std::cout << "Loaded " << dataSize << " rows for TPC-H Query 6." << std::endl;
 
     // Query parameters
-    int start_date = 19940101;   // 1994-01-01
-    int end_date = 19950101;     // 1995-01-01
-    float min_discount = 0.05f;  // 5%
-    float max_discount = 0.07f;  // 7%
-    float max_quantity = 24.0f;
+    int start_date = params.date;                // DATE
+    int end_date = params.endDate();             // DATE + 1 year
+    float min_discount = params.minDiscount();   // DISCOUNT - 0.01
+    float max_discount = params.maxDiscount();   // DISCOUNT + 0.01
+    float max_quantity = (float)params.quantity; // QUANTITY
 
     NS::Error* error = nullptr;
     
@@ -924,8 +1327,10 @@ void runQ6Benchmark(MTL::Device* device, MTL::CommandQueue* commandQueue, MTL::L
     // Execute GPU kernels using a single encoder for both stages
     double q6_gpu_s = 0.0;
     
-    for(int iter = 0; iter < 3; ++iter) {
+    BenchLoop loop;
+    while (loop.next()) {
         MTL::CommandBuffer* commandBuffer = commandQueue->commandBuffer();
+        TraceSpan scanSpan("q6 scan", "probe");
         MTL::ComputeCommandEncoder* enc = commandBuffer->computeCommandEncoder();
         
         // Stage 1: Filter and compute partial revenue sums
@@ -960,27 +1365,35 @@ void runQ6Benchmark(MTL::Device* device, MTL::CommandQueue* commandQueue, MTL::L
         commandBuffer->commit();
         commandBuffer->waitUntilCompleted();
         
-        if (iter == 2) {
-             q6_gpu_s = commandBuffer->GPUEndTime() - commandBuffer->GPUStartTime();
-        }
+        loop.record((commandBuffer->GPUEndTime() - commandBuffer->GPUStartTime()) * 1000.0);
     }
+    q6_gpu_s = loop.stats().median / 1000.0;
 
     // CPU post (minimal) timing: fetching result
     auto q6_cpu_post_start = std::chrono::high_resolution_clock::now();
+    TraceSpan postSpan("q6 post", "post");
 
     // Get result
     float* resultData = (float*)finalRevenueBuffer->contents();
     float totalRevenue = resultData[0];
 
+    postSpan.close();
     auto q6_cpu_post_end = std::chrono::high_resolution_clock::now();
     double q6_cpu_ms = std::chrono::duration<double, std::milli>(q6_cpu_post_end - q6_cpu_post_start).count();
 
     std::cout << "TPC-H Query 6 Result:" << std::endl;
     std::cout << "Total Revenue: $" << std::fixed << std::setprecision(2) << totalRevenue << std::endl;
     // Standardized timing prints
+    loop.print("Q6 GPU time");
     printf("Total TPC-H Q6 GPU time: %0.2f ms\n", q6_gpu_s * 1000.0);
     printf("Q6 CPU time: %0.2f ms\n", q6_cpu_ms);
     printf("Total TPC-H Q6 wall-clock: %0.2f ms\n", q6_gpu_s * 1000.0 + q6_cpu_ms);
+    if (g_results.enabled()) {
+        ResultRecord rec = tpchResult("q6", "gpu", describe(params), loop, catalog, 1);
+        rec.stages.emplace_back("scan", q6_gpu_s * 1000.0);
+        rec.stages.emplace_back("post", q6_cpu_ms);
+        g_results.emit(rec);
+    }
     
     // Calculate effective bandwidth (rough estimate)
     size_t totalDataBytes = dataSize * (sizeof(int) + 3 * sizeof(float)); // All input columns
@@ -1017,29 +1430,31 @@ struct Q9Aggregates_CPU {
 
 
 // --- Main Function for TPC-H Q9 Benchmark ---
-void runQ9Benchmark(MTL::Device* pDevice, MTL::CommandQueue* pCommandQueue, MTL::Library* pLibrary) {
+void runQ9Benchmark(MTL::Device* pDevice, MTL::CommandQueue* pCommandQueue, MTL::Library* pLibrary, ColumnCatalog& catalog, const Q9Params& params) {
     std::cout << "\n--- Running TPC-H Query 9 Benchmark ---" << std::endl;
+    std::cout << "Parameters: " << describe(params) << std::endl;
 
-    const std::string sf_path = g_dataset_path;
     
     // 1. Load data for all SIX tables
-    auto p_partkey = loadIntColumn(sf_path + "part.tbl", 0);
-    auto p_name = loadCharColumn(sf_path + "part.tbl", 1, 55);
-    auto s_suppkey = loadIntColumn(sf_path + "supplier.tbl", 0);
-    auto s_nationkey = loadIntColumn(sf_path + "supplier.tbl", 3);
-    auto l_partkey = loadIntColumn(sf_path + "lineitem.tbl", 1);
-    auto l_suppkey = loadIntColumn(sf_path + "lineitem.tbl", 2);
-    auto l_orderkey = loadIntColumn(sf_path + "lineitem.tbl", 0);
-    auto l_quantity = loadFloatColumn(sf_path + "lineitem.tbl", 4);
-    auto l_extendedprice = loadFloatColumn(sf_path + "lineitem.tbl", 5);
-    auto l_discount = loadFloatColumn(sf_path + "lineitem.tbl", 6);
-    auto ps_partkey = loadIntColumn(sf_path + "partsupp.tbl", 0);
-    auto ps_suppkey = loadIntColumn(sf_path + "partsupp.tbl", 1);
-    auto ps_supplycost = loadFloatColumn(sf_path + "partsupp.tbl", 3);
-    auto o_orderkey = loadIntColumn(sf_path + "orders.tbl", 0);
-    auto o_orderdate = loadDateColumn(sf_path + "orders.tbl", 4);
-    auto n_nationkey = loadIntColumn(sf_path + "nation.tbl", 0);
-    auto n_name = loadCharColumn(sf_path + "nation.tbl", 1, 25);
+    const TableSnapshot orders = catalog.snapshot("orders");
+    const TableSnapshot lineitem = catalog.snapshot("lineitem");
+    const auto p_partkey = catalog.intColumn("part", 0);
+    const auto p_name = catalog.charColumn("part", 1, 55);
+    const auto s_suppkey = catalog.intColumn("supplier", 0);
+    const auto s_nationkey = catalog.intColumn("supplier", 3);
+    const auto l_partkey = lineitem.intColumn(1);
+    const auto l_suppkey = lineitem.intColumn(2);
+    const auto l_orderkey = lineitem.intColumn(0);
+    const auto l_quantity = lineitem.floatColumn(4);
+    const auto l_extendedprice = lineitem.floatColumn(5);
+    const auto l_discount = lineitem.floatColumn(6);
+    const auto ps_partkey = catalog.intColumn("partsupp", 0);
+    const auto ps_suppkey = catalog.intColumn("partsupp", 1);
+    const auto ps_supplycost = catalog.floatColumn("partsupp", 3);
+    const auto o_orderkey = orders.intColumn(0);
+    const auto o_orderdate = orders.dateColumn(4);
+    const auto n_nationkey = catalog.intColumn("nation", 0);
+    const auto n_name = catalog.charColumn("nation", 1, 25);
 
     // Create a map for nation names
     std::map<int, std::string> nation_names;
@@ -1053,21 +1468,15 @@ void runQ9Benchmark(MTL::Device* pDevice, MTL::CommandQueue* pCommandQueue, MTL:
     std::cout << "Loaded data for all tables." << std::endl;
     std::cout << "Part size: " << part_size << ", Supplier size: " << supplier_size << ", Lineitem size: " << lineitem_size << std::endl;
 
-    // Debug: Check for 'green' in p_name
-    int green_count = 0;
+    // Debug: Check for COLOR in p_name
+    const std::string& color = params.color;
+    const uint color_len = (uint)color.size();
+    int color_count = 0;
     for (size_t i = 0; i < part_size; ++i) {
-        bool match = false;
-        for(int j = 0; j < 50; ++j) {
-            if (p_name[i * 55 + j] == 'g' && p_name[i * 55 + j + 1] == 'r' &&
-                p_name[i * 55 + j + 2] == 'e' && p_name[i * 55 + j + 3] == 'e' &&
-                p_name[i * 55 + j + 4] == 'n') {
-                match = true;
-                break;
-            }
-        }
-        if (match) green_count++;
+        std::string_view name(&p_name[i * 55], 55);
+        if (name.find(color) != std::string_view::npos) color_count++;
     }
-    std::cout << "Found " << green_count << " parts with 'green' in name (CPU check)." << std::endl;
+    std::cout << "Found " << color_count << " parts with '" << color << "' in name (CPU check)." << std::endl;
 
 
     // 2. Setup all kernel pipelines
@@ -1102,11 +1511,6 @@ void runQ9Benchmark(MTL::Device* pDevice, MTL::CommandQueue* pCommandQueue, MTL:
     for(int k : p_partkey) max_partkey = std::max(max_partkey, k);
     std::cout << "Max PartKey: " << max_partkey << std::endl;
     const uint part_bitmap_ints = (max_partkey + 31) / 32 + 1;
-    MTL::Buffer* pPartBitmapBuffer = pDevice->newBuffer(part_bitmap_ints * sizeof(uint), MTL::ResourceStorageModeShared);
-    std::memset(pPartBitmapBuffer->contents(), 0, part_bitmap_ints * sizeof(uint));
-    
-    MTL::Buffer* pPartKeyBuffer = pDevice->newBuffer(p_partkey.data(), part_size * sizeof(int), MTL::ResourceStorageModeShared);
-    MTL::Buffer* pPartNameBuffer = pDevice->newBuffer(p_name.data(), p_name.size() * sizeof(char), MTL::ResourceStorageModeShared);
     // Dummy size for compatibility
     const uint part_ht_size = 0; 
 
@@ -1115,29 +1519,16 @@ void runQ9Benchmark(MTL::Device* pDevice, MTL::CommandQueue* pCommandQueue, MTL:
     for(int k : s_suppkey) max_suppkey = std::max(max_suppkey, k);
     std::cout << "Max SuppKey: " << max_suppkey << std::endl;
     const uint supp_map_size = max_suppkey + 1;
-    MTL::Buffer* pSuppMapBuffer = pDevice->newBuffer(supp_map_size * sizeof(int), MTL::ResourceStorageModeShared);
-    // Initialize with -1 to be safe
-    std::memset(pSuppMapBuffer->contents(), -1, supp_map_size * sizeof(int));
-
-    
-    MTL::Buffer* pSuppKeyBuffer = pDevice->newBuffer(s_suppkey.data(), supplier_size * sizeof(int), MTL::ResourceStorageModeShared);
-    MTL::Buffer* pSuppNationKeyBuffer = pDevice->newBuffer(s_nationkey.data(), supplier_size * sizeof(int), MTL::ResourceStorageModeShared);
     // Dummy size for compatibility
     const uint supplier_ht_size = 0;
     
-    const uint partsupp_ht_size = partsupp_size * 4; // larger table to reduce probe lengths
-    // PartSuppEntry has 4 ints (partkey, suppkey, idx, pad); initialize all to -1 to mark empty
-    std::vector<int> cpu_partsupp_ht(partsupp_ht_size * 4, -1);
-    MTL::Buffer* pPsPartKeyBuffer = pDevice->newBuffer(ps_partkey.data(), partsupp_size * sizeof(int), MTL::ResourceStorageModeShared);
-    MTL::Buffer* pPsSuppKeyBuffer = pDevice->newBuffer(ps_suppkey.data(), partsupp_size * sizeof(int), MTL::ResourceStorageModeShared);
+    // (partkey, suppkey) is partsupp's key, so its distinct count is the row count
+    const uint partsupp_ht_size = (uint)hashTableSlots(partsupp_size);
+    // PartSuppEntry has 4 ints (partkey, suppkey, idx, pad); all -1 marks empty
     MTL::Buffer* pPsSupplyCostBuffer = pDevice->newBuffer(ps_supplycost.data(), partsupp_size * sizeof(float), MTL::ResourceStorageModeShared);
-    MTL::Buffer* pPartSuppHTBuffer = pDevice->newBuffer(cpu_partsupp_ht.data(), partsupp_ht_size * sizeof(int) * 4, MTL::ResourceStorageModeShared);
     
-    const uint orders_ht_size = orders_size * 2;
-    std::vector<int> cpu_orders_ht(orders_ht_size * 2, -1);
-    MTL::Buffer* pOrdKeyBuffer = pDevice->newBuffer(o_orderkey.data(), orders_size * sizeof(int), MTL::ResourceStorageModeShared);
-    MTL::Buffer* pOrdDateBuffer = pDevice->newBuffer(o_orderdate.data(), orders_size * sizeof(int), MTL::ResourceStorageModeShared);
-    MTL::Buffer* pOrdersHTBuffer = pDevice->newBuffer(cpu_orders_ht.data(), orders_ht_size * sizeof(int) * 2, MTL::ResourceStorageModeShared);
+    const uint orders_ht_size = (uint)hashTableSlots(orders.intStats(0).distinct);
+    // The four build structures come from the build cache in the loop below
 
     MTL::Buffer* pLinePartKeyBuffer = pDevice->newBuffer(l_partkey.data(), lineitem_size * sizeof(int), MTL::ResourceStorageModeShared);
     MTL::Buffer* pLineSuppKeyBuffer = pDevice->newBuffer(l_suppkey.data(), lineitem_size * sizeof(int), MTL::ResourceStorageModeShared);
@@ -1147,93 +1538,118 @@ void runQ9Benchmark(MTL::Device* pDevice, MTL::CommandQueue* pCommandQueue, MTL:
     MTL::Buffer* pLineDiscBuffer = pDevice->newBuffer(l_discount.data(), lineitem_size * sizeof(float), MTL::ResourceStorageModeShared);
 
     const uint num_threadgroups = 2048, local_ht_size = 256, intermediate_size = num_threadgroups * local_ht_size;
-    MTL::Buffer* pIntermediateBuffer = pDevice->newBuffer(intermediate_size * sizeof(Q9Aggregates_CPU), MTL::ResourceStorageModeShared);
-    // Ensure intermediate buffer is zero-initialized so merge stage can early-out on empty slots
-    std::memset(pIntermediateBuffer->contents(), 0, intermediate_size * sizeof(Q9Aggregates_CPU));
-    const uint final_ht_size = 25 * 10; // 25 nations * ~10 years
-    std::vector<uint> cpu_final_ht(final_ht_size * (sizeof(Q9Aggregates_CPU)/sizeof(uint)), 0);
-    MTL::Buffer* pFinalHTBuffer = pDevice->newBuffer(cpu_final_ht.data(), final_ht_size * sizeof(Q9Aggregates_CPU), MTL::ResourceStorageModeShared);
+    // One group per (supplier nation, order year): both ranges come from the column statistics
+    const ColumnStats& orderDates = orders.dateStats(4);
+    const int64_t q9_nations = std::max<int64_t>(0, catalog.intStats("supplier", 3).max) + 1;
+    const int64_t q9_years = orderDates.empty() ? 1 : orderDates.max / 10000 - orderDates.min / 10000 + 1;
+    const uint final_ht_size = (uint)hashTableSlots((double)(q9_nations * q9_years));
+    // Intermediate and final tables are zeroed every iteration (the merge stage early-outs on empty slots)
+    GpuArena arena(pDevice, GpuArena::align(intermediate_size * sizeof(Q9Aggregates_CPU)) + GpuArena::align(final_ht_size * sizeof(Q9Aggregates_CPU)));
+    const GpuSlice intermediateHT = arena.allocZeroed(intermediate_size * sizeof(Q9Aggregates_CPU));
+    const GpuSlice finalHT = arena.allocZeroed(final_ht_size * sizeof(Q9Aggregates_CPU));
 
     // 4. Dispatch the entire 6-stage pipeline
     double q9_gpu_compute_time = 0.0;
+    double buildMs = 0.0;
+    BuildPhaseTimer buildTimer;
     
-    for(int iter = 0; iter < 3; ++iter) {
+    BenchLoop loop;
+    while (loop.next()) {
         // Reset Buffers
-        std::memset(pPartBitmapBuffer->contents(), 0, part_bitmap_ints * sizeof(uint));
-        std::memset(pSuppMapBuffer->contents(), -1, supp_map_size * sizeof(int));
-        std::memset(pPartSuppHTBuffer->contents(), 0xFF, partsupp_ht_size * sizeof(int) * 4);
-        std::memset(pOrdersHTBuffer->contents(), 0xFF, orders_ht_size * sizeof(int) * 2);
-        std::memset(pIntermediateBuffer->contents(), 0, intermediate_size * sizeof(Q9Aggregates_CPU));
-        std::memset(pFinalHTBuffer->contents(), 0, final_ht_size * sizeof(Q9Aggregates_CPU));
-        
-        MTL::CommandBuffer* pCommandBuffer = pCommandQueue->commandBuffer();
+        arena.zero(pCommandQueue);
+
+        // Build Phase (Stages 1-4): reuse cached structures, building (and caching) only what is missing
+        BuildStats build;
+        TraceSpan buildSpan("q9 build", "build");
 
-        // Encoder 1: Build Phase (Stages 1-4)
-        MTL::ComputeCommandEncoder* pBuildEnc = pCommandBuffer->computeCommandEncoder();
-        
         // Stage 1: Part build (Bitmap)
-        pBuildEnc->setComputePipelineState(pPartBuildPipe);
-        pBuildEnc->setBuffer(pPartKeyBuffer, 0, 0); pBuildEnc->setBuffer(pPartNameBuffer, 0, 1);
-        pBuildEnc->setBuffer(pPartBitmapBuffer, 0, 2); pBuildEnc->setBytes(&part_size, sizeof(part_size), 3);
-        pBuildEnc->setBytes(&part_ht_size, sizeof(part_ht_size), 4);
-        {
-            NS::UInteger threadGroupSize = pPartBuildPipe->maxTotalThreadsPerThreadgroup();
-            if (threadGroupSize > 256) threadGroupSize = 256;
-            MTL::Size threadgroupSize = MTL::Size(threadGroupSize, 1, 1);
-            MTL::Size threadgroups = MTL::Size((part_size + threadGroupSize - 1) / threadGroupSize, 1, 1);
-            pBuildEnc->dispatchThreadgroups(threadgroups, threadgroupSize);
-        }
-        
+        BuildKey partKey{"gpu.q9.part_bitmap", "part", "p_partkey,p_name", "p_name~" + color, catalog.tableVersion("part")};
+        auto partBitmap = getOrBuildGpu(pDevice, pCommandQueue, catalog, partKey, part_bitmap_ints * sizeof(uint), 0,
+            [&](MTL::ComputeCommandEncoder* pBuildEnc, MTL::Buffer* pPartBitmapBuffer) {
+                MTL::Buffer* pPartKeyBuffer = pDevice->newBuffer(p_partkey.data(), part_size * sizeof(int), MTL::ResourceStorageModeShared);
+                MTL::Buffer* pPartNameBuffer = pDevice->newBuffer(p_name.data(), p_name.size() * sizeof(char), MTL::ResourceStorageModeShared);
+                pBuildEnc->setComputePipelineState(pPartBuildPipe);
+                pBuildEnc->setBuffer(pPartKeyBuffer, 0, 0); pBuildEnc->setBuffer(pPartNameBuffer, 0, 1);
+                pBuildEnc->setBuffer(pPartBitmapBuffer, 0, 2); pBuildEnc->setBytes(&part_size, sizeof(part_size), 3);
+                pBuildEnc->setBytes(&part_ht_size, sizeof(part_ht_size), 4);
+                pBuildEnc->setBytes(color.data(), color_len, 5); pBuildEnc->setBytes(&color_len, sizeof(color_len), 6);
+                NS::UInteger threadGroupSize = pPartBuildPipe->maxTotalThreadsPerThreadgroup();
+                if (threadGroupSize > 256) threadGroupSize = 256;
+                MTL::Size threadgroupSize = MTL::Size(threadGroupSize, 1, 1);
+                MTL::Size threadgroups = MTL::Size((part_size + threadGroupSize - 1) / threadGroupSize, 1, 1);
+                pBuildEnc->dispatchThreadgroups(threadgroups, threadgroupSize);
+                pPartKeyBuffer->release(); // retained by the encoder until the build completes
+                pPartNameBuffer->release();
+            }, build);
+
         // Stage 2: Supplier build (Direct Map)
-        pBuildEnc->setComputePipelineState(pSuppBuildPipe);
-        pBuildEnc->setBuffer(pSuppKeyBuffer, 0, 0); pBuildEnc->setBuffer(pSuppNationKeyBuffer, 0, 1);
-        pBuildEnc->setBuffer(pSuppMapBuffer, 0, 2); pBuildEnc->setBytes(&supplier_size, sizeof(supplier_size), 3);
-        pBuildEnc->setBytes(&supplier_ht_size, sizeof(supplier_ht_size), 4);
-        {
-            NS::UInteger threadGroupSize = pSuppBuildPipe->maxTotalThreadsPerThreadgroup();
-            if (threadGroupSize > 256) threadGroupSize = 256;
-            MTL::Size threadgroupSize = MTL::Size(threadGroupSize, 1, 1);
-            MTL::Size threadgroups = MTL::Size((supplier_size + threadGroupSize - 1) / threadGroupSize, 1, 1);
-            pBuildEnc->dispatchThreadgroups(threadgroups, threadgroupSize);
-        }
-        
+        BuildKey suppKey{"gpu.q9.supplier_map", "supplier", "s_suppkey,s_nationkey", "", catalog.tableVersion("supplier")};
+        auto suppMap = getOrBuildGpu(pDevice, pCommandQueue, catalog, suppKey, supp_map_size * sizeof(int), -1,
+            [&](MTL::ComputeCommandEncoder* pBuildEnc, MTL::Buffer* pSuppMapBuffer) {
+                MTL::Buffer* pSuppKeyBuffer = pDevice->newBuffer(s_suppkey.data(), supplier_size * sizeof(int), MTL::ResourceStorageModeShared);
+                MTL::Buffer* pSuppNationKeyBuffer = pDevice->newBuffer(s_nationkey.data(), supplier_size * sizeof(int), MTL::ResourceStorageModeShared);
+                pBuildEnc->setComputePipelineState(pSuppBuildPipe);
+                pBuildEnc->setBuffer(pSuppKeyBuffer, 0, 0); pBuildEnc->setBuffer(pSuppNationKeyBuffer, 0, 1);
+                pBuildEnc->setBuffer(pSuppMapBuffer, 0, 2); pBuildEnc->setBytes(&supplier_size, sizeof(supplier_size), 3);
+                pBuildEnc->setBytes(&supplier_ht_size, sizeof(supplier_ht_size), 4);
+                NS::UInteger threadGroupSize = pSuppBuildPipe->maxTotalThreadsPerThreadgroup();
+                if (threadGroupSize > 256) threadGroupSize = 256;
+                MTL::Size threadgroupSize = MTL::Size(threadGroupSize, 1, 1);
+                MTL::Size threadgroups = MTL::Size((supplier_size + threadGroupSize - 1) / threadGroupSize, 1, 1);
+                pBuildEnc->dispatchThreadgroups(threadgroups, threadgroupSize);
+                pSuppKeyBuffer->release();
+                pSuppNationKeyBuffer->release();
+            }, build);
+
         // Stage 3: PartSupp build
-        pBuildEnc->setComputePipelineState(pPartSuppBuildPipe);
-        pBuildEnc->setBuffer(pPsPartKeyBuffer, 0, 0); pBuildEnc->setBuffer(pPsSuppKeyBuffer, 0, 1);
-        pBuildEnc->setBuffer(pPartSuppHTBuffer, 0, 2); pBuildEnc->setBytes(&partsupp_size, sizeof(partsupp_size), 3);
-        pBuildEnc->setBytes(&partsupp_ht_size, sizeof(partsupp_ht_size), 4);
-        {
-            NS::UInteger threadGroupSize = pPartSuppBuildPipe->maxTotalThreadsPerThreadgroup();
-            if (threadGroupSize > 256) threadGroupSize = 256;
-            MTL::Size threadgroupSize = MTL::Size(threadGroupSize, 1, 1);
-            MTL::Size threadgroups = MTL::Size((partsupp_size + threadGroupSize - 1) / threadGroupSize, 1, 1);
-            pBuildEnc->dispatchThreadgroups(threadgroups, threadgroupSize);
-        }
-        
-        // Stage 4: Orders build
-        pBuildEnc->setComputePipelineState(pOrdersBuildPipe);
-        pBuildEnc->setBuffer(pOrdKeyBuffer, 0, 0); pBuildEnc->setBuffer(pOrdDateBuffer, 0, 1);
-        pBuildEnc->setBuffer(pOrdersHTBuffer, 0, 2); pBuildEnc->setBytes(&orders_size, sizeof(orders_size), 3);
-        pBuildEnc->setBytes(&orders_ht_size, sizeof(orders_ht_size), 4);
-        {
-            NS::UInteger threadGroupSize = pOrdersBuildPipe->maxTotalThreadsPerThreadgroup();
-            if (threadGroupSize > 256) threadGroupSize = 256;
-            MTL::Size threadgroupSize = MTL::Size(threadGroupSize, 1, 1);
-            MTL::Size threadgroups = MTL::Size((orders_size + threadGroupSize - 1) / threadGroupSize, 1, 1);
-            pBuildEnc->dispatchThreadgroups(threadgroups, threadgroupSize);
-        }
-        
-        pBuildEnc->endEncoding();
+        BuildKey psKey{"gpu.q9.partsupp_ht", "partsupp", "ps_partkey,ps_suppkey", "", catalog.tableVersion("partsupp")};
+        auto partSuppHT = getOrBuildGpu(pDevice, pCommandQueue, catalog, psKey, (size_t)partsupp_ht_size * sizeof(int) * 4, 0xFF,
+            [&](MTL::ComputeCommandEncoder* pBuildEnc, MTL::Buffer* pPartSuppHTBuffer) {
+                MTL::Buffer* pPsPartKeyBuffer = pDevice->newBuffer(ps_partkey.data(), partsupp_size * sizeof(int), MTL::ResourceStorageModeShared);
+                MTL::Buffer* pPsSuppKeyBuffer = pDevice->newBuffer(ps_suppkey.data(), partsupp_size * sizeof(int), MTL::ResourceStorageModeShared);
+                pBuildEnc->setComputePipelineState(pPartSuppBuildPipe);
+                pBuildEnc->setBuffer(pPsPartKeyBuffer, 0, 0); pBuildEnc->setBuffer(pPsSuppKeyBuffer, 0, 1);
+                pBuildEnc->setBuffer(pPartSuppHTBuffer, 0, 2); pBuildEnc->setBytes(&partsupp_size, sizeof(partsupp_size), 3);
+                pBuildEnc->setBytes(&partsupp_ht_size, sizeof(partsupp_ht_size), 4);
+                NS::UInteger threadGroupSize = pPartSuppBuildPipe->maxTotalThreadsPerThreadgroup();
+                if (threadGroupSize > 256) threadGroupSize = 256;
+                MTL::Size threadgroupSize = MTL::Size(threadGroupSize, 1, 1);
+                MTL::Size threadgroups = MTL::Size((partsupp_size + threadGroupSize - 1) / threadGroupSize, 1, 1);
+                pBuildEnc->dispatchThreadgroups(threadgroups, threadgroupSize);
+                pPsPartKeyBuffer->release();
+                pPsSuppKeyBuffer->release();
+            }, build);
 
-        // Ensure build phase is complete before probe phase
-        pCommandBuffer->commit();
-        pCommandBuffer->waitUntilCompleted();
-        
-        double buildTime = 0;
-        if (iter == 2) buildTime = pCommandBuffer->GPUEndTime() - pCommandBuffer->GPUStartTime();
-        
-        // Restart command buffer for probe phase
-        pCommandBuffer = pCommandQueue->commandBuffer();
+        // Stage 4: Orders build
+        BuildKey ordersKey{"gpu.q9.orders_ht", "orders", "o_orderkey,o_orderdate", "", orders.version()};
+        auto ordersHT = getOrBuildGpu(pDevice, pCommandQueue, catalog, ordersKey, (size_t)orders_ht_size * sizeof(int) * 2, 0xFF,
+            [&](MTL::ComputeCommandEncoder* pBuildEnc, MTL::Buffer* pOrdersHTBuffer) {
+                MTL::Buffer* pOrdKeyBuffer = pDevice->newBuffer(o_orderkey.data(), orders_size * sizeof(int), MTL::ResourceStorageModeShared);
+                MTL::Buffer* pOrdDateBuffer = pDevice->newBuffer(o_orderdate.data(), orders_size * sizeof(int), MTL::ResourceStorageModeShared);
+                pBuildEnc->setComputePipelineState(pOrdersBuildPipe);
+                pBuildEnc->setBuffer(pOrdKeyBuffer, 0, 0); pBuildEnc->setBuffer(pOrdDateBuffer, 0, 1);
+                pBuildEnc->setBuffer(pOrdersHTBuffer, 0, 2); pBuildEnc->setBytes(&orders_size, sizeof(orders_size), 3);
+                pBuildEnc->setBytes(&orders_ht_size, sizeof(orders_ht_size), 4);
+                NS::UInteger threadGroupSize = pOrdersBuildPipe->maxTotalThreadsPerThreadgroup();
+                if (threadGroupSize > 256) threadGroupSize = 256;
+                MTL::Size threadgroupSize = MTL::Size(threadGroupSize, 1, 1);
+                MTL::Size threadgroups = MTL::Size((orders_size + threadGroupSize - 1) / threadGroupSize, 1, 1);
+                pBuildEnc->dispatchThreadgroups(threadgroups, threadgroupSize);
+                pOrdKeyBuffer->release();
+                pOrdDateBuffer->release();
+            }, build);
+
+        MTL::Buffer* pPartBitmapBuffer = partBitmap->buffer;
+        MTL::Buffer* pSuppMapBuffer = suppMap->buffer;
+        MTL::Buffer* pPartSuppHTBuffer = partSuppHT->buffer;
+        MTL::Buffer* pOrdersHTBuffer = ordersHT->buffer;
+        buildTimer.record(build);
+        buildMs = build.ms;
+        buildSpan.close();
+
+        // Probe phase in its own command buffer, after the builds completed
+        MTL::CommandBuffer* pCommandBuffer = pCommandQueue->commandBuffer();
+        TraceSpan probeSpan("q9 probe", "probe");
 
         // Encoder 2: Probe & Merge Phase (Stages 5-6)
         // Splitting encoders ensures memory consistency between builds and probe
@@ -1248,7 +1664,7 @@ void runQ9Benchmark(MTL::Device* pDevice, MTL::CommandQueue* pCommandQueue, MTL:
         pProbeEnc->setBuffer(pPartBitmapBuffer, 0, 7); // Bitmap
         pProbeEnc->setBuffer(pSuppMapBuffer, 0, 8);    // Direct Map
         pProbeEnc->setBuffer(pPartSuppHTBuffer, 0, 9);
-        pProbeEnc->setBuffer(pOrdersHTBuffer, 0, 10); pProbeEnc->setBuffer(pIntermediateBuffer, 0, 11);
+        pProbeEnc->setBuffer(pOrdersHTBuffer, 0, 10); pProbeEnc->setBuffer(intermediateHT.buffer, intermediateHT.offset, 11);
         pProbeEnc->setBytes(&lineitem_size, sizeof(lineitem_size), 12); pProbeEnc->setBytes(&part_ht_size, sizeof(part_ht_size), 13);
         pProbeEnc->setBytes(&supplier_ht_size, sizeof(supplier_ht_size), 14); pProbeEnc->setBytes(&partsupp_ht_size, sizeof(partsupp_ht_size), 15);
         pProbeEnc->setBytes(&orders_ht_size, sizeof(orders_ht_size), 16);
@@ -1256,7 +1672,7 @@ void runQ9Benchmark(MTL::Device* pDevice, MTL::CommandQueue* pCommandQueue, MTL:
         
         // Stage 6: Merge
         pProbeEnc->setComputePipelineState(pMergePipe);
-        pProbeEnc->setBuffer(pIntermediateBuffer, 0, 0); pProbeEnc->setBuffer(pFinalHTBuffer, 0, 1);
+        pProbeEnc->setBuffer(intermediateHT.buffer, intermediateHT.offset, 0); pProbeEnc->setBuffer(finalHT.buffer, finalHT.offset, 1);
         pProbeEnc->setBytes(&intermediate_size, sizeof(intermediate_size), 2); pProbeEnc->setBytes(&final_ht_size, sizeof(final_ht_size), 3);
         pProbeEnc->dispatchThreads(MTL::Size(intermediate_size, 1, 1), MTL::Size(1024, 1, 1));
         
@@ -1265,15 +1681,16 @@ void runQ9Benchmark(MTL::Device* pDevice, MTL::CommandQueue* pCommandQueue, MTL:
         // Execute and time total Q9
         pCommandBuffer->commit();
         pCommandBuffer->waitUntilCompleted();
+        arena.collectZeroTime();
         
-        if (iter == 2) {
-            q9_gpu_compute_time = buildTime + (pCommandBuffer->GPUEndTime() - pCommandBuffer->GPUStartTime());
-        }
+        loop.record((pCommandBuffer->GPUEndTime() - pCommandBuffer->GPUStartTime()) * 1000.0);
     }
+    q9_gpu_compute_time = loop.stats().median / 1000.0;
 
     // 6. CPU post-processing: read, aggregate, and sort results
     auto q9_cpu_post_start = std::chrono::high_resolution_clock::now();
-    Q9Aggregates_CPU* results = (Q9Aggregates_CPU*)pFinalHTBuffer->contents();
+    TraceSpan postSpan("q9 post", "post");
+    Q9Aggregates_CPU* results = finalHT.data<Q9Aggregates_CPU>();
     std::vector<Q9Result> final_results;
     for (uint i = 0; i < final_ht_size; ++i) {
         if (results[i].key != 0) {
@@ -1311,11 +1728,22 @@ void runQ9Benchmark(MTL::Device* pDevice, MTL::CommandQueue* pCommandQueue, MTL:
         printf("| %6d | %13.4f |\n", kv.first, kv.second);
     }
     printf("+--------+---------------+\n");
+    postSpan.close();
     auto q9_cpu_post_end = std::chrono::high_resolution_clock::now();
     double q9_cpu_ms = std::chrono::duration<double, std::milli>(q9_cpu_post_end - q9_cpu_post_start).count();
+    buildTimer.print("Q9");
+    loop.print("Q9 GPU time");
+    arena.printStats("Q9 scratch");
     printf("Total TPC-H Q9 GPU time: %0.2f ms\n", q9_gpu_compute_time * 1000.0);
     printf("Q9 CPU time: %0.2f ms\n", q9_cpu_ms);
-    printf("Total TPC-H Q9 wall-clock: %0.2f ms\n", q9_gpu_compute_time * 1000.0 + q9_cpu_ms);
+    printf("Total TPC-H Q9 wall-clock: %0.2f ms\n", buildMs + q9_gpu_compute_time * 1000.0 + q9_cpu_ms);
+    if (g_results.enabled()) {
+        ResultRecord rec = tpchResult("q9", "gpu", describe(params), loop, catalog, final_results.size());
+        rec.addBuildStages(buildTimer);
+        rec.stages.emplace_back("probe", q9_gpu_compute_time * 1000.0);
+        rec.stages.emplace_back("post", q9_cpu_ms);
+        g_results.emit(rec);
+    }
     
     // Release all functions and pipelines
     pPartBuildFn->release();
@@ -1332,27 +1760,13 @@ void runQ9Benchmark(MTL::Device* pDevice, MTL::CommandQueue* pCommandQueue, MTL:
     pMergePipe->release();
     
     // Release all buffers
-    pPartKeyBuffer->release();
-    pPartNameBuffer->release();
-    pPartBitmapBuffer->release();
-    pSuppKeyBuffer->release();
-    pSuppNationKeyBuffer->release();
-    pSuppMapBuffer->release();
-    pPsPartKeyBuffer->release();
-    pPsSuppKeyBuffer->release();
     pPsSupplyCostBuffer->release();
-    pPartSuppHTBuffer->release();
-    pOrdKeyBuffer->release();
-    pOrdDateBuffer->release();
-    pOrdersHTBuffer->release();
     pLinePartKeyBuffer->release();
     pLineSuppKeyBuffer->release();
     pLineOrdKeyBuffer->release();
     pLineQtyBuffer->release();
     pLinePriceBuffer->release();
     pLineDiscBuffer->release();
-    pIntermediateBuffer->release();
-    pFinalHTBuffer->release();
 }
 
 
@@ -1374,15 +1788,16 @@ struct Q13Result {
 
 
 // --- Main Function for TPC-H Q13 Benchmark ---
-void runQ13Benchmark(MTL::Device* pDevice, MTL::CommandQueue* pCommandQueue, MTL::Library* pLibrary) {
+void runQ13Benchmark(MTL::Device* pDevice, MTL::CommandQueue* pCommandQueue, MTL::Library* pLibrary, ColumnCatalog& catalog, const Q13Params& params) {
     std::cout << "\n--- Running TPC-H Query 13 Benchmark ---" << std::endl;
+    std::cout << "Parameters: " << describe(params) << std::endl;
 
-    const std::string sf_path = g_dataset_path;
     
     // 1. Load data
-    auto o_custkey = loadIntColumn(sf_path + "orders.tbl", 1);
-    auto o_comment = loadCharColumn(sf_path + "orders.tbl", 8, 100);
-    auto c_custkey = loadIntColumn(sf_path + "customer.tbl", 0);
+    const TableSnapshot orders = catalog.snapshot("orders");
+    const auto o_custkey = orders.intColumn(1);
+    const auto o_comment = orders.charColumn(8, 100);
+    const auto c_custkey = catalog.intColumn("customer", 0);
 
     const uint orders_size = (uint)o_custkey.size();
     const uint customer_size = (uint)c_custkey.size();
@@ -1399,45 +1814,57 @@ void runQ13Benchmark(MTL::Device* pDevice, MTL::CommandQueue* pCommandQueue, MTL
     MTL::Buffer* pOrdCommentBuffer = pDevice->newBuffer(o_comment.data(), o_comment.size() * sizeof(char), MTL::ResourceStorageModeShared);
 
     // Direct mapping output: per-customer order counts (index = custkey - 1).
-    std::vector<uint> cpu_counts_per_customer(customer_size, 0u);
-    MTL::Buffer* pCountsPerCustomerBuffer = pDevice->newBuffer(cpu_counts_per_customer.data(), customer_size * sizeof(uint), MTL::ResourceStorageModeShared);
+    GpuArena arena(pDevice, GpuArena::align(customer_size * sizeof(uint)));
+    const GpuSlice countsPerCustomer = arena.allocZeroed(customer_size * sizeof(uint));
+
+    // o_comment NOT LIKE '%WORD1%WORD2%'
+    const uint word1_len = (uint)params.word1.size();
+    const uint word2_len = (uint)params.word2.size();
 
     // 4. Dispatch the fused GPU stage
     double gpuExecutionTime = 0.0;
     
-    for(int iter = 0; iter < 3; ++iter) {
+    BenchLoop loop;
+    while (loop.next()) {
         // Reset output buffer
-        std::memset(pCountsPerCustomerBuffer->contents(), 0, customer_size * sizeof(uint));
+        arena.zero(pCommandQueue);
         
         MTL::CommandBuffer* pCommandBuffer = pCommandQueue->commandBuffer();
+        TraceSpan countSpan("q13 count", "probe");
         
         // Single encoder
         MTL::ComputeCommandEncoder* enc = pCommandBuffer->computeCommandEncoder();
         enc->setComputePipelineState(pFusedCountPipe);
         enc->setBuffer(pOrdCustKeyBuffer, 0, 0);
         enc->setBuffer(pOrdCommentBuffer, 0, 1);
-        enc->setBuffer(pCountsPerCustomerBuffer, 0, 2);
+        enc->setBuffer(countsPerCustomer.buffer, countsPerCustomer.offset, 2);
         enc->setBytes(&orders_size, sizeof(orders_size), 3);
         enc->setBytes(&customer_size, sizeof(customer_size), 4);
+        enc->setBytes(params.word1.data(), word1_len, 5);
+        enc->setBytes(&word1_len, sizeof(word1_len), 6);
+        enc->setBytes(params.word2.data(), word2_len, 7);
+        enc->setBytes(&word2_len, sizeof(word2_len), 8);
         enc->dispatchThreadgroups(MTL::Size(num_threadgroups, 1, 1), MTL::Size(1024, 1, 1));
         enc->endEncoding();
 
         // 5. Execute GPU work
         pCommandBuffer->commit();
         pCommandBuffer->waitUntilCompleted();
+        arena.collectZeroTime();
         
-        if (iter == 2) {
-            gpuExecutionTime = pCommandBuffer->GPUEndTime() - pCommandBuffer->GPUStartTime();
-        }
+        loop.record((pCommandBuffer->GPUEndTime() - pCommandBuffer->GPUStartTime()) * 1000.0);
     }
+    gpuExecutionTime = loop.stats().median / 1000.0;
 
     // 6. Perform final merge on CPU (authoritative): build histogram by scanning per-customer counts.
     auto q13_cpu_merge_start = std::chrono::high_resolution_clock::now();
+    TraceSpan mergeSpan("q13 merge", "merge");
     std::map<uint, uint> final_histogram;
-    auto* counts_per_customer = (uint*)pCountsPerCustomerBuffer->contents();
+    auto* counts_per_customer = countsPerCustomer.data<uint>();
     for (uint i = 0; i < customer_size; ++i) {
         final_histogram[counts_per_customer[i]] += 1;
     }
+    mergeSpan.close();
     auto q13_cpu_merge_end = std::chrono::high_resolution_clock::now();
     double q13_cpu_merge_time = std::chrono::duration<double>(q13_cpu_merge_end - q13_cpu_merge_start).count();
 
@@ -1460,40 +1887,153 @@ void runQ13Benchmark(MTL::Device* pDevice, MTL::CommandQueue* pCommandQueue, MTL
         printf("| %7u | %8u |\n", res.c_count, res.custdist);
     }
     printf("+---------+----------+\n");
+    loop.print("Q13 GPU time");
+    arena.printStats("Q13 scratch");
     printf("Total TPC-H Q13 GPU time: %0.2f ms\n", gpuExecutionTime * 1000.0);
     printf("Q13 CPU time: %0.2f ms\n", q13_cpu_merge_time * 1000.0);
     printf("Total TPC-H Q13 wall-clock: %0.2f ms\n", (gpuExecutionTime + q13_cpu_merge_time) * 1000.0);
+    if (g_results.enabled()) {
+        ResultRecord rec = tpchResult("q13", "gpu", describe(params), loop, catalog, final_results.size());
+        rec.stages.emplace_back("count", gpuExecutionTime * 1000.0);
+        rec.stages.emplace_back("merge", q13_cpu_merge_time * 1000.0);
+        g_results.emit(rec);
+    }
 
     // Release objects...
     pFusedCountFn->release();
     pFusedCountPipe->release();
     pOrdCustKeyBuffer->release();
     pOrdCommentBuffer->release();
-    pCountsPerCustomerBuffer->release();
 }
 
 
+#endif // GPUDB_CPU_ONLY
+
+
+// "1,2,4" -> {"1", "2", "4"}; empty items are dropped.
+std::vector<std::string> splitList(const std::string& list) {
+    std::vector<std::string> items;
+    size_t begin = 0;
+    while (begin <= list.size()) {
+        size_t end = list.find(',', begin);
+        if (end == std::string::npos) end = list.size();
+        if (end > begin) items.push_back(list.substr(begin, end - begin));
+        begin = end + 1;
+    }
+    return items;
+}
+
+// --- Column Statistics Listing ---
+// The statistics the planners size their structures from, for the key and date columns the queries use.
+void printTpchColumnStats(ColumnCatalog& catalog) {
+    struct Column { const char* table; int index; const char* name; bool date; };
+    static const Column kColumns[] = {
+        {"customer", 0, "c_custkey", false}, {"orders", 0, "o_orderkey", false}, {"orders", 1, "o_custkey", false},
+        {"orders", 4, "o_orderdate", true}, {"lineitem", 0, "l_orderkey", false}, {"lineitem", 1, "l_partkey", false},
+        {"lineitem", 2, "l_suppkey", false}, {"lineitem", 10, "l_shipdate", true}, {"part", 0, "p_partkey", false},
+        {"supplier", 0, "s_suppkey", false}, {"supplier", 3, "s_nationkey", false}, {"partsupp", 0, "ps_partkey", false},
+        {"partsupp", 1, "ps_suppkey", false},
+    };
+    std::cout << "\n--- Column Statistics ---" << std::endl;
+    std::vector<std::pair<std::string, ColumnStats>> columns;
+    for (const Column& c : kColumns) {
+        columns.emplace_back(c.name, c.date ? catalog.dateStats(c.table, c.index) : catalog.intStats(c.table, c.index));
+    }
+    printColumnStats(columns);
+}
+
 void showHelp() {
     std::cout << "GPU Database Metal Benchmark" << std::endl;
-    std::cout << "Usage: GPUDBMetalBenchmark [sf1|sf10] [query]" << std::endl;
+    std::cout << "Usage: GPUDBMetalBenchmark [sf<N>] [query] [options]   (sf<N> reads data/SF-<N>/, e.g. sf1, sf10, sf0.1)" << std::endl;
     std::cout << "" << std::endl;
     std::cout << "Available queries:" << std::endl;
     std::cout << "  all           - Run all benchmarks (default)" << std::endl;
-    std::cout << "  selection     - Run selection benchmark" << std::endl;
-    std::cout << "  aggregation   - Run aggregation benchmark" << std::endl;
-    std::cout << "  join          - Run join benchmark" << std::endl;
+    std::cout << "  selection     - Selection output modes (flags, bitmap, row ids, materialized) over a selectivity sweep (GPU only)" << std::endl;
+    std::cout << "  aggregation   - Run aggregation benchmark (GPU only)" << std::endl;
+    std::cout << "  join          - Run join benchmark (GPU only)" << std::endl;
+    std::cout << "  join-dist     - Join build/probe over synthetic keys, one parameter swept at a time" << std::endl;
+    std::cout << "  aggregation-dist - GROUP BY aggregation over synthetic keys, one parameter swept at a time" << std::endl;
     std::cout << "  q1            - Run TPC-H Query 1 (Pricing Summary Report)" << std::endl;
     std::cout << "  q3            - Run TPC-H Query 3 (Shipping Priority)" << std::endl;
     std::cout << "  q6            - Run TPC-H Query 6 (Forecasting Revenue Change)" << std::endl;
     std::cout << "  q9            - Run TPC-H Query 9 (Product Type Profit Measure)" << std::endl;
     std::cout << "  q13           - Run TPC-H Query 13 (Customer Distribution)" << std::endl;
+    std::cout << "  throughput    - Run the TPC-H throughput test (concurrent query streams)" << std::endl;
+    std::cout << "  refresh       - Run RF1/RF2 refresh sets, then a background delta merge" << std::endl;
+    std::cout << "  incremental   - Maintain Q1/Q6 results under refresh sets (CPU backend)" << std::endl;
+    std::cout << "  sweep         - Scale-factor x thread-count sweep with scaling efficiency (CPU backend)" << std::endl;
+    std::cout << "  tune          - Search threads, morsel size, prefetch distance and local table size per query; write the tuning profile (CPU backend)" << std::endl;
+    std::cout << "  stats         - Column statistics (min, max, HyperLogLog distinct count, histogram quartiles) of the TPC-H key and date columns" << std::endl;
+    std::cout << "  generate      - Generate TPC-H data at --gen-sf as binary columns (no dbgen, no .tbl)" << std::endl;
     std::cout << "  help          - Show this help message" << std::endl;
     std::cout << "" << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "  --seed <n>        - Draw qgen-style random substitution parameters from seed n" << std::endl;
+    std::cout << "                      (default: TPC-H validation parameters)" << std::endl;
+    std::cout << "  --param-sets <n>  - Run each TPC-H query with n parameter sets (default: 1)" << std::endl;
+    std::cout << "  --backend <b>     - gpu (default) or cpu (morsel-driven worker pool)" << std::endl;
+    std::cout << "  --threads <n>     - CPU backend worker threads (default: hardware concurrency)" << std::endl;
+    std::cout << "  --numa <policy>   - Column pages on NUMA nodes: off (first touch), interleave, partition (node-local morsels, pinned)" << std::endl;
+    std::cout << "  --pin-threads     - Pin CPU workers round-robin over the NUMA nodes" << std::endl;
+    std::cout << "  --huge-pages <m>  - Huge pages for build tables, scratch and columns: off, thp, 2m, 1g (MAP_HUGETLB, THP fallback)" << std::endl;
+    std::cout << "  --huge-page-min-mb <n> - Smallest allocation put on huge pages (default: 2)" << std::endl;
+    std::cout << "  --memory-budget-mb <n> - Per-query join/aggregation memory on the CPU backend; Q3 and Q13 partition and spill above it (default: 0 = unlimited)" << std::endl;
+    std::cout << "  --spill-dir <path>   - Directory for spill files (default: /tmp)" << std::endl;
+    std::cout << "  --read-backend <b>   - Column file reads: uring (Linux default, falls back to threads), threads (pread per in-flight block), sync" << std::endl;
+    std::cout << "  --read-depth <n>     - Column file reads in flight while earlier blocks are parsed (default: 4)" << std::endl;
+    std::cout << "  --read-block-kb <n>  - Column file read size (default: 4096)" << std::endl;
+    std::cout << "  --direct-io          - Read column files with O_DIRECT (F_NOCACHE on macOS) for cold-cache loads" << std::endl;
+    std::cout << "  --materialization <m> - CPU Q3 payload columns: early (copied through the probe) or late (position lists, fetched for the top 10)" << std::endl;
+    std::cout << "  --join <s>        - CPU Q3/Q9 orders join: map (direct map probes), merge (co-partitioned merge join over the orderkey-sorted tables) or index (persisted lineitem foreign-key indexes, Q9 also for supplier/partsupp)" << std::endl;
+    std::cout << "  --streams <n>     - Concurrent query streams for 'throughput' (default: 2)" << std::endl;
+    std::cout << "  --build-cache-mb <n> - Budget for cached join build structures (default: 4096, 0 = off)" << std::endl;
+    std::cout << "  --warmup <n>         - Unmeasured executions before measuring (default: 2)" << std::endl;
+    std::cout << "  --reps <n>           - Measured executions; times reported are their median (default: 1)" << std::endl;
+    std::cout << "  --time-budget-ms <t> - Keep measuring until t ms are spent (at least --reps samples)" << std::endl;
+    std::cout << "  --cold               - Evict CPU caches with a flush buffer before every execution" << std::endl;
+    std::cout << "  --flush-mb <n>       - Flush buffer size for --cold (default: 256)" << std::endl;
+    std::cout << "  --keep-outliers      - Do not reject samples outside Tukey's fences" << std::endl;
+    std::cout << "  --results <path>     - Append one JSON/CSV record per query run to path ('-' = stdout)" << std::endl;
+    std::cout << "  --results-format <f> - json (JSON Lines) or csv (default: from the file extension, else json)" << std::endl;
+    std::cout << "  --trace <path>       - Write load/build/probe/merge spans as a Chrome trace (chrome://tracing, Perfetto)" << std::endl;
+    std::cout << "  --perf-counters      - Per-stage cycles, instructions, LLC/dTLB/branch misses (CPU backend, Linux)" << std::endl;
+    std::cout << "  --roofline           - Measure copy/triad bandwidth and latency, report each stage's share of peak (CPU backend)" << std::endl;
+    std::cout << "  --roofline-mb <n>    - Size of each STREAM array and of the latency probe (default: 128)" << std::endl;
+    std::cout << "  --sweep-sf <list>    - Scale factors for 'sweep', read from data/SF-<sf>/ (default: current dataset)" << std::endl;
+    std::cout << "  --sweep-threads <list> - Thread counts for 'sweep' (default: 1, 2, 4, ... all cores)" << std::endl;
+    std::cout << "  --sweep-queries <list> - Queries for 'sweep' (default: q1,q3,q6,q9,q13)" << std::endl;
+    std::cout << "  --tune-budget <n>    - Configurations 'tune' times per query, the defaults included (default: 12)" << std::endl;
+    std::cout << "  --tune-reps <n>      - Timed executions per configuration, best of (default: 3)" << std::endl;
+    std::cout << "  --tune-queries <list> - Queries for 'tune' (default: q1,q3,q6,q9,q13)" << std::endl;
+    std::cout << "  --tune-profile <path> - Tuning profile written by 'tune' and loaded by CPU runs (default: cpu-tuning.profile; none = off)" << std::endl;
+    std::cout << "  --gen-sf <sf>        - Scale factor for 'generate'; with any other query, generate it in memory" << std::endl;
+    std::cout << "  --gen-dir <path>     - Output directory for 'generate' (default: data/SF-<sf>/)" << std::endl;
+    std::cout << "  --dist-sweep <list>  - Parameters swept by join-dist/aggregation-dist: theta,stride,ratio,match,groups (default: all)" << std::endl;
+    std::cout << "  --zipf-theta <t>     - Base Zipf skew of probe/group keys (default: 0 = uniform)" << std::endl;
+    std::cout << "  --key-stride <n>     - Base spacing of the key domain (default: 1 = dense)" << std::endl;
+    std::cout << "  --build-rows <n>     - Build rows for join-dist (default: 1048576)" << std::endl;
+    std::cout << "  --probe-ratio <r>    - Probe rows per build row for join-dist (default: 4)" << std::endl;
+    std::cout << "  --match-rate <f>     - Fraction of probe rows with a build match (default: 1)" << std::endl;
+    std::cout << "  --agg-rows <n>       - Rows for aggregation-dist (default: 8388608)" << std::endl;
+    std::cout << "  --groups <n>         - Base group count for aggregation-dist (default: 65536)" << std::endl;
+    std::cout << "  --refresh-sets <n>   - Refresh sets applied by 'refresh' before the merge (default: 2)" << std::endl;
+    std::cout << "  --refresh-orders <n> - Orders inserted/deleted per refresh set (default: orders / 1000)" << std::endl;
+    std::cout << "" << std::endl;
     std::cout << "Examples:" << std::endl;
     std::cout << "  GPUDBMetalBenchmark        # Run all benchmarks" << std::endl;
     std::cout << "  GPUDBMetalBenchmark q1     # Run only TPC-H Query 1" << std::endl;
     std::cout << "  GPUDBMetalBenchmark q3     # Run only TPC-H Query 3" << std::endl;
     std::cout << "  GPUDBMetalBenchmark sf10 q13  # Run Q13 on SF-10" << std::endl;
+    std::cout << "  GPUDBMetalBenchmark q6 --seed 7 --param-sets 5  # Q6 over 5 random parameter sets" << std::endl;
+    std::cout << "  GPUDBMetalBenchmark throughput --streams 4 --seed 1  # 4 concurrent streams" << std::endl;
+    std::cout << "  GPUDBMetalBenchmark q9 --backend cpu --threads 8     # Q9 on 8 CPU threads" << std::endl;
+    std::cout << "  GPUDBMetalBenchmark refresh --refresh-sets 4         # Query slowdown under RF1/RF2" << std::endl;
+    std::cout << "  GPUDBMetalBenchmark q1 --warmup 3 --reps 30          # Q1 latency distribution" << std::endl;
+    std::cout << "  GPUDBMetalBenchmark all --results results.jsonl      # Machine-readable records" << std::endl;
+    std::cout << "  GPUDBMetalBenchmark sweep --backend cpu --sweep-sf 1,10 --sweep-threads 1,2,4,8" << std::endl;
+    std::cout << "  GPUDBMetalBenchmark tune --backend cpu --tune-budget 8  # Tune, then plain CPU runs load cpu-tuning.profile" << std::endl;
+    std::cout << "  GPUDBMetalBenchmark join-dist --dist-sweep theta,match --probe-ratio 16  # Skewed, partial-match joins" << std::endl;
+    std::cout << "  GPUDBMetalBenchmark generate --gen-sf 100            # Write data/SF-100/ binary columns" << std::endl;
 }
 
 // --- Main Entry Point ---
@@ -1504,24 +2044,349 @@ int main(int argc, const char * argv[]) {
     //   GPUDBMetalBenchmark sf10 q13
     //   GPUDBMetalBenchmark q13 sf10
     std::string query = "all"; // default to running all benchmarks
+    bool use_random_params = false;
+    uint64_t param_seed = 0;
+    int param_sets = 1;
+#ifdef GPUDB_CPU_ONLY
+    std::string backend = "cpu";
+#else
+    std::string backend = "gpu";
+#endif
+    unsigned cpu_threads = 0;
+    int streams = 2;
+    size_t build_cache_mb = BuildCache::kDefaultBudgetBytes >> 20;
+    int refresh_sets = 2;
+    size_t refresh_orders = 0;
+    std::string results_path, results_format, trace_path;
+    bool perf_counters = false;
+    size_t roofline_mb = 128;
+    SweepConfig sweep_config;
+    TuneConfig tune_config;
+    std::string gen_sf, gen_dir;
+    MicroSweepConfig dist_config;
     for (int i = 1; i < argc; ++i) {
         std::string arg(argv[i]);
         if (arg == "help" || arg == "--help" || arg == "-h") {
             showHelp();
             return 0;
         }
-        if (arg == "sf1") {
-            g_dataset_path = "data/SF-1/";
+        if (arg == "--cold") { g_harness.coldCache = true; continue; }
+        if (arg == "--keep-outliers") { g_harness.rejectOutliers = false; continue; }
+        if (arg == "--perf-counters") { perf_counters = true; continue; }
+        if (arg == "--pin-threads") { numaConfig().pinWorkers = true; continue; }
+        if (arg == "--direct-io") { asyncReadConfig().direct = true; continue; }
+        if (arg == "--roofline") { g_rooflineEnabled.store(true); continue; }
+        if ((arg == "--seed" || arg == "--param-sets" || arg == "--backend" || arg == "--threads" || arg == "--streams" ||
+             arg == "--build-cache-mb" || arg == "--refresh-sets" || arg == "--refresh-orders" || arg == "--warmup" ||
+             arg == "--reps" || arg == "--time-budget-ms" || arg == "--flush-mb" || arg == "--results" ||
+             arg == "--results-format" || arg == "--trace" || arg == "--roofline-mb" || arg == "--sweep-sf" ||
+             arg == "--sweep-threads" || arg == "--sweep-queries" || arg == "--gen-sf" || arg == "--gen-dir" || arg == "--dist-sweep" || arg == "--zipf-theta" ||
+             arg == "--key-stride" || arg == "--build-rows" || arg == "--probe-ratio" || arg == "--match-rate" ||
+             arg == "--agg-rows" || arg == "--groups" || arg == "--numa" || arg == "--huge-pages" || arg == "--huge-page-min-mb" ||
+             arg == "--memory-budget-mb" || arg == "--spill-dir" || arg == "--materialization" || arg == "--join" ||
+             arg == "--tune-budget" || arg == "--tune-reps" || arg == "--tune-queries" || arg == "--tune-profile" ||
+             arg == "--read-backend" || arg == "--read-depth" || arg == "--read-block-kb") && i + 1 < argc) {
+            std::string value(argv[++i]);
+            if (arg == "--seed") { param_seed = std::stoull(value); use_random_params = true; }
+            else if (arg == "--param-sets") { param_sets = std::max(1, std::stoi(value)); }
+            else if (arg == "--backend") { backend = value; }
+            else if (arg == "--threads") { cpu_threads = (unsigned)std::max(0, std::stoi(value)); }
+            else if (arg == "--streams") { streams = std::max(1, std::stoi(value)); }
+            else if (arg == "--build-cache-mb") { build_cache_mb = std::stoull(value); }
+            else if (arg == "--refresh-sets") { refresh_sets = std::max(1, std::stoi(value)); }
+            else if (arg == "--refresh-orders") { refresh_orders = std::stoull(value); }
+            else if (arg == "--warmup") { g_harness.warmup = std::max(0, std::stoi(value)); }
+            else if (arg == "--reps") { g_harness.repetitions = std::max(1, std::stoi(value)); }
+            else if (arg == "--time-budget-ms") { g_harness.timeBudgetMs = std::max(0.0, std::stod(value)); }
+            else if (arg == "--results") { results_path = value; }
+            else if (arg == "--results-format") { results_format = value; }
+            else if (arg == "--trace") { trace_path = value; }
+            else if (arg == "--roofline-mb") { roofline_mb = std::max<size_t>(1, std::stoull(value)); }
+            else if (arg == "--sweep-sf") { sweep_config.scaleFactors = splitList(value); }
+            else if (arg == "--sweep-threads") {
+                sweep_config.threads.clear();
+                for (const auto& t : splitList(value)) sweep_config.threads.push_back((unsigned)std::max(1, std::stoi(t)));
+            }
+            else if (arg == "--sweep-queries") { sweep_config.queries = splitList(value); }
+            else if (arg == "--tune-budget") { tune_config.budget = (unsigned)std::max(1, std::stoi(value)); }
+            else if (arg == "--tune-reps") { tune_config.reps = (unsigned)std::max(1, std::stoi(value)); }
+            else if (arg == "--tune-queries") { tune_config.queries = splitList(value); }
+            else if (arg == "--tune-profile") { tune_config.profilePath = value; }
+            else if (arg == "--gen-sf") { gen_sf = value; }
+            else if (arg == "--gen-dir") { gen_dir = value; }
+            else if (arg == "--dist-sweep") { dist_config.parameters = splitList(value); }
+            else if (arg == "--zipf-theta") { dist_config.join.zipfTheta = dist_config.aggregation.zipfTheta = std::max(0.0, std::stod(value)); }
+            else if (arg == "--key-stride") { dist_config.join.keyStride = dist_config.aggregation.keyStride = (uint32_t)std::max(1, std::stoi(value)); }
+            else if (arg == "--build-rows") { dist_config.join.buildRows = std::max<size_t>(1, std::stoull(value)); }
+            else if (arg == "--probe-ratio") { dist_config.join.probeRatio = std::max(0.0, std::stod(value)); }
+            else if (arg == "--match-rate") { dist_config.join.matchRate = std::clamp(std::stod(value), 0.0, 1.0); }
+            else if (arg == "--agg-rows") { dist_config.aggregation.rows = std::max<size_t>(1, std::stoull(value)); }
+            else if (arg == "--groups") { dist_config.aggregation.groups = std::max<size_t>(1, std::stoull(value)); }
+            else if (arg == "--numa") {
+                if (!parseNumaPolicy(value, numaConfig().policy)) {
+                    std::cerr << "Unknown NUMA policy: " << value << " (expected off, interleave or partition)" << std::endl;
+                    return 1;
+                }
+            }
+            else if (arg == "--huge-pages") {
+                if (!parseHugePageMode(value, hugePageConfig().mode)) {
+                    std::cerr << "Unknown huge-page mode: " << value << " (expected off, thp, 2m or 1g)" << std::endl;
+                    return 1;
+                }
+            }
+            else if (arg == "--huge-page-min-mb") { hugePageConfig().minBytes = std::max<size_t>(1, std::stoull(value)) << 20; }
+            else if (arg == "--memory-budget-mb") { memoryBudget().queryBytes = (size_t)(std::max(0.0, std::stod(value)) * (1 << 20)); }
+            else if (arg == "--spill-dir") { memoryBudget().directory = value; }
+            else if (arg == "--read-backend") {
+                if (!parseReadBackend(value, asyncReadConfig().backend)) {
+                    std::cerr << "Unknown read backend: " << value << " (expected sync, threads or uring)" << std::endl;
+                    return 1;
+                }
+            }
+            else if (arg == "--read-depth") { asyncReadConfig().queueDepth = (unsigned)std::max(1, std::stoi(value)); }
+            else if (arg == "--read-block-kb") { asyncReadConfig().blockBytes = std::max<size_t>(4, std::stoull(value)) << 10; }
+            else if (arg == "--materialization") {
+                if (!parseMaterialization(value, cpuMaterialization())) {
+                    std::cerr << "Unknown materialization: " << value << " (expected early or late)" << std::endl;
+                    return 1;
+                }
+                cpuMaterializationRequested() = true;
+            }
+            else if (arg == "--join") {
+                if (!parseJoinStrategy(value, cpuJoinStrategy())) {
+                    std::cerr << "Unknown join strategy: " << value << " (expected map, merge or index)" << std::endl;
+                    return 1;
+                }
+            }
+            else { g_harness.flushBytes = std::max<size_t>(1, std::stoull(value)) << 20; }
             continue;
         }
-        if (arg == "sf10") {
-            g_dataset_path = "data/SF-10/";
-            continue;
+        // sf<N>: the dataset in data/SF-<N>/ (sf1, sf10, or any scale factor 'generate' wrote)
+        if (arg.size() > 2 && arg.compare(0, 2, "sf") == 0) {
+            char* end = nullptr;
+            const double sf = std::strtod(arg.c_str() + 2, &end);
+            if (*end == '\0' && sf > 0.0) {
+                g_dataset_path = "data/SF-" + arg.substr(2) + "/";
+                continue;
+            }
         }
         // Otherwise treat as the query selector.
         query = arg;
     }
+    if (backend != "gpu" && backend != "cpu") {
+        std::cerr << "Unknown backend: " << backend << " (expected gpu or cpu)" << std::endl;
+        return 1;
+    }
+#ifdef GPUDB_CPU_ONLY
+    if (backend == "gpu") {
+        std::cerr << "This build has no Metal support; use --backend cpu" << std::endl;
+        return 1;
+    }
+#endif
+    if (!results_path.empty()) {
+        if (results_format.empty()) {
+            results_format = results_path.size() >= 4 && results_path.compare(results_path.size() - 4, 4, ".csv") == 0 ? "csv" : "json";
+        }
+        if (results_format != "json" && results_format != "csv") {
+            std::cerr << "Unknown results format: " << results_format << " (expected json or csv)" << std::endl;
+            return 1;
+        }
+        if (!g_results.open(results_path, results_format == "csv" ? ResultFormat::Csv : ResultFormat::Json)) {
+            std::cerr << "Cannot open results file: " << results_path << std::endl;
+            return 1;
+        }
+    }
+    // Written on every exit path, after the worker pool has been joined
+    struct TraceWriter { ~TraceWriter() { finishTrace(); } } trace_writer;
+    if (!trace_path.empty()) {
+        if (!startTrace(trace_path)) {
+            std::cerr << "Cannot create trace file: " << trace_path << std::endl;
+            return 1;
+        }
+        setTraceThreadName("main");
+    }
+    // Before the WorkerPool starts, so every worker opens its own counter group
+    std::string perf_error;
+    if (perf_counters && !startPerfCounters(perf_error)) {
+        std::cerr << "Hardware counters unavailable: " << perf_error << "; continuing without them" << std::endl;
+    }
+    // Peak bandwidth and latency of this machine, measured once before any data is loaded
+    if (rooflineEnabled()) {
+        WorkerPool probe_pool(cpu_threads);
+        g_machine = measureMachine(probe_pool, roofline_mb << 20);
+        printMachineProfile(g_machine);
+    }
 
+    // Data generation: write binary columns and exit, or (below) generate into memory
+    if (!gen_sf.empty() && !(std::strtod(gen_sf.c_str(), nullptr) > 0.0)) {
+        std::cerr << "Invalid --gen-sf: " << gen_sf << std::endl;
+        return 1;
+    }
+    if (query == "generate") {
+        if (gen_sf.empty()) {
+            std::cerr << "'generate' needs --gen-sf <sf>" << std::endl;
+            return 1;
+        }
+        if (gen_dir.empty()) gen_dir = "data/SF-" + gen_sf + "/";
+        if (gen_dir.back() != '/') gen_dir += '/';
+        std::error_code ec;
+        std::filesystem::create_directories(gen_dir, ec);
+        if (ec) {
+            std::cerr << "Cannot create " << gen_dir << ": " << ec.message() << std::endl;
+            return 1;
+        }
+        WorkerPool gen_pool(cpu_threads);
+        std::cout << "\n--- Generating TPC-H SF " << gen_sf << " into " << gen_dir << " (" << gen_pool.size() << " threads) ---" << std::endl;
+        return writeTpch(gen_pool, std::stod(gen_sf), gen_dir) ? 0 : 1;
+    }
+    if (!gen_sf.empty()) g_dataset_path = "data/SF-" + gen_sf + "/";
+
+    // Substitution parameters: validation defaults, or one qgen draw per parameter set
+    std::vector<TpchParams> param_list;
+    QgenParameterGenerator param_gen(param_seed);
+    for (int s = 0; s < param_sets; ++s) {
+        param_list.push_back(use_random_params ? param_gen.next() : TpchParams{});
+    }
+
+    // Columns are loaded once and shared by every query, backend and stream
+    ColumnCatalog catalog(g_dataset_path);
+    catalog.buildCache().setBudgetBytes(build_cache_mb << 20);
+    if (!gen_sf.empty()) {
+        WorkerPool gen_pool(cpu_threads);
+        const auto gen_start = std::chrono::steady_clock::now();
+        for (const auto& [table, data] : generateTpch(gen_pool, std::stod(gen_sf)).tables) catalog.attachMemoryTable(table, data);
+        printf("Generated SF %s in memory in %.2f s\n", gen_sf.c_str(),
+               std::chrono::duration<double>(std::chrono::steady_clock::now() - gen_start).count());
+    }
+    if (query == "stats") {
+        printTpchColumnStats(catalog);
+        return 0;
+    }
+    ThroughputConfig throughput_config;
+    throughput_config.streams = streams;
+    throughput_config.seed = param_seed;
+    throughput_config.scaleFactor = datasetScaleFactor();
+    throughput_config.backend = backend;
+    RefreshConfig refresh_config;
+    refresh_config.refreshSets = refresh_sets;
+    refresh_config.ordersPerSet = refresh_orders;
+    refresh_config.seed = param_seed;
+    refresh_config.backend = backend;
+
+    if (backend == "cpu") {
+        try {
+            // Tuned knobs from an earlier 'tune' run; 'tune' itself starts from the defaults
+            if (query != "tune" && tune_config.profilePath != "none") loadTuningProfile(tune_config.profilePath);
+            WorkerPool pool(cpu_threads);
+            // A query's tuned worker count gets its own pool, unless --threads fixes it
+            std::map<unsigned, std::unique_ptr<WorkerPool>> tuned_pools;
+            auto poolFor = [&](const std::string& q) -> WorkerPool& {
+                const unsigned threads = cpu_threads ? 0 : cpuTuning(q).threads;
+                if (!threads || threads == pool.size()) return pool;
+                auto& tuned = tuned_pools[threads];
+                if (!tuned) tuned = std::make_unique<WorkerPool>(threads);
+                return *tuned;
+            };
+            if (query == "all") {
+                for (const auto& p : param_list) runCpuQ1Benchmark(catalog, poolFor("q1"), p.q1);
+                for (const auto& p : param_list) runCpuQ3Benchmark(catalog, poolFor("q3"), p.q3);
+                for (const auto& p : param_list) runCpuQ6Benchmark(catalog, poolFor("q6"), p.q6);
+                for (const auto& p : param_list) runCpuQ9Benchmark(catalog, poolFor("q9"), p.q9);
+                for (const auto& p : param_list) runCpuQ13Benchmark(catalog, poolFor("q13"), p.q13);
+            } else if (query == "q1") {
+                for (const auto& p : param_list) runCpuQ1Benchmark(catalog, poolFor("q1"), p.q1);
+            } else if (query == "q3") {
+                for (const auto& p : param_list) runCpuQ3Benchmark(catalog, poolFor("q3"), p.q3);
+            } else if (query == "q6") {
+                for (const auto& p : param_list) runCpuQ6Benchmark(catalog, poolFor("q6"), p.q6);
+            } else if (query == "q9") {
+                for (const auto& p : param_list) runCpuQ9Benchmark(catalog, poolFor("q9"), p.q9);
+            } else if (query == "q13") {
+                for (const auto& p : param_list) runCpuQ13Benchmark(catalog, poolFor("q13"), p.q13);
+            } else if (query == "tune") {
+                for (const auto& q : tune_config.queries) {
+                    if (q != "q1" && q != "q3" && q != "q6" && q != "q9" && q != "q13") {
+                        std::cerr << "Unknown query for 'tune': " << q << std::endl;
+                        return 1;
+                    }
+                }
+                if (tune_config.profilePath == "none") {
+                    std::cerr << "'tune' needs a --tune-profile path to write" << std::endl;
+                    return 1;
+                }
+                tune_config.maxThreads = cpu_threads;
+                if (!runAutoTune(tune_config, catalog, param_list.front())) return 1;
+            } else if (query == "throughput") {
+                runThroughputTest(throughput_config, [&](const std::string& q, const TpchParams& p) {
+                    cpuExecuteQuery(q, catalog, pool, p);
+                });
+            } else if (query == "refresh") {
+                // Fingerprints of every query, so the delta-aware scans (main + delta
+                // positions, deleted rows, join fallbacks, spill partitions) are
+                // checked against the recompute over the merged columns
+                auto checksum = [&](const std::string& q) {
+                    TpchParams p;
+                    double sum = 0.0;
+                    if (q == "q1") {
+                        for (const auto& r : cpuExecuteQ1(catalog, pool, p.q1)) sum += (double)r.count + r.sum_qty + r.sum_charge;
+                    } else if (q == "q3") {
+                        size_t groups = 0;
+                        for (const auto& r : cpuExecuteQ3(catalog, pool, p.q3, nullptr, 0, &groups)) sum += r.revenue;
+                        sum += (double)groups;
+                    } else if (q == "q6") {
+                        sum = cpuExecuteQ6(catalog, pool, p.q6);
+                    } else if (q == "q9") {
+                        for (const auto& r : cpuExecuteQ9(catalog, pool, p.q9)) sum += r.profit;
+                    } else if (q == "q13") {
+                        // Hash of the whole (c_count, custdist) histogram in row order; its
+                        // top 53 bits fit a double exactly
+                        uint64_t h = 0xCBF29CE484222325ull;
+                        for (const auto& r : cpuExecuteQ13(catalog, pool, p.q13)) {
+                            for (uint64_t v : {(uint64_t)r.c_count, (uint64_t)r.custdist}) h = (h ^ v) * 0x100000001B3ull;
+                        }
+                        sum = (double)(h >> 11);
+                    } else {
+                        return std::nan("");
+                    }
+                    return sum;
+                };
+                if (!runRefreshTest(catalog, refresh_config, [&](const std::string& q, const TpchParams& p) {
+                    cpuExecuteQuery(q, catalog, pool, p);
+                }, checksum)) return 1;
+            } else if (query == "incremental") {
+                if (!runIncrementalAggregateTest(catalog, pool, refresh_config, param_list)) return 1;
+            } else if (query == "sweep") {
+                for (const auto& q : sweep_config.queries) {
+                    if (q != "q1" && q != "q3" && q != "q6" && q != "q9" && q != "q13") {
+                        std::cerr << "Unknown query for the sweep: " << q << std::endl;
+                        return 1;
+                    }
+                }
+                if (sweep_config.scaleFactors.empty()) {
+                    char sf[32];
+                    snprintf(sf, sizeof(sf), "%g", datasetScaleFactor());
+                    sweep_config.scaleFactors.push_back(sf);
+                }
+                sweep_config.buildCacheBytes = build_cache_mb << 20;
+                runScalingSweep(sweep_config, param_list.front());
+            } else if (query == "join-dist") {
+                if (!runJoinSweep(dist_config, cpuJoinRunner(pool))) return 1;
+            } else if (query == "aggregation-dist") {
+                if (!runAggregationSweep(dist_config, cpuAggregationRunner(pool))) return 1;
+            } else {
+                std::cerr << "Unknown query for the CPU backend: " << query << std::endl;
+                std::cerr << "Use 'help' to see available options." << std::endl;
+                return 1;
+            }
+        } catch (const std::runtime_error& e) {
+            // I/O errors of the spilling plans (full disk, unwritable --spill-dir)
+            std::cerr << "Error: " << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+#ifndef GPUDB_CPU_ONLY
     NS::AutoreleasePool* pAutoreleasePool = NS::AutoreleasePool::alloc()->init();
     
     MTL::Device* device = MTL::CreateSystemDefaultDevice();
@@ -1555,27 +2420,62 @@ int main(int argc, const char * argv[]) {
         runSelectionBenchmark(device, commandQueue, library);
         runAggregationBenchmark(device, commandQueue, library);
         runJoinBenchmark(device, commandQueue, library);
-        runQ1Benchmark(device, commandQueue, library);
-        runQ3Benchmark(device, commandQueue, library);
-        runQ6Benchmark(device, commandQueue, library);
-        runQ9Benchmark(device, commandQueue, library);
-        runQ13Benchmark(device, commandQueue, library);
+        for (const auto& p : param_list) runQ1Benchmark(device, commandQueue, library, catalog, p.q1);
+        for (const auto& p : param_list) runQ3Benchmark(device, commandQueue, library, catalog, p.q3);
+        for (const auto& p : param_list) runQ6Benchmark(device, commandQueue, library, catalog, p.q6);
+        for (const auto& p : param_list) runQ9Benchmark(device, commandQueue, library, catalog, p.q9);
+        for (const auto& p : param_list) runQ13Benchmark(device, commandQueue, library, catalog, p.q13);
     } else if (query == "selection") {
         runSelectionBenchmark(device, commandQueue, library);
     } else if (query == "aggregation") {
         runAggregationBenchmark(device, commandQueue, library);
     } else if (query == "join") {
         runJoinBenchmark(device, commandQueue, library);
+    } else if (query == "join-dist") {
+        MTL::ComputePipelineState* buildPipeline = makeComputePipeline(device, library, "hash_join_build");
+        MTL::ComputePipelineState* probePipeline = makeComputePipeline(device, library, "hash_join_probe");
+        if (!buildPipeline || !probePipeline) return 1;
+        if (!runJoinSweep(dist_config, gpuJoinRunner(device, commandQueue, buildPipeline, probePipeline))) return 1;
+        buildPipeline->release();
+        probePipeline->release();
+    } else if (query == "aggregation-dist") {
+        MTL::ComputePipelineState* aggregatePipeline = makeComputePipeline(device, library, "hash_aggregate_kernel");
+        if (!aggregatePipeline) return 1;
+        if (!runAggregationSweep(dist_config, gpuAggregationRunner(device, commandQueue, aggregatePipeline))) return 1;
+        aggregatePipeline->release();
     } else if (query == "q1") {
-        runQ1Benchmark(device, commandQueue, library);
+        for (const auto& p : param_list) runQ1Benchmark(device, commandQueue, library, catalog, p.q1);
     } else if (query == "q3") {
-        runQ3Benchmark(device, commandQueue, library);
+        for (const auto& p : param_list) runQ3Benchmark(device, commandQueue, library, catalog, p.q3);
     } else if (query == "q6") {
-        runQ6Benchmark(device, commandQueue, library);
+        for (const auto& p : param_list) runQ6Benchmark(device, commandQueue, library, catalog, p.q6);
     } else if (query == "q9") {
-        runQ9Benchmark(device, commandQueue, library);
+        for (const auto& p : param_list) runQ9Benchmark(device, commandQueue, library, catalog, p.q9);
     } else if (query == "q13") {
-        runQ13Benchmark(device, commandQueue, library);
+        for (const auto& p : param_list) runQ13Benchmark(device, commandQueue, library, catalog, p.q13);
+    } else if (query == "throughput") {
+        // One execution per query per stream; all streams share the device and command queue
+        g_harness = HarnessConfig::single();
+        runThroughputTest(throughput_config, [&](const std::string& q, const TpchParams& p) {
+            if (q == "q1") runQ1Benchmark(device, commandQueue, library, catalog, p.q1);
+            else if (q == "q3") runQ3Benchmark(device, commandQueue, library, catalog, p.q3);
+            else if (q == "q6") runQ6Benchmark(device, commandQueue, library, catalog, p.q6);
+            else if (q == "q9") runQ9Benchmark(device, commandQueue, library, catalog, p.q9);
+            else if (q == "q13") runQ13Benchmark(device, commandQueue, library, catalog, p.q13);
+        });
+    } else if (query == "incremental") {
+        std::cerr << "The incremental Q1/Q6 test runs on the CPU backend; use --backend cpu" << std::endl;
+        return 1;
+    } else if (query == "refresh") {
+        // Each refresh version uploads its visible rows once; the timings include that materialisation
+        g_harness = HarnessConfig::single();
+        runRefreshTest(catalog, refresh_config, [&](const std::string& q, const TpchParams& p) {
+            if (q == "q1") runQ1Benchmark(device, commandQueue, library, catalog, p.q1);
+            else if (q == "q3") runQ3Benchmark(device, commandQueue, library, catalog, p.q3);
+            else if (q == "q6") runQ6Benchmark(device, commandQueue, library, catalog, p.q6);
+            else if (q == "q9") runQ9Benchmark(device, commandQueue, library, catalog, p.q9);
+            else if (q == "q13") runQ13Benchmark(device, commandQueue, library, catalog, p.q13);
+        });
     } else {
         std::cerr << "Unknown query: " << query << std::endl;
         std::cerr << "Use 'help' to see available options." << std::endl;
@@ -1592,5 +2492,6 @@ int main(int argc, const char * argv[]) {
     // commandQueue->release();
     // device->release();
     // pAutoreleasePool->release();
+#endif
     return 0;
 }